@@ -0,0 +1,229 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_AWAITABLE_HPP
+#define KADEMLIA_AWAITABLE_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+// This header requires C++20 coroutines,
+// it is empty with older standards.
+#if defined( __cpp_impl_coroutine ) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <system_error>
+#include <utility>
+
+#include <kademlia/session_base.hpp>
+
+namespace kademlia {
+
+/**
+ *  @brief This object saves a data when awaited
+ *         by a coroutine.
+ *  @details The coroutine is resumed by the thread running
+ *           the session main loop, within the save handler.
+ *           The awaiter lives in the coroutine frame and the
+ *           handler only captures the awaiter and the coroutine
+ *           addresses, which fits std::function inline storage,
+ *           hence awaiting doesn't allocate by itself.
+ */
+template< typename SessionType >
+class save_awaitable final
+{
+public:
+    /**
+     *
+     */
+    save_awaitable
+        ( SessionType & s
+        , session_base::key_type const& key
+        , session_base::data_type const& data )
+            : session_( s )
+            , key_( key )
+            , data_( data )
+            , failure_()
+    { }
+
+    /**
+     *
+     */
+    bool
+    await_ready
+        ( void )
+        const noexcept
+    { return false; }
+
+    /**
+     *
+     */
+    void
+    await_suspend
+        ( std::coroutine_handle<> coroutine )
+    {
+        auto on_save = [ this, coroutine ]( std::error_code const& failure )
+        {
+            failure_ = failure;
+            coroutine.resume();
+        };
+
+        session_.async_save( key_, data_, on_save );
+    }
+
+    /**
+     *  @throw std::system_error if the save failed.
+     */
+    void
+    await_resume
+        ( void )
+    {
+        if ( failure_ )
+            throw std::system_error{ failure_ };
+    }
+
+private:
+    ///
+    SessionType & session_;
+    ///
+    session_base::key_type const& key_;
+    ///
+    session_base::data_type const& data_;
+    ///
+    std::error_code failure_;
+};
+
+/**
+ *  @brief This object loads a data when awaited
+ *         by a coroutine.
+ *  @details The coroutine is resumed by the thread running
+ *           the session main loop, within the load handler.
+ *           The awaiter lives in the coroutine frame, see
+ *           save_awaitable.
+ */
+template< typename SessionType >
+class load_awaitable final
+{
+public:
+    /**
+     *
+     */
+    load_awaitable
+        ( SessionType & s
+        , session_base::key_type const& key )
+            : session_( s )
+            , key_( key )
+            , failure_()
+            , data_()
+    { }
+
+    /**
+     *
+     */
+    bool
+    await_ready
+        ( void )
+        const noexcept
+    { return false; }
+
+    /**
+     *
+     */
+    void
+    await_suspend
+        ( std::coroutine_handle<> coroutine )
+    {
+        auto on_load = [ this, coroutine ]( std::error_code const& failure
+                                          , session_base::data_type const& data )
+        {
+            failure_ = failure;
+            if ( ! failure )
+                data_ = data;
+            coroutine.resume();
+        };
+
+        session_.async_load( key_, on_load );
+    }
+
+    /**
+     *  @return The loaded data.
+     *  @throw std::system_error if the load failed.
+     */
+    session_base::data_type
+    await_resume
+        ( void )
+    {
+        if ( failure_ )
+            throw std::system_error{ failure_ };
+
+        return std::move( data_ );
+    }
+
+private:
+    ///
+    SessionType & session_;
+    ///
+    session_base::key_type const& key_;
+    ///
+    std::error_code failure_;
+    ///
+    session_base::data_type data_;
+};
+
+/**
+ *  @brief Save a data into the network from a coroutine,
+ *         i.e. co_await save( s, key, data ).
+ *  @details key and data are read when the awaitable is
+ *           awaited, hence they have to outlive the
+ *           co_await expression.
+ */
+template< typename SessionType >
+save_awaitable< SessionType >
+save
+    ( SessionType & s
+    , session_base::key_type const& key
+    , session_base::data_type const& data )
+{ return save_awaitable< SessionType >{ s, key, data }; }
+
+/**
+ *  @brief Load a data from the network from a coroutine,
+ *         i.e. auto data = co_await load( s, key ).
+ *  @details key is read when the awaitable is awaited,
+ *           hence it has to outlive the co_await expression.
+ */
+template< typename SessionType >
+load_awaitable< SessionType >
+load
+    ( SessionType & s
+    , session_base::key_type const& key )
+{ return load_awaitable< SessionType >{ s, key }; }
+
+} // namespace kademlia
+
+#endif
+
+#endif
+
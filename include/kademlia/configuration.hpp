@@ -0,0 +1,457 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_CONFIGURATION_HPP
+#define KADEMLIA_CONFIGURATION_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <chrono>
+#include <cstddef>
+
+#include <kademlia/detail/symbol_visibility.hpp>
+
+namespace kademlia {
+
+/**
+ *  @brief This object holds the protocol parameters of a session.
+ *  @details The defaults suit most networks. Larger buckets
+ *           and more concurrent requests make lookups faster
+ *           and more reliable at the cost of more messages.
+ */
+class configuration final
+{
+public:
+    /// The count of peers.
+    using size_type = std::size_t;
+    /// The network delays.
+    using duration_type = std::chrono::milliseconds;
+
+    /**
+     *  @brief Construct a configuration with the default parameters.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    configuration
+        ( void );
+
+    /**
+     *  @brief Get the peers count per routing table bucket,
+     *         i.e. Kademlia k.
+     *  @details It is also the count of peers a lookup
+     *           converges to and a peer responds with.
+     *
+     *  @return The bucket size.
+     */
+    size_type
+    k_bucket_size
+        ( void )
+        const
+    { return k_bucket_size_; }
+
+    /**
+     *  @brief Set the peers count per routing table bucket.
+     *
+     *  @param k_bucket_size The bucket size, greater than 0.
+     */
+    void
+    k_bucket_size
+        ( size_type k_bucket_size )
+    { k_bucket_size_ = k_bucket_size; }
+
+    /**
+     *  @brief Get the requests count a lookup keeps in flight,
+     *         i.e. Kademlia alpha.
+     *
+     *  @return The concurrent requests count.
+     */
+    size_type
+    concurrent_requests_count
+        ( void )
+        const
+    { return concurrent_requests_count_; }
+
+    /**
+     *  @brief Set the requests count a lookup keeps in flight.
+     *
+     *  @param concurrent_requests_count The concurrent requests
+     *         count, greater than 0.
+     */
+    void
+    concurrent_requests_count
+        ( size_type concurrent_requests_count )
+    { concurrent_requests_count_ = concurrent_requests_count; }
+
+    /**
+     *  @brief Get the count of peers a saved value is stored on.
+     *
+     *  @return The replicas count.
+     */
+    size_type
+    redundant_save_count
+        ( void )
+        const
+    { return redundant_save_count_; }
+
+    /**
+     *  @brief Set the count of peers a saved value is stored on.
+     *
+     *  @param redundant_save_count The replicas count,
+     *         greater than 0.
+     */
+    void
+    redundant_save_count
+        ( size_type redundant_save_count )
+    { redundant_save_count_ = redundant_save_count; }
+
+    /**
+     *  @brief Get the count of replicas that must acknowledge
+     *         a saved value before the save succeeds.
+     *  @details Peers too old to acknowledge stores
+     *           are counted once the value is sent.
+     *
+     *  @return The write quorum.
+     */
+    size_type
+    write_quorum
+        ( void )
+        const
+    { return write_quorum_; }
+
+    /**
+     *  @brief Set the count of replicas that must acknowledge
+     *         a saved value before the save succeeds.
+     *
+     *  @param write_quorum The write quorum, greater than 0
+     *         and not greater than the redundant save count.
+     */
+    void
+    write_quorum
+        ( size_type write_quorum )
+    { write_quorum_ = write_quorum; }
+
+    /**
+     *  @brief Get the count of replicas that must agree
+     *         on a loaded value before the load succeeds.
+     *  @details Above 1, the replicas holding an older
+     *           version are sent the latest one.
+     *
+     *  @return The read quorum.
+     */
+    size_type
+    read_quorum
+        ( void )
+        const
+    { return read_quorum_; }
+
+    /**
+     *  @brief Set the count of replicas that must agree
+     *         on a loaded value before the load succeeds.
+     *
+     *  @param read_quorum The read quorum, greater than 0
+     *         and not greater than the redundant save count.
+     */
+    void
+    read_quorum
+        ( size_type read_quorum )
+    { read_quorum_ = read_quorum; }
+
+    /**
+     *  @brief Get the delay the initial peer has to respond.
+     *
+     *  @return The initial contact timeout.
+     */
+    duration_type const&
+    initial_contact_timeout
+        ( void )
+        const
+    { return initial_contact_timeout_; }
+
+    /**
+     *  @brief Set the delay the initial peer has to respond.
+     *
+     *  @param initial_contact_timeout The initial contact timeout.
+     */
+    void
+    initial_contact_timeout
+        ( duration_type const& initial_contact_timeout )
+    { initial_contact_timeout_ = initial_contact_timeout; }
+
+    /**
+     *  @brief Get the delay a peer has to respond during a lookup.
+     *
+     *  @return The lookup request timeout.
+     */
+    duration_type const&
+    peer_lookup_timeout
+        ( void )
+        const
+    { return peer_lookup_timeout_; }
+
+    /**
+     *  @brief Set the delay a peer has to respond during a lookup.
+     *
+     *  @param peer_lookup_timeout The lookup request timeout.
+     */
+    void
+    peer_lookup_timeout
+        ( duration_type const& peer_lookup_timeout )
+    { peer_lookup_timeout_ = peer_lookup_timeout; }
+
+    /**
+     *  @brief Get the chunk requests kept in flight
+     *         while transferring a large value.
+     *
+     *  @return The chunk window size.
+     */
+    size_type
+    chunk_window_size
+        ( void )
+        const
+    { return chunk_window_size_; }
+
+    /**
+     *  @brief Set the chunk requests kept in flight
+     *         while transferring a large value.
+     *
+     *  @param chunk_window_size The chunk window size,
+     *         greater than 0.
+     */
+    void
+    chunk_window_size
+        ( size_type chunk_window_size )
+    { chunk_window_size_ = chunk_window_size; }
+
+    /**
+     *  @brief Get the size in bytes of the recently
+     *         loaded values cache.
+     *
+     *  @return The cache capacity, 0 if disabled.
+     */
+    size_type
+    value_cache_capacity
+        ( void )
+        const
+    { return value_cache_capacity_; }
+
+    /**
+     *  @brief Set the size in bytes of the recently
+     *         loaded values cache.
+     *  @details The cache isn't used when the read quorum
+     *           is above 1, as replicas must then agree.
+     *
+     *  @param value_cache_capacity The cache capacity,
+     *         0 to disable it.
+     */
+    void
+    value_cache_capacity
+        ( size_type value_cache_capacity )
+    { value_cache_capacity_ = value_cache_capacity; }
+
+    /**
+     *  @brief Get the delay a loaded value is served
+     *         from the cache.
+     *
+     *  @return The cache time to live.
+     */
+    duration_type const&
+    value_cache_ttl
+        ( void )
+        const
+    { return value_cache_ttl_; }
+
+    /**
+     *  @brief Set the delay a loaded value is served
+     *         from the cache.
+     *
+     *  @param value_cache_ttl The cache time to live.
+     */
+    void
+    value_cache_ttl
+        ( duration_type const& value_cache_ttl )
+    { value_cache_ttl_ = value_cache_ttl; }
+
+    /**
+     *  @brief Get the longest delay a found value is cached
+     *         on the closest peer of the lookup path that
+     *         didn't have it.
+     *  @details Copies sent by peers are kept at most
+     *           this delay too, and refused if 0.
+     *
+     *  @return The path caching time to live, 0 if disabled.
+     */
+    duration_type const&
+    path_caching_ttl
+        ( void )
+        const
+    { return path_caching_ttl_; }
+
+    /**
+     *  @brief Set the longest delay a found value is cached
+     *         on the closest peer of the lookup path that
+     *         didn't have it.
+     *
+     *  @param path_caching_ttl The path caching time to live,
+     *         below a second to disable path caching.
+     */
+    void
+    path_caching_ttl
+        ( duration_type const& path_caching_ttl )
+    { path_caching_ttl_ = path_caching_ttl; }
+
+    /**
+     *  @brief Get the delay before a saved value
+     *         is saved again, i.e. Kademlia tRepublish.
+     *
+     *  @return The publisher republish interval.
+     */
+    duration_type const&
+    publisher_republish_interval
+        ( void )
+        const
+    { return publisher_republish_interval_; }
+
+    /**
+     *  @brief Set the delay before a saved value
+     *         is saved again.
+     *
+     *  @param publisher_republish_interval The publisher
+     *         republish interval.
+     */
+    void
+    publisher_republish_interval
+        ( duration_type const& publisher_republish_interval )
+    { publisher_republish_interval_ = publisher_republish_interval; }
+
+    /**
+     *  @brief Get the delay before a value stored by a peer
+     *         is stored again, i.e. Kademlia tReplicate.
+     *
+     *  @return The replica republish interval.
+     */
+    duration_type const&
+    replica_republish_interval
+        ( void )
+        const
+    { return replica_republish_interval_; }
+
+    /**
+     *  @brief Set the delay before a value stored by a peer
+     *         is stored again.
+     *
+     *  @param replica_republish_interval The replica
+     *         republish interval.
+     */
+    void
+    replica_republish_interval
+        ( duration_type const& replica_republish_interval )
+    { replica_republish_interval_ = replica_republish_interval; }
+
+    /**
+     *  @brief Get the delay a saved value is republished
+     *         by this session, its replicas keep it afterwards.
+     *
+     *  @return The published value time to live.
+     */
+    duration_type const&
+    published_value_ttl
+        ( void )
+        const
+    { return published_value_ttl_; }
+
+    /**
+     *  @brief Set the delay a saved value is republished
+     *         by this session.
+     *
+     *  @param published_value_ttl The published value
+     *         time to live.
+     */
+    void
+    published_value_ttl
+        ( duration_type const& published_value_ttl )
+    { published_value_ttl_ = published_value_ttl; }
+
+    /**
+     *  @brief Get the delay between two checks
+     *         for values due to be republished.
+     *
+     *  @return The republish batch interval.
+     */
+    duration_type const&
+    republish_batch_interval
+        ( void )
+        const
+    { return republish_batch_interval_; }
+
+    /**
+     *  @brief Set the delay between two checks
+     *         for values due to be republished.
+     *
+     *  @param republish_batch_interval The republish
+     *         batch interval, greater than 0.
+     */
+    void
+    republish_batch_interval
+        ( duration_type const& republish_batch_interval )
+    { republish_batch_interval_ = republish_batch_interval; }
+
+private:
+    ///
+    size_type k_bucket_size_;
+    ///
+    size_type concurrent_requests_count_;
+    ///
+    size_type redundant_save_count_;
+    ///
+    size_type write_quorum_;
+    ///
+    size_type read_quorum_;
+    ///
+    duration_type initial_contact_timeout_;
+    ///
+    duration_type peer_lookup_timeout_;
+    ///
+    size_type chunk_window_size_;
+    ///
+    size_type value_cache_capacity_;
+    ///
+    duration_type value_cache_ttl_;
+    ///
+    duration_type path_caching_ttl_;
+    ///
+    duration_type publisher_republish_interval_;
+    ///
+    duration_type replica_republish_interval_;
+    ///
+    duration_type published_value_ttl_;
+    ///
+    duration_type republish_batch_interval_;
+};
+
+} // namespace kademlia
+
+#endif
+
@@ -74,6 +74,12 @@ enum error_type
     TIMER_MALFUNCTION,
     /// Another call to session::run() is still blocked.
     ALREADY_RUNNING,
+    /// Not enough replicas acknowledged the request.
+    QUORUM_NOT_REACHED,
+    /// The tenant isn't hosted by this host.
+    UNKNOWN_TENANT,
+    /// A configuration parameter is out of range.
+    INVALID_CONFIGURATION,
 };
 
 /**
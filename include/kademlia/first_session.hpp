@@ -30,12 +30,14 @@
 #   pragma once
 #endif
 
+#include <chrono>
 #include <memory>
 #include <system_error>
 
 #include <kademlia/detail/symbol_visibility.hpp>
 #include <kademlia/detail/cxx11_macros.hpp>
 #include <kademlia/endpoint.hpp>
+#include <kademlia/configuration.hpp>
 #include <kademlia/session_base.hpp>
 
 namespace kademlia {
@@ -59,11 +61,15 @@ public:
      *
      *  @param listen_on_ipv4 IPv4 listening endpoint.
      *  @param listen_on_ipv6 IPv6 listening endpoint.
+     *  @param config The protocol parameters.
+     *  @throw std::system_error INVALID_CONFIGURATION if a parameter
+     *         of config is out of range.
      */
     KADEMLIA_SYMBOL_VISIBILITY
     first_session
         ( endpoint const& listen_on_ipv4 = endpoint{ "0.0.0.0", DEFAULT_PORT }
-        , endpoint const& listen_on_ipv6 = endpoint{ "::", DEFAULT_PORT } );
+        , endpoint const& listen_on_ipv6 = endpoint{ "::", DEFAULT_PORT }
+        , configuration const& config = configuration{} );
 
     /**
      *  @brief Destruct the first_session.
@@ -97,6 +103,48 @@ public:
     run
         ( void );
 
+    /**
+     *  @brief This <b>blocking call</b> execute the first_session main loop
+     *         on several threads.
+     *  @details The calling thread is one of the threads_count threads.
+     *           Callbacks are executed inside this call, one at a time.
+     *
+     *  @param threads_count The count of threads running the main loop.
+     *  @return The exit reason of the call.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    run_with_threads
+        ( std::size_t threads_count );
+
+    /**
+     *  @brief This <b>blocking call</b> execute the first_session main loop
+     *         until abort() is called or duration elapsed.
+     *  @details Callbacks are executed inside this call.
+     *
+     *  @param duration The maximum duration of the call.
+     *  @return RUN_ABORTED if aborted, no error if duration elapsed.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    run_for
+        ( std::chrono::milliseconds const& duration );
+
+    /**
+     *  @brief This <b>non-blocking call</b> execute the ready
+     *         callbacks of the first_session main loop.
+     *  @details This call allows an application event loop to drive
+     *           the first_session without a dedicated thread, by calling it
+     *           periodically (e.g. each few milliseconds).
+     *
+     *  @return ALREADY_RUNNING if the main loop is running,
+     *          no error otherwise.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    poll
+        ( void );
+
     /**
      *  @brief Abort the first_session main loop.
      */
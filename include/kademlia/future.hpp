@@ -0,0 +1,115 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_FUTURE_HPP
+#define KADEMLIA_FUTURE_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <future>
+#include <memory>
+#include <system_error>
+
+#include <kademlia/session_base.hpp>
+
+namespace kademlia {
+
+/**
+ *  @brief Async save a data into the network.
+ *  @details The future is ready once the save completed,
+ *           it throws a std::system_error on failure.
+ *           The session main loop has to run on another thread
+ *           for the future to become ready.
+ *
+ *  @param s The session (or first_session) saving the data.
+ *  @param key The data to save key.
+ *  @param data The data to save.
+ */
+template< typename SessionType >
+std::future< void >
+save_future
+    ( SessionType & s
+    , session_base::key_type const& key
+    , session_base::data_type const& data )
+{
+    // std::function requires a copyable handler.
+    auto const promise = std::make_shared< std::promise< void > >();
+
+    auto on_save = [ promise ]( std::error_code const& failure )
+    {
+        if ( failure )
+            promise->set_exception
+                    ( std::make_exception_ptr( std::system_error{ failure } ) );
+        else
+            promise->set_value();
+    };
+
+    auto result = promise->get_future();
+    s.async_save( key, data, on_save );
+
+    return result;
+}
+
+/**
+ *  @brief Async load a data from the network.
+ *  @details The future holds the data once the load completed,
+ *           it throws a std::system_error on failure.
+ *           The session main loop has to run on another thread
+ *           for the future to become ready.
+ *
+ *  @param s The session (or first_session) loading the data.
+ *  @param key The data to load key.
+ */
+template< typename SessionType >
+std::future< session_base::data_type >
+load_future
+    ( SessionType & s
+    , session_base::key_type const& key )
+{
+    using promise_type = std::promise< session_base::data_type >;
+    auto const promise = std::make_shared< promise_type >();
+
+    auto on_load = [ promise ]( std::error_code const& failure
+                              , session_base::data_type const& data )
+    {
+        if ( failure )
+            promise->set_exception
+                    ( std::make_exception_ptr( std::system_error{ failure } ) );
+        else
+            promise->set_value( data );
+    };
+
+    auto result = promise->get_future();
+    s.async_load( key, on_load );
+
+    return result;
+}
+
+} // namespace kademlia
+
+#endif
+
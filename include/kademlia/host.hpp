@@ -0,0 +1,236 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_HOST_HPP
+#define KADEMLIA_HOST_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <system_error>
+
+#include <kademlia/detail/symbol_visibility.hpp>
+#include <kademlia/detail/cxx11_macros.hpp>
+#include <kademlia/endpoint.hpp>
+#include <kademlia/configuration.hpp>
+#include <kademlia/session_base.hpp>
+
+namespace kademlia {
+
+/**
+ *  @brief This object hosts several network identities,
+ *         called tenants, in one process.
+ *  @details Tenants share the main loop and its threads
+ *           instead of running a session each. Each tenant
+ *           still listens on its own endpoints.
+ */
+class host final
+        : public session_base
+{
+public:
+    /// The index of a tenant within its host.
+    using tenant_type = std::size_t;
+
+public:
+    /**
+     *  @brief Construct a host without tenant.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    host
+        ( void );
+
+    /**
+     *  @brief Destruct the host and its tenants.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    ~host
+        ( void );
+
+    /**
+     *  @brief Disabled copy constructor.
+     */
+    host
+        ( host const& )
+        = delete;
+
+    /**
+     *  @brief Disabled assignment operator.
+     */
+    host&
+    operator=
+        ( host const& )
+        = delete;
+
+    /**
+     *  @brief Add a passive tenant, like a first_session.
+     *  @details Tenants are added while the host isn't running,
+     *           otherwise an ALREADY_RUNNING exception is thrown.
+     *
+     *  @param listen_on_ipv4 IPv4 listening endpoint.
+     *  @param listen_on_ipv6 IPv6 listening endpoint.
+     *  @param config The tenant protocol parameters.
+     *  @return The new tenant.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    tenant_type
+    add_tenant
+        ( endpoint const& listen_on_ipv4
+        , endpoint const& listen_on_ipv6
+        , configuration const& config = configuration{} );
+
+    /**
+     *  @brief Add an active tenant, like a session.
+     *  @details Tenants are added while the host isn't running,
+     *           otherwise an ALREADY_RUNNING exception is thrown.
+     *
+     *  @param initial_peer The peer the tenant discovers
+     *         its neighbors from.
+     *  @param listen_on_ipv4 IPv4 listening endpoint.
+     *  @param listen_on_ipv6 IPv6 listening endpoint.
+     *  @param config The tenant protocol parameters.
+     *  @return The new tenant.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    tenant_type
+    add_tenant
+        ( endpoint const& initial_peer
+        , endpoint const& listen_on_ipv4
+        , endpoint const& listen_on_ipv6
+        , configuration const& config = configuration{} );
+
+    /**
+     *  @return The count of tenants.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::size_t
+    tenants_count
+        ( void )
+        const;
+
+    /**
+     *  @brief Async save a data into the network on behalf of tenant.
+     *
+     *  @param tenant The tenant saving the data.
+     *  @param key The data to save key.
+     *  @param data The data to save.
+     *  @param handler Callback called to report call status.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    void
+    async_save
+        ( tenant_type tenant
+        , key_type const& key
+        , data_type const& data
+        , save_handler_type handler );
+
+    /**
+     *  @brief Async load a data from the network on behalf of tenant.
+     *
+     *  @param tenant The tenant loading the data.
+     *  @param key The data to load key.
+     *  @param handler Callback called to report call status.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    void
+    async_load
+        ( tenant_type tenant
+        , key_type const& key
+        , load_handler_type handler );
+
+    /**
+     *  @brief This <b>blocking call</b> execute the host main loop.
+     *  @details Callbacks of all tenants are executed inside this call.
+     *
+     *  @return The exit reason of the call.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    run
+        ( void );
+
+    /**
+     *  @brief This <b>blocking call</b> execute the host main loop
+     *         on several threads.
+     *  @details The calling thread is one of the threads_count threads.
+     *           Callbacks are executed inside this call, one at a time
+     *           for a given tenant, while distinct tenants run in parallel.
+     *
+     *  @param threads_count The count of threads running the main loop.
+     *  @return The exit reason of the call.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    run_with_threads
+        ( std::size_t threads_count );
+
+    /**
+     *  @brief This <b>blocking call</b> execute the host main loop
+     *         until abort() is called or duration elapsed.
+     *
+     *  @param duration The maximum duration of the call.
+     *  @return RUN_ABORTED if aborted, no error if duration elapsed.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    run_for
+        ( std::chrono::milliseconds const& duration );
+
+    /**
+     *  @brief This <b>non-blocking call</b> execute the ready
+     *         callbacks of the host main loop.
+     *
+     *  @return ALREADY_RUNNING if the main loop is running,
+     *          no error otherwise.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    poll
+        ( void );
+
+    /**
+     *  @brief Abort the host main loop.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    void
+    abort
+        ( void );
+
+private:
+    /// Hidden implementation.
+    struct impl;
+
+private:
+    /// The hidden implementation instance.
+    std::unique_ptr< impl > impl_;
+};
+
+} // namespace kademlia
+
+#endif
+
@@ -30,12 +30,14 @@
 #   pragma once
 #endif
 
+#include <chrono>
 #include <memory>
 #include <system_error>
 
 #include <kademlia/detail/symbol_visibility.hpp>
 #include <kademlia/detail/cxx11_macros.hpp>
 #include <kademlia/endpoint.hpp>
+#include <kademlia/configuration.hpp>
 #include <kademlia/session_base.hpp>
 
 namespace kademlia {
@@ -58,12 +60,16 @@ public:
      *         contacts this peer and retrieve it's neighbors.
      *  @param listen_on_ipv4 IPv4 listening endpoint.
      *  @param listen_on_ipv6 IPv6 listening endpoint.
+     *  @param config The protocol parameters.
+     *  @throw std::system_error INVALID_CONFIGURATION if a parameter
+     *         of config is out of range.
      */
     KADEMLIA_SYMBOL_VISIBILITY
     session
         ( endpoint const& initial_peer
         , endpoint const& listen_on_ipv4 = endpoint{ "0.0.0.0", DEFAULT_PORT }
-        , endpoint const& listen_on_ipv6 = endpoint{ "::", DEFAULT_PORT } );
+        , endpoint const& listen_on_ipv6 = endpoint{ "::", DEFAULT_PORT }
+        , configuration const& config = configuration{} );
 
     /**
      *  @brief Destruct the session.
@@ -113,6 +119,32 @@ public:
         ( key_type const& key
         , load_handler_type handler );
 
+    /**
+     *  @brief Async save several data into the network.
+     *  @details Lookups of nearby keys share the peers they found.
+     *
+     *  @param values The keys and data to save.
+     *  @param handler Callback called once per value to report its status.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    void
+    async_save_many
+        ( std::vector< value_type > const& values
+        , save_many_handler_type handler );
+
+    /**
+     *  @brief Async load several data from the network.
+     *  @details Lookups of nearby keys share the peers they found.
+     *
+     *  @param keys The data to load keys.
+     *  @param handler Callback called once per key to report its status.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    void
+    async_load_many
+        ( std::vector< key_type > const& keys
+        , load_many_handler_type handler );
+
     /**
      *  @brief This <b>blocking call</b> execute the session main loop.
      *  @details Callbacks are executed inside this call.
@@ -124,6 +156,48 @@ public:
     run
         ( void );
 
+    /**
+     *  @brief This <b>blocking call</b> execute the session main loop
+     *         on several threads.
+     *  @details The calling thread is one of the threads_count threads.
+     *           Callbacks are executed inside this call, one at a time.
+     *
+     *  @param threads_count The count of threads running the main loop.
+     *  @return The exit reason of the call.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    run_with_threads
+        ( std::size_t threads_count );
+
+    /**
+     *  @brief This <b>blocking call</b> execute the session main loop
+     *         until abort() is called or duration elapsed.
+     *  @details Callbacks are executed inside this call.
+     *
+     *  @param duration The maximum duration of the call.
+     *  @return RUN_ABORTED if aborted, no error if duration elapsed.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    run_for
+        ( std::chrono::milliseconds const& duration );
+
+    /**
+     *  @brief This <b>non-blocking call</b> execute the ready
+     *         callbacks of the session main loop.
+     *  @details This call allows an application event loop to drive
+     *           the session without a dedicated thread, by calling it
+     *           periodically (e.g. each few milliseconds).
+     *
+     *  @return ALREADY_RUNNING if the main loop is running,
+     *          no error otherwise.
+     */
+    KADEMLIA_SYMBOL_VISIBILITY
+    std::error_code
+    poll
+        ( void );
+
     /**
      *  @brief Abort the session main loop.
      */
@@ -31,6 +31,7 @@
 #endif
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 #include <system_error>
 #include <functional>
@@ -63,6 +64,23 @@ public:
                 , data_type const& data )
             >;
 
+    /// The key and data of a value to save.
+    using value_type = std::pair< key_type, data_type >;
+
+    /// The callback type called to signal the save status of each value.
+    using save_many_handler_type = std::function
+            < void
+                ( std::error_code const& error
+                , key_type const& key )
+            >;
+    /// The callback type called to signal the load status of each key.
+    using load_many_handler_type = std::function
+            < void
+                ( std::error_code const& error
+                , key_type const& key
+                , data_type const& data )
+            >;
+
     /// This kademlia implementation default port.
     static CXX11_CONSTEXPR std::uint16_t DEFAULT_PORT = 27980;
 
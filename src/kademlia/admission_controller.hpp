@@ -0,0 +1,124 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_ADMISSION_CONTROLLER_HPP
+#define KADEMLIA_ADMISSION_CONTROLLER_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <chrono>
+
+#include "kademlia/message.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class sheds costly requests
+ *         when the event loop falls behind.
+ *  @details
+ *  The event loop lag is the delay a ready handler waits
+ *  before it runs. Store requests are shed first as
+ *  they insert data, then value lookups. Pings and peer
+ *  lookups are kept to maintain the routing table.
+ */
+class admission_controller final
+{
+public:
+    ///
+    using duration = std::chrono::steady_clock::duration;
+
+    ///
+    enum admission
+    {
+        ///
+        ADMITTED,
+        ///
+        STORE_SHED,
+        ///
+        FIND_VALUE_SHED,
+    };
+
+public:
+    /**
+     *  @param store_shedding_lag The lag above which
+     *         store requests are shed.
+     *  @param find_value_shedding_lag The lag above which
+     *         value lookups are shed.
+     */
+    admission_controller
+        ( duration const& store_shedding_lag
+        , duration const& find_value_shedding_lag )
+            : store_shedding_lag_( store_shedding_lag )
+            , find_value_shedding_lag_( find_value_shedding_lag )
+            , lag_()
+    { }
+
+    /**
+     *
+     */
+    void
+    update_lag
+        ( duration const& lag )
+    { lag_ = lag; }
+
+    /**
+     *
+     */
+    admission
+    admit
+        ( header::type const& t )
+        const
+    {
+        switch ( t )
+        {
+            case header::STORE_REQUEST:
+            case header::STORE_CHUNK_REQUEST:
+            case header::STORE_VALUES_REQUEST:
+                return lag_ < store_shedding_lag_ ? ADMITTED : STORE_SHED;
+            case header::FIND_VALUE_REQUEST:
+            case header::FIND_CHUNK_REQUEST:
+            case header::FIND_VALUES_REQUEST:
+                return lag_ < find_value_shedding_lag_ ? ADMITTED : FIND_VALUE_SHED;
+            default:
+                return ADMITTED;
+        }
+    }
+
+private:
+    ///
+    duration store_shedding_lag_;
+    ///
+    duration find_value_shedding_lag_;
+    ///
+    duration lag_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
@@ -0,0 +1,290 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_BATCH_TASK_HPP
+#define KADEMLIA_BATCH_TASK_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+
+#include "kademlia/log.hpp"
+#include "kademlia/constants.hpp"
+#include "kademlia/candidates_pool.hpp"
+#include "kademlia/id.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class schedules the lookups of a multi-key request.
+ *  @details Keys sharing their first BATCH_GROUP_PREFIX_BITS bits
+ *           belong to the same group. The first key of a group is
+ *           looked up alone, then the remaining keys of the group
+ *           start from the responsive peers it met, shared through
+ *           a candidates_pool, instead of from the routing table.
+ *           In between, the group can be prepared at once, e.g. using
+ *           multi-key messages sent to the peers of the pool.
+ *           Up to BATCH_CONCURRENT_REQUESTS_COUNT lookups are in flight.
+ */
+template< typename StartRequestType >
+class batch_task final
+    : public boost::intrusive_ref_counter< batch_task< StartRequestType >
+                                        , boost::thread_unsafe_counter >
+{
+public:
+    /// Called as start_request( key_index, pool, on_completion ).
+    using start_request_type = StartRequestType;
+
+    ///
+    using completion_handler_type = std::function< void ( void ) >;
+
+    /// Called as prepare_group( key_indexes, pool, on_completion ).
+    using prepare_group_type = std::function
+            < void
+                ( std::vector< std::size_t > const& key_indexes
+                , std::shared_ptr< candidates_pool > pool
+                , completion_handler_type on_completion )
+            >;
+
+public:
+    /**
+     *
+     */
+    static void
+    start
+        ( std::vector< id > const& keys
+        , start_request_type start_request
+        , prepare_group_type prepare_group )
+    {
+        boost::intrusive_ptr< batch_task > t;
+        t.reset( new batch_task( keys
+                               , std::move( start_request )
+                               , std::move( prepare_group ) ) );
+
+        start_requests( t );
+    }
+
+private:
+    ///
+    struct group final
+    {
+        ///
+        std::vector< std::size_t > key_indexes_;
+        ///
+        std::size_t next_key_;
+        /// The other keys can be started.
+        bool is_ready_;
+        ///
+        std::shared_ptr< candidates_pool > pool_;
+    };
+
+private:
+    /**
+     *
+     */
+    batch_task
+        ( std::vector< id > const& keys
+        , start_request_type start_request
+        , prepare_group_type prepare_group )
+            : start_request_( std::move( start_request ) )
+            , prepare_group_( std::move( prepare_group ) )
+            , groups_()
+            , in_flight_requests_count_()
+    {
+        std::vector< std::size_t > key_indexes( keys.size() );
+        for ( std::size_t i = 0; i != keys.size(); ++ i )
+            key_indexes[ i ] = i;
+
+        std::sort( key_indexes.begin(), key_indexes.end()
+                 , [ &keys ]( std::size_t a, std::size_t b )
+                 { return keys[ a ] < keys[ b ]; } );
+
+        for ( std::size_t i = 0; i != key_indexes.size(); ++ i )
+        {
+            if ( i == 0 || ! have_same_prefix( keys[ key_indexes[ i - 1 ] ]
+                                             , keys[ key_indexes[ i ] ] ) )
+                groups_.push_back( group{ {}, 0, false
+                                        , std::make_shared< candidates_pool >() } );
+
+            groups_.back().key_indexes_.push_back( key_indexes[ i ] );
+        }
+
+        LOG_DEBUG( batch_task, this ) << "create batch task for "
+                << keys.size() << " key(s) in " << groups_.size()
+                << " group(s)." << std::endl;
+    }
+
+    /**
+     *
+     */
+    static bool
+    have_same_prefix
+        ( id const& a
+        , id const& b )
+    {
+        for ( std::size_t i = 0; i != BATCH_GROUP_PREFIX_BITS; ++ i )
+            if ( static_cast< bool >( a[ i ] ) != static_cast< bool >( b[ i ] ) )
+                return false;
+
+        return true;
+    }
+
+    /**
+     *  @brief Start the leader of each group first, then
+     *         the other keys of the groups whose leader is done.
+     */
+    static void
+    start_requests
+        ( boost::intrusive_ptr< batch_task > task )
+    {
+        for ( std::size_t g = 0; g != task->groups_.size(); ++ g )
+        {
+            auto & current = task->groups_[ g ];
+
+            while ( task->in_flight_requests_count_
+                    < BATCH_CONCURRENT_REQUESTS_COUNT
+                  && current.next_key_ < current.key_indexes_.size()
+                  && ( current.next_key_ == 0 || current.is_ready_ ) )
+                start_request( task, g );
+
+            if ( task->in_flight_requests_count_
+                 >= BATCH_CONCURRENT_REQUESTS_COUNT )
+                break;
+        }
+    }
+
+    /**
+     *
+     */
+    static void
+    start_request
+        ( boost::intrusive_ptr< batch_task > task
+        , std::size_t group_index )
+    {
+        auto & current = task->groups_[ group_index ];
+        bool const is_leader = current.next_key_ == 0;
+        auto const key_index = current.key_indexes_[ current.next_key_ ];
+        ++ current.next_key_;
+        ++ task->in_flight_requests_count_;
+
+        auto on_completion = [ task, group_index, is_leader ]( void )
+        {
+            if ( is_leader )
+                prepare_group( task, group_index );
+            else
+            {
+                -- task->in_flight_requests_count_;
+                start_requests( task );
+            }
+        };
+
+        task->start_request_( key_index
+                            , current.pool_
+                            , completion_handler_type{ on_completion } );
+    }
+
+    /**
+     *  @brief Prepare the other keys of a group, then start them.
+     *  @note The preparation takes the place of the leader request
+     *        within the requests in flight.
+     */
+    static void
+    prepare_group
+        ( boost::intrusive_ptr< batch_task > task
+        , std::size_t group_index )
+    {
+        auto on_completion = [ task, group_index ]( void )
+        {
+            -- task->in_flight_requests_count_;
+            task->groups_[ group_index ].is_ready_ = true;
+
+            start_requests( task );
+        };
+
+        auto const& current = task->groups_[ group_index ];
+        if ( ! task->prepare_group_ || current.key_indexes_.size() == 1 )
+        {
+            on_completion();
+            return;
+        }
+
+        std::vector< std::size_t > const followers
+                ( std::next( current.key_indexes_.begin() )
+                , current.key_indexes_.end() );
+
+        task->prepare_group_( followers
+                            , current.pool_
+                            , completion_handler_type{ on_completion } );
+    }
+
+private:
+    ///
+    start_request_type start_request_;
+    ///
+    prepare_group_type prepare_group_;
+    ///
+    std::vector< group > groups_;
+    ///
+    std::size_t in_flight_requests_count_;
+};
+
+/**
+ *  @brief Look keys up by groups of nearby keys.
+ *  @details start_request( key_index, pool, on_completion ) must
+ *           start the request of keys[ key_index ] using pool, and
+ *           call on_completion() once this request is done.
+ *           If not null, prepare_group( key_indexes, pool, on_completion )
+ *           is called before the other keys of a group are started.
+ */
+template< typename StartRequestType >
+void
+start_batch_task
+    ( std::vector< id > const& keys
+    , StartRequestType && start_request
+    , typename batch_task< typename std::decay< StartRequestType >::type >
+            ::prepare_group_type prepare_group = nullptr )
+{
+    using start_request_type = typename std::decay< StartRequestType >::type;
+    using task = batch_task< start_request_type >;
+
+    task::start( keys
+               , std::forward< StartRequestType >( start_request )
+               , std::move( prepare_group ) );
+}
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
@@ -0,0 +1,219 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_CANDIDATES_POOL_HPP
+#define KADEMLIA_CANDIDATES_POOL_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "kademlia/peer.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief Responsive peers shared by the lookups of
+ *         keys from the same region of the key space.
+ *  @details It also keeps the values found and the versions
+ *           stored by multi-key requests until their lookups
+ *           or saves claim them.
+ */
+class candidates_pool final
+{
+public:
+    /**
+     *
+     */
+    void
+    add
+        ( peer const& p );
+
+    /**
+     *
+     */
+    void
+    remove
+        ( id const& peer_id );
+
+    /**
+     *  @return Up to max_count peers, the closest to key first.
+     */
+    std::vector< peer >
+    find_closest
+        ( id const& key
+        , std::size_t max_count )
+        const;
+
+    /**
+     *
+     */
+    std::size_t
+    size
+        ( void )
+        const;
+
+    /**
+     *
+     */
+    void
+    add_value
+        ( id const& key
+        , std::vector< std::uint8_t > data );
+
+    /**
+     *  @brief Remove the value of key found meanwhile, if any.
+     *  @return true if data has been set to the found value.
+     */
+    bool
+    take_value
+        ( id const& key
+        , std::vector< std::uint8_t > & data );
+
+    /**
+     *
+     */
+    void
+    add_stored_version
+        ( id const& key
+        , std::uint64_t version );
+
+    /**
+     *  @brief Remove the version of key stored meanwhile, if any.
+     *  @return true if version has been set to the stored version.
+     */
+    bool
+    take_stored_version
+        ( id const& key
+        , std::uint64_t & version );
+
+private:
+    ///
+    std::map< id, peer > peers_;
+    ///
+    std::map< id, std::vector< std::uint8_t > > values_;
+    ///
+    std::map< id, std::uint64_t > stored_versions_;
+};
+
+inline void
+candidates_pool::add
+    ( peer const& p )
+{ peers_.emplace( p.id_, p ); }
+
+inline void
+candidates_pool::remove
+    ( id const& peer_id )
+{ peers_.erase( peer_id ); }
+
+inline std::vector< peer >
+candidates_pool::find_closest
+    ( id const& key
+    , std::size_t max_count )
+    const
+{
+    using distance_and_peer = std::pair< id, peer const* >;
+
+    std::vector< distance_and_peer > candidates;
+    candidates.reserve( peers_.size() );
+    for ( auto const& p : peers_ )
+        candidates.emplace_back( distance( p.first, key ), &p.second );
+
+    auto const count = std::min( max_count, candidates.size() );
+    auto const by_distance = []( distance_and_peer const& a
+                               , distance_and_peer const& b )
+    { return a.first < b.first; };
+    std::partial_sort( candidates.begin()
+                     , candidates.begin() + count
+                     , candidates.end()
+                     , by_distance );
+
+    std::vector< peer > closest;
+    closest.reserve( count );
+    for ( std::size_t i = 0; i != count; ++ i )
+        closest.push_back( *candidates[ i ].second );
+
+    return closest;
+}
+
+inline std::size_t
+candidates_pool::size
+    ( void )
+    const
+{ return peers_.size(); }
+
+inline void
+candidates_pool::add_value
+    ( id const& key
+    , std::vector< std::uint8_t > data )
+{ values_[ key ] = std::move( data ); }
+
+inline bool
+candidates_pool::take_value
+    ( id const& key
+    , std::vector< std::uint8_t > & data )
+{
+    auto const i = values_.find( key );
+    if ( i == values_.end() )
+        return false;
+
+    data = std::move( i->second );
+    values_.erase( i );
+
+    return true;
+}
+
+inline void
+candidates_pool::add_stored_version
+    ( id const& key
+    , std::uint64_t version )
+{ stored_versions_[ key ] = version; }
+
+inline bool
+candidates_pool::take_stored_version
+    ( id const& key
+    , std::uint64_t & version )
+{
+    auto const i = stored_versions_.find( key );
+    if ( i == stored_versions_.end() )
+        return false;
+
+    version = i->second;
+    stored_versions_.erase( i );
+
+    return true;
+}
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
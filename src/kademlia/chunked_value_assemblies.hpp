@@ -0,0 +1,348 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_CHUNKED_VALUE_ASSEMBLIES_HPP
+#define KADEMLIA_CHUNKED_VALUE_ASSEMBLIES_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <boost/asio/ip/address.hpp>
+
+#include "kademlia/message.hpp"
+#include "kademlia/value_store.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class gathers the chunks of the
+ *         values received by chunks.
+ *  @details
+ *  Memory is allocated as chunks arrive, hence the size
+ *  announced by a sender doesn't reserve anything. Each
+ *  received chunk is charged chunk_size bytes, so that
+ *  tiny last chunks can't pin many assemblies. Chunks are
+ *  refused once either all the assemblies or the ones
+ *  started by their sender address would exceed their limit.
+ *  An assembly is only continued by the peer which started
+ *  it, with the same version and size, until it completes
+ *  or expires.
+ */
+template< typename KeyType, typename DataType >
+class chunked_value_assemblies final
+{
+public:
+    ///
+    using key_type = KeyType;
+
+    ///
+    using data_type = DataType;
+
+    ///
+    using sender_type = boost::asio::ip::address;
+
+    ///
+    using chunk_type = value_chunk< data_type >;
+
+    /// The chunks of a value, by index.
+    using chunks_type = std::vector< chunk_type >;
+
+    ///
+    using clock = std::chrono::steady_clock;
+
+    ///
+    using duration = clock::duration;
+
+    ///
+    enum status
+    {
+        /// The chunk has been dropped.
+        CHUNK_REFUSED,
+        /// The chunk has been kept, or was already.
+        CHUNK_ACCEPTED,
+        /// The chunk was the last one missing.
+        VALUE_COMPLETED
+    };
+
+    ///
+    struct statistics final
+    {
+        ///
+        std::uint64_t refused_chunks_count_;
+        ///
+        std::uint64_t expired_assemblies_count_;
+    };
+
+public:
+    /**
+     *  @param chunk_size The size of all chunks but the last one.
+     *  @param max_size The maximum count of charged bytes.
+     *  @param max_size_per_sender The maximum count of charged
+     *         bytes of the assemblies started by an address.
+     *  @param timeout The time an assembly waits for its next chunk.
+     */
+    chunked_value_assemblies
+        ( std::size_t chunk_size
+        , std::size_t max_size
+        , std::size_t max_size_per_sender
+        , duration const& timeout )
+            : chunk_size_( chunk_size )
+            , max_size_( max_size )
+            , max_size_per_sender_( max_size_per_sender )
+            , timeout_( timeout )
+            , size_()
+            , sizes_by_sender_()
+            , assemblies_()
+            , statistics_()
+    { }
+
+    /**
+     *
+     */
+    chunked_value_assemblies
+        ( chunked_value_assemblies const& )
+        = delete;
+
+    /**
+     *
+     */
+    chunked_value_assemblies &
+    operator=
+        ( chunked_value_assemblies const& )
+        = delete;
+
+    /**
+     *  @brief Keep a chunk at its place in the value.
+     *  @details chunk_index and the chunk size must have
+     *           been checked against value_size. Chunks are
+     *           kept as received, compressed or not.
+     *  @param chunks Set to the chunks of the value once completed.
+     */
+    status
+    add_chunk
+        ( key_type const& key
+        , sender_type const& sender
+        , std::uint64_t version
+        , std::size_t value_size
+        , std::size_t chunk_index
+        , data_type && chunk
+        , bool is_compressed
+        , clock::time_point const& now
+        , chunks_type & chunks )
+    {
+        auto i = assemblies_.find( key );
+
+        // A different value waits for this one to complete or expire.
+        if ( i != assemblies_.end()
+           && ( i->second.sender_ != sender
+              || i->second.version_ != version
+              || i->second.value_size_ != value_size ) )
+            return refuse_chunk();
+
+        bool const is_duplicate = i != assemblies_.end()
+                && i->second.chunks_.count( chunk_index ) > 0;
+
+        if ( ! is_duplicate && ! has_room( sender ) )
+            return refuse_chunk();
+
+        if ( i == assemblies_.end() )
+            i = assemblies_.emplace( key
+                                   , assembly{ sender
+                                             , version
+                                             , value_size
+                                             , get_chunks_count( value_size
+                                                               , chunk_size_ )
+                                             , {}
+                                             , now } ).first;
+
+        auto & a = i->second;
+        a.expiration_time_ = now + timeout_;
+
+        // The sender may have missed the ack of a duplicate.
+        if ( is_duplicate )
+            return CHUNK_ACCEPTED;
+
+        a.chunks_.emplace( chunk_index, chunk_type{ std::move( chunk )
+                                                  , is_compressed } );
+        size_ += chunk_size_;
+        sizes_by_sender_[ sender ] += chunk_size_;
+
+        if ( a.chunks_.size() < a.chunks_count_ )
+            return CHUNK_ACCEPTED;
+
+        chunks.clear();
+        chunks.reserve( a.chunks_count_ );
+        for ( auto & c : a.chunks_ )
+            chunks.push_back( std::move( c.second ) );
+
+        erase( i );
+
+        return VALUE_COMPLETED;
+    }
+
+    /**
+     *  @brief Forget the values whose chunks stopped arriving.
+     */
+    void
+    drop_expired
+        ( clock::time_point const& now )
+    {
+        auto i = assemblies_.begin();
+        while ( i != assemblies_.end() )
+        {
+            if ( i->second.expiration_time_ <= now )
+            {
+                i = erase( i );
+                ++ statistics_.expired_assemblies_count_;
+            }
+            else
+                ++ i;
+        }
+    }
+
+    /**
+     *  @return The count of charged bytes.
+     */
+    std::size_t
+    size
+        ( void )
+        const
+    { return size_; }
+
+    /**
+     *  @return The count of values being assembled.
+     */
+    std::size_t
+    assemblies_count
+        ( void )
+        const
+    { return assemblies_.size(); }
+
+    /**
+     *
+     */
+    statistics const&
+    get_statistics
+        ( void )
+        const
+    { return statistics_; }
+
+private:
+    ///
+    struct assembly final
+    {
+        ///
+        sender_type sender_;
+        ///
+        std::uint64_t version_;
+        ///
+        std::size_t value_size_;
+        ///
+        std::size_t chunks_count_;
+        /// The received chunks, by index.
+        std::map< std::size_t, chunk_type > chunks_;
+        ///
+        clock::time_point expiration_time_;
+    };
+
+    ///
+    using assemblies_type = value_store< key_type, assembly >;
+
+private:
+    /**
+     *
+     */
+    bool
+    has_room
+        ( sender_type const& sender )
+        const
+    {
+        if ( size_ + chunk_size_ > max_size_ )
+            return false;
+
+        auto const i = sizes_by_sender_.find( sender );
+        return i == sizes_by_sender_.end()
+            || i->second + chunk_size_ <= max_size_per_sender_;
+    }
+
+    /**
+     *
+     */
+    status
+    refuse_chunk
+        ( void )
+    {
+        ++ statistics_.refused_chunks_count_;
+        return CHUNK_REFUSED;
+    }
+
+    /**
+     *
+     */
+    typename assemblies_type::iterator
+    erase
+        ( typename assemblies_type::iterator i )
+    {
+        auto const charged_size = i->second.chunks_.size() * chunk_size_;
+        size_ -= charged_size;
+
+        auto const sender_size = sizes_by_sender_.find( i->second.sender_ );
+        sender_size->second -= charged_size;
+        if ( sender_size->second == 0 )
+            sizes_by_sender_.erase( sender_size );
+
+        return assemblies_.erase( i );
+    }
+
+private:
+    ///
+    std::size_t chunk_size_;
+    ///
+    std::size_t max_size_;
+    ///
+    std::size_t max_size_per_sender_;
+    ///
+    duration timeout_;
+    ///
+    std::size_t size_;
+    ///
+    std::map< sender_type, std::size_t > sizes_by_sender_;
+    ///
+    assemblies_type assemblies_;
+    ///
+    statistics statistics_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
@@ -0,0 +1,118 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "kademlia/compression.hpp"
+
+#include <iterator>
+
+#ifdef KADEMLIA_ENABLE_COMPRESSION
+#   include <zlib.h>
+#endif
+
+#include "kademlia/error_impl.hpp"
+#include "kademlia/constants.hpp"
+
+namespace kademlia {
+namespace detail {
+
+#ifdef KADEMLIA_ENABLE_COMPRESSION
+
+bool
+is_compression_enabled
+    ( void )
+{ return true; }
+
+bool
+compress
+    ( std::vector< std::uint8_t >::const_iterator begin
+    , std::vector< std::uint8_t >::const_iterator end
+    , std::vector< std::uint8_t > & compressed )
+{
+    auto const size = std::size_t( std::distance( begin, end ) );
+    if ( size < COMPRESSION_MIN_SIZE )
+        return false;
+
+    compressed.resize( ::compressBound( uLong( size ) ) );
+
+    auto compressed_size = uLongf( compressed.size() );
+    auto const result = ::compress2( compressed.data(), &compressed_size
+                                   , &*begin, uLong( size )
+                                   , Z_BEST_SPEED );
+    if ( result != Z_OK || compressed_size >= size )
+    {
+        compressed.clear();
+        return false;
+    }
+
+    compressed.resize( compressed_size );
+    return true;
+}
+
+std::error_code
+decompress
+    ( std::vector< std::uint8_t > const& compressed
+    , std::vector< std::uint8_t > & data )
+{
+    data.resize( CHUNK_SIZE );
+
+    auto data_size = uLongf( data.size() );
+    auto const result = ::uncompress( data.data(), &data_size
+                                    , compressed.data()
+                                    , uLong( compressed.size() ) );
+    if ( result != Z_OK )
+    {
+        data.clear();
+        return make_error_code( CORRUPTED_BODY );
+    }
+
+    data.resize( data_size );
+    return std::error_code{};
+}
+
+#else
+
+bool
+is_compression_enabled
+    ( void )
+{ return false; }
+
+bool
+compress
+    ( std::vector< std::uint8_t >::const_iterator
+    , std::vector< std::uint8_t >::const_iterator
+    , std::vector< std::uint8_t > & )
+{ return false; }
+
+std::error_code
+decompress
+    ( std::vector< std::uint8_t > const&
+    , std::vector< std::uint8_t > & )
+{ return make_error_code( CORRUPTED_BODY ); }
+
+#endif
+
+} // namespace detail
+} // namespace kademlia
+
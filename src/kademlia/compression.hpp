@@ -0,0 +1,87 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_COMPRESSION_HPP
+#define KADEMLIA_COMPRESSION_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <cstdint>
+#include <system_error>
+#include <vector>
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @return true if this build can compress and decompress values.
+ *  @note Compression is enabled at build time by
+ *        KADEMLIA_ENABLE_COMPRESSION.
+ */
+bool
+is_compression_enabled
+    ( void );
+
+/**
+ *  @brief Compress the bytes in [begin, end) if it's worth it.
+ *  @details Values smaller than COMPRESSION_MIN_SIZE and values
+ *           not shrinking are left uncompressed. Values stored
+ *           by chunks are compressed one chunk at a time.
+ *  @return true if compressed has been filled.
+ */
+bool
+compress
+    ( std::vector< std::uint8_t >::const_iterator begin
+    , std::vector< std::uint8_t >::const_iterator end
+    , std::vector< std::uint8_t > & compressed );
+
+/**
+ *
+ */
+inline bool
+compress
+    ( std::vector< std::uint8_t > const& data
+    , std::vector< std::uint8_t > & compressed )
+{ return compress( data.begin(), data.end(), compressed ); }
+
+/**
+ *  @brief Decompress data compressed by compress().
+ *  @details Either a value fitting a single message
+ *           or a chunk was compressed.
+ *  @return CORRUPTED_BODY if compressed is invalid or would
+ *          exceed CHUNK_SIZE once decompressed.
+ */
+std::error_code
+decompress
+    ( std::vector< std::uint8_t > const& compressed
+    , std::vector< std::uint8_t > & data );
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
@@ -0,0 +1,52 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <kademlia/configuration.hpp>
+
+#include "kademlia/constants.hpp"
+
+namespace kademlia {
+
+configuration::configuration
+    ( void )
+        : k_bucket_size_( detail::ROUTING_TABLE_BUCKET_SIZE )
+        , concurrent_requests_count_( detail::CONCURRENT_FIND_PEER_REQUESTS_COUNT )
+        , redundant_save_count_( detail::REDUNDANT_SAVE_COUNT )
+        , write_quorum_( detail::STORE_WRITE_QUORUM )
+        , read_quorum_( detail::LOAD_READ_QUORUM )
+        , initial_contact_timeout_( detail::INITIAL_CONTACT_RECEIVE_TIMEOUT )
+        , peer_lookup_timeout_( detail::PEER_LOOKUP_TIMEOUT )
+        , chunk_window_size_( detail::CHUNK_WINDOW_SIZE )
+        , value_cache_capacity_( detail::VALUE_CACHE_CAPACITY )
+        , value_cache_ttl_( detail::VALUE_CACHE_TTL )
+        , path_caching_ttl_( detail::PATH_CACHING_TTL )
+        , publisher_republish_interval_( detail::PUBLISHER_REPUBLISH_INTERVAL )
+        , replica_republish_interval_( detail::REPLICA_REPUBLISH_INTERVAL )
+        , published_value_ttl_( detail::PUBLISHED_VALUE_TTL )
+        , republish_batch_interval_( detail::REPUBLISH_BATCH_INTERVAL )
+{ }
+
+} // namespace kademlia
+
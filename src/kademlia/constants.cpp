@@ -25,16 +25,78 @@
 
 #include "kademlia/constants.hpp"
 
+#include <cstdint>
+
 namespace kademlia {
 namespace detail {
 
 std::size_t const ROUTING_TABLE_BUCKET_SIZE{ 20 };
 std::size_t const CONCURRENT_FIND_PEER_REQUESTS_COUNT{ 3 };
 std::size_t const REDUNDANT_SAVE_COUNT{ 3 };
+std::size_t const STORE_WRITE_QUORUM{ 1 };
+std::size_t const LOAD_READ_QUORUM{ 1 };
 
 std::chrono::milliseconds const INITIAL_CONTACT_RECEIVE_TIMEOUT{ 1000 };
 std::chrono::milliseconds const PEER_LOOKUP_TIMEOUT{ 20 };
 
+std::size_t const VALUE_CACHE_CAPACITY{ 1024 * 1024 };
+std::chrono::milliseconds const VALUE_CACHE_TTL{ 30000 };
+
+std::chrono::seconds const PATH_CACHING_TTL{ 3600 };
+
+std::chrono::seconds const PUBLISHER_REPUBLISH_INTERVAL{ 86400 };
+std::chrono::seconds const REPLICA_REPUBLISH_INTERVAL{ 3600 };
+std::chrono::seconds const PUBLISHED_VALUE_TTL{ 7 * 86400 };
+std::chrono::seconds const REPUBLISH_BATCH_INTERVAL{ 60 };
+std::size_t const REPUBLISH_BATCH_SIZE{ 64 };
+
+// A chunk message fits the 1280 bytes IPv6 minimum MTU.
+std::size_t const CHUNK_SIZE{ 1024 };
+std::size_t const CHUNK_WINDOW_SIZE{ 16 };
+std::size_t const CHUNKED_VALUE_MAX_SIZE{ 64 * 1024 * 1024 };
+std::chrono::seconds const CHUNKED_VALUE_ASSEMBLY_TIMEOUT{ 60 };
+// A sender can upload a single value of the largest size at once.
+std::size_t const CHUNKED_VALUE_ASSEMBLIES_MAX_SIZE{ 2 * 64 * 1024 * 1024 };
+std::size_t const CHUNKED_VALUE_ASSEMBLIES_MAX_SIZE_PER_SENDER{ 64 * 1024 * 1024 };
+
+// Smaller values hardly shrink, being mostly header.
+std::size_t const COMPRESSION_MIN_SIZE{ 128 };
+
+// The 1280 bytes IPv6 minimum MTU less the IPv6 and UDP headers.
+std::size_t const MULTI_KEY_MESSAGE_MAX_SIZE{ 1280 - 40 - 8 };
+// The input buffer size of message_socket.
+std::size_t const MESSAGE_MAX_SIZE{ UINT16_MAX };
+std::size_t const PEER_VERSIONS_CAPACITY{ 4096 };
+
+// Enough for requests, sparing the reallocations of growing buffers.
+std::size_t const MESSAGE_RESERVED_SIZE{ 256 };
+
+std::size_t const TASK_POOL_CAPACITY{ 64 };
+
+// 4 x 1024 buckets of 16 bytes each.
+std::size_t const SOURCE_RATE_LIMIT_SKETCH_DEPTH{ 4 };
+std::size_t const SOURCE_RATE_LIMIT_SKETCH_WIDTH{ 1024 };
+// A peer sends a few requests per lookup it runs, while a
+// burst covers the bucket refreshes of a joining peer or
+// the stores of a republish batch.
+std::size_t const SOURCE_REQUESTS_RATE{ 32 };
+std::size_t const SOURCE_REQUESTS_BURST{ 256 };
+std::size_t const PREFIX_REQUESTS_RATE{ 4 * 32 };
+std::size_t const PREFIX_REQUESTS_BURST{ 4 * 256 };
+// About 2 MB/s of chunks, while a burst covers the transfer
+// of the largest value, as a dropped chunk fails its transfer.
+std::size_t const SOURCE_CHUNK_REQUESTS_RATE{ 2048 };
+std::size_t const SOURCE_CHUNK_REQUESTS_BURST{ CHUNKED_VALUE_MAX_SIZE / CHUNK_SIZE };
+
+std::chrono::milliseconds const EVENT_LOOP_LAG_PROBE_INTERVAL{ 100 };
+std::chrono::milliseconds const STORE_SHEDDING_LAG{ 50 };
+std::chrono::milliseconds const FIND_VALUE_SHEDDING_LAG{ 200 };
+
+std::size_t const SUBMISSION_BATCH_SIZE{ 64 };
+
+std::size_t const BATCH_GROUP_PREFIX_BITS{ 8 };
+std::size_t const BATCH_CONCURRENT_REQUESTS_COUNT{ 16 };
+
 } // namespace detail
 } // namespace kademlia
 
@@ -35,18 +35,99 @@
 namespace kademlia {
 namespace detail {
 
-// k
+// k, default of configuration::k_bucket_size().
 extern std::size_t const ROUTING_TABLE_BUCKET_SIZE;
-// a
+// a, default of configuration::concurrent_requests_count().
 extern std::size_t const CONCURRENT_FIND_PEER_REQUESTS_COUNT;
-// c
+// c, default of configuration::redundant_save_count().
 extern std::size_t const REDUNDANT_SAVE_COUNT;
+// W, default of configuration::write_quorum().
+extern std::size_t const STORE_WRITE_QUORUM;
+// R, default of configuration::read_quorum().
+extern std::size_t const LOAD_READ_QUORUM;
 
-//
+// Default of configuration::initial_contact_timeout().
 extern std::chrono::milliseconds const INITIAL_CONTACT_RECEIVE_TIMEOUT;
-//
+// Default of configuration::peer_lookup_timeout().
 extern std::chrono::milliseconds const PEER_LOOKUP_TIMEOUT;
 
+// Default of configuration::value_cache_capacity().
+extern std::size_t const VALUE_CACHE_CAPACITY;
+// Default of configuration::value_cache_ttl().
+extern std::chrono::milliseconds const VALUE_CACHE_TTL;
+
+// Default of configuration::path_caching_ttl().
+extern std::chrono::seconds const PATH_CACHING_TTL;
+
+// tRepublish, default of configuration::publisher_republish_interval().
+extern std::chrono::seconds const PUBLISHER_REPUBLISH_INTERVAL;
+// tReplicate, default of configuration::replica_republish_interval().
+extern std::chrono::seconds const REPLICA_REPUBLISH_INTERVAL;
+// Default of configuration::published_value_ttl().
+extern std::chrono::seconds const PUBLISHED_VALUE_TTL;
+// Default of configuration::republish_batch_interval().
+extern std::chrono::seconds const REPUBLISH_BATCH_INTERVAL;
+// Maximum values republished per batch.
+extern std::size_t const REPUBLISH_BATCH_SIZE;
+
+// Values larger than this are stored by chunks of this size.
+extern std::size_t const CHUNK_SIZE;
+// Default of configuration::chunk_window_size().
+extern std::size_t const CHUNK_WINDOW_SIZE;
+// Largest value that can be stored by chunks.
+extern std::size_t const CHUNKED_VALUE_MAX_SIZE;
+// Delay after which a partially received value is dropped.
+extern std::chrono::seconds const CHUNKED_VALUE_ASSEMBLY_TIMEOUT;
+// Bytes of the values being received by chunks from all senders.
+extern std::size_t const CHUNKED_VALUE_ASSEMBLIES_MAX_SIZE;
+// Bytes of the values being received by chunks from a single address.
+extern std::size_t const CHUNKED_VALUE_ASSEMBLIES_MAX_SIZE_PER_SENDER;
+
+// Smallest value compressed when sent to peers supporting it.
+extern std::size_t const COMPRESSION_MIN_SIZE;
+
+// Largest multi-key message, sized to avoid IP fragmentation.
+extern std::size_t const MULTI_KEY_MESSAGE_MAX_SIZE;
+// Largest message a peer receives, as its UDP datagrams.
+extern std::size_t const MESSAGE_MAX_SIZE;
+// Peers whose highest protocol version is remembered.
+extern std::size_t const PEER_VERSIONS_CAPACITY;
+// Bytes reserved by a message buffer before serialization.
+extern std::size_t const MESSAGE_RESERVED_SIZE;
+// Destroyed tasks of each kind whose storage a thread keeps for reuse.
+extern std::size_t const TASK_POOL_CAPACITY;
+
+// Rows and buckets per row of the senders rate limiting sketches.
+extern std::size_t const SOURCE_RATE_LIMIT_SKETCH_DEPTH;
+extern std::size_t const SOURCE_RATE_LIMIT_SKETCH_WIDTH;
+// Requests per second a sender address can send.
+extern std::size_t const SOURCE_REQUESTS_RATE;
+// Requests a sender address can send at once.
+extern std::size_t const SOURCE_REQUESTS_BURST;
+// Requests per second the senders of a network prefix can send.
+extern std::size_t const PREFIX_REQUESTS_RATE;
+// Requests the senders of a network prefix can send at once.
+extern std::size_t const PREFIX_REQUESTS_BURST;
+// Chunk requests per second a sender address can send.
+extern std::size_t const SOURCE_CHUNK_REQUESTS_RATE;
+// Chunk requests a sender address can send at once.
+extern std::size_t const SOURCE_CHUNK_REQUESTS_BURST;
+
+// Delay between two measures of the event loop lag.
+extern std::chrono::milliseconds const EVENT_LOOP_LAG_PROBE_INTERVAL;
+// Event loop lag above which store requests are shed.
+extern std::chrono::milliseconds const STORE_SHEDDING_LAG;
+// Event loop lag above which value lookups are shed.
+extern std::chrono::milliseconds const FIND_VALUE_SHEDDING_LAG;
+
+// Application submissions executed by the engine at once.
+extern std::size_t const SUBMISSION_BATCH_SIZE;
+
+// Keys of a multi-key request sharing these leading bits share their peers.
+extern std::size_t const BATCH_GROUP_PREFIX_BITS;
+// Lookups in flight per multi-key request.
+extern std::size_t const BATCH_CONCURRENT_REQUESTS_COUNT;
+
 } // namespace detail
 } // namespace kademlia
 
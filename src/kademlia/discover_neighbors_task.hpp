@@ -31,13 +31,14 @@
 #endif
 
 #include <system_error>
-#include <memory>
 #include <type_traits>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
 
 #include "kademlia/error_impl.hpp"
 
 #include "kademlia/log.hpp"
-#include "kademlia/constants.hpp"
+#include "kademlia/task_pool.hpp"
 #include "kademlia/message.hpp"
 
 namespace kademlia {
@@ -49,6 +50,15 @@ template< typename TrackerType
         , typename EndpointsType
         , typename OnCompleteType >
 class discover_neighbors_task final
+    : public boost::intrusive_ref_counter< discover_neighbors_task< TrackerType
+                                                                , RoutingTableType
+                                                                , EndpointsType
+                                                                , OnCompleteType >
+                                        , boost::thread_unsafe_counter >
+    , public pooled_task< discover_neighbors_task< TrackerType
+                                                 , RoutingTableType
+                                                 , EndpointsType
+                                                 , OnCompleteType > >
 {
 public:
     ///
@@ -72,7 +82,7 @@ public:
         , endpoints_type const& endpoints_to_query
         , on_complete_type const& on_complete )
     {
-        std::shared_ptr< discover_neighbors_task > d;
+        boost::intrusive_ptr< discover_neighbors_task > d;
         d.reset( new discover_neighbors_task( my_id
                                             , tracker
                                             , routing_table
@@ -107,7 +117,7 @@ private:
      */
     static void
     search_ourselves
-        ( std::shared_ptr< discover_neighbors_task > task )
+        ( boost::intrusive_ptr< discover_neighbors_task > task )
     {
         if ( task->endpoints_to_query_.empty() )
         {
@@ -139,7 +149,7 @@ private:
 
         task->tracker_.send_request( find_peer_request_body{ task->my_id_ }
                                    , endpoint_to_query
-                                   , INITIAL_CONTACT_RECEIVE_TIMEOUT
+                                   , task->tracker_.get_configuration().initial_contact_timeout()
                                    , on_message_received
                                    , on_error );
     }
@@ -149,7 +159,7 @@ private:
      */
     static void
     handle_initial_contact_response
-        ( std::shared_ptr< discover_neighbors_task > task
+        ( boost::intrusive_ptr< discover_neighbors_task > task
         , ip_endpoint const& s
         , header const& h
         , buffer::const_iterator i
@@ -171,7 +181,7 @@ private:
         };
 
         find_peer_response_body response;
-        if ( auto failure = deserialize( i, e, response ) )
+        if ( auto failure = deserialize( i, e, h.version_, task->my_id_, response ) )
         {
             LOG_DEBUG( discover_neighbors_task, task.get() )
                     << "failed to deserialize find peer response ("
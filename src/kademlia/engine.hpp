@@ -39,9 +39,11 @@
 #include <utility>
 #include <type_traits>
 #include <functional>
+#include <map>
 #include <boost/asio/io_service.hpp>
 
 #include <kademlia/endpoint.hpp>
+#include <kademlia/configuration.hpp>
 #include "kademlia/error_impl.hpp"
 
 #include "kademlia/log.hpp"
@@ -50,13 +52,24 @@
 #include "kademlia/response_router.hpp"
 #include "kademlia/network.hpp"
 #include "kademlia/message.hpp"
+#include "kademlia/message_filter.hpp"
 #include "kademlia/routing_table.hpp"
 #include "kademlia/value_store.hpp"
+#include "kademlia/compression.hpp"
 #include "kademlia/find_value_task.hpp"
 #include "kademlia/store_value_task.hpp"
+#include "kademlia/batch_task.hpp"
 #include "kademlia/discover_neighbors_task.hpp"
 #include "kademlia/notify_peer_task.hpp"
 #include "kademlia/tracker.hpp"
+#include "kademlia/in_flight_requests.hpp"
+#include "kademlia/small_function.hpp"
+#include "kademlia/value_cache.hpp"
+#include "kademlia/request_decoder.hpp"
+#include "kademlia/chunked_value_assemblies.hpp"
+#include "kademlia/reception_buffer_pool.hpp"
+#include "kademlia/timer.hpp"
+#include "kademlia/strand.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -81,36 +94,102 @@ public:
     using routing_table_type = routing_table< endpoint_type >;
 
     ///
-    using value_store_type = value_store< id, data_type >;
+    using value_store_entry_type = value_store_entry< data_type >;
+
+    ///
+    using value_store_type = value_store< id, value_store_entry_type >;
+
+    ///
+    using value_cache_type = value_cache< id, data_type >;
+
+    /**
+     *  @brief Values republished during the last batch.
+     */
+    struct republish_statistics final
+    {
+        /// Values this engine saved itself.
+        std::size_t published_values_count_;
+        /// Values this engine holds as a replica.
+        std::size_t replicated_values_count_;
+        /// Republishes postponed as a peer already sent the value.
+        std::size_t postponed_values_count_;
+        /// Published values and cached copies dropped once expired.
+        std::size_t expired_values_count_;
+        /// Size of the republished values.
+        std::size_t bytes_count_;
+    };
 
 public:
     /**
-     *
+     *  @param timers The timer queue shared with the engines
+     *         of io_service, or nullptr to use queues of its own.
+     *  @param reception_buffers The pool lending the reception
+     *         buffers of the engines of io_service, or nullptr
+     *         to use buffers of its own.
+     *  @throw std::system_error INVALID_CONFIGURATION if a parameter
+     *         of config is out of range.
      */
     engine
         ( boost::asio::io_service & io_service
         , endpoint const& ipv4
         , endpoint const& ipv6
-        , id const& new_id = id{} )
-            : random_engine_( std::random_device{}() )
+        , id const& new_id = id{}
+        , configuration const& config = configuration{}
+        , timer_queue * timers = nullptr
+        , reception_buffer_pool * reception_buffers = nullptr )
+            : strand_( io_service )
+            , configuration_( check_configuration( config ) )
+            , random_engine_( std::random_device{}() )
             , my_id_( new_id == id{} ? id{ random_engine_ } : new_id )
             , network_( io_service
-                      , message_socket_type::ipv4( io_service, ipv4 )
-                      , message_socket_type::ipv6( io_service, ipv6 )
+                      , message_socket_type::ipv4( strand_, ipv4, reception_buffers )
+                      , message_socket_type::ipv6( strand_, ipv6, reception_buffers )
                       , std::bind( &engine::handle_new_message
                                  , this
                                  , std::placeholders::_1
                                  , std::placeholders::_2
                                  , std::placeholders::_3 ) )
-            , tracker_( io_service
+            , tracker_( strand_
                       , my_id_
                       , network_
-                      , random_engine_ )
-            , routing_table_( my_id_ )
+                      , random_engine_
+                      , configuration_
+                      , timers )
+            , message_filter_( token_bucket_sketch{ SOURCE_RATE_LIMIT_SKETCH_DEPTH
+                                                  , SOURCE_RATE_LIMIT_SKETCH_WIDTH
+                                                  , SOURCE_REQUESTS_RATE
+                                                  , SOURCE_REQUESTS_BURST }
+                             , token_bucket_sketch{ SOURCE_RATE_LIMIT_SKETCH_DEPTH
+                                                  , SOURCE_RATE_LIMIT_SKETCH_WIDTH
+                                                  , PREFIX_REQUESTS_RATE
+                                                  , PREFIX_REQUESTS_BURST }
+                             , token_bucket_sketch{ SOURCE_RATE_LIMIT_SKETCH_DEPTH
+                                                  , SOURCE_RATE_LIMIT_SKETCH_WIDTH
+                                                  , SOURCE_CHUNK_REQUESTS_RATE
+                                                  , SOURCE_CHUNK_REQUESTS_BURST }
+                             , admission_controller{ STORE_SHEDDING_LAG
+                                                   , FIND_VALUE_SHEDDING_LAG } )
+            , event_loop_lag_timer_( strand_, timers )
+            , routing_table_( my_id_, configuration_.k_bucket_size() )
             , value_store_()
             , is_connected_()
             , pending_tasks_()
-    { }
+            , in_flight_saves_()
+            , in_flight_loads_()
+            , value_cache_( configuration_.value_cache_capacity()
+                          , configuration_.value_cache_ttl() )
+            , published_values_()
+            , republish_timer_( strand_, timers )
+            , republish_statistics_()
+            , postponed_republishes_count_()
+            , chunked_value_assemblies_( CHUNK_SIZE
+                                       , CHUNKED_VALUE_ASSEMBLIES_MAX_SIZE
+                                       , CHUNKED_VALUE_ASSEMBLIES_MAX_SIZE_PER_SENDER
+                                       , CHUNKED_VALUE_ASSEMBLY_TIMEOUT )
+    {
+        schedule_republish();
+        schedule_event_loop_lag_probe();
+    }
 
     /**
      *
@@ -120,8 +199,12 @@ public:
         , endpoint const& initial_peer
         , endpoint const& ipv4
         , endpoint const& ipv6
-        , id const& new_id = id{} )
-            : engine( io_service, ipv4, ipv6, new_id )
+        , id const& new_id = id{}
+        , configuration const& config = configuration{}
+        , timer_queue * timers = nullptr
+        , reception_buffer_pool * reception_buffers = nullptr )
+            : engine( io_service, ipv4, ipv6, new_id, config
+                    , timers, reception_buffers )
     {
         LOG_DEBUG( engine, this ) << "bootstrapping using peer '"
                 << initial_peer << "'." << std::endl;
@@ -153,6 +236,317 @@ public:
         ( key_type const& key
         , data_type const& data
         , HandlerType && handler )
+    { save( key, data, std::forward< HandlerType >( handler ), nullptr ); }
+
+    /**
+     *
+     */
+    template< typename HandlerType >
+    void
+    async_load
+        ( key_type const& key
+        , HandlerType && handler )
+    { load( key, std::forward< HandlerType >( handler ), nullptr ); }
+
+    /**
+     *  @brief Save several values, the lookups of nearby
+     *         keys sharing the peers they found.
+     *  @details handler( failure, key ) is called once per value,
+     *           as soon as this value is saved. Nearby values are
+     *           packed within multi-key stores to the peers
+     *           found by the lookup of the first of them.
+     */
+    template< typename ValuesType, typename HandlerType >
+    void
+    async_save_many
+        ( ValuesType const& values
+        , HandlerType && handler )
+    {
+        using handler_type = typename std::decay< HandlerType >::type;
+        using value_type = std::pair< key_type, data_type >;
+
+        auto const saved_values = std::make_shared< std::vector< value_type > >
+                ( values.begin(), values.end() );
+        auto const shared_handler = std::make_shared< handler_type >
+                ( std::forward< HandlerType >( handler ) );
+
+        std::vector< id > keys;
+        for ( auto const& v : *saved_values )
+            keys.emplace_back( v.first );
+
+        auto start_save = [ this, saved_values, shared_handler ]
+            ( std::size_t key_index
+            , std::shared_ptr< candidates_pool > pool
+            , std::function< void ( void ) > on_completion )
+        {
+            auto const& value = ( *saved_values )[ key_index ];
+            auto const key = value.first;
+            auto on_save = [ shared_handler, key, on_completion ]
+                ( std::error_code const& failure )
+            {
+                ( *shared_handler )( failure, key );
+                on_completion();
+            };
+
+            save( key, value.second, std::move( on_save ), std::move( pool ) );
+        };
+
+        // Values stored by a multi-key request skip their own
+        // lookup once acknowledged by the write quorum.
+        auto prestore = [ this, saved_values ]
+            ( std::vector< std::size_t > const& key_indexes
+            , std::shared_ptr< candidates_pool > pool
+            , std::function< void ( void ) > on_completion )
+        {
+            std::vector< stored_value > values;
+            for ( auto const key_index : key_indexes )
+            {
+                auto const& value = ( *saved_values )[ key_index ];
+                values.push_back( stored_value{ id( value.first )
+                                              , value.second
+                                              , generate_version() } );
+            }
+
+            prestore_values( values, std::move( pool ), std::move( on_completion ) );
+        };
+
+        start_batch_task( keys, std::move( start_save ), prestore );
+    }
+
+    /**
+     *  @brief Load several keys, the lookups of nearby
+     *         keys sharing the peers they found.
+     *  @details handler( failure, key, data ) is called once
+     *           per key, as soon as this key is loaded.
+     */
+    template< typename KeysType, typename HandlerType >
+    void
+    async_load_many
+        ( KeysType const& keys
+        , HandlerType && handler )
+    {
+        using handler_type = typename std::decay< HandlerType >::type;
+
+        auto const loaded_keys = std::make_shared< std::vector< key_type > >
+                ( keys.begin(), keys.end() );
+        auto const shared_handler = std::make_shared< handler_type >
+                ( std::forward< HandlerType >( handler ) );
+
+        std::vector< id > key_ids;
+        for ( auto const& k : *loaded_keys )
+            key_ids.emplace_back( k );
+
+        auto start_load = [ this, loaded_keys, shared_handler ]
+            ( std::size_t key_index
+            , std::shared_ptr< candidates_pool > pool
+            , std::function< void ( void ) > on_completion )
+        {
+            auto const key = ( *loaded_keys )[ key_index ];
+            auto on_load = [ shared_handler, key, on_completion ]
+                ( std::error_code const& failure
+                , data_type const& data )
+            {
+                ( *shared_handler )( failure, key, data );
+                on_completion();
+            };
+
+            load( key, std::move( on_load ), std::move( pool ) );
+        };
+
+        // Values found by a multi-key request skip their own lookup,
+        // unless more than one replica must agree on them.
+        auto prefetch = [ this, key_ids ]
+            ( std::vector< std::size_t > const& key_indexes
+            , std::shared_ptr< candidates_pool > pool
+            , std::function< void ( void ) > on_completion )
+        {
+            std::vector< id > keys;
+            for ( auto const key_index : key_indexes )
+                keys.push_back( key_ids[ key_index ] );
+
+            prefetch_values( keys, std::move( pool ), std::move( on_completion ) );
+        };
+
+        if ( configuration_.read_quorum() > 1 )
+            start_batch_task( key_ids, std::move( start_load ) );
+        else
+            start_batch_task( key_ids, std::move( start_load ), prefetch );
+    }
+
+    /**
+     *  @return The number of async_save() calls attached
+     *          to an identical in flight save.
+     */
+    std::uint64_t
+    coalesced_saves_count
+        ( void )
+        const
+    { return in_flight_saves_.coalesced_requests_count(); }
+
+    /**
+     *  @return The number of async_load() calls attached
+     *          to an in flight lookup of the same key.
+     */
+    std::uint64_t
+    coalesced_loads_count
+        ( void )
+        const
+    { return in_flight_loads_.coalesced_requests_count(); }
+
+    /**
+     *  @return The loaded values cache hit/miss statistics.
+     */
+    typename value_cache_type::statistics const&
+    get_value_cache_statistics
+        ( void )
+        const
+    { return value_cache_.get_statistics(); }
+
+    /**
+     *  @return The strand serializing the handlers of this engine,
+     *          on which its methods are called.
+     */
+    strand &
+    get_strand
+        ( void )
+    { return strand_; }
+
+    /**
+     *  @return The count of incoming messages dropped per reason.
+     */
+    message_filter::statistics const&
+    get_message_filter_statistics
+        ( void )
+        const
+    { return message_filter_.get_statistics(); }
+
+    /**
+     *  @return The statistics of the last republish batch.
+     */
+    republish_statistics const&
+    get_republish_statistics
+        ( void )
+        const
+    { return republish_statistics_; }
+
+    /**
+     *  @brief Save again the values that are due, at most
+     *         REPUBLISH_BATCH_SIZE of them.
+     *  @details This is called every configured republish batch
+     *           interval. Values saved by this engine are republished
+     *           every publisher republish interval, until their
+     *           published value ttl passed. Values stored by peers
+     *           are republished every replica republish interval,
+     *           unless another peer stored them again meanwhile.
+     *           Values cached along lookup paths are not republished,
+     *           and dropped once expired.
+     */
+    void
+    republish_values
+        ( typename value_store_entry_type::clock::time_point const& now )
+    {
+        republish_statistics statistics{};
+        statistics.postponed_values_count_ = postponed_republishes_count_;
+        postponed_republishes_count_ = 0;
+
+        chunked_value_assemblies_.drop_expired( now );
+        statistics.expired_values_count_
+                = drop_expired_entries( published_values_, now )
+                + drop_expired_entries( value_store_, now );
+
+        if ( is_connected_ )
+        {
+            auto remaining_count = REPUBLISH_BATCH_SIZE;
+
+            statistics.published_values_count_
+                    = republish_due_values( published_values_
+                                          , configuration_.publisher_republish_interval()
+                                          , now
+                                          , remaining_count
+                                          , statistics.bytes_count_ );
+
+            statistics.replicated_values_count_
+                    = republish_due_values( value_store_
+                                          , configuration_.replica_republish_interval()
+                                          , now
+                                          , remaining_count
+                                          , statistics.bytes_count_ );
+        }
+
+        LOG_DEBUG( engine, this ) << "republished "
+                << statistics.published_values_count_ << " published and "
+                << statistics.replicated_values_count_ << " replicated value(s) ("
+                << statistics.bytes_count_ << " bytes)." << std::endl;
+
+        republish_statistics_ = statistics;
+    }
+
+private:
+    ///
+    using pending_task_type = std::function< void ( void ) >;
+
+    ///
+    using message_socket_type = message_socket< UnderlyingSocketType >;
+
+    ///
+    using network_type = network< message_socket_type >;
+
+    ///
+    using random_engine_type = std::default_random_engine;
+
+    ///
+    using tracker_type = tracker< random_engine_type, network_type >;
+
+    ///
+    using save_handler_type = small_function
+            < void ( std::error_code const& ) >;
+
+    ///
+    using load_handler_type = small_function
+            < void ( std::error_code const&, data_type const& ) >;
+
+    ///
+    using save_request_type = std::pair< id, data_type >;
+
+    ///
+    using clock = typename value_store_entry_type::clock;
+
+    ///
+    using chunked_value_assemblies_type
+            = chunked_value_assemblies< id, data_type >;
+
+private:
+    /**
+     *  @return config if lookups can progress with it.
+     */
+    static configuration const&
+    check_configuration
+        ( configuration const& config )
+    {
+        if ( config.k_bucket_size() == 0
+           || config.concurrent_requests_count() == 0
+           || config.redundant_save_count() == 0
+           || config.write_quorum() == 0
+           || config.write_quorum() > config.redundant_save_count()
+           || config.read_quorum() == 0
+           || config.read_quorum() > config.redundant_save_count()
+           || config.chunk_window_size() == 0
+           || config.republish_batch_interval().count() <= 0 )
+            throw std::system_error{ make_error_code( INVALID_CONFIGURATION ) };
+
+        return config;
+    }
+
+    /**
+     *  @param pool If not null, peers shared with lookups of nearby keys.
+     */
+    template< typename HandlerType >
+    void
+    save
+        ( key_type const& key
+        , data_type const& data
+        , HandlerType && handler
+        , std::shared_ptr< candidates_pool > pool )
     {
         // If the routing table is empty, save the
         // current request for processing when
@@ -162,32 +556,89 @@ public:
             LOG_DEBUG( engine, this ) << "delaying async save of key '"
                     << to_string( key ) << "'." << std::endl;
 
-            auto t = [ this, key, data, handler ] ( void ) mutable
-            { async_save( key, data, std::move( handler ) ); };
+            auto t = [ this, key, data, handler, pool ] ( void ) mutable
+            { save( key, data, std::move( handler ), std::move( pool ) ); };
 
             pending_tasks_.push( std::move( t ) );
         }
         else
         {
+            save_request_type const request{ id( key ), data };
+
+            // Our own loads must not return the previous value.
+            value_cache_.invalidate( request.first );
+
+            // A multi-key request may have stored it meanwhile.
+            auto version = generate_version();
+            bool const is_prestored
+                    = pool && pool->take_stored_version( request.first, version );
+
+            // Past its ttl, the value is left to its replicas.
+            auto const now = clock::now();
+            published_values_[ request.first ]
+                    = value_store_entry_type{ data
+                                            , now + configuration_.published_value_ttl()
+                                            , version
+                                            , now
+                                              + configuration_.publisher_republish_interval()
+                                            , false
+                                            , {}
+                                            , 0 };
+
+            if ( is_prestored )
+            {
+                LOG_DEBUG( engine, this ) << "saved key '"
+                        << to_string( key ) << "' with a multi-key request."
+                        << std::endl;
+
+                auto on_save = [ handler ]( void ) mutable
+                { handler( std::error_code{} ); };
+
+                strand_.post( std::move( on_save ) );
+                return;
+            }
+
+            // An identical save is still in flight,
+            // its completion will notify this handler.
+            if ( ! in_flight_saves_.attach( request
+                                          , std::forward< HandlerType >( handler ) ) )
+            {
+                LOG_DEBUG( engine, this ) << "coalescing async save of key '"
+                        << to_string( key ) << "'." << std::endl;
+                return;
+            }
+
             LOG_DEBUG( engine, this ) << "executing async save of key '"
                     << to_string( key ) << "'." << std::endl;
 
-            start_store_value_task( id( key )
+            auto on_save = [ this, request ]
+                ( std::error_code const& failure )
+            {
+                // A lookup may have cached the previous value meanwhile.
+                value_cache_.invalidate( request.first );
+                in_flight_saves_.notify( request, failure );
+            };
+
+            start_store_value_task( request.first
                                   , data
                                   , tracker_
                                   , routing_table_
-                                  , std::forward< HandlerType >( handler ) );
+                                  , std::move( on_save )
+                                  , configuration_.write_quorum()
+                                  , version
+                                  , std::move( pool ) );
         }
     }
 
     /**
-     *
+     *  @param pool If not null, peers shared with lookups of nearby keys.
      */
     template< typename HandlerType >
     void
-    async_load
+    load
         ( key_type const& key
-        , HandlerType && handler )
+        , HandlerType && handler
+        , std::shared_ptr< candidates_pool > pool )
     {
         // If the routing table is empty, save the
         // current request for processing when
@@ -197,40 +648,315 @@ public:
             LOG_DEBUG( engine, this ) << "delaying async load of key '"
                     << to_string( key ) << "'." << std::endl;
 
-            auto t = [ this, key, handler ] ( void ) mutable
-            { async_load( key, std::move( handler ) ); };
+            auto t = [ this, key, handler, pool ] ( void ) mutable
+            { load( key, std::move( handler ), std::move( pool ) ); };
 
             pending_tasks_.push( std::move( t ) );
         }
         else
         {
+            id const key_id{ key };
+
+            // The value may have been recently loaded, unless
+            // more than one replica must agree on it.
+            auto const is_cache_used = configuration_.read_quorum() == 1;
+            if ( auto const cached_data = is_cache_used
+                                        ? value_cache_.find( key_id )
+                                        : nullptr )
+            {
+                LOG_DEBUG( engine, this ) << "loading key '"
+                        << to_string( key ) << "' from cache." << std::endl;
+
+                auto const data = *cached_data;
+                auto on_load = [ handler, data ]( void ) mutable
+                { handler( std::error_code{}, data ); };
+
+                strand_.post( std::move( on_load ) );
+                return;
+            }
+
+            // A multi-key request may have found it meanwhile.
+            data_type prefetched_data;
+            if ( pool && pool->take_value( key_id, prefetched_data ) )
+            {
+                LOG_DEBUG( engine, this ) << "loading key '"
+                        << to_string( key ) << "' from a multi-key request."
+                        << std::endl;
+
+                value_cache_.insert( key_id, prefetched_data );
+
+                auto on_load = [ handler, prefetched_data ]( void ) mutable
+                { handler( std::error_code{}, prefetched_data ); };
+
+                strand_.post( std::move( on_load ) );
+                return;
+            }
+
+            // A lookup of this key is still in flight,
+            // its completion will notify this handler.
+            if ( ! in_flight_loads_.attach( key_id
+                                          , std::forward< HandlerType >( handler ) ) )
+            {
+                LOG_DEBUG( engine, this ) << "coalescing async load of key '"
+                        << to_string( key ) << "'." << std::endl;
+                return;
+            }
+
             LOG_DEBUG( engine, this ) << "executing async load of key '"
                     << to_string( key ) << "'." << std::endl;
 
-            start_find_value_task< data_type >( id( key )
+            auto on_load = [ this, key_id, is_cache_used ]
+                ( std::error_code const& failure
+                , data_type const& data )
+            {
+                if ( ! failure && is_cache_used )
+                    value_cache_.insert( key_id, data );
+
+                in_flight_loads_.notify( key_id, failure, data );
+            };
+
+            start_find_value_task< data_type >( key_id
                                               , tracker_
                                               , routing_table_
-                                              , std::forward< HandlerType >( handler ) );
+                                              , std::move( on_load )
+                                              , get_path_caching_ttl()
+                                              , configuration_.read_quorum()
+                                              , std::move( pool ) );
         }
     }
 
-private:
-    ///
-    using pending_task_type = std::function< void ( void ) >;
+    /**
+     *  @return The longest life of a value cached
+     *          along a lookup path, 0 if disabled.
+     */
+    std::chrono::seconds
+    get_path_caching_ttl
+        ( void )
+        const
+    {
+        using std::chrono::duration_cast;
+        return duration_cast< std::chrono::seconds >( configuration_.path_caching_ttl() );
+    }
 
-    ///
-    using message_socket_type = message_socket< UnderlyingSocketType >;
+    /**
+     *  @brief Forget the entries whose expiration time passed.
+     *  @return The number of entries dropped.
+     */
+    template< typename StoreType >
+    static std::size_t
+    drop_expired_entries
+        ( StoreType & store
+        , typename clock::time_point const& now )
+    {
+        std::size_t dropped_count = 0;
 
-    ///
-    using network_type = network< message_socket_type >;
+        auto i = store.begin();
+        while ( i != store.end() )
+        {
+            if ( i->second.expiration_time_ <= now )
+            {
+                i = store.erase( i );
+                ++ dropped_count;
+            }
+            else
+                ++ i;
+        }
 
-    ///
-    using random_engine_type = std::default_random_engine;
+        return dropped_count;
+    }
 
-    ///
-    using tracker_type = tracker< random_engine_type, network_type >;
+    /**
+     *
+     */
+    void
+    schedule_republish
+        ( void )
+    {
+        auto on_fire = [ this ]( void )
+        {
+            republish_values( clock::now() );
+            schedule_republish();
+        };
+
+        republish_timer_.expires_from_now( configuration_.republish_batch_interval()
+                                         , on_fire );
+    }
+
+    /**
+     *  @brief Periodically measure how long a ready handler
+     *         waits to run to let the message filter shed
+     *         requests when the event loop falls behind.
+     *  @details How late the timer fires isn't measured, as
+     *           the timers of a loop driven by poll() fire
+     *           whenever it is polled, idle or not.
+     */
+    void
+    schedule_event_loop_lag_probe
+        ( void )
+    {
+        auto on_fire = [ this ]( void )
+        {
+            auto const ready_time = clock::now();
+            strand_.post( [ this, ready_time ]( void )
+            {
+                message_filter_.update_event_loop_lag( clock::now() - ready_time );
+                schedule_event_loop_lag_probe();
+            } );
+        };
+
+        event_loop_lag_timer_.expires_from_now( EVENT_LOOP_LAG_PROBE_INTERVAL
+                                              , on_fire );
+    }
+
+    /**
+     *  @return The number of values republished.
+     */
+    std::size_t
+    republish_due_values
+        ( value_store_type & values
+        , configuration::duration_type const& interval
+        , typename clock::time_point const& now
+        , std::size_t & remaining_count
+        , std::size_t & bytes_count )
+    {
+        auto on_republish = [ this ]( std::error_code const& failure )
+        {
+            LOG_DEBUG( engine, this ) << "republish completed ("
+                    << failure.message() << ")." << std::endl;
+        };
+
+        std::size_t republished_count = 0;
+        for ( auto & v : values )
+        {
+            if ( remaining_count == 0 )
+                break;
+
+            // Copies cached along lookup paths are never due.
+            auto & entry = v.second;
+            if ( entry.republish_time_ > now )
+                continue;
+
+            entry.republish_time_ = now + interval;
+
+            data_type data;
+            if ( get_value_data( entry, data ) )
+                continue;
+
+            start_store_value_task( v.first
+                                  , data
+                                  , tracker_
+                                  , routing_table_
+                                  , on_republish
+                                  , configuration_.write_quorum()
+                                  , entry.version_ );
+
+            bytes_count += data.size();
+            ++ republished_count;
+            -- remaining_count;
+        }
+
+        return republished_count;
+    }
+
+    /**
+     *  @brief Version a newly saved value using the wall clock,
+     *         so that quorum reads prefer the latest save.
+     */
+    static std::uint64_t
+    generate_version
+        ( void )
+    {
+        using namespace std::chrono;
+        auto const now = system_clock::now().time_since_epoch();
+        return std::uint64_t( duration_cast< microseconds >( now ).count() );
+    }
+
+    /**
+     *  @brief Forwards the messages decoded by
+     *         decode_request() to the engine.
+     */
+    struct request_handler final
+    {
+        ///
+        void
+        handle_request
+            ( header const& h )
+        { engine_.handle_ping_request( sender_, h ); }
+
+        ///
+        void
+        handle_request
+            ( header const& h
+            , store_value_request_body && request )
+        { engine_.handle_store_request( sender_, h, std::move( request ) ); }
+
+        ///
+        void
+        handle_request
+            ( header const& h
+            , find_peer_request_body && request )
+        { engine_.handle_find_peer_request( sender_, h, request ); }
+
+        ///
+        void
+        handle_request
+            ( header const& h
+            , find_value_request_body && request )
+        { engine_.handle_find_value_request( sender_, h, request ); }
+
+        ///
+        void
+        handle_request
+            ( header const& h
+            , store_chunk_request_body && request )
+        { engine_.handle_store_chunk_request( sender_, h, std::move( request ) ); }
+
+        ///
+        void
+        handle_request
+            ( header const& h
+            , find_chunk_request_body && request )
+        { engine_.handle_find_chunk_request( sender_, h, request ); }
+
+        ///
+        void
+        handle_request
+            ( header const& h
+            , find_values_request_body && request )
+        { engine_.handle_find_values_request( sender_, h, request ); }
+
+        ///
+        void
+        handle_request
+            ( header const& h
+            , store_values_request_body && request )
+        { engine_.handle_store_values_request( sender_, h, std::move( request ) ); }
+
+        ///
+        void
+        handle_invalid_request
+            ( header const& h
+            , std::error_code const& failure )
+        {
+            LOG_DEBUG( engine, &engine_ )
+                    << "failed to deserialize " << h.type_ << " ("
+                    << failure.message() << ")." << std::endl;
+        }
+
+        ///
+        void
+        handle_response
+            ( header const& h
+            , buffer::const_iterator i
+            , buffer::const_iterator e )
+        { engine_.tracker_.handle_new_response( sender_, h, i, e ); }
+
+        ///
+        engine & engine_;
+        ///
+        ip_endpoint const& sender_;
+    };
 
-private:
     /**
      *
      */
@@ -241,24 +967,8 @@ private:
         , buffer::const_iterator i
         , buffer::const_iterator e )
     {
-        switch ( h.type_ )
-        {
-            case header::PING_REQUEST:
-                handle_ping_request( sender, h );
-                break;
-            case header::STORE_REQUEST:
-                handle_store_request( sender, h, i, e );
-                break;
-            case header::FIND_PEER_REQUEST:
-                handle_find_peer_request( sender, h, i, e );
-                break;
-            case header::FIND_VALUE_REQUEST:
-                handle_find_value_request( sender, h, i, e );
-                break;
-            default:
-                tracker_.handle_new_response( sender, h, i, e );
-                break;
-        }
+        request_handler handler{ *this, sender };
+        decode_request( h, i, e, handler );
     }
 
     /**
@@ -283,50 +993,131 @@ private:
     handle_store_request
         ( ip_endpoint const& sender
         , header const& h
-        , buffer::const_iterator i
-        , buffer::const_iterator e )
+        , store_value_request_body && request )
     {
         LOG_DEBUG( engine, this ) << "handling store request."
                 << std::endl;
 
-        store_value_request_body request;
-        if ( auto failure = deserialize( i, e, request ) )
+        // Keep the value compressed, once checked,
+        // so serving it needs no recompression.
+        data_type data;
+        if ( h.is_compressed_ && decompress( request.data_value_, data ) )
         {
             LOG_DEBUG( engine, this )
-                    << "failed to deserialize store value request ("
-                    << failure.message() << ")." << std::endl;
+                    << "ignoring corrupted compressed value." << std::endl;
 
             return;
         }
 
-        value_store_[ request.data_key_hash_ ]
-                = std::move( request.data_value_ );
+        store_value( request.data_key_hash_
+                   , std::move( request.data_value_ )
+                   , request.ttl_
+                   , request.version_
+                   , h.is_compressed_ );
+
+        // Path caching and read-repair stores go unacknowledged.
+        if ( request.is_acknowledgement_requested_ )
+            tracker_.send_response( h.random_token_
+                                  , store_value_response_body{}
+                                  , sender );
+    }
+
+    /**
+     *  @brief Store a value sent by a peer, unless
+     *         a newer version is already known or
+     *         path caching is disabled for a copy.
+     *  @param ttl Time to live of a cached copy, 0 if
+     *         the value doesn't expire.
+     */
+    void
+    store_value
+        ( id const& key
+        , data_type data
+        , std::chrono::seconds const& ttl
+        , std::uint64_t version
+        , bool is_compressed )
+    {
+        auto const now = clock::now();
+        auto expiration_time = clock::time_point::max();
+        auto republish_time = clock::time_point::max();
+
+        // This is a copy cached by a lookup.
+        if ( ttl.count() > 0 )
+        {
+            auto const path_caching_ttl = get_path_caching_ttl();
+            if ( path_caching_ttl.count() == 0 )
+                return;
+
+            expiration_time = now + std::min( ttl, path_caching_ttl );
+        }
+        // Another peer just republished this value,
+        // hence there is no need to republish it soon.
+        else
+            republish_time = now + configuration_.replica_republish_interval();
+
+        auto const known = value_store_.find( key );
+        bool const is_outdated = known != value_store_.end()
+                && ( known->second.version_ > version
+                     // Don't shorten the life of an already known value.
+                   || ( ttl.count() > 0
+                      && known->second.version_ == version
+                      && known->second.expiration_time_ >= expiration_time ) );
+
+        if ( is_outdated )
+            return;
+
+        if ( known != value_store_.end()
+           && known->second.expiration_time_ == clock::time_point::max()
+           && republish_time != clock::time_point::max() )
+            ++ postponed_republishes_count_;
+
+        value_store_[ key ] = value_store_entry_type{ std::move( data )
+                                                    , expiration_time
+                                                    , version
+                                                    , republish_time
+                                                    , is_compressed
+                                                    , {}
+                                                    , 0 };
     }
 
     /**
      *
      */
     void
-    handle_find_peer_request
+    handle_store_values_request
         ( ip_endpoint const& sender
         , header const& h
-        , buffer::const_iterator i
-        , buffer::const_iterator e )
+        , store_values_request_body && request )
     {
-        LOG_DEBUG( engine, this ) << "handling find peer request."
+        LOG_DEBUG( engine, this ) << "handling store values request."
                 << std::endl;
 
-        // Ensure the request is valid.
-        find_peer_request_body request;
-        if ( auto failure = deserialize( i, e, request ) )
+        store_values_response_body response;
+        for ( auto & v : request.values_ )
         {
-            LOG_DEBUG( engine, this )
-                    << "failed to deserialize find peer request ("
-                    << failure.message() << ")" << std::endl;
-
-            return;
+            store_value( v.data_key_hash_
+                       , std::move( v.data_value_ )
+                       , std::chrono::seconds::zero()
+                       , v.version_
+                       , false );
+            response.stored_keys_.push_back( v.data_key_hash_ );
         }
 
+        tracker_.send_response( h.random_token_, response, sender );
+    }
+
+    /**
+     *
+     */
+    void
+    handle_find_peer_request
+        ( ip_endpoint const& sender
+        , header const& h
+        , find_peer_request_body const& request )
+    {
+        LOG_DEBUG( engine, this ) << "handling find peer request."
+                << std::endl;
+
         send_find_peer_response( sender
                                , h.random_token_
                                , request.peer_to_find_id_ );
@@ -345,15 +1136,23 @@ private:
         // their location into the response..
         find_peer_response_body response;
 
-        auto remaining_peer = ROUTING_TABLE_BUCKET_SIZE;
+        auto remaining_peer = configuration_.k_bucket_size();
         for ( auto i = routing_table_.find( peer_to_find_id )
                  , e = routing_table_.end()
             ; i != e && remaining_peer > 0
             ; ++i, -- remaining_peer )
             response.peers_.push_back( { i->first, i->second } );
 
-        // Now send the response.
-        tracker_.send_response( random_token, response, sender );
+        // Now send the response, compacted if the sender
+        // will read it with a V2 header.
+        if ( tracker_.get_peer_version( sender ) < header::V2 )
+            tracker_.send_response( random_token, response, sender );
+        else
+        {
+            find_peer_compact_response_body const compact_response
+                    { peer_to_find_id, std::move( response.peers_ ) };
+            tracker_.send_response( random_token, compact_response, sender );
+        }
     }
 
     /**
@@ -363,34 +1162,602 @@ private:
     handle_find_value_request
         ( ip_endpoint const& sender
         , header const& h
-        , buffer::const_iterator i
-        , buffer::const_iterator e )
+        , find_value_request_body const& request )
     {
         LOG_DEBUG( engine, this ) << "handling find value request."
                 << std::endl;
 
-        find_value_request_body request;
-        if ( auto failure = deserialize( i, e, request ) )
+        auto const found = find_stored_value( request.value_to_find_ );
+        if ( found == value_store_.end() )
+            send_find_peer_response( sender
+                                   , h.random_token_
+                                   , request.value_to_find_ );
+        // Large values are fetched by chunks, V1 peers don't
+        // know them hence get the value if it fits. Otherwise
+        // they would read the manifest as an empty value, so
+        // they are answered as if the value were unknown.
+        else if ( get_value_size( found->second ) > CHUNK_SIZE )
+        {
+            if ( tracker_.get_peer_version( sender ) < header::V2 )
+            {
+                find_value_response_body response{ data_type{}
+                                                 , found->second.version_ };
+                if ( get_value_data( found->second, response.data_ ) )
+                    return;
+
+                if ( fits_in_datagram( response ) )
+                    tracker_.send_response( h.random_token_
+                                          , response
+                                          , sender );
+                else
+                    send_find_peer_response( sender
+                                           , h.random_token_
+                                           , request.value_to_find_ );
+                return;
+            }
+
+            find_value_response_body const manifest{ data_type{}
+                                                   , found->second.version_
+                                                   , get_value_size( found->second ) };
+            tracker_.send_response( h.random_token_
+                                  , manifest
+                                  , sender );
+        }
+        // Peers supporting compression get the value as stored.
+        else if ( ! found->second.is_compressed_
+                || tracker_.get_peer_version( sender ) >= header::V3 )
+        {
+            find_value_response_body const response{ found->second.data_
+                                                    , found->second.version_
+                                                    , 0
+                                                    , found->second.is_compressed_ };
+            tracker_.send_response( h.random_token_
+                                  , response
+                                  , sender );
+        }
+        else
+        {
+            find_value_response_body response{ data_type{}
+                                             , found->second.version_ };
+            if ( get_value_data( found->second, response.data_ ) )
+                return;
+
+            tracker_.send_response( h.random_token_
+                                  , response
+                                  , sender );
+        }
+    }
+
+    /**
+     *  @brief Copy the uncompressed data of entry into data.
+     */
+    static std::error_code
+    get_value_data
+        ( value_store_entry_type const& entry
+        , data_type & data )
+    {
+        if ( entry.chunks_.empty() )
+        {
+            if ( ! entry.is_compressed_ )
+            {
+                data = entry.data_;
+                return std::error_code{};
+            }
+
+            return decompress( entry.data_, data );
+        }
+
+        data.clear();
+        data.reserve( entry.chunked_value_size_ );
+
+        data_type chunk;
+        for ( auto const& c : entry.chunks_ )
+        {
+            if ( ! c.is_compressed_ )
+                data.insert( data.end(), c.data_.begin(), c.data_.end() );
+            else if ( auto failure = decompress( c.data_, chunk ) )
+                return failure;
+            else
+                data.insert( data.end(), chunk.begin(), chunk.end() );
+        }
+
+        return std::error_code{};
+    }
+
+    /**
+     *  @return The size of the value of entry, once uncompressed.
+     *  @note A value compressed within a single message
+     *        is never larger than CHUNK_SIZE.
+     */
+    static std::size_t
+    get_value_size
+        ( value_store_entry_type const& entry )
+    {
+        return entry.chunks_.empty() ? entry.data_.size()
+                                     : entry.chunked_value_size_;
+    }
+
+    /**
+     *  @return The value stored for key, forgetting
+     *          cached copies once expired.
+     */
+    typename value_store_type::iterator
+    find_stored_value
+        ( id const& key )
+    {
+        auto found = value_store_.find( key );
+
+        if ( found != value_store_.end()
+           && found->second.expiration_time_ <= clock::now() )
+        {
+            value_store_.erase( found );
+            found = value_store_.end();
+        }
+
+        return found;
+    }
+
+    /**
+     *  @brief Answer as many keys as fit in a single datagram.
+     *  @details Values stored by chunks are left out, their
+     *           requester must look them up one at a time.
+     */
+    void
+    handle_find_values_request
+        ( ip_endpoint const& sender
+        , header const& h
+        , find_values_request_body const& request )
+    {
+        LOG_DEBUG( engine, this ) << "handling find values request."
+                << std::endl;
+
+        find_values_response_body response;
+        auto remaining_size = get_multi_key_body_max_size( response );
+
+        for ( auto const& key : request.values_to_find_ )
+        {
+            find_values_result result{ key, false, data_type{}, 0, {} };
+
+            auto const found = find_stored_value( key );
+            if ( found == value_store_.end() )
+            {
+                auto remaining_peer = configuration_.concurrent_requests_count();
+                for ( auto p = routing_table_.find( key )
+                         , p_end = routing_table_.end()
+                    ; p != p_end && remaining_peer > 0
+                    ; ++p, -- remaining_peer )
+                    result.peers_.push_back( { p->first, p->second } );
+            }
+            else if ( get_value_size( found->second ) > CHUNK_SIZE
+                    || get_value_data( found->second, result.data_ ) )
+                continue;
+            else
+            {
+                result.is_found_ = true;
+                result.version_ = found->second.version_;
+            }
+
+            auto const result_size = get_serialized_size( result );
+            if ( result_size > remaining_size )
+                continue;
+
+            remaining_size -= result_size;
+            response.results_.push_back( std::move( result ) );
+        }
+
+        tracker_.send_response( h.random_token_, response, sender );
+    }
+
+    /**
+     *  @return The room left for the elements of body
+     *          within a multi-key message.
+     */
+    template< typename MessageBodyType >
+    static std::size_t
+    get_multi_key_body_max_size
+        ( MessageBodyType const& empty_body )
+    {
+        return MULTI_KEY_MESSAGE_MAX_SIZE
+                - get_serialized_size( header{} )
+                - get_serialized_size( empty_body );
+    }
+
+    /**
+     *  @brief Ask a peer of pool for the values of keys with
+     *         multi-key requests, and keep the values found
+     *         in pool.
+     *  @details The peer closest to the first key and not known
+     *           to only speak V1 is asked. Keys are split among
+     *           requests fitting a single datagram.
+     */
+    void
+    prefetch_values
+        ( std::vector< id > const& keys
+        , std::shared_ptr< candidates_pool > pool
+        , std::function< void ( void ) > on_completion )
+    {
+        std::vector< peer > candidates
+                = pool->find_closest( keys.front(), configuration_.k_bucket_size() );
+        auto const is_v1 = [ this ]( peer const& p )
+        {
+            auto version = header::V2;
+            tracker_.find_peer_version( p.endpoint_, version );
+            return version < header::V2;
+        };
+        auto const target = std::find_if_not( candidates.begin()
+                                            , candidates.end()
+                                            , is_v1 );
+        if ( target == candidates.end() )
+        {
+            on_completion();
+            return;
+        }
+
+        auto const keys_per_request
+                = get_multi_key_body_max_size( find_values_request_body{} )
+                / id::BLOCKS_COUNT;
+        auto const requests_count = get_chunks_count( keys.size()
+                                                    , keys_per_request );
+        auto const remaining_count
+                = std::make_shared< std::size_t >( requests_count );
+        auto const peer_id = target->id_;
+        auto const peer_endpoint = target->endpoint_;
+
+        auto on_done = [ remaining_count, on_completion ]( void )
+        {
+            if ( -- *remaining_count == 0 )
+                on_completion();
+        };
+
+        auto on_response = [ pool, on_done ]
+            ( endpoint_type const&
+            , header const& h
+            , buffer::const_iterator i
+            , buffer::const_iterator e )
+        {
+            find_values_response_body response;
+            if ( h.type_ == header::FIND_VALUES_RESPONSE
+               && ! deserialize( i, e, response ) )
+            {
+                for ( auto & r : response.results_ )
+                {
+                    if ( r.is_found_ )
+                        pool->add_value( r.key_, std::move( r.data_ ) );
+                    else
+                        for ( auto const& p : r.peers_ )
+                            pool->add( p );
+                }
+            }
+
+            on_done();
+        };
+
+        // A peer silently drops messages of versions it doesn't
+        // know, hence try an older version next time.
+        auto on_error = [ this, pool, peer_id, peer_endpoint, on_done ]
+            ( std::error_code const& )
+        {
+            pool->remove( peer_id );
+            auto version = get_latest_version();
+            tracker_.find_peer_version( peer_endpoint, version );
+            if ( version > header::V1 )
+                tracker_.record_peer_version( peer_endpoint
+                                            , header::version( version - 1 ) );
+
+            on_done();
+        };
+
+        for ( std::size_t r = 0; r != requests_count; ++ r )
+        {
+            auto const first = keys.begin() + r * keys_per_request;
+            auto const last = keys.begin()
+                    + std::min( keys.size(), ( r + 1 ) * keys_per_request );
+
+            find_values_request_body const request{ std::vector< id >( first, last ) };
+            tracker_.send_request( request
+                                 , target->endpoint_
+                                 , configuration_.peer_lookup_timeout()
+                                 , on_response
+                                 , on_error );
+        }
+    }
+
+    /**
+     *  @brief Store values on the peers of pool closest to their
+     *         keys with multi-key requests, and keep in pool the
+     *         versions acknowledged by the write quorum.
+     *  @details As for a single value, each value is sent to the
+     *           redundant save count closest peers not known to
+     *           only speak V1. The values sent to a peer are split
+     *           among requests fitting a single datagram, and values
+     *           stored by chunks are left to their own save.
+     */
+    void
+    prestore_values
+        ( std::vector< stored_value > const& values
+        , std::shared_ptr< candidates_pool > pool
+        , std::function< void ( void ) > on_completion )
+    {
+        auto const is_v1 = [ this ]( peer const& p )
+        {
+            auto version = header::V2;
+            tracker_.find_peer_version( p.endpoint_, version );
+            return version < header::V2;
+        };
+
+        auto const max_size = get_multi_key_body_max_size( store_values_request_body{} );
+        auto const redundant_save_count = configuration_.redundant_save_count();
+
+        // Pack the values by replica.
+        std::map< id, std::pair< peer, std::vector< store_values_request_body > > > requests;
+        std::map< id, std::size_t > remaining_sizes;
+        for ( auto const& v : values )
+        {
+            auto const value_size = get_serialized_size( v );
+            if ( v.data_value_.size() > CHUNK_SIZE || value_size > max_size )
+                continue;
+
+            auto candidates = pool->find_closest( v.data_key_hash_
+                                                , configuration_.k_bucket_size() );
+            candidates.erase( std::remove_if( candidates.begin()
+                                            , candidates.end()
+                                            , is_v1 )
+                            , candidates.end() );
+            if ( candidates.size() > redundant_save_count )
+                candidates.resize( redundant_save_count );
+
+            for ( auto const& c : candidates )
+            {
+                auto & replica = requests[ c.id_ ];
+                auto & remaining_size = remaining_sizes[ c.id_ ];
+                if ( replica.second.empty() || value_size > remaining_size )
+                {
+                    replica.first = c;
+                    replica.second.emplace_back();
+                    remaining_size = max_size;
+                }
+
+                replica.second.back().values_.push_back( v );
+                remaining_size -= value_size;
+            }
+        }
+
+        std::size_t requests_count = 0;
+        for ( auto const& replica : requests )
+            requests_count += replica.second.second.size();
+
+        if ( requests_count == 0 )
+        {
+            on_completion();
+            return;
+        }
+
+        auto const remaining_count
+                = std::make_shared< std::size_t >( requests_count );
+        auto const acknowledgements
+                = std::make_shared< std::map< id, std::size_t > >();
+        auto const write_quorum = std::max< std::size_t >
+                ( 1, std::min( configuration_.write_quorum(), redundant_save_count ) );
+
+        auto on_done = [ values, pool, remaining_count, acknowledgements
+                       , write_quorum, on_completion ]( void )
+        {
+            if ( -- *remaining_count != 0 )
+                return;
+
+            for ( auto const& v : values )
+                if ( ( *acknowledgements )[ v.data_key_hash_ ] >= write_quorum )
+                    pool->add_stored_version( v.data_key_hash_, v.version_ );
+
+            on_completion();
+        };
+
+        for ( auto const& replica : requests )
+        {
+            auto const peer_id = replica.first;
+            auto const peer_endpoint = replica.second.first.endpoint_;
+
+            for ( auto const& request : replica.second.second )
+            {
+                std::vector< id > sent_keys;
+                for ( auto const& v : request.values_ )
+                    sent_keys.push_back( v.data_key_hash_ );
+
+                // Only the keys sent to this peer are counted.
+                auto on_response = [ sent_keys, acknowledgements, on_done ]
+                    ( endpoint_type const&
+                    , header const& h
+                    , buffer::const_iterator i
+                    , buffer::const_iterator e )
+                {
+                    store_values_response_body response;
+                    if ( h.type_ == header::STORE_VALUES_RESPONSE
+                       && ! deserialize( i, e, response ) )
+                    {
+                        for ( auto const& key : sent_keys )
+                            if ( std::find( response.stored_keys_.begin()
+                                          , response.stored_keys_.end()
+                                          , key )
+                                 != response.stored_keys_.end() )
+                                ++ ( *acknowledgements )[ key ];
+                    }
+
+                    on_done();
+                };
+
+                // A peer silently drops messages of versions it doesn't
+                // know, hence try an older version next time.
+                auto on_error = [ this, pool, peer_id, peer_endpoint, on_done ]
+                    ( std::error_code const& )
+                {
+                    pool->remove( peer_id );
+                    auto version = get_latest_version();
+                    tracker_.find_peer_version( peer_endpoint, version );
+                    if ( version > header::V1 )
+                        tracker_.record_peer_version( peer_endpoint
+                                                    , header::version( version - 1 ) );
+
+                    on_done();
+                };
+
+                tracker_.send_request( request
+                                     , peer_endpoint
+                                     , configuration_.peer_lookup_timeout()
+                                     , on_response
+                                     , on_error );
+            }
+        }
+    }
+
+    /**
+     *  @brief Keep a chunk at its place in the value
+     *         and store the value once complete.
+     *  @details Chunks are kept compressed, once checked,
+     *           so serving them needs no recompression.
+     */
+    void
+    handle_store_chunk_request
+        ( ip_endpoint const& sender
+        , header const& h
+        , store_chunk_request_body && request )
+    {
+        auto chunk_size = request.chunk_.size();
+        if ( h.is_compressed_ )
+        {
+            data_type chunk;
+            if ( decompress( request.chunk_, chunk ) )
+            {
+                LOG_DEBUG( engine, this )
+                        << "ignoring corrupted compressed chunk." << std::endl;
+
+                return;
+            }
+
+            chunk_size = chunk.size();
+        }
+
+        auto const value_size = request.value_size_;
+        auto const chunks_count = get_chunks_count( value_size, CHUNK_SIZE );
+        auto const offset = request.chunk_index_ * CHUNK_SIZE;
+        if ( value_size <= CHUNK_SIZE
+           || value_size > CHUNKED_VALUE_MAX_SIZE
+           || request.chunk_index_ >= chunks_count
+           || chunk_size
+                != std::min< std::uint64_t >( CHUNK_SIZE, value_size - offset ) )
         {
             LOG_DEBUG( engine, this )
-                    << "failed to deserialize find value request ("
-                    << failure.message() << ")" << std::endl;
+                    << "ignoring invalid store chunk request." << std::endl;
 
             return;
         }
 
-        auto found = value_store_.find( request.value_to_find_ );
-        if ( found == value_store_.end() )
+        auto const now = clock::now();
+        auto const key = request.data_key_hash_;
+
+        auto const known = value_store_.find( key );
+        if ( known != value_store_.end()
+           && known->second.version_ >= request.version_ )
+        {
+            // Another peer just republished this value.
+            if ( known->second.version_ == request.version_
+               && request.chunk_index_ == 0 )
+            {
+                known->second.republish_time_
+                        = now + configuration_.replica_republish_interval();
+                ++ postponed_republishes_count_;
+            }
+        }
+        else
+        {
+            typename chunked_value_assemblies_type::chunks_type chunks;
+            auto const status = chunked_value_assemblies_.add_chunk
+                    ( key
+                    , sender.address_
+                    , request.version_
+                    , value_size
+                    , request.chunk_index_
+                    , std::move( request.chunk_ )
+                    , h.is_compressed_
+                    , now
+                    , chunks );
+
+            // Without an ack, the sender gives this replica up.
+            if ( status == chunked_value_assemblies_type::CHUNK_REFUSED )
+            {
+                LOG_DEBUG( engine, this )
+                        << "refusing store chunk request." << std::endl;
+
+                return;
+            }
+
+            if ( status == chunked_value_assemblies_type::VALUE_COMPLETED )
+                value_store_[ key ]
+                        = value_store_entry_type{ data_type{}
+                                                , clock::time_point::max()
+                                                , request.version_
+                                                , now
+                                                  + configuration_.replica_republish_interval()
+                                                , false
+                                                , std::move( chunks )
+                                                , value_size };
+        }
+
+        tracker_.send_response( h.random_token_
+                              , store_value_response_body{}
+                              , sender );
+    }
+
+    /**
+     *
+     */
+    void
+    handle_find_chunk_request
+        ( ip_endpoint const& sender
+        , header const& h
+        , find_chunk_request_body const& request )
+    {
+        auto const found = value_store_.find( request.data_key_hash_ );
+        if ( found == value_store_.end()
+           || found->second.version_ != request.version_
+           // Compressed values fit a single datagram.
+           || found->second.is_compressed_
+           || request.chunk_index_
+                >= get_chunks_count( get_value_size( found->second ), CHUNK_SIZE ) )
+        {
+            // Let the requester try another peer right away.
             send_find_peer_response( sender
                                    , h.random_token_
-                                   , request.value_to_find_ );
+                                   , request.data_key_hash_ );
+            return;
+        }
+
+        find_chunk_response_body response{ request.chunk_index_ };
+
+        auto const& entry = found->second;
+        // A V1 peer stored the value whole.
+        if ( entry.chunks_.empty() )
+        {
+            auto const begin = std::next( entry.data_.begin()
+                                        , request.chunk_index_ * CHUNK_SIZE );
+            auto const size = std::size_t( std::distance( begin, entry.data_.end() ) );
+            response.chunk_.assign( begin, std::next( begin, std::min( CHUNK_SIZE
+                                                                     , size ) ) );
+        }
+        // Peers supporting compression get the chunk as stored.
         else
         {
-            find_value_response_body const response{ found->second };
-            tracker_.send_response( h.random_token_
-                                  , response
-                                  , sender );
+            auto const& chunk = entry.chunks_[ request.chunk_index_ ];
+            if ( ! chunk.is_compressed_
+               || tracker_.get_peer_version( sender ) >= header::V3 )
+            {
+                response.chunk_ = chunk.data_;
+                response.is_compressed_ = chunk.is_compressed_;
+            }
+            else if ( decompress( chunk.data_, response.chunk_ ) )
+                return;
         }
+
+        tracker_.send_response( h.random_token_, response, sender );
     }
 
     /**
@@ -473,18 +1840,35 @@ private:
         LOG_DEBUG( engine, this ) << "received new message from '"
                 << sender << "'." << std::endl;
 
+        auto is_awaited_response = [ this ]
+            ( id const& response_id )
+        { return tracker_.is_awaited_response( response_id ); };
+
         detail::header h;
-        // Try to deserialize header.
-        if ( auto failure = deserialize( i, e, h ) )
+        // Drop invalid, unsolicited or flooding messages
+        // before they update the routing table.
+        if ( ! message_filter_.accept( sender, i, e, h
+                                     , message_filter::clock::now()
+                                     , is_awaited_response ) )
         {
-            LOG_DEBUG( engine, this )
-                    << "failed to deserialize message header ("
-                    << failure.message() << ")" << std::endl;
+            LOG_DEBUG( engine, this ) << "dropping message from '"
+                    << sender << "'." << std::endl;
             return;
         }
 
         routing_table_.push( h.source_id_, sender );
 
+        // Peers send V1 messages with a V1 header until they
+        // learn our version, hence only upgrades are recorded.
+        auto const sender_version = get_sender_version( h, i, e );
+        // Peers still talking keep their version.
+        auto known_version = header::V1;
+        tracker_.find_peer_version( sender, known_version );
+        if ( sender_version > known_version )
+            tracker_.record_peer_version( sender, sender_version );
+        else
+            tracker_.touch_peer_version( sender );
+
         process_new_message( sender, h, i, e );
 
         // A message has been received, hence the connection
@@ -516,6 +1900,11 @@ private:
     }
 
 private:
+    /// Serializes the handlers of this engine only, hence
+    /// the engines sharing a io_service run in parallel.
+    strand strand_;
+    ///
+    configuration const configuration_;
     ///
     random_engine_type random_engine_;
     ///
@@ -525,6 +1914,10 @@ private:
     ///
     tracker_type tracker_;
     ///
+    message_filter message_filter_;
+    ///
+    timer event_loop_lag_timer_;
+    ///
     routing_table_type routing_table_;
     ///
     value_store_type value_store_;
@@ -532,6 +1925,22 @@ private:
     bool is_connected_;
     ///
     std::queue< pending_task_type > pending_tasks_;
+    ///
+    in_flight_requests< save_request_type, save_handler_type > in_flight_saves_;
+    ///
+    in_flight_requests< id, load_handler_type > in_flight_loads_;
+    ///
+    value_cache_type value_cache_;
+    /// Values saved by this engine, until their ttl passed.
+    value_store_type published_values_;
+    ///
+    timer republish_timer_;
+    ///
+    republish_statistics republish_statistics_;
+    ///
+    std::size_t postponed_republishes_count_;
+    ///
+    chunked_value_assemblies_type chunked_value_assemblies_;
 };
 
 } // namespace detail
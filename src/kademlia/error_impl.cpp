@@ -88,6 +88,12 @@ struct kademlia_error_category : std::error_category
                 return "timer malfunction";
             case ALREADY_RUNNING:
                 return "already running";
+            case QUORUM_NOT_REACHED:
+                return "quorum not reached";
+            case UNKNOWN_TENANT:
+                return "unknown tenant";
+            case INVALID_CONFIGURATION:
+                return "invalid configuration";
             default:
                 return "unknown error";
         }
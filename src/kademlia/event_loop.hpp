@@ -0,0 +1,287 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_EVENT_LOOP_HPP
+#define KADEMLIA_EVENT_LOOP_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <boost/asio/basic_waitable_timer.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include "kademlia/error_impl.hpp"
+#include "kademlia/constants.hpp"
+#include "kademlia/concurrent_guard.hpp"
+#include "kademlia/strand.hpp"
+#include "kademlia/submission_queue.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class runs the io_service shared by
+ *         the engines of a session or a host.
+ *  @details The application threads submit their requests
+ *           through the submission queue, which hands them
+ *           over to the strand of their engine.
+ */
+class event_loop
+{
+public:
+    /**
+     *
+     */
+    std::error_code
+    run
+        ( void )
+    { return run_with_threads( 1 ); }
+
+    /**
+     *  @brief Run the io_service on threads_count threads,
+     *         the calling one included.
+     *  @details The handlers of each engine are serialized
+     *           by its strand when threads_count is above 1,
+     *           distinct engines run in parallel.
+     */
+    std::error_code
+    run_with_threads
+        ( std::size_t threads_count )
+    {
+        // Protect against concurrent invocation of this method.
+        detail::concurrent_guard::sentry s{ concurrent_guard_ };
+        if ( ! s )
+            return make_error_code( ALREADY_RUNNING );
+
+        return run_until_stopped( threads_count );
+    }
+
+    /**
+     *  @brief Run the io_service on the calling thread
+     *         until abort() is called or duration elapsed.
+     *  @return RUN_ABORTED if aborted, no error otherwise.
+     */
+    std::error_code
+    run_for
+        ( std::chrono::milliseconds const& duration )
+    {
+        detail::concurrent_guard::sentry s{ concurrent_guard_ };
+        if ( ! s )
+            return make_error_code( ALREADY_RUNNING );
+
+        // A deadline cancelled by an abort completes with
+        // operation_aborted during a following run.
+        auto on_deadline = [ this ]( boost::system::error_code const& failure )
+        {
+            if ( ! failure )
+                io_service_.stop();
+        };
+
+        run_deadline_.expires_from_now( duration );
+        run_deadline_.async_wait( on_deadline );
+
+        auto const result = run_until_stopped( 1 );
+        run_deadline_.cancel();
+
+        return result;
+    }
+
+    /**
+     *  @brief Execute the ready handlers on the calling thread
+     *         without blocking.
+     *  @details This allows an application to drive the session
+     *           from its own event loop, calling this method
+     *           periodically. abort() has no effect on this call.
+     */
+    std::error_code
+    poll
+        ( void )
+    {
+        detail::concurrent_guard::sentry s{ concurrent_guard_ };
+        if ( ! s )
+            return make_error_code( ALREADY_RUNNING );
+
+        io_service_.reset();
+        get_strand_service( io_service_ ).set_concurrent( false );
+        io_service_.poll();
+
+        return std::error_code{};
+    }
+
+    /**
+     *  @details This method can be called from any thread,
+     *           including an handler. An abort requested while
+     *           the session isn't running aborts the next run.
+     */
+    void
+    abort
+        ( void )
+    {
+        is_abort_requested_ = true;
+        // Stopping the io_service wakes up
+        // the threads waiting for a handler.
+        io_service_.stop();
+    }
+
+private:
+    /**
+     *  @return RUN_ABORTED if an abort was requested,
+     *          no error if the io_service was stopped otherwise.
+     */
+    std::error_code
+    run_until_stopped
+        ( std::size_t threads_count )
+    {
+        io_service_.reset();
+
+        // abort() sets the flag before stopping the io_service,
+        // so an abort stopping the io_service before the reset
+        // is seen here.
+        if ( is_abort_requested_.exchange( false ) )
+            return make_error_code( RUN_ABORTED );
+
+        get_strand_service( io_service_ ).set_concurrent( threads_count > 1 );
+
+        // The first failure of a thread stops the others
+        // and is reported to the caller.
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+        auto run_loop = [ this, &failure, &failure_mutex ]( void )
+        {
+            try
+            {
+                io_service_.run();
+            }
+            catch ( ... )
+            {
+                std::lock_guard< std::mutex > lock{ failure_mutex };
+                if ( ! failure )
+                    failure = std::current_exception();
+
+                io_service_.stop();
+            }
+        };
+
+        {
+            // Keep the threads blocked while there is no handler,
+            // until stop() is called.
+            boost::asio::io_service::work work{ io_service_ };
+
+            std::vector< std::thread > workers;
+            for ( std::size_t i = 1; i < threads_count; ++ i )
+                workers.emplace_back( run_loop );
+
+            run_loop();
+
+            for ( auto & w : workers )
+                w.join();
+        }
+
+        auto const is_aborted = is_abort_requested_.exchange( false );
+
+        if ( failure )
+            std::rethrow_exception( failure );
+
+        if ( is_aborted )
+            return make_error_code( RUN_ABORTED );
+
+        return std::error_code{};
+    }
+
+protected:
+    /**
+     *
+     */
+    event_loop
+        ( void )
+            : io_service_{}
+            , submissions_{ get_default_strand( io_service_ )
+                          , SUBMISSION_BATCH_SIZE }
+            , run_deadline_{ io_service_ }
+            , is_abort_requested_{}
+            , concurrent_guard_{}
+    { }
+
+    /**
+     *
+     */
+    ~event_loop
+        ( void )
+        = default;
+
+    /**
+     *
+     */
+    boost::asio::io_service &
+    get_io_service
+        ( void )
+    { return io_service_; }
+
+    /**
+     *  @brief Protects the calls which require the
+     *         io_service not to be running.
+     */
+    detail::concurrent_guard &
+    get_concurrent_guard
+        ( void )
+    { return concurrent_guard_; }
+
+    /**
+     *  @brief Execute task on s, the strand of an engine.
+     *  @details This method can be called from any thread.
+     */
+    template< typename TaskType >
+    void
+    submit
+        ( strand & s
+        , TaskType && task )
+    { submissions_.push( s.wrap( std::forward< TaskType >( task ) ) ); }
+
+private:
+    ///
+    boost::asio::io_service io_service_;
+    ///
+    submission_queue submissions_;
+    /// Stops the io_service at the end of a run_for().
+    boost::asio::basic_waitable_timer< std::chrono::steady_clock > run_deadline_;
+    ///
+    std::atomic< bool > is_abort_requested_;
+    ///
+    detail::concurrent_guard concurrent_guard_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
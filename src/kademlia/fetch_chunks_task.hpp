@@ -0,0 +1,387 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_FETCH_CHUNKS_TASK_HPP
+#define KADEMLIA_FETCH_CHUNKS_TASK_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+
+#include "kademlia/error_impl.hpp"
+
+#include "kademlia/log.hpp"
+#include "kademlia/constants.hpp"
+#include "kademlia/message.hpp"
+#include "kademlia/compression.hpp"
+#include "kademlia/peer.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class fetches the chunks of a value
+ *         too large to be sent within a single message.
+ *  @details Up to the configured chunk window size of requests
+ *           are in flight, spread over the peers holding the value.
+ *           A peer that fails to provide a chunk is no longer queried
+ *           and its chunk is requested from another one. Chunks are copied
+ *           straight from the received messages to their place in
+ *           the value, which grows as its chunks are requested rather
+ *           than being allocated whole from an untrusted manifest.
+ */
+template< typename LoadHandlerType, typename TrackerType, typename DataType >
+class fetch_chunks_task final
+    : public boost::intrusive_ref_counter< fetch_chunks_task< LoadHandlerType, TrackerType, DataType >
+                                        , boost::thread_unsafe_counter >
+{
+public:
+    ///
+    using load_handler_type = LoadHandlerType;
+
+    ///
+    using tracker_type = TrackerType;
+
+    ///
+    using data_type = DataType;
+
+public:
+    /**
+     *
+     */
+    static boost::intrusive_ptr< fetch_chunks_task >
+    start
+        ( id const& key
+        , std::uint64_t version
+        , std::size_t value_size
+        , std::vector< peer > const& holders
+        , tracker_type & tracker
+        , load_handler_type handler )
+    {
+        boost::intrusive_ptr< fetch_chunks_task > t;
+        t.reset( new fetch_chunks_task( key
+                                      , version
+                                      , value_size
+                                      , holders
+                                      , tracker
+                                      , std::move( handler ) ) );
+
+        fill_window( t );
+
+        return t;
+    }
+
+    /**
+     *  @brief Also fetch chunks from holder.
+     */
+    static void
+    add_holder
+        ( boost::intrusive_ptr< fetch_chunks_task > task
+        , peer const& holder )
+    {
+        if ( task->is_finished_ || task->find_holder( holder.id_ )
+                                   != task->holders_.end() )
+            return;
+
+        task->holders_.push_back( holder );
+        fill_window( task );
+    }
+
+    /**
+     *
+     */
+    std::uint64_t
+    get_version
+        ( void )
+        const
+    { return version_; }
+
+    /**
+     *
+     */
+    std::size_t
+    get_value_size
+        ( void )
+        const
+    { return value_size_; }
+
+private:
+    /**
+     *
+     */
+    fetch_chunks_task
+        ( id const& key
+        , std::uint64_t version
+        , std::size_t value_size
+        , std::vector< peer > const& holders
+        , tracker_type & tracker
+        , load_handler_type load_handler )
+            : key_( key )
+            , version_( version )
+            , tracker_( tracker )
+            , load_handler_( std::move( load_handler ) )
+            , value_size_( value_size )
+            , value_()
+            , missing_chunks_()
+            , holders_( holders )
+            , next_holder_()
+            , in_flight_requests_count_()
+            , received_chunks_count_()
+            , is_finished_()
+    {
+        auto const chunks_count = get_chunks_count( value_size, CHUNK_SIZE );
+        for ( std::uint64_t c = 0; c != chunks_count; ++ c )
+            missing_chunks_.push_back( c );
+
+        LOG_DEBUG( fetch_chunks_task, this )
+                << "create fetch chunks task for '"
+                << key << "' value (" << chunks_count
+                << " chunks)." << std::endl;
+    }
+
+    /**
+     *
+     */
+    void
+    notify_caller
+        ( std::error_code const& failure )
+    {
+        is_finished_ = true;
+
+        if ( failure )
+            load_handler_( failure, data_type{} );
+        else
+            load_handler_( failure, std::move( value_ ) );
+    }
+
+    /**
+     *
+     */
+    typename std::vector< peer >::iterator
+    find_holder
+        ( id const& holder_id )
+    {
+        auto i = holders_.begin();
+        while ( i != holders_.end() && i->id_ != holder_id )
+            ++ i;
+
+        return i;
+    }
+
+    /**
+     *
+     */
+    static void
+    fill_window
+        ( boost::intrusive_ptr< fetch_chunks_task > task )
+    {
+        while ( task->in_flight_requests_count_
+                    < task->tracker_.get_configuration().chunk_window_size()
+              && ! task->missing_chunks_.empty()
+              && ! task->holders_.empty() )
+        {
+            auto const chunk_index = task->missing_chunks_.front();
+            task->missing_chunks_.pop_front();
+
+            auto const& holder
+                    = task->holders_[ task->next_holder_ ++ % task->holders_.size() ];
+            send_find_chunk_request( chunk_index, holder, task );
+        }
+
+        // Every holder failed.
+        if ( task->in_flight_requests_count_ == 0 && ! task->is_finished_ )
+            task->notify_caller( make_error_code( VALUE_NOT_FOUND ) );
+    }
+
+    /**
+     *
+     */
+    static void
+    send_find_chunk_request
+        ( std::uint64_t chunk_index
+        , peer const& holder
+        , boost::intrusive_ptr< fetch_chunks_task > task )
+    {
+        auto on_message_received = [ task, chunk_index, holder ]
+            ( ip_endpoint const&
+            , header const& h
+            , buffer::const_iterator i
+            , buffer::const_iterator e )
+        {
+            -- task->in_flight_requests_count_;
+            handle_find_chunk_response( chunk_index, holder, h, i, e, task );
+        };
+
+        auto on_error = [ task, chunk_index, holder ]
+            ( std::error_code const& )
+        {
+            -- task->in_flight_requests_count_;
+            drop_holder( chunk_index, holder, task );
+        };
+
+        ++ task->in_flight_requests_count_;
+
+        // The chunks received are checked against
+        // the value size, hence it must cover this one.
+        auto const chunk_end = std::min( ( chunk_index + 1 ) * CHUNK_SIZE
+                                       , std::uint64_t( task->value_size_ ) );
+        if ( task->value_.size() < chunk_end )
+            task->value_.resize( std::size_t( chunk_end ) );
+
+        find_chunk_request_body const request{ task->key_
+                                             , task->version_
+                                             , chunk_index };
+        task->tracker_.send_request( request
+                                   , holder.endpoint_
+                                   , task->tracker_.get_configuration().peer_lookup_timeout()
+                                   , on_message_received
+                                   , on_error );
+    }
+
+    /**
+     *
+     */
+    static void
+    handle_find_chunk_response
+        ( std::uint64_t chunk_index
+        , peer const& holder
+        , header const& h
+        , buffer::const_iterator i
+        , buffer::const_iterator e
+        , boost::intrusive_ptr< fetch_chunks_task > task )
+    {
+        if ( task->is_finished_ )
+            return;
+
+        std::uint64_t received_index;
+        if ( h.type_ != header::FIND_CHUNK_RESPONSE
+           || read_chunk( h, i, e, task->value_, received_index )
+           || received_index != chunk_index )
+        {
+            LOG_DEBUG( fetch_chunks_task, task.get() )
+                    << "'" << holder << "' failed to provide chunk "
+                    << chunk_index << "." << std::endl;
+
+            drop_holder( chunk_index, holder, task );
+            return;
+        }
+
+        ++ task->received_chunks_count_;
+        if ( task->received_chunks_count_
+                == get_chunks_count( task->value_size_, CHUNK_SIZE ) )
+            task->notify_caller( std::error_code{} );
+        else
+            fill_window( task );
+    }
+
+    /**
+     *  @brief Copy the chunk of a find chunk response
+     *         at its place in value.
+     */
+    static std::error_code
+    read_chunk
+        ( header const& h
+        , buffer::const_iterator i
+        , buffer::const_iterator e
+        , data_type & value
+        , std::uint64_t & chunk_index )
+    {
+        if ( ! h.is_compressed_ )
+            return deserialize_chunk( i, e, CHUNK_SIZE, value, chunk_index );
+
+        find_chunk_response_body response;
+        if ( auto failure = deserialize( i, e, response ) )
+            return failure;
+
+        chunk_index = response.chunk_index_;
+
+        data_type chunk;
+        if ( auto failure = decompress( response.chunk_, chunk ) )
+            return failure;
+
+        return copy_chunk( chunk_index, chunk, CHUNK_SIZE, value );
+    }
+
+    /**
+     *  @brief Forget holder and request chunk_index again.
+     */
+    static void
+    drop_holder
+        ( std::uint64_t chunk_index
+        , peer const& holder
+        , boost::intrusive_ptr< fetch_chunks_task > task )
+    {
+        if ( task->is_finished_ )
+            return;
+
+        task->missing_chunks_.push_front( chunk_index );
+
+        auto const i = task->find_holder( holder.id_ );
+        if ( i != task->holders_.end() )
+            task->holders_.erase( i );
+
+        fill_window( task );
+    }
+
+private:
+    ///
+    id key_;
+    ///
+    std::uint64_t version_;
+    ///
+    tracker_type & tracker_;
+    ///
+    load_handler_type load_handler_;
+    ///
+    std::size_t value_size_;
+    /// Chunks are copied at their offset.
+    data_type value_;
+    ///
+    std::deque< std::uint64_t > missing_chunks_;
+    ///
+    std::vector< peer > holders_;
+    ///
+    std::size_t next_holder_;
+    ///
+    std::size_t in_flight_requests_count_;
+    ///
+    std::size_t received_chunks_count_;
+    ///
+    bool is_finished_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
@@ -30,16 +30,24 @@
 #   pragma once
 #endif
 
+#include <algorithm>
 #include <system_error>
 #include <memory>
+#include <vector>
 #include <type_traits>
+#include <chrono>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
 
 #include "kademlia/error_impl.hpp"
 
 #include "kademlia/lookup_task.hpp"
+#include "kademlia/fetch_chunks_task.hpp"
 #include "kademlia/log.hpp"
 #include "kademlia/constants.hpp"
+#include "kademlia/task_pool.hpp"
 #include "kademlia/message.hpp"
+#include "kademlia/compression.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -85,6 +93,9 @@ namespace detail {
 template< typename LoadHandlerType, typename TrackerType, typename DataType >
 class find_value_task final
     : public lookup_task
+    , public boost::intrusive_ref_counter< find_value_task< LoadHandlerType, TrackerType, DataType >
+                                        , boost::thread_unsafe_counter >
+    , public pooled_task< find_value_task< LoadHandlerType, TrackerType, DataType > >
 {
 public:
     ///
@@ -96,6 +107,11 @@ public:
     ///
     using data_type = DataType;
 
+    ///
+    using fetch_chunks_task_type = fetch_chunks_task< load_handler_type
+                                                    , tracker_type
+                                                    , data_type >;
+
 public:
     /**
      *
@@ -106,13 +122,19 @@ public:
         ( detail::id const & key
         , tracker_type & tracker
         , RoutingTableType & routing_table
-        , load_handler_type handler )
+        , load_handler_type handler
+        , std::chrono::seconds const& path_caching_ttl
+        , std::size_t read_quorum
+        , std::shared_ptr< candidates_pool > pool )
     {
-        std::shared_ptr< find_value_task > t;
+        boost::intrusive_ptr< find_value_task > t;
         t.reset( new find_value_task( key
                                     , tracker
                                     , routing_table
-                                    , std::move( handler ) ) );
+                                    , std::move( handler )
+                                    , path_caching_ttl
+                                    , read_quorum ) );
+        t->use_candidates_pool( std::move( pool ) );
 
         try_candidates( t );
     }
@@ -126,13 +148,27 @@ private:
         ( id const & searched_key
         , tracker_type & tracker
         , RoutingTableType & routing_table
-        , load_handler_type load_handler )
+        , load_handler_type load_handler
+        , std::chrono::seconds const& path_caching_ttl
+        , std::size_t read_quorum )
             : lookup_task( searched_key
                          , routing_table.find( searched_key )
-                         , routing_table.end() )
+                         , routing_table.end()
+                         , tracker.get_configuration().k_bucket_size() )
             , tracker_( tracker )
             , load_handler_( std::move( load_handler ) )
             , is_finished_()
+            , path_caching_ttl_( path_caching_ttl )
+            , closest_missing_peer_()
+            , is_closest_missing_peer_known_()
+            , read_quorum_( std::max< std::size_t >( 1, read_quorum ) )
+            , is_value_found_()
+            , best_data_()
+            , best_version_()
+            , best_chunked_value_size_()
+            , up_to_date_replicas_()
+            , stale_replicas_()
+            , fetch_chunks_task_()
     {
         LOG_DEBUG( find_value_task, this )
                 << "create find value task for '"
@@ -177,17 +213,23 @@ private:
      */
     static void
     try_candidates
-        ( std::shared_ptr< find_value_task > task
-        , std::size_t concurrent_requests_count = CONCURRENT_FIND_PEER_REQUESTS_COUNT )
+        ( boost::intrusive_ptr< find_value_task > task )
     {
         auto const closest_candidates = task->select_new_closest_candidates
-                ( concurrent_requests_count );
+                ( task->tracker_.get_configuration().concurrent_requests_count() );
 
         find_value_request_body const request{ task->get_key() };
         for ( auto const& c : closest_candidates )
             send_find_value_request( request, c, task );
 
-        if ( task->have_all_requests_completed() )
+        if ( ! task->is_lookup_complete() )
+            return;
+
+        // Fewer than read_quorum replicas agree,
+        // return the best version seen anyway.
+        if ( task->is_value_found_ )
+            complete_quorum_read( task );
+        else
             task->notify_caller( make_error_code( VALUE_NOT_FOUND ) );
     }
 
@@ -198,7 +240,7 @@ private:
     send_find_value_request
         ( find_value_request_body const& request
         , peer const& current_candidate
-        , std::shared_ptr< find_value_task > task )
+        , boost::intrusive_ptr< find_value_task > task )
     {
         LOG_DEBUG( find_value_task, task.get() ) << "sending find '" << task->get_key()
                 << "' value request to '"
@@ -212,10 +254,21 @@ private:
             , buffer::const_iterator e )
         {
             if ( task->is_caller_notified() )
+            {
+                // A late replica can still serve chunks,
+                // or be stale and need a repair.
+                if ( h.type_ != header::FIND_VALUE_RESPONSE )
+                    return;
+
+                if ( task->fetch_chunks_task_ )
+                    add_chunks_holder( current_candidate, i, e, task );
+                else if ( task->read_quorum_ > 1 )
+                    repair_late_replica( current_candidate, i, e, task );
                 return;
+            }
 
             task->flag_candidate_as_valid( current_candidate.id_ );
-            handle_find_value_response( s, h, i, e, task );
+            handle_find_value_response( current_candidate, h, i, e, task );
         };
 
         // On error, retry with another endpoint.
@@ -232,7 +285,7 @@ private:
 
         task->tracker_.send_request( request
                                    , current_candidate.endpoint_
-                                   , PEER_LOOKUP_TIMEOUT
+                                   , task->tracker_.get_configuration().peer_lookup_timeout()
                                    , on_message_received
                                    , on_error );
     }
@@ -243,11 +296,11 @@ private:
      */
     static void
     handle_find_value_response
-        ( ip_endpoint const& s
+        ( peer const& current_candidate
         , header const& h
         , buffer::const_iterator i
         , buffer::const_iterator e
-        , std::shared_ptr< find_value_task > task )
+        , boost::intrusive_ptr< find_value_task > task )
     {
         LOG_DEBUG( find_value_task, task.get() )
                 << "handling response type '"
@@ -255,12 +308,15 @@ private:
                 << task->get_key() << "' value." << std::endl;
 
         if ( h.type_ == header::FIND_PEER_RESPONSE )
+        {
             // The current peer didn't know the value
             // but provided closest peers.
-            send_find_value_requests_on_closer_peers( i, e, task );
+            task->flag_missing_peer( current_candidate );
+            send_find_value_requests_on_closer_peers( h, i, e, task );
+        }
         else if ( h.type_ == header::FIND_VALUE_RESPONSE )
             // The current peer knows the value.
-            process_found_value( i, e, task );
+            process_found_value( current_candidate, h, i, e, task );
     }
 
     /**
@@ -272,22 +328,26 @@ private:
      */
     static void
     send_find_value_requests_on_closer_peers
-        ( buffer::const_iterator i
+        ( header const& h
+        , buffer::const_iterator i
         , buffer::const_iterator e
-        , std::shared_ptr< find_value_task > task )
+        , boost::intrusive_ptr< find_value_task > task )
     {
         LOG_DEBUG( find_value_task, task.get() ) << "checking if found closest peers to '"
                 << task->get_key() << "' value from closer peers."
                 << std::endl;
 
         find_peer_response_body response;
-        if ( auto failure = deserialize( i, e, response ) )
+        auto const failure = deserialize( i, e, h.version_
+                                        , task->get_key(), response );
+        if ( failure )
         {
             LOG_DEBUG( find_value_task, task.get() )
                     << "failed to deserialize find peer response '"
                     << task->get_key() << "' because ("
                     << failure.message() << ")." << std::endl;
 
+            try_candidates( task );
             return;
         }
 
@@ -302,9 +362,11 @@ private:
      */
     static void
     process_found_value
-        ( buffer::const_iterator i
+        ( peer const& current_candidate
+        , header const& h
+        , buffer::const_iterator i
         , buffer::const_iterator e
-        , std::shared_ptr< find_value_task > task )
+        , boost::intrusive_ptr< find_value_task > task )
     {
         LOG_DEBUG( find_value_task, task.get() )
                 << "found '" << task->get_key()
@@ -316,10 +378,336 @@ private:
             LOG_DEBUG( find_value_task, task.get() )
                     << "failed to deserialize find value response ("
                     << failure.message() << ")" << std::endl;
+            skip_unusable_value( current_candidate, task );
+            return;
+        }
+
+        if ( h.is_compressed_ )
+        {
+            std::vector< std::uint8_t > data;
+            if ( auto failure = decompress( response.data_, data ) )
+            {
+                LOG_DEBUG( find_value_task, task.get() )
+                        << "failed to decompress find value response ("
+                        << failure.message() << ")" << std::endl;
+                skip_unusable_value( current_candidate, task );
+                return;
+            }
+
+            response.data_ = std::move( data );
+        }
+
+        if ( response.chunked_value_size_ > CHUNKED_VALUE_MAX_SIZE )
+        {
+            LOG_DEBUG( find_value_task, task.get() )
+                    << "ignoring too large chunked value." << std::endl;
+            skip_unusable_value( current_candidate, task );
+            return;
+        }
+
+        // Fast path, the first replica wins.
+        if ( task->read_quorum_ == 1 && response.chunked_value_size_ > 0 )
+        {
+            start_chunks_fetch( response.version_
+                              , response.chunked_value_size_
+                              , std::vector< peer >{ current_candidate }
+                              , task );
+            return;
+        }
+
+        if ( task->read_quorum_ == 1 )
+        {
+            task->notify_caller( response.data_ );
+
+            cache_found_value( current_candidate
+                             , response.data_
+                             , response.version_
+                             , task );
+            return;
+        }
+
+        task->record_replica( current_candidate, std::move( response ) );
+
+        if ( task->up_to_date_replicas_.size() >= task->read_quorum_ )
+            complete_quorum_read( task );
+        else
+            try_candidates( task );
+    }
+
+    /**
+     *  @brief Continue the lookup as if current_candidate
+     *         didn't have the value it sent.
+     */
+    static void
+    skip_unusable_value
+        ( peer const& current_candidate
+        , boost::intrusive_ptr< find_value_task > task )
+    {
+        task->flag_missing_peer( current_candidate );
+        try_candidates( task );
+    }
+
+    /**
+     *  @brief Keep track of the best version found so far.
+     */
+    void
+    record_replica
+        ( peer const& p
+        , find_value_response_body && response )
+    {
+        if ( ! is_value_found_ || response.version_ > best_version_ )
+        {
+            // Replicas of the previous best version are now stale.
+            stale_replicas_.insert( stale_replicas_.end()
+                                  , up_to_date_replicas_.begin()
+                                  , up_to_date_replicas_.end() );
+            up_to_date_replicas_.clear();
+
+            best_data_ = std::move( response.data_ );
+            best_version_ = response.version_;
+            best_chunked_value_size_ = response.chunked_value_size_;
+            is_value_found_ = true;
+        }
+        else if ( response.version_ < best_version_
+                || response.data_ != best_data_
+                || response.chunked_value_size_ != best_chunked_value_size_ )
+        {
+            stale_replicas_.push_back( p );
+            return;
+        }
+
+        up_to_date_replicas_.push_back( p );
+    }
+
+    /**
+     *  @brief Return the best version to the caller
+     *         and repair replicas which missed it.
+     */
+    static void
+    complete_quorum_read
+        ( boost::intrusive_ptr< find_value_task > task )
+    {
+        // Chunked values aren't repaired.
+        if ( task->best_chunked_value_size_ > 0 )
+        {
+            start_chunks_fetch( task->best_version_
+                              , task->best_chunked_value_size_
+                              , task->up_to_date_replicas_
+                              , task );
             return;
         }
 
-        task->notify_caller( response.data_ );
+        task->notify_caller( task->best_data_ );
+
+        // Stale replicas and the closest responding peers
+        // without the value get the best version.
+        auto replicas = task->select_closest_valid_candidates
+                ( task->tracker_.get_configuration().redundant_save_count() );
+        replicas.insert( replicas.end()
+                       , task->stale_replicas_.begin()
+                       , task->stale_replicas_.end() );
+
+        std::vector< id > repaired_replicas;
+        for ( auto const& r : replicas )
+        {
+            if ( task->is_up_to_date_replica( r.id_ )
+               || std::find( repaired_replicas.begin()
+                           , repaired_replicas.end()
+                           , r.id_ ) != repaired_replicas.end() )
+                continue;
+
+            repair_replica( r, task );
+            repaired_replicas.push_back( r.id_ );
+        }
+    }
+
+    /**
+     *  @brief Repair a replica whose response arrived
+     *         once the quorum had been reached.
+     */
+    static void
+    repair_late_replica
+        ( peer const& replica
+        , buffer::const_iterator i
+        , buffer::const_iterator e
+        , boost::intrusive_ptr< find_value_task > task )
+    {
+        // Chunked values aren't repaired.
+        if ( task->best_chunked_value_size_ > 0 )
+            return;
+
+        find_value_response_body response;
+        if ( deserialize( i, e, response ) )
+            return;
+
+        if ( response.version_ < task->best_version_ )
+            repair_replica( replica, task );
+    }
+
+    /**
+     *  @brief Send the best version to a replica
+     *         which missed it.
+     */
+    static void
+    repair_replica
+        ( peer const& replica
+        , boost::intrusive_ptr< find_value_task > task )
+    {
+        LOG_DEBUG( find_value_task, task.get() )
+                << "repairing '" << task->get_key()
+                << "' value on '" << replica << "'." << std::endl;
+
+        store_value_request_body const request{ task->get_key()
+                                              , task->best_data_
+                                              , std::chrono::seconds::zero()
+                                              , task->best_version_ };
+        task->tracker_.send_request( request, replica.endpoint_ );
+    }
+
+    /**
+     *  @brief Hand the caller over to a task fetching
+     *         the chunks of the found value.
+     */
+    static void
+    start_chunks_fetch
+        ( std::uint64_t version
+        , std::size_t value_size
+        , std::vector< peer > const& holders
+        , boost::intrusive_ptr< find_value_task > task )
+    {
+        LOG_DEBUG( find_value_task, task.get() )
+                << "fetching '" << task->get_key() << "' value of "
+                << value_size << " bytes by chunks." << std::endl;
+
+        assert( ! task->is_caller_notified() );
+        task->is_finished_ = true;
+        task->fetch_chunks_task_ = fetch_chunks_task_type::start( task->get_key()
+                                                                , version
+                                                                , value_size
+                                                                , holders
+                                                                , task->tracker_
+                                                                , std::move( task->load_handler_ ) );
+    }
+
+    /**
+     *
+     */
+    static void
+    add_chunks_holder
+        ( peer const& current_candidate
+        , buffer::const_iterator i
+        , buffer::const_iterator e
+        , boost::intrusive_ptr< find_value_task > task )
+    {
+        find_value_response_body response;
+        if ( deserialize( i, e, response ) )
+            return;
+
+        auto const& fetch = task->fetch_chunks_task_;
+        if ( response.chunked_value_size_ == fetch->get_value_size()
+           && response.version_ == fetch->get_version() )
+            fetch_chunks_task_type::add_holder( fetch, current_candidate );
+    }
+
+    /**
+     *
+     */
+    bool
+    is_up_to_date_replica
+        ( id const& peer_id )
+        const
+    {
+        for ( auto const& r : up_to_date_replicas_ )
+            if ( r.id_ == peer_id )
+                return true;
+
+        return false;
+    }
+
+    /**
+     *  @brief Record a peer which doesn't have the value.
+     *  @details V1 peers ignore the time to live of a store,
+     *           hence they would keep a cached copy forever
+     *           and aren't recorded.
+     */
+    void
+    flag_missing_peer
+        ( peer const& p )
+    {
+        if ( tracker_.get_peer_version( p.endpoint_ ) < header::V2 )
+            return;
+
+        if ( is_closest_missing_peer_known_
+           && distance( closest_missing_peer_.id_, get_key() )
+                < distance( p.id_, get_key() ) )
+            return;
+
+        closest_missing_peer_ = p;
+        is_closest_missing_peer_known_ = true;
+    }
+
+    /**
+     *  @brief Store the found value on the closest peer
+     *         met on the lookup path that didn't have it
+     *         and honours time to lives.
+     *  @details The cached copy time to live is halved
+     *           each time the XOR distance between this
+     *           peer and the key doubles compared to the
+     *           distance of the peer which had the value.
+     */
+    static void
+    cache_found_value
+        ( peer const& value_owner
+        , data_type const& data
+        , std::uint64_t version
+        , boost::intrusive_ptr< find_value_task > task )
+    {
+        if ( task->path_caching_ttl_.count() == 0
+           || ! task->is_closest_missing_peer_known_ )
+            return;
+
+        auto const& key = task->get_key();
+        auto const missing_peer_bits
+                = count_significant_bits( distance( task->closest_missing_peer_.id_
+                                                  , key ) );
+        auto const value_owner_bits
+                = count_significant_bits( distance( value_owner.id_, key ) );
+
+        auto ttl = task->path_caching_ttl_;
+        if ( missing_peer_bits > value_owner_bits )
+        {
+            auto const shift = missing_peer_bits - value_owner_bits;
+            ttl = shift < 32 ? ttl / ( std::int64_t{ 1 } << shift )
+                             : std::chrono::seconds::zero();
+        }
+
+        // A 0 ttl would make the copy permanent.
+        if ( ttl.count() == 0 )
+            return;
+
+        LOG_DEBUG( find_value_task, task.get() )
+                << "caching '" << key << "' value on '"
+                << task->closest_missing_peer_ << "' for "
+                << ttl.count() << "s." << std::endl;
+
+        store_value_request_body const request{ key, data, ttl, version };
+        task->tracker_.send_request( request
+                                   , task->closest_missing_peer_.endpoint_ );
+    }
+
+    /**
+     *
+     */
+    static std::size_t
+    count_significant_bits
+        ( id const& value )
+    {
+        std::size_t leading_zeros = 0;
+        while ( leading_zeros < id::BIT_SIZE
+              && ! static_cast< bool >( value[ leading_zeros ] ) )
+            ++ leading_zeros;
+
+        return id::BIT_SIZE - leading_zeros;
     }
 
 private:
@@ -329,10 +717,40 @@ private:
     load_handler_type load_handler_;
     ///
     bool is_finished_;
+    ///
+    std::chrono::seconds path_caching_ttl_;
+    ///
+    peer closest_missing_peer_;
+    ///
+    bool is_closest_missing_peer_known_;
+    ///
+    std::size_t read_quorum_;
+    ///
+    bool is_value_found_;
+    ///
+    data_type best_data_;
+    ///
+    std::uint64_t best_version_;
+    ///
+    std::uint64_t best_chunked_value_size_;
+    ///
+    std::vector< peer > up_to_date_replicas_;
+    ///
+    std::vector< peer > stale_replicas_;
+    ///
+    boost::intrusive_ptr< fetch_chunks_task_type > fetch_chunks_task_;
 };
 
 /**
- *
+ *  @param path_caching_ttl If not 0, the found value is cached
+ *         on the closest peer that didn't have it for at most
+ *         this duration.
+ *  @param read_quorum If greater than 1, the lookup continues until
+ *         this many replicas agree on the latest version or no
+ *         candidate is left. Replicas that returned an older
+ *         version, and the closest peers that didn't have the value,
+ *         are then repaired instead of path caching the value.
+ *  @param pool If not null, peers shared with lookups of nearby keys.
  */
 template< typename DataType
         , typename TrackerType
@@ -343,13 +761,20 @@ start_find_value_task
     ( id const& key
     , TrackerType & tracker
     , RoutingTableType & routing_table
-    , HandlerType && handler )
+    , HandlerType && handler
+    , std::chrono::seconds const& path_caching_ttl
+            = std::chrono::seconds::zero()
+    , std::size_t read_quorum = 1
+    , std::shared_ptr< candidates_pool > pool = nullptr )
 {
     using handler_type = typename std::decay< HandlerType >::type;
     using task = find_value_task< handler_type, TrackerType, DataType >;
 
     task::start( key, tracker, routing_table
-               , std::forward< HandlerType >( handler ) );
+               , std::forward< HandlerType >( handler )
+               , path_caching_ttl
+               , read_quorum
+               , std::move( pool ) );
 }
 
 } // namespace detail
@@ -40,16 +40,19 @@ struct first_session::impl final
      */
     impl
         ( endpoint const& listen_on_ipv4
-        , endpoint const& listen_on_ipv6 )
+        , endpoint const& listen_on_ipv6
+        , configuration const& config )
             : session_impl{ listen_on_ipv4
-                          , listen_on_ipv6 }
+                          , listen_on_ipv6
+                          , config }
     { }
 };
 
 first_session::first_session
     ( endpoint const& listen_on_ipv4
-    , endpoint const& listen_on_ipv6 )
-        : impl_{ new impl{ listen_on_ipv4, listen_on_ipv6 } }
+    , endpoint const& listen_on_ipv6
+    , configuration const& config )
+        : impl_{ new impl{ listen_on_ipv4, listen_on_ipv6, config } }
 { }
 
 first_session::~first_session
@@ -61,6 +64,21 @@ first_session::run
     ( void )
 { return impl_->run(); }
 
+std::error_code
+first_session::run_with_threads
+    ( std::size_t threads_count )
+{ return impl_->run_with_threads( threads_count ); }
+
+std::error_code
+first_session::run_for
+    ( std::chrono::milliseconds const& duration )
+{ return impl_->run_for( duration ); }
+
+std::error_code
+first_session::poll
+    ( void )
+{ return impl_->poll(); }
+
 void
 first_session::abort
         ( void )
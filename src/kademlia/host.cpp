@@ -0,0 +1,110 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <kademlia/host.hpp>
+
+#include "kademlia/host_impl.hpp"
+
+namespace kademlia {
+
+/**
+ *
+ */
+struct host::impl final
+        : detail::host_impl
+{ };
+
+host::host
+    ( void )
+        : impl_{ new impl{} }
+{ }
+
+host::~host
+    ( void )
+{ }
+
+host::tenant_type
+host::add_tenant
+    ( endpoint const& listen_on_ipv4
+    , endpoint const& listen_on_ipv6
+    , configuration const& config )
+{ return impl_->add_tenant( config, listen_on_ipv4, listen_on_ipv6 ); }
+
+host::tenant_type
+host::add_tenant
+    ( endpoint const& initial_peer
+    , endpoint const& listen_on_ipv4
+    , endpoint const& listen_on_ipv6
+    , configuration const& config )
+{ return impl_->add_tenant( config, initial_peer, listen_on_ipv4, listen_on_ipv6 ); }
+
+std::size_t
+host::tenants_count
+    ( void )
+    const
+{ return impl_->tenants_count(); }
+
+void
+host::async_save
+    ( tenant_type tenant
+    , key_type const& key
+    , data_type const& data
+    , save_handler_type handler )
+{ impl_->async_save( tenant, key, data, std::move( handler ) ); }
+
+void
+host::async_load
+    ( tenant_type tenant
+    , key_type const& key
+    , load_handler_type handler )
+{ impl_->async_load( tenant, key, std::move( handler ) ); }
+
+std::error_code
+host::run
+    ( void )
+{ return impl_->run(); }
+
+std::error_code
+host::run_with_threads
+    ( std::size_t threads_count )
+{ return impl_->run_with_threads( threads_count ); }
+
+std::error_code
+host::run_for
+    ( std::chrono::milliseconds const& duration )
+{ return impl_->run_for( duration ); }
+
+std::error_code
+host::poll
+    ( void )
+{ return impl_->poll(); }
+
+void
+host::abort
+        ( void )
+{ impl_->abort(); }
+
+} // namespace kademlia
+
@@ -0,0 +1,191 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_HOST_IMPL_HPP
+#define KADEMLIA_HOST_IMPL_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <memory>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/asio/ip/udp.hpp>
+
+#include "kademlia/error_impl.hpp"
+#include "kademlia/message_socket.hpp"
+#include "kademlia/engine.hpp"
+#include "kademlia/event_loop.hpp"
+#include "kademlia/reception_buffer_pool.hpp"
+#include "kademlia/timer.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class runs the engines of several
+ *         identities on a single event loop.
+ *  @details The engines share the io_service, hence its
+ *           reactor and threads, the submission queue,
+ *           a timer queue and a pool of reception buffers.
+ *           Each engine has its own strand, hence the tenants
+ *           run in parallel when the host runs several threads.
+ *           Each engine listens on its own endpoints, as the
+ *           messages don't carry their recipient id, hence the
+ *           kernel demultiplexes the incoming messages by port.
+ *           Sockets wait for a message before borrowing a
+ *           buffer to read it, hence the host holds a buffer
+ *           per message being handled rather than per socket.
+ */
+class host_impl
+        : public event_loop
+{
+public:
+    ///
+    using socket_type = boost::asio::ip::udp::socket;
+    ///
+    using engine_type = detail::engine< socket_type >;
+    ///
+    using tenant_type = std::size_t;
+
+public:
+    /**
+     *
+     */
+    host_impl
+        ( void )
+            : event_loop{}
+            , timers_{ get_default_strand( get_io_service() ) }
+            , reception_buffers_{ message_socket< socket_type >::INPUT_BUFFER_SIZE }
+            , engines_{}
+    { }
+
+    /**
+     *  @details Engines are added while the host isn't running,
+     *           as their construction starts their reception.
+     */
+    template< typename... EndpointsType >
+    tenant_type
+    add_tenant
+        ( configuration const& config
+        , EndpointsType const&... endpoints )
+    {
+        detail::concurrent_guard::sentry s{ get_concurrent_guard() };
+        if ( ! s )
+            throw std::system_error{ make_error_code( ALREADY_RUNNING ) };
+
+        engines_.emplace_back( new engine_type{ get_io_service()
+                                              , endpoints...
+                                              , id{}
+                                              , config
+                                              , &timers_
+                                              , &reception_buffers_ } );
+        return engines_.size() - 1;
+    }
+
+    /**
+     *
+     */
+    std::size_t
+    tenants_count
+        ( void )
+        const
+    { return engines_.size(); }
+
+    /**
+     *  @details This method can be called from any thread,
+     *           the save is submitted to the tenant engine.
+     */
+    template< typename KeyType, typename DataType, typename HandlerType >
+    void
+    async_save
+        ( tenant_type tenant
+        , KeyType const& key
+        , DataType const& data
+        , HandlerType && handler )
+    {
+        using handler_type = typename std::decay< HandlerType >::type;
+
+        auto & e = get_engine( tenant );
+        handler_type h( std::forward< HandlerType >( handler ) );
+        auto start_save = [ &e, key, data, h ]( void )
+        { e.async_save( key, data, h ); };
+
+        submit( e.get_strand(), std::move( start_save ) );
+    }
+
+    /**
+     *  @details This method can be called from any thread,
+     *           the load is submitted to the tenant engine.
+     */
+    template< typename KeyType, typename HandlerType >
+    void
+    async_load
+        ( tenant_type tenant
+        , KeyType const& key
+        , HandlerType && handler )
+    {
+        using handler_type = typename std::decay< HandlerType >::type;
+
+        auto & e = get_engine( tenant );
+        handler_type h( std::forward< HandlerType >( handler ) );
+        auto start_load = [ &e, key, h ]( void )
+        { e.async_load( key, h ); };
+
+        submit( e.get_strand(), std::move( start_load ) );
+    }
+
+private:
+    /**
+     *
+     */
+    engine_type &
+    get_engine
+        ( tenant_type tenant )
+    {
+        if ( tenant >= engines_.size() )
+            throw std::system_error{ make_error_code( UNKNOWN_TENANT ) };
+
+        return *engines_[ tenant ];
+    }
+
+private:
+    /// Declared before the engines, which use it.
+    timer_queue timers_;
+    ///
+    reception_buffer_pool reception_buffers_;
+    /// Engines are never removed, hence their
+    /// references are stable.
+    std::vector< std::unique_ptr< engine_type > > engines_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
@@ -0,0 +1,168 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_IN_FLIGHT_REQUESTS_HPP
+#define KADEMLIA_IN_FLIGHT_REQUESTS_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class keeps track of the handlers waiting
+ *         for the completion of a network request.
+ *  @details
+ *  When a request is issued while an identical one
+ *  is still in flight, the new handler is attached
+ *  to the pending request instead of triggering
+ *  another network lookup. All attached handlers
+ *  are notified once the request completes.
+ */
+template< typename KeyType, typename HandlerType >
+class in_flight_requests final
+{
+public:
+    ///
+    using key_type = KeyType;
+
+    ///
+    using handler_type = HandlerType;
+
+public:
+    /**
+     *
+     */
+    in_flight_requests
+        ( void )
+            : requests_()
+            , coalesced_requests_count_()
+    { }
+
+    /**
+     *
+     */
+    in_flight_requests
+        ( in_flight_requests const& )
+        = delete;
+
+    /**
+     *
+     */
+    in_flight_requests &
+    operator=
+        ( in_flight_requests const& )
+        = delete;
+
+    /**
+     *  @brief Attach a handler to the request associated with key.
+     *  @return true if no identical request was in flight, i.e.
+     *          the caller is responsible for starting it.
+     */
+    bool
+    attach
+        ( key_type const& key
+        , handler_type handler )
+    {
+        auto i = requests_.find( key );
+        if ( i == requests_.end() )
+        {
+            requests_[ key ].push_back( std::move( handler ) );
+            return true;
+        }
+
+        i->second.push_back( std::move( handler ) );
+        ++ coalesced_requests_count_;
+
+        return false;
+    }
+
+    /**
+     *  @brief Notify and forget all the handlers
+     *         attached to the request associated with key.
+     */
+    template< typename... Args >
+    void
+    notify
+        ( key_type const& key
+        , Args const&... args )
+    {
+        auto i = requests_.find( key );
+        if ( i == requests_.end() )
+            return;
+
+        // Handlers may issue a new identical request,
+        // hence forget the current one before calling them.
+        auto const handlers = std::move( i->second );
+        requests_.erase( i );
+
+        for ( auto const& h : handlers )
+            h( args... );
+    }
+
+    /**
+     *
+     */
+    bool
+    is_in_flight
+        ( key_type const& key )
+        const
+    { return requests_.count( key ) > 0; }
+
+    /**
+     *  @return The number of requests that have been
+     *          attached to an already in flight request.
+     */
+    std::uint64_t
+    coalesced_requests_count
+        ( void )
+        const
+    { return coalesced_requests_count_; }
+
+private:
+    ///
+    using handlers_type = std::vector< handler_type >;
+
+    ///
+    using requests_type = std::map< key_type, handlers_type >;
+
+private:
+    ///
+    requests_type requests_;
+    ///
+    std::uint64_t coalesced_requests_count_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
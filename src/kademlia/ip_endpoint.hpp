@@ -84,6 +84,17 @@ operator!=
     , ip_endpoint const& b )
 { return ! ( a == b ); }
 
+/**
+ *
+ */
+inline bool
+operator<
+    ( ip_endpoint const& a
+    , ip_endpoint const& b )
+{
+    return a.address_ < b.address_
+        || ( a.address_ == b.address_ && a.port_ < b.port_ );
+}
 
 } // namespace detail
 } // namespace kademlia
@@ -30,19 +30,48 @@
 #   pragma once
 #endif
 
+#include <algorithm>
 #include <cassert>
-#include <map>
+#include <iterator>
+#include <memory>
 #include <vector>
+#include <boost/container/small_vector.hpp>
+
+#include <kademlia/detail/cxx11_macros.hpp>
 
 #include "kademlia/peer.hpp"
 #include "kademlia/log.hpp"
+#include "kademlia/candidates_pool.hpp"
 
 namespace kademlia {
 namespace detail {
 
-///
+/**
+ *  @brief This class is the base of the iterative lookups.
+ *  @details
+ *  It keeps a shortlist of the closest candidates met,
+ *  sorted by distance to the key. Candidates farther than
+ *  the k-th closest one which responded are dropped, as are
+ *  the farthest of more than k candidates yet to respond,
+ *  hence a responder is never dropped for a closer peer
+ *  which may not answer. Unresponsive candidates are
+ *  removed. Candidates already contacted are never added
+ *  again.
+ */
 class lookup_task
 {
+public:
+    /// Candidates stored inline, enough for
+    /// k responders and k others with usual k.
+    static CXX11_CONSTEXPR std::size_t INLINE_CANDIDATES_COUNT = 40;
+
+    /// Candidates selected at once, enough for small alpha.
+    static CXX11_CONSTEXPR std::size_t INLINE_SELECTED_CANDIDATES_COUNT = 8;
+
+    ///
+    using selected_candidates_type = boost::container::small_vector
+            < peer, INLINE_SELECTED_CANDIDATES_COUNT >;
+
 public:
     /**
      *
@@ -61,7 +90,7 @@ public:
     /**
      *
      */
-    std::vector< peer >
+    selected_candidates_type
     select_new_closest_candidates
         ( std::size_t max_count );
 
@@ -88,6 +117,19 @@ public:
         ( void )
         const;
 
+    /**
+     *  @return true if the lookup is over, i.e. the closest
+     *          candidates have all responded, or no request
+     *          is in flight and none is left to send.
+     *  @pre The new closest candidates have been selected.
+     *  @details Requests still in flight then target candidates
+     *           dropped from the shortlist, hence don't matter.
+     */
+    bool
+    is_lookup_complete
+        ( void )
+        const;
+
     /**
      *
      */
@@ -104,28 +146,42 @@ protected:
         ( void );
 
     /**
-     *
+     *  @param max_candidates_count The shortlist size, i.e. k.
      */
     template< typename Iterator >
     lookup_task
         ( id const & key
-        , Iterator i, Iterator e );
+        , Iterator i, Iterator e
+        , std::size_t max_candidates_count );
+
+    /**
+     *  @brief Also start from the closest peers of pool, and
+     *         share the responsive peers met with it.
+     */
+    void
+    use_candidates_pool
+        ( std::shared_ptr< candidates_pool > pool );
 
 private:
     ///
     struct candidate final
     {
+        id distance_;
         peer peer_;
         enum {
             STATE_UNKNOWN,
             STATE_CONTACTED,
             STATE_RESPONDED,
-            STATE_TIMEOUTED,
         } state_;
     };
 
-    ///
-    using candidates_type = std::map< id, candidate >;
+    /// Sorted by distance to the key, closest first.
+    using candidates_type = boost::container::small_vector
+            < candidate, INLINE_CANDIDATES_COUNT >;
+
+    /// Sorted distances to the key.
+    using distances_type = boost::container::small_vector
+            < id, INLINE_SELECTED_CANDIDATES_COUNT >;
 
 private:
     /**
@@ -135,6 +191,38 @@ private:
     add_candidate
         ( peer const& p );
 
+    /**
+     *  @brief Remove a candidate from the shortlist,
+     *         remembering it if it was contacted.
+     */
+    void
+    drop_candidate
+        ( candidates_type::iterator i );
+
+    /**
+     *  @brief Drop the candidates farther than the
+     *         k-th closest candidate which responded.
+     */
+    void
+    drop_candidates_past_responders
+        ( void );
+
+    /**
+     *  @brief Drop the farthest candidate yet to respond
+     *         if more than k candidates are.
+     */
+    void
+    drop_candidates_past_unknowns
+        ( void );
+
+    /**
+     *  @return The k-th closest candidate which responded,
+     *          or the end if fewer candidates responded.
+     */
+    candidates_type::iterator
+    find_last_closest_responder
+        ( void );
+
     /**
      *
      */
@@ -142,13 +230,29 @@ private:
     find_candidate
         ( id const& candidate_id );
 
+    /**
+     *  @return The first candidate not closer than candidate_distance.
+     */
+    candidates_type::iterator
+    find_candidate_position
+        ( id const& candidate_distance );
+
 private:
     ///
     id key_;
     ///
+    std::size_t max_candidates_count_;
+    ///
     std::size_t in_flight_requests_count_;
     ///
     candidates_type candidates_;
+    /// No candidate before this one is left to contact.
+    std::size_t first_unknown_candidate_;
+    /// The candidates contacted then dropped or removed
+    /// from the shortlist, hence not to be contacted again.
+    distances_type dropped_candidates_;
+    ///
+    std::shared_ptr< candidates_pool > candidates_pool_;
 };
 
 inline
@@ -160,10 +264,15 @@ template< typename Iterator >
 inline
 lookup_task::lookup_task
     ( id const & key
-    , Iterator i, Iterator e )
+    , Iterator i, Iterator e
+    , std::size_t max_candidates_count )
         : key_{ key }
+        , max_candidates_count_{ max_candidates_count }
         , in_flight_requests_count_{ 0 }
         , candidates_{}
+        , first_unknown_candidate_{ 0 }
+        , dropped_candidates_{}
+        , candidates_pool_{}
 {
     for ( ; i != e; ++i )
         add_candidate( peer{ i->first, i->second } );
@@ -173,44 +282,69 @@ inline void
 lookup_task::flag_candidate_as_valid
     ( id const& candidate_id )
 {
+    // The candidate may have been dropped from
+    // the shortlist while its request was in flight.
+    -- in_flight_requests_count_;
+
     auto i = find_candidate( candidate_id );
     if ( i == candidates_.end() )
         return;
 
-    -- in_flight_requests_count_;
-    i->second.state_ = candidate::STATE_RESPONDED;
+    i->state_ = candidate::STATE_RESPONDED;
+
+    if ( candidates_pool_ )
+        candidates_pool_->add( i->peer_ );
+
+    drop_candidates_past_responders();
 }
 
 inline void
 lookup_task::flag_candidate_as_invalid
     ( id const& candidate_id )
 {
+    -- in_flight_requests_count_;
+
+    if ( candidates_pool_ )
+        candidates_pool_->remove( candidate_id );
+
     auto i = find_candidate( candidate_id );
     if ( i == candidates_.end() )
         return;
 
-    -- in_flight_requests_count_;
-    i->second.state_ = candidate::STATE_TIMEOUTED;
+    // Free its place in the shortlist for a responsive one.
+    drop_candidate( i );
 }
 
-inline std::vector< peer >
+inline void
+lookup_task::use_candidates_pool
+    ( std::shared_ptr< candidates_pool > pool )
+{
+    if ( ! pool )
+        return;
+
+    add_candidates( pool->find_closest( key_, max_candidates_count_ ) );
+    candidates_pool_ = std::move( pool );
+}
+
+inline lookup_task::selected_candidates_type
 lookup_task::select_new_closest_candidates
     ( std::size_t max_count )
 {
-    std::vector< peer > candidates;
+    selected_candidates_type candidates;
 
-    // Iterate over all candidates until we picked
-    // candidates_max_count not-contacted candidates.
-    for ( auto i = candidates_.begin(), e = candidates_.end()
-        ; i != e && in_flight_requests_count_ < max_count
-        ; ++ i )
+    // Contact the closest candidates not contacted yet
+    // until max_count requests are in flight.
+    for ( ; first_unknown_candidate_ < candidates_.size()
+            && in_flight_requests_count_ < max_count
+          ; ++ first_unknown_candidate_ )
     {
-        if ( i->second.state_ == candidate::STATE_UNKNOWN )
-        {
-            i->second.state_ = candidate::STATE_CONTACTED;
-            ++ in_flight_requests_count_;
-            candidates.push_back( i->second.peer_ );
-        }
+        auto & c = candidates_[ first_unknown_candidate_ ];
+        if ( c.state_ != candidate::STATE_UNKNOWN )
+            continue;
+
+        c.state_ = candidate::STATE_CONTACTED;
+        ++ in_flight_requests_count_;
+        candidates.push_back( c.peer_ );
     }
 
     return candidates;
@@ -228,8 +362,8 @@ lookup_task::select_closest_valid_candidates
         ; i != e && candidates.size() < max_count
         ; ++ i )
     {
-        if ( i->second.state_ == candidate::STATE_RESPONDED )
-            candidates.push_back( i->second.peer_ );
+        if ( i->state_ == candidate::STATE_RESPONDED )
+            candidates.push_back( i->peer_ );
     }
 
     return candidates;
@@ -250,6 +384,25 @@ lookup_task::have_all_requests_completed
     const
 { return in_flight_requests_count_ == 0; }
 
+inline bool
+lookup_task::is_lookup_complete
+    ( void )
+    const
+{
+    if ( have_all_requests_completed() )
+        return true;
+
+    auto const has_responded = []( candidate const& c )
+    { return c.state_ == candidate::STATE_RESPONDED; };
+
+    auto const closest_count = std::min( candidates_.size()
+                                       , max_candidates_count_ );
+    return ! candidates_.empty()
+         && std::all_of( candidates_.begin()
+                       , std::next( candidates_.begin(), closest_count )
+                       , has_responded );
+}
+
 inline id const&
 lookup_task::get_key
     ( void )
@@ -260,12 +413,97 @@ inline void
 lookup_task::add_candidate
     ( peer const& p )
 {
+    auto const d = distance( p.id_, key_ );
+    auto const i = find_candidate_position( d );
+    if ( i != candidates_.end() && i->distance_ == d )
+        return;
+
+    // Contacted candidates dropped from the shortlist,
+    // e.g. after a timeout, aren't queried again.
+    if ( std::binary_search( dropped_candidates_.begin()
+                           , dropped_candidates_.end()
+                           , d ) )
+        return;
+
+    // Once k candidates responded, only closer candidates matter.
+    auto const last_responder = find_last_closest_responder();
+    if ( last_responder != candidates_.end() && last_responder < i )
+        return;
+
     LOG_DEBUG( lookup_task, this )
             << "adding '" << p << "'." << std::endl;
 
-    auto const d = distance( p.id_, key_ );
-    candidate const c{ p, candidate::STATE_UNKNOWN };
-    candidates_.emplace( d, c );
+    auto const index = std::size_t( i - candidates_.begin() );
+    candidates_.insert( i, candidate{ d, p, candidate::STATE_UNKNOWN } );
+
+    if ( index < first_unknown_candidate_ )
+        first_unknown_candidate_ = index;
+
+    drop_candidates_past_unknowns();
+}
+
+inline void
+lookup_task::drop_candidate
+    ( candidates_type::iterator i )
+{
+    // A request to it may still be in flight,
+    // and it isn't to be contacted again.
+    if ( i->state_ != candidate::STATE_UNKNOWN )
+        dropped_candidates_.insert( std::lower_bound( dropped_candidates_.begin()
+                                                    , dropped_candidates_.end()
+                                                    , i->distance_ )
+                                  , i->distance_ );
+
+    auto const index = std::size_t( i - candidates_.begin() );
+    candidates_.erase( i );
+
+    if ( index < first_unknown_candidate_ )
+        -- first_unknown_candidate_;
+}
+
+inline void
+lookup_task::drop_candidates_past_responders
+    ( void )
+{
+    auto const last_responder = find_last_closest_responder();
+    if ( last_responder == candidates_.end() )
+        return;
+
+    while ( std::prev( candidates_.end() ) != last_responder )
+        drop_candidate( std::prev( candidates_.end() ) );
+}
+
+inline void
+lookup_task::drop_candidates_past_unknowns
+    ( void )
+{
+    auto const has_responded = []( candidate const& c )
+    { return c.state_ == candidate::STATE_RESPONDED; };
+
+    auto const responders_count = std::size_t( std::count_if( candidates_.begin()
+                                                            , candidates_.end()
+                                                            , has_responded ) );
+    if ( candidates_.size() - responders_count <= max_candidates_count_ )
+        return;
+
+    auto i = std::prev( candidates_.end() );
+    while ( has_responded( *i ) )
+        -- i;
+
+    drop_candidate( i );
+}
+
+inline lookup_task::candidates_type::iterator
+lookup_task::find_last_closest_responder
+    ( void )
+{
+    std::size_t responders_count = 0;
+    for ( auto i = candidates_.begin(), e = candidates_.end(); i != e; ++ i )
+        if ( i->state_ == candidate::STATE_RESPONDED
+           && ++ responders_count == max_candidates_count_ )
+            return i;
+
+    return candidates_.end();
 }
 
 inline lookup_task::candidates_type::iterator
@@ -273,7 +511,22 @@ lookup_task::find_candidate
     ( id const& candidate_id )
 {
     auto const d = distance( candidate_id, key_ );
-    return candidates_.find( d );
+    auto const i = find_candidate_position( d );
+    if ( i == candidates_.end() || i->distance_ != d )
+        return candidates_.end();
+
+    return i;
+}
+
+inline lookup_task::candidates_type::iterator
+lookup_task::find_candidate_position
+    ( id const& candidate_distance )
+{
+    auto const is_closer = []( candidate const& c, id const& d )
+    { return c.distance_ < d; };
+
+    return std::lower_bound( candidates_.begin(), candidates_.end()
+                           , candidate_distance, is_closer );
 }
 
 } // namespace detail
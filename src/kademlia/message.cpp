@@ -25,9 +25,14 @@
 
 #include "kademlia/message.hpp"
 
+#include <algorithm>
 #include <iostream>
 
+#include <kademlia/session_base.hpp>
+
 #include "kademlia/error_impl.hpp"
+#include "kademlia/compression.hpp"
+#include "kademlia/varint.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -132,6 +137,9 @@ deserialize
     return std::error_code{};
 }
 
+/// Set in the version nibble of headers whose body value is compressed.
+CXX11_CONSTEXPR std::uint8_t HEADER_COMPRESSED_FLAG = 0x8;
+
 /**
  *
  */
@@ -140,15 +148,20 @@ deserialize
     ( buffer::const_iterator & i
     , buffer::const_iterator e
     , header::version & v
-    , header::type & t )
+    , header::type & t
+    , bool & is_compressed )
 {
     if ( std::distance( i, e ) < 1 )
         return make_error_code( TRUNCATED_HEADER );
 
-    v = static_cast< header::version >( *i & 0xf );
+    v = static_cast< header::version >( *i & ~HEADER_COMPRESSED_FLAG & 0xf );
     t = static_cast< header::type >( *i >> 4 );
+    is_compressed = ( *i & HEADER_COMPRESSED_FLAG ) != 0;
 
-    if ( v != header::V1 )
+    // Types unknown to this build belong to a newer protocol.
+    if ( v < header::V1 || v > get_latest_version() || v < get_version( t )
+       || t > header::STORE_VALUES_RESPONSE
+       || ( is_compressed && v < header::V3 ) )
         return make_error_code( UNKNOWN_PROTOCOL_VERSION );
 
     std::advance( i, 1 );
@@ -160,6 +173,58 @@ enum
     { KADEMLIA_ENDPOINT_SERIALIZATION_IPV4 = 1
     , KADEMLIA_ENDPOINT_SERIALIZATION_IPV6 = 2 };
 
+/**
+ *  @brief The fewest bytes an element of a list
+ *         can be serialized into.
+ *  @details Declared lists sizes are checked against
+ *           the remaining bytes before any allocation.
+ */
+template< typename ElementType >
+struct serialized_element_traits;
+
+template<>
+struct serialized_element_traits< id >
+{ enum { MIN_SIZE = id::BLOCKS_COUNT }; };
+
+// Id, port, IPv4 protocol and address.
+template<>
+struct serialized_element_traits< peer >
+{ enum { MIN_SIZE = id::BLOCKS_COUNT + 2 + 1 + 4 }; };
+
+// Key, found flag, and either an empty value or two empty peers lists.
+template<>
+struct serialized_element_traits< find_values_result >
+{ enum { MIN_SIZE = id::BLOCKS_COUNT + 1 + 1 }; };
+
+// Key, empty value and version.
+template<>
+struct serialized_element_traits< stored_value >
+{ enum { MIN_SIZE = id::BLOCKS_COUNT + 1 + 8 }; };
+
+/**
+ *  @return TRUNCATED_SIZE if count elements can't
+ *          fit in the bytes remaining in [i, e).
+ */
+template< typename ElementType >
+inline std::error_code
+check_elements_count
+    ( buffer::const_iterator i
+    , buffer::const_iterator e
+    , std::uint64_t count )
+{
+    std::size_t const min_size = serialized_element_traits< ElementType >::MIN_SIZE;
+    if ( count > std::uint64_t( std::distance( i, e ) ) / min_size )
+        return make_error_code( TRUNCATED_SIZE );
+
+    return std::error_code{};
+}
+
+enum
+    { COMPACT_PEERS_INITIAL_PORT = session_base::DEFAULT_PORT
+    // Prefix size, address and single byte port delta.
+    , COMPACT_IPV4_PEER_MIN_SIZE = 1 + 4 + 1
+    , COMPACT_IPV6_PEER_MIN_SIZE = 1 + 16 + 1 };
+
 /**
  *
  */
@@ -227,11 +292,8 @@ deserialize
 
         address = a;
     }
-    else
+    else if ( protocol == KADEMLIA_ENDPOINT_SERIALIZATION_IPV6 )
     {
-        assert( protocol == KADEMLIA_ENDPOINT_SERIALIZATION_IPV6
-              && "unknown IP version");
-
         boost::asio::ip::address_v6 a;
         auto const failure = deserialize_address( i, e, a );
         if ( failure )
@@ -239,6 +301,9 @@ deserialize
 
         address = a;
     }
+    // Peers only send IPv4 and IPv6 addresses.
+    else
+        return make_error_code( CORRUPTED_BODY );
 
     return std::error_code{};
 }
@@ -276,8 +341,377 @@ deserialize
     return deserialize( i, e, n.endpoint_.address_ );
 }
 
+/**
+ *  @brief Map a signed port delta to an unsigned
+ *         integer, small when the delta is small.
+ */
+inline std::uint64_t
+zigzag_encode
+    ( std::int64_t delta )
+{ return ( std::uint64_t( delta ) << 1 ) ^ ( delta < 0 ? ~0ULL : 0 ); }
+
+/**
+ *
+ */
+inline std::int64_t
+zigzag_decode
+    ( std::uint64_t value )
+{ return std::int64_t( value >> 1 ) ^ - std::int64_t( value & 1 ); }
+
+/**
+ *  @brief Serialize peers of the address family
+ *         selected by is_v4, relative to target.
+ */
+inline void
+serialize_compact_peers
+    ( std::vector< peer > const& peers
+    , bool is_v4
+    , id const& target
+    , buffer & b )
+{
+    std::int64_t previous_port = COMPACT_PEERS_INITIAL_PORT;
+
+    for ( auto const& p : peers )
+    {
+        if ( p.endpoint_.address_.is_v4() != is_v4 )
+            continue;
+
+        auto const prefix = std::mismatch( p.id_.begin(), p.id_.end()
+                                         , target.begin() ).first;
+        b.push_back( buffer::value_type( prefix - p.id_.begin() ) );
+        b.insert( b.end(), prefix, p.id_.end() );
+
+        if ( is_v4 )
+        {
+            auto const& a = p.endpoint_.address_.to_v4().to_bytes();
+            b.insert( b.end(), a.begin(), a.end() );
+        }
+        else
+        {
+            auto const& a = p.endpoint_.address_.to_v6().to_bytes();
+            b.insert( b.end(), a.begin(), a.end() );
+        }
+
+        serialize_varint( zigzag_encode( p.endpoint_.port_ - previous_port ), b );
+        previous_port = p.endpoint_.port_;
+    }
+}
+
+/**
+ *  @brief Deserialize count peers of the
+ *         Address family, relative to target.
+ */
+template< typename Address >
+inline std::error_code
+deserialize_compact_peers
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , std::uint64_t count
+    , id const& target
+    , std::vector< peer > & peers )
+{
+    std::int64_t previous_port = COMPACT_PEERS_INITIAL_PORT;
+
+    for ( ; count > 0; -- count )
+    {
+        if ( i == e )
+            return make_error_code( TRUNCATED_ID );
+
+        std::size_t const prefix_size = *i++;
+        if ( prefix_size > id::BLOCKS_COUNT )
+            return make_error_code( CORRUPTED_BODY );
+
+        auto const suffix_size = id::BLOCKS_COUNT - prefix_size;
+        if ( std::size_t( std::distance( i, e ) ) < suffix_size )
+            return make_error_code( TRUNCATED_ID );
+
+        peers.resize( peers.size() + 1 );
+        auto & p = peers.back();
+
+        auto const suffix = std::copy_n( target.begin(), prefix_size
+                                       , p.id_.begin() );
+        std::copy_n( i, suffix_size, suffix );
+        std::advance( i, suffix_size );
+
+        Address address;
+        auto failure = deserialize_address( i, e, address );
+        if ( failure )
+            return failure;
+
+        p.endpoint_.address_ = address;
+
+        std::uint64_t delta;
+        failure = deserialize_varint( i, e, delta );
+        if ( failure )
+            return failure;
+
+        auto const port = previous_port + zigzag_decode( delta );
+        if ( port < 0 || port > 0xffff )
+            return make_error_code( CORRUPTED_BODY );
+
+        p.endpoint_.port_ = std::uint16_t( port );
+        previous_port = port;
+    }
+
+    return std::error_code{};
+}
+
+/**
+ *  @brief Serialize peers grouped by address family,
+ *         each family prefixed by its varint count.
+ */
+inline void
+serialize_compact_peers
+    ( std::vector< peer > const& peers
+    , id const& target
+    , buffer & b )
+{
+    auto const v4_count = std::count_if( peers.begin(), peers.end()
+                                       , []( peer const& p )
+                                       { return p.endpoint_.address_.is_v4(); } );
+    serialize_varint( std::uint64_t( v4_count ), b );
+    serialize_varint( peers.size() - v4_count, b );
+
+    serialize_compact_peers( peers, true, target, b );
+    serialize_compact_peers( peers, false, target, b );
+}
+
+/**
+ *
+ */
+inline std::error_code
+deserialize_compact_peers
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , id const& target
+    , std::vector< peer > & peers )
+{
+    std::uint64_t v4_count;
+    auto failure = deserialize_varint( i, e, v4_count );
+    if ( failure )
+        return failure;
+
+    std::uint64_t v6_count;
+    failure = deserialize_varint( i, e, v6_count );
+    if ( failure )
+        return failure;
+
+    // A peer takes at least its prefix size,
+    // address and port bytes: reject absurd
+    // counts before allocating anything.
+    auto const remaining = std::uint64_t( std::distance( i, e ) );
+    if ( v4_count > remaining / COMPACT_IPV4_PEER_MIN_SIZE
+       || v6_count > remaining / COMPACT_IPV6_PEER_MIN_SIZE
+       || v4_count * COMPACT_IPV4_PEER_MIN_SIZE
+          + v6_count * COMPACT_IPV6_PEER_MIN_SIZE > remaining )
+        return make_error_code( TRUNCATED_SIZE );
+
+    peers.reserve( peers.size() + v4_count + v6_count );
+
+    failure = deserialize_compact_peers< boost::asio::ip::address_v4 >
+            ( i, e, v4_count, target, peers );
+    if ( failure )
+        return failure;
+
+    return deserialize_compact_peers< boost::asio::ip::address_v6 >
+            ( i, e, v6_count, target, peers );
+}
+
+/**
+ *  @brief Serialize data within a V2 message,
+ *         prefixed by its varint size.
+ */
+inline void
+serialize_data
+    ( std::vector< std::uint8_t > const& data
+    , buffer & b )
+{
+    serialize_varint( data.size(), b );
+    b.insert( b.end(), data.begin(), data.end() );
+}
+
+/**
+ *
+ */
+inline std::error_code
+deserialize_data
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , std::vector< std::uint8_t > & data )
+{
+    std::uint64_t size;
+    auto failure = deserialize_varint( i, e, size );
+    if ( failure )
+        return failure;
+
+    if ( std::uint64_t( std::distance( i, e ) ) < size )
+        return make_error_code( CORRUPTED_BODY );
+
+    e = std::next( i, size );
+    data.assign( i, e );
+    i = e;
+
+    return std::error_code{};
+}
+
+/**
+ *  @brief Serialize the elements of a V2 message,
+ *         prefixed by their varint count.
+ */
+template< typename ElementType >
+inline void
+serialize_elements
+    ( std::vector< ElementType > const& elements
+    , buffer & b )
+{
+    serialize_varint( elements.size(), b );
+
+    for ( auto const& element : elements )
+        serialize( element, b );
+}
+
+/**
+ *
+ */
+template< typename ElementType >
+inline std::error_code
+deserialize_elements
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , std::vector< ElementType > & elements )
+{
+    std::uint64_t size;
+    auto failure = deserialize_varint( i, e, size );
+    if ( failure )
+        return failure;
+
+    failure = check_elements_count< ElementType >( i, e, size );
+    if ( failure )
+        return failure;
+
+    elements.reserve( elements.size() + size );
+
+    for (
+        ; size > 0 && ! failure
+        ; -- size )
+    {
+        elements.resize( elements.size() + 1 );
+        failure = deserialize( i, e, elements.back() );
+    }
+
+    return failure;
+}
+
+/**
+ *  @return true if the chunk_index chunk of a value_size
+ *          bytes value may be size bytes long.
+ */
+bool
+is_chunk_size_valid
+    ( std::uint64_t chunk_index
+    , std::uint64_t size
+    , std::size_t chunk_size
+    , std::size_t value_size )
+{
+    auto const offset = chunk_index * chunk_size;
+    return size == std::min< std::uint64_t >( chunk_size, value_size - offset );
+}
+
 } // anonymous namespace
 
+header::version
+get_version
+    ( header::type const& t )
+{
+    switch ( t )
+    {
+        case header::FIND_VALUES_REQUEST:
+        case header::FIND_VALUES_RESPONSE:
+        case header::STORE_VALUES_REQUEST:
+        case header::STORE_VALUES_RESPONSE:
+            return header::V2;
+        default:
+            return header::V1;
+    }
+}
+
+bool
+is_request
+    ( header::type const& t )
+{
+    switch ( t )
+    {
+        case header::PING_REQUEST:
+        case header::STORE_REQUEST:
+        case header::FIND_PEER_REQUEST:
+        case header::FIND_VALUE_REQUEST:
+        case header::STORE_CHUNK_REQUEST:
+        case header::FIND_CHUNK_REQUEST:
+        case header::FIND_VALUES_REQUEST:
+        case header::STORE_VALUES_REQUEST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+header::version
+get_latest_version
+    ( void )
+{
+    return is_compression_enabled() ? header::V3 : header::V2;
+}
+
+void
+serialize_version_trailer
+    ( header const& h
+    , buffer & b )
+{
+    if ( h.version_ != header::V1 )
+        return;
+
+    switch ( h.type_ )
+    {
+        case header::FIND_PEER_REQUEST:
+        case header::FIND_VALUE_REQUEST:
+            b.push_back( buffer::value_type( get_latest_version() ) );
+            break;
+        default:
+            break;
+    }
+}
+
+header::version
+get_sender_version
+    ( header const& h
+    , buffer::const_iterator i
+    , buffer::const_iterator e )
+{
+    if ( h.version_ != header::V1 )
+        return std::min( h.version_, get_latest_version() );
+
+    // The body of both requests only contains an id.
+    id ignored;
+    switch ( h.type_ )
+    {
+        case header::FIND_PEER_REQUEST:
+        case header::FIND_VALUE_REQUEST:
+            if ( deserialize( i, e, ignored ) )
+                return header::V1;
+            break;
+        default:
+            return header::V1;
+    }
+
+    std::uint8_t version;
+    if ( deserialize_integer( i, e, version ) || i != e
+       || version < header::V1 )
+        return header::V1;
+
+    return std::min( static_cast< header::version >( version )
+                   , get_latest_version() );
+}
+
 std::ostream &
 operator<<
     ( std::ostream & out
@@ -301,6 +735,22 @@ operator<<
             return out << "find_value_request";
         case header::FIND_VALUE_RESPONSE:
             return out << "find_value_response";
+        case header::STORE_RESPONSE:
+            return out << "store_response";
+        case header::STORE_CHUNK_REQUEST:
+            return out << "store_chunk_request";
+        case header::FIND_CHUNK_REQUEST:
+            return out << "find_chunk_request";
+        case header::FIND_CHUNK_RESPONSE:
+            return out << "find_chunk_response";
+        case header::FIND_VALUES_REQUEST:
+            return out << "find_values_request";
+        case header::FIND_VALUES_RESPONSE:
+            return out << "find_values_response";
+        case header::STORE_VALUES_REQUEST:
+            return out << "store_values_request";
+        case header::STORE_VALUES_RESPONSE:
+            return out << "store_values_response";
     }
 }
 
@@ -317,7 +767,9 @@ serialize
     ( header const& h
     , buffer & b )
 {
-    b.push_back( h.version_ | h.type_ << 4 );
+    b.push_back( h.version_
+               | ( h.is_compressed_ ? HEADER_COMPRESSED_FLAG : 0 )
+               | h.type_ << 4 );
     serialize( h.source_id_, b );
     serialize( h.random_token_, b );
 }
@@ -328,7 +780,7 @@ deserialize
     , buffer::const_iterator e
     , header & h )
 {
-    auto failure = deserialize( i, e, h.version_, h.type_ );
+    auto failure = deserialize( i, e, h.version_, h.type_, h.is_compressed_ );
     if ( failure )
         return failure;
 
@@ -375,6 +827,14 @@ deserialize
 {
     std::uint64_t size;
     auto failure = deserialize_integer( i, e, size );
+    if ( failure )
+        return failure;
+
+    failure = check_elements_count< peer >( i, e, size );
+    if ( failure )
+        return failure;
+
+    body.peers_.reserve( body.peers_.size() + size );
 
     for (
         ; size > 0 && ! failure
@@ -387,6 +847,37 @@ deserialize
     return failure;
 }
 
+void
+serialize
+    ( find_peer_compact_response_body const& body
+    , buffer & b )
+{
+    serialize_compact_peers( body.peers_, body.target_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_peer_compact_response_body & body )
+{
+    return deserialize_compact_peers( i, e, body.target_, body.peers_ );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , header::version const& version
+    , id const& target
+    , find_peer_response_body & body )
+{
+    if ( version < header::V2 )
+        return deserialize( i, e, body );
+
+    return deserialize_compact_peers( i, e, target, body.peers_ );
+}
+
 void
 serialize
     ( find_value_request_body const& body
@@ -410,6 +901,13 @@ serialize
     , buffer & b )
 {
     serialize( body.data_, b );
+
+    // Unversioned values are sent as V1 peers expect them.
+    if ( body.version_ > 0 || body.chunked_value_size_ > 0 )
+        serialize_integer( body.version_, b );
+
+    if ( body.chunked_value_size_ > 0 )
+        serialize_integer( body.chunked_value_size_, b );
 }
 
 std::error_code
@@ -418,7 +916,21 @@ deserialize
     , buffer::const_iterator e
     , find_value_response_body & body )
 {
-    return deserialize( i, e, body.data_ );
+    auto failure = deserialize( i, e, body.data_ );
+    if ( failure )
+        return failure;
+
+    body.version_ = 0;
+    body.chunked_value_size_ = 0;
+    body.is_compressed_ = false;
+    if ( i == e )
+        return std::error_code{};
+
+    failure = deserialize_integer( i, e, body.version_ );
+    if ( failure || i == e )
+        return failure;
+
+    return deserialize_integer( i, e, body.chunked_value_size_ );
 }
 
 void
@@ -429,6 +941,17 @@ serialize
     serialize( body.data_key_hash_, b );
 
     serialize( body.data_value_, b );
+
+    // Permanent unversioned values are sent as V1 peers expect them.
+    if ( body.ttl_.count() > 0 || body.version_ > 0
+       || body.is_acknowledgement_requested_ )
+        serialize_integer( std::uint64_t( body.ttl_.count() ), b );
+
+    if ( body.version_ > 0 || body.is_acknowledgement_requested_ )
+        serialize_integer( body.version_, b );
+
+    if ( body.is_acknowledgement_requested_ )
+        b.push_back( 1 );
 }
 
 std::error_code
@@ -441,7 +964,323 @@ deserialize
     if ( failure )
         return failure;
 
-    return deserialize( i, e, body.data_value_ );
+    failure = deserialize( i, e, body.data_value_ );
+    if ( failure )
+        return failure;
+
+    body.ttl_ = std::chrono::seconds::zero();
+    body.version_ = 0;
+    body.is_compressed_ = false;
+    body.is_acknowledgement_requested_ = false;
+    if ( i == e )
+        return std::error_code{};
+
+    std::uint64_t ttl;
+    failure = deserialize_integer( i, e, ttl );
+    if ( failure )
+        return failure;
+
+    body.ttl_ = std::chrono::seconds( ttl );
+
+    body.version_ = 0;
+    if ( i == e )
+        return std::error_code{};
+
+    failure = deserialize_integer( i, e, body.version_ );
+    if ( failure || i == e )
+        return failure;
+
+    body.is_acknowledgement_requested_ = *i++ != 0;
+
+    return std::error_code{};
+}
+
+void
+serialize
+    ( store_value_response_body const&
+    , buffer & )
+{ }
+
+std::error_code
+deserialize
+    ( buffer::const_iterator &
+    , buffer::const_iterator
+    , store_value_response_body & )
+{ return std::error_code{}; }
+
+void
+serialize
+    ( store_chunk_request_body const& body
+    , buffer & b )
+{
+    serialize( body.data_key_hash_, b );
+    serialize_integer( body.version_, b );
+    serialize_integer( body.value_size_, b );
+    serialize_integer( body.chunk_index_, b );
+    serialize( body.chunk_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , store_chunk_request_body & body )
+{
+    auto failure = deserialize( i, e, body.data_key_hash_ );
+    if ( failure )
+        return failure;
+
+    failure = deserialize_integer( i, e, body.version_ );
+    if ( failure )
+        return failure;
+
+    failure = deserialize_integer( i, e, body.value_size_ );
+    if ( failure )
+        return failure;
+
+    failure = deserialize_integer( i, e, body.chunk_index_ );
+    if ( failure )
+        return failure;
+
+    body.is_compressed_ = false;
+    return deserialize( i, e, body.chunk_ );
+}
+
+void
+serialize
+    ( find_chunk_request_body const& body
+    , buffer & b )
+{
+    serialize( body.data_key_hash_, b );
+    serialize_integer( body.version_, b );
+    serialize_integer( body.chunk_index_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_chunk_request_body & body )
+{
+    auto failure = deserialize( i, e, body.data_key_hash_ );
+    if ( failure )
+        return failure;
+
+    failure = deserialize_integer( i, e, body.version_ );
+    if ( failure )
+        return failure;
+
+    return deserialize_integer( i, e, body.chunk_index_ );
+}
+
+void
+serialize
+    ( find_chunk_response_body const& body
+    , buffer & b )
+{
+    serialize_integer( body.chunk_index_, b );
+    serialize( body.chunk_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_chunk_response_body & body )
+{
+    auto failure = deserialize_integer( i, e, body.chunk_index_ );
+    if ( failure )
+        return failure;
+
+    body.is_compressed_ = false;
+    return deserialize( i, e, body.chunk_ );
+}
+
+std::error_code
+deserialize_chunk
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , std::size_t chunk_size
+    , std::vector< std::uint8_t > & value
+    , std::uint64_t & chunk_index )
+{
+    auto failure = deserialize_integer( i, e, chunk_index );
+    if ( failure )
+        return failure;
+
+    if ( chunk_index >= get_chunks_count( value.size(), chunk_size ) )
+        return make_error_code( CORRUPTED_BODY );
+
+    std::uint64_t size;
+    failure = deserialize_integer( i, e, size );
+    if ( failure )
+        return failure;
+
+    if ( ! is_chunk_size_valid( chunk_index, size, chunk_size, value.size() )
+       || std::uint64_t( std::distance( i, e ) ) < size )
+        return make_error_code( CORRUPTED_BODY );
+
+    e = std::next( i, size );
+    std::copy( i, e, std::next( value.begin(), chunk_index * chunk_size ) );
+    i = e;
+
+    return std::error_code{};
+}
+
+std::error_code
+copy_chunk
+    ( std::uint64_t chunk_index
+    , std::vector< std::uint8_t > const& chunk
+    , std::size_t chunk_size
+    , std::vector< std::uint8_t > & value )
+{
+    if ( chunk_index >= get_chunks_count( value.size(), chunk_size )
+       || ! is_chunk_size_valid( chunk_index, chunk.size()
+                               , chunk_size, value.size() ) )
+        return make_error_code( CORRUPTED_BODY );
+
+    std::copy( chunk.begin(), chunk.end()
+             , std::next( value.begin(), chunk_index * chunk_size ) );
+
+    return std::error_code{};
+}
+
+void
+serialize
+    ( find_values_request_body const& body
+    , buffer & b )
+{
+    serialize_elements( body.values_to_find_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_values_request_body & body )
+{
+    return deserialize_elements( i, e, body.values_to_find_ );
+}
+
+void
+serialize
+    ( find_values_result const& result
+    , buffer & b )
+{
+    serialize( result.key_, b );
+    b.push_back( result.is_found_ ? 1 : 0 );
+
+    if ( result.is_found_ )
+    {
+        serialize_data( result.data_, b );
+        serialize_integer( result.version_, b );
+    }
+    else
+        serialize_compact_peers( result.peers_, result.key_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_values_result & result )
+{
+    auto failure = deserialize( i, e, result.key_ );
+    if ( failure )
+        return failure;
+
+    if ( i == e )
+        return make_error_code( CORRUPTED_BODY );
+
+    result.is_found_ = *i++ != 0;
+    result.version_ = 0;
+
+    if ( ! result.is_found_ )
+        return deserialize_compact_peers( i, e, result.key_, result.peers_ );
+
+    failure = deserialize_data( i, e, result.data_ );
+    if ( failure )
+        return failure;
+
+    return deserialize_integer( i, e, result.version_ );
+}
+
+void
+serialize
+    ( find_values_response_body const& body
+    , buffer & b )
+{
+    serialize_elements( body.results_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_values_response_body & body )
+{
+    return deserialize_elements( i, e, body.results_ );
+}
+
+void
+serialize
+    ( stored_value const& value
+    , buffer & b )
+{
+    serialize( value.data_key_hash_, b );
+    serialize_data( value.data_value_, b );
+    serialize_integer( value.version_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , stored_value & value )
+{
+    auto failure = deserialize( i, e, value.data_key_hash_ );
+    if ( failure )
+        return failure;
+
+    failure = deserialize_data( i, e, value.data_value_ );
+    if ( failure )
+        return failure;
+
+    return deserialize_integer( i, e, value.version_ );
+}
+
+void
+serialize
+    ( store_values_request_body const& body
+    , buffer & b )
+{
+    serialize_elements( body.values_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , store_values_request_body & body )
+{
+    return deserialize_elements( i, e, body.values_ );
+}
+
+void
+serialize
+    ( store_values_response_body const& body
+    , buffer & b )
+{
+    serialize_elements( body.stored_keys_, b );
+}
+
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , store_values_response_body & body )
+{
+    return deserialize_elements( i, e, body.stored_keys_ );
 }
 
 } // namespace detail
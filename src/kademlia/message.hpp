@@ -31,6 +31,7 @@
 #endif
 
 #include <iosfwd>
+#include <chrono>
 #include <cstdint>
 #include <algorithm>
 #include <system_error>
@@ -43,6 +44,7 @@
 #include "kademlia/peer.hpp"
 #include "kademlia/id.hpp"
 #include "kademlia/buffer.hpp"
+#include "kademlia/constants.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -56,6 +58,11 @@ struct header final
     {
         ///
         V1 = 1,
+        /// Adds the multi-key messages, whose counts
+        /// and sizes are encoded as varints.
+        V2 = 2,
+        /// Adds compressed values, flagged by is_compressed_.
+        V3 = 3,
     } version_;
 
     ///
@@ -75,12 +82,32 @@ struct header final
         FIND_VALUE_REQUEST,
         ///
         FIND_VALUE_RESPONSE,
+        ///
+        STORE_RESPONSE,
+        ///
+        STORE_CHUNK_REQUEST,
+        ///
+        FIND_CHUNK_REQUEST,
+        ///
+        FIND_CHUNK_RESPONSE,
+        ///
+        FIND_VALUES_REQUEST,
+        ///
+        FIND_VALUES_RESPONSE,
+        ///
+        STORE_VALUES_REQUEST,
+        ///
+        STORE_VALUES_RESPONSE,
     } type_;
 
     ///
     id source_id_;
     ///
     id random_token_;
+    /// The value carried by the body is compressed.
+    /// @note Sent within the version byte, hence
+    ///       V1 peers reject it as an unknown version.
+    bool is_compressed_;
 };
 
 /**
@@ -99,6 +126,56 @@ operator<<
     ( std::ostream & out
     , header const& h );
 
+/**
+ *  @return The oldest protocol version knowing messages of type t.
+ *  @note Messages are sent with this version in their header,
+ *        hence V1 peers can still parse V1 messages sent by
+ *        newer peers, and reject the messages they don't know.
+ */
+header::version
+get_version
+    ( header::type const& t );
+
+/**
+ *  @return true if messages of type t are requests,
+ *          false if they answer a request.
+ */
+bool
+is_request
+    ( header::type const& t );
+
+/**
+ *  @return The highest protocol version spoken by this build.
+ */
+header::version
+get_latest_version
+    ( void );
+
+/**
+ *  @brief Append the latest version of this build to the
+ *         lookup request headed by h if it has a V1 header.
+ *  @details V1 peers ignore the bytes following the body of
+ *           these requests, newer ones learn our version and
+ *           answer with it, hence both peers negotiate their
+ *           version from single key lookups.
+ */
+void
+serialize_version_trailer
+    ( header const& h
+    , buffer & b );
+
+/**
+ *  @return The highest version spoken by the sender of the message
+ *          headed by h, i.e. the version advertised after the body
+ *          of a V1 lookup request, or the header version otherwise.
+ *  @note The version is capped to the latest one of this build.
+ */
+header::version
+get_sender_version
+    ( header const& h
+    , buffer::const_iterator i
+    , buffer::const_iterator e );
+
 /**
  *
  */
@@ -189,6 +266,57 @@ deserialize
     , buffer::const_iterator e
     , find_peer_response_body & body );
 
+/**
+ *  @brief A find_peer_response_body sent to V2 peers.
+ *  @details Peers are grouped by address family. Each id is sent as
+ *           the length of its prefix shared with target_, followed
+ *           by its remaining bytes, and each port as a varint delta
+ *           from the previous one of its family.
+ */
+struct find_peer_compact_response_body final
+{
+    /// The requested id, known by both ends and never sent.
+    id target_;
+    ///
+    std::vector< peer > peers_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< find_peer_compact_response_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::FIND_PEER_RESPONSE; };
+
+/**
+ *
+ */
+void
+serialize
+    ( find_peer_compact_response_body const& body
+    , buffer & b );
+
+/**
+ *  @pre body.target_ is the requested id.
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_peer_compact_response_body & body );
+
+/**
+ *  @brief Deserialize a find peer response
+ *         in the format of its header version.
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , header::version const& version
+    , id const& target
+    , find_peer_response_body & body );
+
 /**
  *
  */
@@ -229,6 +357,17 @@ struct find_value_response_body final
 {
     ///
     std::vector< std::uint8_t > data_;
+    /// Version of the value, 0 if unknown.
+    /// @note This field is optional on the wire.
+    std::uint64_t version_;
+    /// Size of a value stored by chunks, 0 otherwise.
+    /// When not 0, data_ is empty and this body is the
+    /// manifest used to fetch the value chunks.
+    /// @note This field is optional on the wire.
+    std::uint64_t chunked_value_size_;
+    /// data_ is compressed.
+    /// @note This field is sent within the header.
+    bool is_compressed_;
 };
 
 /**
@@ -265,6 +404,19 @@ struct store_value_request_body final
     id data_key_hash_;
     ///
     std::vector< std::uint8_t > data_value_;
+    /// Time to live of a cached copy, 0 if the value doesn't expire.
+    /// @note This field is optional on the wire.
+    std::chrono::seconds ttl_;
+    /// Version of the value set by its publisher, 0 if unknown.
+    /// @note This field is optional on the wire.
+    std::uint64_t version_;
+    /// data_value_ is compressed.
+    /// @note This field is sent within the header.
+    bool is_compressed_;
+    /// The receiver acknowledges the store with
+    /// a store_value_response_body.
+    /// @note This field is optional on the wire.
+    bool is_acknowledgement_requested_;
 };
 
 /**
@@ -292,6 +444,458 @@ deserialize
     , buffer::const_iterator e
     , store_value_request_body & body );
 
+/**
+ *  @brief Acknowledge a store_value_request_body.
+ */
+struct store_value_response_body final
+{ };
+
+/**
+ *
+ */
+template<>
+struct message_traits< store_value_response_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::STORE_RESPONSE; };
+
+/**
+ *
+ */
+void
+serialize
+    ( store_value_response_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , store_value_response_body & body );
+
+/**
+ *  @return The count of chunk_size bytes chunks of a value.
+ */
+inline std::size_t
+get_chunks_count
+    ( std::size_t value_size
+    , std::size_t chunk_size )
+{ return ( value_size + chunk_size - 1 ) / chunk_size; }
+
+/**
+ *  @brief Store one chunk of a value too large
+ *         for a single message.
+ */
+struct store_chunk_request_body final
+{
+    ///
+    id data_key_hash_;
+    ///
+    std::uint64_t version_;
+    ///
+    std::uint64_t value_size_;
+    ///
+    std::uint64_t chunk_index_;
+    ///
+    std::vector< std::uint8_t > chunk_;
+    /// chunk_ is compressed, value_size_ is not.
+    /// @note This field is sent within the header.
+    bool is_compressed_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< store_chunk_request_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::STORE_CHUNK_REQUEST; };
+
+/**
+ *
+ */
+void
+serialize
+    ( store_chunk_request_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , store_chunk_request_body & body );
+
+/**
+ *
+ */
+struct find_chunk_request_body final
+{
+    ///
+    id data_key_hash_;
+    ///
+    std::uint64_t version_;
+    ///
+    std::uint64_t chunk_index_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< find_chunk_request_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::FIND_CHUNK_REQUEST; };
+
+/**
+ *
+ */
+void
+serialize
+    ( find_chunk_request_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_chunk_request_body & body );
+
+/**
+ *
+ */
+struct find_chunk_response_body final
+{
+    ///
+    std::uint64_t chunk_index_;
+    ///
+    std::vector< std::uint8_t > chunk_;
+    /// chunk_ is compressed.
+    /// @note This field is sent within the header.
+    bool is_compressed_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< find_chunk_response_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::FIND_CHUNK_RESPONSE; };
+
+/**
+ *
+ */
+void
+serialize
+    ( find_chunk_response_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_chunk_response_body & body );
+
+/**
+ *  @brief Deserialize a find_chunk_response_body, copying its
+ *         chunk straight to its place in value.
+ *  @details value is already sized, and its chunks are
+ *           chunk_size bytes long but the last one.
+ */
+std::error_code
+deserialize_chunk
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , std::size_t chunk_size
+    , std::vector< std::uint8_t > & value
+    , std::uint64_t & chunk_index );
+
+/**
+ *  @brief Copy the chunk_index chunk at its place in value.
+ *  @details value is already sized, and its chunks are
+ *           chunk_size bytes long but the last one.
+ *  @return CORRUPTED_BODY if chunk doesn't fit there.
+ */
+std::error_code
+copy_chunk
+    ( std::uint64_t chunk_index
+    , std::vector< std::uint8_t > const& chunk
+    , std::size_t chunk_size
+    , std::vector< std::uint8_t > & value );
+
+/**
+ *  @brief Look up several values at once.
+ */
+struct find_values_request_body final
+{
+    ///
+    std::vector< id > values_to_find_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< find_values_request_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::FIND_VALUES_REQUEST; };
+
+/**
+ *
+ */
+void
+serialize
+    ( find_values_request_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_values_request_body & body );
+
+/**
+ *  @brief The outcome of the lookup of one key
+ *         of a find_values_request_body.
+ */
+struct find_values_result final
+{
+    ///
+    id key_;
+    ///
+    bool is_found_;
+    /// The value, if found.
+    std::vector< std::uint8_t > data_;
+    /// The value version, if found.
+    std::uint64_t version_;
+    /// Peers closer to key_, if not found,
+    /// sent as in a find_peer_compact_response_body.
+    std::vector< peer > peers_;
+};
+
+/**
+ *
+ */
+void
+serialize
+    ( find_values_result const& result
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_values_result & result );
+
+/**
+ *  @note Keys whose result doesn't fit in a
+ *        single datagram are left out.
+ */
+struct find_values_response_body final
+{
+    ///
+    std::vector< find_values_result > results_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< find_values_response_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::FIND_VALUES_RESPONSE; };
+
+/**
+ *
+ */
+void
+serialize
+    ( find_values_response_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , find_values_response_body & body );
+
+/**
+ *  @brief One value of a store_values_request_body.
+ */
+struct stored_value final
+{
+    ///
+    id data_key_hash_;
+    ///
+    std::vector< std::uint8_t > data_value_;
+    ///
+    std::uint64_t version_;
+};
+
+/**
+ *
+ */
+void
+serialize
+    ( stored_value const& value
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , stored_value & value );
+
+/**
+ *  @brief Store several values at once.
+ */
+struct store_values_request_body final
+{
+    ///
+    std::vector< stored_value > values_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< store_values_request_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::STORE_VALUES_REQUEST; };
+
+/**
+ *
+ */
+void
+serialize
+    ( store_values_request_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , store_values_request_body & body );
+
+/**
+ *  @brief Acknowledge the values of a store_values_request_body.
+ */
+struct store_values_response_body final
+{
+    ///
+    std::vector< id > stored_keys_;
+};
+
+/**
+ *
+ */
+template<>
+struct message_traits< store_values_response_body >
+{ static CXX11_CONSTEXPR header::type TYPE_ID = header::STORE_VALUES_RESPONSE; };
+
+/**
+ *
+ */
+void
+serialize
+    ( store_values_response_body const& body
+    , buffer & b );
+
+/**
+ *
+ */
+std::error_code
+deserialize
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , store_values_response_body & body );
+
+/**
+ *  @return true if the value carried by message is compressed.
+ */
+template< typename MessageType >
+bool
+is_compressed
+    ( MessageType const& )
+{ return false; }
+
+/**
+ *
+ */
+inline bool
+is_compressed
+    ( find_value_response_body const& body )
+{ return body.is_compressed_; }
+
+/**
+ *
+ */
+inline bool
+is_compressed
+    ( store_value_request_body const& body )
+{ return body.is_compressed_; }
+
+/**
+ *
+ */
+inline bool
+is_compressed
+    ( store_chunk_request_body const& body )
+{ return body.is_compressed_; }
+
+/**
+ *
+ */
+inline bool
+is_compressed
+    ( find_chunk_response_body const& body )
+{ return body.is_compressed_; }
+
+/**
+ *  @return The size of message once serialized.
+ */
+template< typename MessageType >
+std::size_t
+get_serialized_size
+    ( MessageType const& message )
+{
+    buffer b;
+    serialize( message, b );
+    return b.size();
+}
+
+/**
+ *  @return true if message, once headed, fits
+ *          in a single datagram.
+ */
+template< typename MessageType >
+bool
+fits_in_datagram
+    ( MessageType const& message )
+{
+    return get_serialized_size( header{} ) + get_serialized_size( message )
+            <= MESSAGE_MAX_SIZE;
+}
+
 } // namespace detail
 } // namespace kademlia
 
@@ -0,0 +1,262 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_MESSAGE_FILTER_HPP
+#define KADEMLIA_MESSAGE_FILTER_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <boost/functional/hash.hpp>
+
+#include "kademlia/admission_controller.hpp"
+#include "kademlia/ip_endpoint.hpp"
+#include "kademlia/message.hpp"
+#include "kademlia/token_bucket_sketch.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class drops unwanted messages before
+ *         they reach the routing table.
+ *  @details
+ *  A message is dropped when its header is invalid,
+ *  when it is a response to no outstanding request,
+ *  when its request is shed by the admission controller
+ *  or when its sender address or network prefix exceeds
+ *  its requests rate limit. Chunk requests are rate limited
+ *  by sender address within their own, larger, budget as
+ *  a large value is transferred by thousands of them,
+ *  their memory being bounded by the chunk assemblies.
+ *  Awaited responses aren't rate limited, their count
+ *  being bounded by our own requests.
+ */
+class message_filter final
+{
+public:
+    ///
+    using clock = token_bucket_sketch::clock;
+
+    ///
+    struct statistics final
+    {
+        ///
+        std::uint64_t invalid_headers_count_;
+        ///
+        std::uint64_t unassociated_responses_count_;
+        ///
+        std::uint64_t shed_stores_count_;
+        ///
+        std::uint64_t shed_find_values_count_;
+        ///
+        std::uint64_t rate_limited_addresses_count_;
+        ///
+        std::uint64_t rate_limited_prefixes_count_;
+        ///
+        std::uint64_t rate_limited_chunks_count_;
+    };
+
+public:
+    /**
+     *  @param address_buckets Rate limits requests by sender address.
+     *  @param prefix_buckets Rate limits requests by sender network prefix.
+     *  @param chunk_buckets Rate limits chunk requests by sender address.
+     *  @param admission Sheds requests when the event loop lags.
+     */
+    message_filter
+        ( token_bucket_sketch address_buckets
+        , token_bucket_sketch prefix_buckets
+        , token_bucket_sketch chunk_buckets
+        , admission_controller const& admission )
+            : address_buckets_( std::move( address_buckets ) )
+            , prefix_buckets_( std::move( prefix_buckets ) )
+            , chunk_buckets_( std::move( chunk_buckets ) )
+            , admission_( admission )
+            , statistics_()
+    { }
+
+    /**
+     *
+     */
+    message_filter
+        ( message_filter const& )
+        = delete;
+
+    /**
+     *
+     */
+    message_filter &
+    operator=
+        ( message_filter const& )
+        = delete;
+
+    /**
+     *  @brief Deserialize the header of a message
+     *         and check it should be processed.
+     *  @param is_awaited_response Tells whether a
+     *         response token belongs to an outstanding request.
+     *  @return true if the message should be processed,
+     *          in which case h and i are updated.
+     */
+    template< typename IsAwaitedResponse >
+    bool
+    accept
+        ( ip_endpoint const& sender
+        , buffer::const_iterator & i
+        , buffer::const_iterator e
+        , header & h
+        , clock::time_point const& now
+        , IsAwaitedResponse const& is_awaited_response )
+    {
+        if ( deserialize( i, e, h ) )
+        {
+            ++ statistics_.invalid_headers_count_;
+            return false;
+        }
+
+        if ( ! is_request( h.type_ )
+           && ! is_awaited_response( h.random_token_ ) )
+        {
+            ++ statistics_.unassociated_responses_count_;
+            return false;
+        }
+
+        switch ( admission_.admit( h.type_ ) )
+        {
+            case admission_controller::STORE_SHED:
+                ++ statistics_.shed_stores_count_;
+                return false;
+            case admission_controller::FIND_VALUE_SHED:
+                ++ statistics_.shed_find_values_count_;
+                return false;
+            default:
+                break;
+        }
+
+        if ( ! is_request( h.type_ ) )
+            return true;
+
+        if ( h.type_ == header::STORE_CHUNK_REQUEST
+           || h.type_ == header::FIND_CHUNK_REQUEST )
+        {
+            if ( chunk_buckets_.consume( hash_address( sender.address_ ), now ) )
+                return true;
+
+            ++ statistics_.rate_limited_chunks_count_;
+            return false;
+        }
+
+        if ( ! address_buckets_.consume( hash_address( sender.address_ ), now ) )
+        {
+            ++ statistics_.rate_limited_addresses_count_;
+            return false;
+        }
+
+        if ( ! prefix_buckets_.consume( hash_prefix( sender.address_ ), now ) )
+        {
+            ++ statistics_.rate_limited_prefixes_count_;
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     *  @brief Report the delay by which the event loop
+     *         handles its events.
+     */
+    void
+    update_event_loop_lag
+        ( admission_controller::duration const& lag )
+    { admission_.update_lag( lag ); }
+
+    /**
+     *
+     */
+    statistics const&
+    get_statistics
+        ( void )
+        const
+    { return statistics_; }
+
+private:
+    /**
+     *
+     */
+    static std::size_t
+    hash_address
+        ( boost::asio::ip::address const& address )
+    {
+        if ( address.is_v4() )
+        {
+            auto const bytes = address.to_v4().to_bytes();
+            return boost::hash_range( bytes.begin(), bytes.end() );
+        }
+
+        auto const bytes = address.to_v6().to_bytes();
+        return boost::hash_range( bytes.begin(), bytes.end() );
+    }
+
+    /**
+     *  @return The hash of the /24 IPv4 or /48 IPv6
+     *          network of address, usually owned by
+     *          a single host or organization.
+     */
+    static std::size_t
+    hash_prefix
+        ( boost::asio::ip::address const& address )
+    {
+        if ( address.is_v4() )
+        {
+            auto const bytes = address.to_v4().to_bytes();
+            return boost::hash_range( bytes.begin(), bytes.begin() + 3 );
+        }
+
+        auto const bytes = address.to_v6().to_bytes();
+        return boost::hash_range( bytes.begin(), bytes.begin() + 6 );
+    }
+
+private:
+    ///
+    token_bucket_sketch address_buckets_;
+    ///
+    token_bucket_sketch prefix_buckets_;
+    ///
+    token_bucket_sketch chunk_buckets_;
+    ///
+    admission_controller admission_;
+    ///
+    statistics statistics_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
@@ -25,6 +25,8 @@
 
 #include "kademlia/message_serializer.hpp"
 
+#include <algorithm>
+
 namespace kademlia {
 namespace detail {
 
@@ -36,21 +38,25 @@ message_serializer::message_serializer
 header
 message_serializer::generate_header
     ( header::type const& type
-    , id const& token )
+    , id const& token
+    , header::version const& version
+    , bool is_compressed )
 {
     return header
-            { detail::header::V1
+            { std::max( version, get_version( type ) )
             , type
             , my_id_
-            , token };
+            , token
+            , is_compressed };
 }
 
 buffer
 message_serializer::serialize
     ( header::type const& type
-    , id const& token )
+    , id const& token
+    , header::version const& version )
 {
-    auto const header = generate_header( type, token );
+    auto const header = generate_header( type, token, version );
 
     buffer b;
     detail::serialize( header, b );
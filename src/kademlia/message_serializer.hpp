@@ -32,6 +32,7 @@
 
 #include <memory>
 
+#include "kademlia/constants.hpp"
 #include "kademlia/message.hpp"
 
 namespace kademlia {
@@ -50,13 +51,15 @@ public:
         ( id const& my_id );
 
     /**
-     *
+     *  @param version The highest version the receiver speaks,
+     *         used in the header unless message requires a newer one.
      */
     template< typename Message >
     buffer
     serialize
         ( Message const& message
-        , id const& token );
+        , id const& token
+        , header::version const& version = header::V1 );
 
     /**
      *
@@ -64,7 +67,8 @@ public:
     buffer
     serialize
         ( header::type const& type
-        , id const& token );
+        , id const& token
+        , header::version const& version = header::V1 );
 
 private:
     /**
@@ -73,7 +77,9 @@ private:
     header
     generate_header
         ( header::type const& type
-        , id const& token );
+        , id const& token
+        , header::version const& version
+        , bool is_compressed = false );
 
 private:
     ///
@@ -84,14 +90,18 @@ template< typename Message >
 buffer
 message_serializer::serialize
     ( Message const& message
-    , id const& token )
+    , id const& token
+    , header::version const& version )
 {
     auto const type = message_traits< Message >::TYPE_ID;
-    auto const header = generate_header( type, token );
+    auto const header = generate_header( type, token, version
+                                       , is_compressed( message ) );
 
     buffer b;
+    b.reserve( MESSAGE_RESERVED_SIZE );
     detail::serialize( header, b );
     detail::serialize( message, b );
+    serialize_version_trailer( header, b );
 
     return b;
 }
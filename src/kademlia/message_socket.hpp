@@ -42,6 +42,8 @@
 #include "kademlia/buffer.hpp"
 #include "kademlia/ip_endpoint.hpp"
 #include "kademlia/boost_to_std_error.hpp"
+#include "kademlia/reception_buffer_pool.hpp"
+#include "kademlia/strand.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -73,22 +75,28 @@ public:
         , EndpointType const& e );
 
     /**
-     *
+     *  @param s The strand calling the completion handlers.
+     *  @param buffers The pool lending the reception buffers,
+     *         or nullptr to use a buffer of its own.
      */
     template< typename EndpointType >
     static message_socket
     ipv4
-        ( boost::asio::io_service & io_service
-        , EndpointType const& e );
+        ( strand & s
+        , EndpointType const& e
+        , reception_buffer_pool * buffers = nullptr );
 
     /**
-     *
+     *  @param s The strand calling the completion handlers.
+     *  @param buffers The pool lending the reception buffers,
+     *         or nullptr to use a buffer of its own.
      */
     template< typename EndpointType >
     static message_socket
     ipv6
-        ( boost::asio::io_service & io_service
-        , EndpointType const& e );
+        ( strand & s
+        , EndpointType const& e
+        , reception_buffer_pool * buffers = nullptr );
 
     /**
      *
@@ -130,7 +138,7 @@ public:
     template<typename SendCallback>
     void
     async_send
-        ( buffer const& message
+        ( buffer message
         , endpoint_type const& to
         , SendCallback const& callback );
 
@@ -154,8 +162,18 @@ private:
      *
      */
     message_socket
-        ( boost::asio::io_service & io_service
-        , endpoint_type const& e );
+        ( strand & s
+        , endpoint_type const& e
+        , reception_buffer_pool * buffers );
+
+    /**
+     *  @brief Wait for a message, then read it into
+     *         a buffer borrowed from reception_buffers_.
+     */
+    template<typename ReceiveCallback>
+    void
+    async_receive_into_pool
+        ( ReceiveCallback const& callback );
 
     /**
      *
@@ -180,27 +198,32 @@ private:
         ( endpoint_type const& e );
 
 private:
-    ///
+    /// Empty when the buffers are borrowed from a pool.
     buffer reception_buffer_;
     ///
+    reception_buffer_pool * reception_buffers_;
+    ///
     underlying_endpoint_type current_message_sender_;
     ///
     underlying_socket_type socket_;
+    /// Serializes the completion handlers with the engine ones.
+    strand * strand_;
 };
 
 template< typename UnderlyingSocketType >
 template< typename EndpointType >
 inline message_socket< UnderlyingSocketType >
 message_socket< UnderlyingSocketType >::ipv4
-    ( boost::asio::io_service & io_service
-    , EndpointType const& ipv4_endpoint )
+    ( strand & s
+    , EndpointType const& ipv4_endpoint
+    , reception_buffer_pool * buffers )
 {
-    auto endpoints = resolve_endpoint( io_service, ipv4_endpoint );
+    auto endpoints = resolve_endpoint( s.get_io_service(), ipv4_endpoint );
 
     for ( auto const& i : endpoints )
     {
         if ( i.address_.is_v4() )
-            return message_socket{ io_service, i };
+            return message_socket{ s, i, buffers };
     }
 
     throw std::system_error{ make_error_code( INVALID_IPV4_ADDRESS ) };
@@ -210,15 +233,16 @@ template< typename UnderlyingSocketType >
 template< typename EndpointType >
 inline message_socket< UnderlyingSocketType >
 message_socket< UnderlyingSocketType >::ipv6
-    ( boost::asio::io_service & io_service
-    , EndpointType const& ipv6_endpoint )
+    ( strand & s
+    , EndpointType const& ipv6_endpoint
+    , reception_buffer_pool * buffers )
 {
-    auto endpoints = resolve_endpoint( io_service, ipv6_endpoint );
+    auto endpoints = resolve_endpoint( s.get_io_service(), ipv6_endpoint );
 
     for ( auto const& i : endpoints )
     {
         if ( i.address_.is_v6() )
-            return message_socket{ io_service, i };
+            return message_socket{ s, i, buffers };
     }
 
     throw std::system_error{ make_error_code( INVALID_IPV6_ADDRESS ) };
@@ -227,12 +251,20 @@ message_socket< UnderlyingSocketType >::ipv6
 template< typename UnderlyingSocketType >
 inline
 message_socket< UnderlyingSocketType >::message_socket
-    ( boost::asio::io_service & io_service
-    , endpoint_type const& e )
-    : reception_buffer_( INPUT_BUFFER_SIZE )
+    ( strand & s
+    , endpoint_type const& e
+    , reception_buffer_pool * buffers )
+    : reception_buffer_( buffers ? 0 : INPUT_BUFFER_SIZE )
+    , reception_buffers_( buffers )
     , current_message_sender_()
-    , socket_( create_underlying_socket( io_service, e ) )
-{ }
+    , socket_( create_underlying_socket( s.get_io_service(), e ) )
+    , strand_( &s )
+{
+    // A message may be dropped between its readiness
+    // and its read, e.g. on a checksum failure.
+    if ( reception_buffers_ )
+        socket_.non_blocking( true );
+}
 
 template< typename UnderlyingSocketType >
 inline
@@ -249,6 +281,9 @@ inline void
 message_socket< UnderlyingSocketType >::async_receive
     ( ReceiveCallback const& callback )
 {
+    if ( reception_buffers_ )
+        return async_receive_into_pool( callback );
+
     auto on_completion = [ this, callback ]
         ( boost::system::error_code const& failure
         , std::size_t bytes_received )
@@ -275,22 +310,74 @@ message_socket< UnderlyingSocketType >::async_receive
     assert( reception_buffer_.size() == INPUT_BUFFER_SIZE );
     socket_.async_receive_from( boost::asio::buffer( reception_buffer_ )
                               , current_message_sender_
-                              , std::move( on_completion ) );
+                              , strand_->wrap( std::move( on_completion ) ) );
+}
+
+template< typename UnderlyingSocketType >
+template< typename ReceiveCallback >
+inline void
+message_socket< UnderlyingSocketType >::async_receive_into_pool
+    ( ReceiveCallback const& callback )
+{
+    auto on_readable = [ this, callback ]
+        ( boost::system::error_code failure
+        , std::size_t /* bytes_received */ )
+    {
+        buffer b;
+        std::size_t bytes_received = 0;
+
+        if ( ! failure )
+        {
+            b = reception_buffers_->acquire();
+            bytes_received = socket_.receive_from( boost::asio::buffer( b )
+                                                 , current_message_sender_
+                                                 , 0, failure );
+        }
+
+#ifdef _MSC_VER
+        // See async_receive().
+        if ( failure == boost::system::errc::connection_reset )
+            failure = boost::asio::error::would_block;
+#endif
+        // The message was dropped since its readiness.
+        if ( failure == boost::asio::error::would_block )
+        {
+            if ( ! b.empty() )
+                reception_buffers_->release( std::move( b ) );
+            return async_receive_into_pool( callback );
+        }
+
+        auto i = b.begin(), e = i;
+
+        if ( ! failure )
+            std::advance( e, bytes_received );
+
+        callback( boost_to_std_error( failure )
+                , convert_endpoint( current_message_sender_ )
+                , i, e );
+
+        if ( ! b.empty() )
+            reception_buffers_->release( std::move( b ) );
+    };
+
+    socket_.async_receive_from( boost::asio::null_buffers()
+                              , current_message_sender_
+                              , strand_->wrap( std::move( on_readable ) ) );
 }
 
 template< typename UnderlyingSocketType >
 template< typename SendCallback >
 inline void
 message_socket< UnderlyingSocketType >::async_send
-    ( buffer const& message
+    ( buffer message
     , endpoint_type const& to
     , SendCallback const& callback )
 {
     if ( message.size() > INPUT_BUFFER_SIZE )
         callback( make_error_code( std::errc::value_too_large ) );
     else {
-        // Copy the buffer as it has to live past the end of this call.
-        auto message_copy = std::make_shared< buffer >( message );
+        // Move the buffer as it has to live past the end of this call.
+        auto message_copy = std::make_shared< buffer >( std::move( message ) );
         auto on_completion = [ this, callback, message_copy ]
             ( boost::system::error_code const& failure
             , std::size_t /* bytes_sent */ )
@@ -300,7 +387,7 @@ message_socket< UnderlyingSocketType >::async_send
 
         socket_.async_send_to( boost::asio::buffer( *message_copy )
                              , convert_endpoint( to )
-                             , std::move( on_completion ) );
+                             , strand_->wrap( std::move( on_completion ) ) );
     }
 }
 
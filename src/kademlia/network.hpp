@@ -103,10 +103,10 @@ public:
     template< typename Message, typename OnMessageSent >
     void
     send
-        ( Message const& message
+        ( Message message
         , endpoint_type const& e
         , OnMessageSent const& on_message_sent )
-    { get_socket_for( e ).async_send( message, e, on_message_sent ); }
+    { get_socket_for( e ).async_send( std::move( message ), e, on_message_sent ); }
 
     /**
      *
@@ -30,13 +30,14 @@
 #   pragma once
 #endif
 
-#include <memory>
 #include <system_error>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
 
 #include "kademlia/lookup_task.hpp"
 #include "kademlia/message.hpp"
 #include "kademlia/tracker.hpp"
-#include "kademlia/constants.hpp"
+#include "kademlia/task_pool.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -45,6 +46,9 @@ namespace detail {
 template< typename TrackerType >
 class notify_peer_task final
     : public lookup_task
+    , public boost::intrusive_ref_counter< notify_peer_task< TrackerType >
+                                        , boost::thread_unsafe_counter >
+    , public pooled_task< notify_peer_task< TrackerType > >
 {
 public:
     ///
@@ -64,7 +68,7 @@ public:
         , tracker_type & tracker
         , RoutingTableType & routing_table )
     {
-        std::shared_ptr< notify_peer_task > c;
+        boost::intrusive_ptr< notify_peer_task > c;
         c.reset( new notify_peer_task( key, tracker, routing_table ) );
 
         try_to_notify_neighbors( c );
@@ -81,7 +85,8 @@ private:
         , RoutingTableType & routing_table )
             : lookup_task( key
                          , routing_table.find( key )
-                         , routing_table.end() )
+                         , routing_table.end()
+                         , tracker.get_configuration().k_bucket_size() )
             , tracker_( tracker )
     {
         LOG_DEBUG( notify_peer_task, this )
@@ -94,7 +99,7 @@ private:
      */
     static void
     try_to_notify_neighbors
-        ( std::shared_ptr< notify_peer_task > task )
+        ( boost::intrusive_ptr< notify_peer_task > task )
     {
         LOG_DEBUG( notify_peer_task, task.get() )
                 << "sending find peer to notify '"
@@ -103,7 +108,7 @@ private:
         find_peer_request_body const request{ task->get_key() };
 
         auto const closest_peers = task->select_new_closest_candidates
-                ( CONCURRENT_FIND_PEER_REQUESTS_COUNT );
+                ( task->tracker_.get_configuration().concurrent_requests_count() );
 
         for ( auto const& c : closest_peers )
             send_notify_peer_request( request, c, task );
@@ -116,7 +121,7 @@ private:
     send_notify_peer_request
         ( find_peer_request_body const& request
         , peer const& current_peer
-        , std::shared_ptr< notify_peer_task > task )
+        , boost::intrusive_ptr< notify_peer_task > task )
     {
         LOG_DEBUG( notify_peer_task, task.get() )
                 << "sending find peer to notify to '"
@@ -138,7 +143,7 @@ private:
 
         task->tracker_.send_request( request
                                    , current_peer.endpoint_
-                                   , PEER_LOOKUP_TIMEOUT
+                                   , task->tracker_.get_configuration().peer_lookup_timeout()
                                    , on_message_received
                                    , on_error );
     }
@@ -152,7 +157,7 @@ private:
         , header const& h
         , buffer::const_iterator i
         , buffer::const_iterator e
-        , std::shared_ptr< notify_peer_task > task )
+        , boost::intrusive_ptr< notify_peer_task > task )
     {
         LOG_DEBUG( notify_peer_task, task.get() )
                 << "handle notify peer response from '" << s
@@ -161,7 +166,7 @@ private:
         assert( h.type_ == header::FIND_PEER_RESPONSE );
         find_peer_response_body response;
 
-        if ( auto failure = deserialize( i, e, response ) )
+        if ( auto failure = deserialize( i, e, h.version_, task->get_key(), response ) )
         {
             LOG_DEBUG( notify_peer_task, &task )
                     << "failed to deserialize find peer response ("
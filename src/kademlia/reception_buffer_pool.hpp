@@ -0,0 +1,142 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_RECEPTION_BUFFER_POOL_HPP
+#define KADEMLIA_RECEPTION_BUFFER_POOL_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "kademlia/buffer.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class lends reception buffers to the sockets
+ *         of the engines sharing an io_service.
+ *  @details A socket only borrows a buffer while it reads
+ *           a message and its engine handles it, hence the
+ *           pool holds as many buffers as messages handled
+ *           at once, i.e. at most one per thread, rather
+ *           than one per socket.
+ */
+class reception_buffer_pool final
+{
+public:
+    /**
+     *
+     */
+    explicit
+    reception_buffer_pool
+        ( std::size_t buffer_size )
+            : buffer_size_( buffer_size )
+            , mutex_{}
+            , free_buffers_{}
+            , buffers_count_{}
+    { }
+
+    /**
+     *
+     */
+    reception_buffer_pool
+        ( reception_buffer_pool const& )
+        = delete;
+
+    /**
+     *
+     */
+    reception_buffer_pool &
+    operator=
+        ( reception_buffer_pool const& )
+        = delete;
+
+    /**
+     *  @return A buffer of buffer_size bytes, to be released.
+     */
+    buffer
+    acquire
+        ( void )
+    {
+        {
+            std::lock_guard< std::mutex > lock{ mutex_ };
+            if ( ! free_buffers_.empty() )
+            {
+                auto b = std::move( free_buffers_.back() );
+                free_buffers_.pop_back();
+                return b;
+            }
+
+            ++ buffers_count_;
+        }
+
+        return buffer( buffer_size_ );
+    }
+
+    /**
+     *  @brief Give back a buffer returned by acquire().
+     */
+    void
+    release
+        ( buffer && b )
+    {
+        std::lock_guard< std::mutex > lock{ mutex_ };
+        free_buffers_.push_back( std::move( b ) );
+    }
+
+    /**
+     *  @return The count of buffers allocated by this pool.
+     */
+    std::size_t
+    buffers_count
+        ( void )
+        const
+    {
+        std::lock_guard< std::mutex > lock{ mutex_ };
+        return buffers_count_;
+    }
+
+private:
+    ///
+    std::size_t const buffer_size_;
+    ///
+    mutable std::mutex mutex_;
+    ///
+    std::vector< buffer > free_buffers_;
+    ///
+    std::size_t buffers_count_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
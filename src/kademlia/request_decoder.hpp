@@ -0,0 +1,116 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_REQUEST_DECODER_HPP
+#define KADEMLIA_REQUEST_DECODER_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <system_error>
+#include <utility>
+
+#include "kademlia/buffer.hpp"
+#include "kademlia/message.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief Deserialize a request body of type BodyType
+ *         and forward it to handler.
+ */
+template< typename BodyType, typename HandlerType >
+void
+decode_request_body
+    ( header const& h
+    , buffer::const_iterator i
+    , buffer::const_iterator e
+    , HandlerType & handler )
+{
+    BodyType body;
+    if ( auto failure = deserialize( i, e, body ) )
+        handler.handle_invalid_request( h, failure );
+    else
+        handler.handle_request( h, std::move( body ) );
+}
+
+/**
+ *  @brief Deserialize the body of the message headed
+ *         by h and forward it to handler.
+ *  @details handler is called with:
+ *           - handle_request( h ) for a ping request;
+ *           - handle_request( h, body ) for other requests;
+ *           - handle_invalid_request( h, failure ) if
+ *             the body of a request can't be deserialized;
+ *           - handle_response( h, i, e ) for responses, which
+ *             are deserialized by the task awaiting them.
+ */
+template< typename HandlerType >
+void
+decode_request
+    ( header const& h
+    , buffer::const_iterator i
+    , buffer::const_iterator e
+    , HandlerType & handler )
+{
+    switch ( h.type_ )
+    {
+        case header::PING_REQUEST:
+            handler.handle_request( h );
+            break;
+        case header::STORE_REQUEST:
+            decode_request_body< store_value_request_body >( h, i, e, handler );
+            break;
+        case header::FIND_PEER_REQUEST:
+            decode_request_body< find_peer_request_body >( h, i, e, handler );
+            break;
+        case header::FIND_VALUE_REQUEST:
+            decode_request_body< find_value_request_body >( h, i, e, handler );
+            break;
+        case header::STORE_CHUNK_REQUEST:
+            decode_request_body< store_chunk_request_body >( h, i, e, handler );
+            break;
+        case header::FIND_CHUNK_REQUEST:
+            decode_request_body< find_chunk_request_body >( h, i, e, handler );
+            break;
+        case header::FIND_VALUES_REQUEST:
+            decode_request_body< find_values_request_body >( h, i, e, handler );
+            break;
+        case header::STORE_VALUES_REQUEST:
+            decode_request_body< store_values_request_body >( h, i, e, handler );
+            break;
+        default:
+            handler.handle_response( h, i, e );
+            break;
+    }
+}
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
@@ -35,9 +35,10 @@ namespace detail {
 void
 response_callbacks::push_callback
     ( id const& message_id
-    , callback const& on_message_received )
+    , callback on_message_received )
 {
-    auto i = callbacks_.emplace( message_id, on_message_received );
+    auto i = callbacks_.emplace( message_id
+                               , std::move( on_message_received ) );
     (void)i;
     assert( i.second && "an id can't be registered twice" );
 }
@@ -47,6 +48,12 @@ response_callbacks::remove_callback
     ( id const& message_id )
 { return callbacks_.erase( message_id ) > 0; }
 
+bool
+response_callbacks::has_callback
+    ( id const& message_id )
+    const
+{ return callbacks_.count( message_id ) > 0; }
+
 std::error_code
 response_callbacks::dispatch_response
     ( endpoint_type const& sender
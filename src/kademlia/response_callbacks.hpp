@@ -31,11 +31,11 @@
 #endif
 
 #include <map>
-#include <functional>
 
 #include "kademlia/id.hpp"
 #include "kademlia/ip_endpoint.hpp"
 #include "kademlia/message.hpp"
+#include "kademlia/small_function.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -48,7 +48,7 @@ public:
     using endpoint_type = ip_endpoint;
 
     ///
-    using callback = std::function< void
+    using callback = small_function< void
             ( endpoint_type const& sender
             , header const& h
             , buffer::const_iterator i
@@ -61,7 +61,7 @@ public:
     void
     push_callback
         ( id const& message_id
-        , callback const& on_message_received );
+        , callback on_message_received );
 
     /**
      *
@@ -70,6 +70,14 @@ public:
     remove_callback
         ( id const& message_id );
 
+    /**
+     *  @return true if a callback is registered for message_id.
+     */
+    bool
+    has_callback
+        ( id const& message_id )
+        const;
+
     /**
      *
      */
@@ -59,6 +59,19 @@ public:
             , timer_( io_service )
     { }
 
+    /**
+     *  @brief Call the callbacks on s.
+     *  @param timers The timer queue shared with other
+     *         strands, or nullptr.
+     */
+    explicit
+    response_router
+        ( strand & s
+        , timer_queue * timers = nullptr )
+            : response_callbacks_()
+            , timer_( s, timers )
+    { }
+
     /**
      *
      */
@@ -94,6 +107,15 @@ public:
                     << std::endl;
     }
 
+    /**
+     *  @return true if a response with this id is awaited.
+     */
+    bool
+    is_awaited_response
+        ( id const& response_id )
+        const
+    { return response_callbacks_.has_callback( response_id ); }
+
     /**
      *
      */
@@ -43,6 +43,7 @@
 
 #include "kademlia/id.hpp"
 #include "kademlia/log.hpp"
+#include "kademlia/constants.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -55,9 +56,6 @@ template< typename PeerType >
 class routing_table final
 {
 public:
-    ///
-    enum { DEFAULT_K_BUCKET_SIZE = 20 };
-
     ///
     using peer_type = PeerType;
 
@@ -72,7 +70,7 @@ public:
      */
     routing_table
         ( id const& my_id
-        , std::size_t k_bucket_size = DEFAULT_K_BUCKET_SIZE )
+        , std::size_t k_bucket_size = ROUTING_TABLE_BUCKET_SIZE )
             : k_buckets_( id::BIT_SIZE ), my_id_( my_id )
             , peer_count_( 0 ), k_bucket_size_( k_bucket_size )
             , largest_k_bucket_index_( 0 )
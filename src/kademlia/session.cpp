@@ -41,18 +41,21 @@ struct session::impl final
     impl
         ( endpoint const& initial_peer
         , endpoint const& listen_on_ipv4
-        , endpoint const& listen_on_ipv6 )
+        , endpoint const& listen_on_ipv6
+        , configuration const& config )
             : session_impl{ initial_peer
                           , listen_on_ipv4
-                          , listen_on_ipv6 }
+                          , listen_on_ipv6
+                          , config }
     { }
 };
 
 session::session
     ( endpoint const& initial_peer
     , endpoint const& listen_on_ipv4
-    , endpoint const& listen_on_ipv6 )
-        : impl_{ new impl{ initial_peer, listen_on_ipv4, listen_on_ipv6 } }
+    , endpoint const& listen_on_ipv6
+    , configuration const& config )
+        : impl_{ new impl{ initial_peer, listen_on_ipv4, listen_on_ipv6, config } }
 { }
 
 session::~session
@@ -72,11 +75,38 @@ session::async_load
     , load_handler_type handler )
 { impl_->async_load( key, std::move( handler ) ); }
 
+void
+session::async_save_many
+    ( std::vector< value_type > const& values
+    , save_many_handler_type handler )
+{ impl_->async_save_many( values, std::move( handler ) ); }
+
+void
+session::async_load_many
+    ( std::vector< key_type > const& keys
+    , load_many_handler_type handler )
+{ impl_->async_load_many( keys, std::move( handler ) ); }
+
 std::error_code
 session::run
     ( void )
 { return impl_->run(); }
 
+std::error_code
+session::run_with_threads
+    ( std::size_t threads_count )
+{ return impl_->run_with_threads( threads_count ); }
+
+std::error_code
+session::run_for
+    ( std::chrono::milliseconds const& duration )
+{ return impl_->run_for( duration ); }
+
+std::error_code
+session::poll
+    ( void )
+{ return impl_->poll(); }
+
 void
 session::abort
         ( void )
@@ -33,13 +33,14 @@
 
 #include <kademlia/session_impl.hpp>
 
+#include <type_traits>
 #include <utility>
-#include <boost/asio/io_service.hpp>
+#include <vector>
 #include <boost/asio/ip/udp.hpp>
 
 #include "kademlia/message_socket.hpp"
 #include "kademlia/engine.hpp"
-#include "kademlia/concurrent_guard.hpp"
+#include "kademlia/event_loop.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -48,6 +49,7 @@ namespace detail {
  *
  */
 class session_impl
+        : public event_loop
 {
 public:
     ///
@@ -65,13 +67,14 @@ public:
      */
     session_impl
         ( endpoint const& listen_on_ipv4
-        , endpoint const& listen_on_ipv6 )
-            : io_service_{}
-            , engine_{ io_service_
+        , endpoint const& listen_on_ipv6
+        , configuration const& config )
+            : event_loop{}
+            , engine_{ get_io_service()
                      , listen_on_ipv4
-                     , listen_on_ipv6 }
-            , is_abort_requested_{}
-            , concurrent_guard_{}
+                     , listen_on_ipv6
+                     , id{}
+                     , config }
     { }
 
     /**
@@ -80,18 +83,20 @@ public:
     session_impl
         ( endpoint const& initial_peer
         , endpoint const& listen_on_ipv4
-        , endpoint const& listen_on_ipv6 )
-            : io_service_{}
-            , engine_{ io_service_
+        , endpoint const& listen_on_ipv6
+        , configuration const& config )
+            : event_loop{}
+            , engine_{ get_io_service()
                      , initial_peer
                      , listen_on_ipv4
-                     , listen_on_ipv6 }
-            , is_abort_requested_{}
-            , concurrent_guard_{}
+                     , listen_on_ipv6
+                     , id{}
+                     , config }
     { }
 
     /**
-     *
+     *  @details This method can be called from any thread,
+     *           the save is submitted to the engine.
      */
     template< typename HandlerType >
     void
@@ -100,13 +105,18 @@ public:
         , data_type const& data
         , HandlerType && handler )
     {
-        engine_.async_save( key
-                          , data
-                          , std::forward< HandlerType >( handler ) );
+        using handler_type = typename std::decay< HandlerType >::type;
+
+        handler_type h( std::forward< HandlerType >( handler ) );
+        auto start_save = [ this, key, data, h ]( void )
+        { engine_.async_save( key, data, h ); };
+
+        submit( engine_.get_strand(), std::move( start_save ) );
     }
 
     /**
-     *
+     *  @details This method can be called from any thread,
+     *           the load is submitted to the engine.
      */
     template< typename HandlerType >
     void
@@ -114,55 +124,54 @@ public:
         ( key_type const& key
         , HandlerType && handler )
     {
-        engine_.async_load( key
-                          , std::forward< HandlerType >( handler ) );
+        using handler_type = typename std::decay< HandlerType >::type;
+
+        handler_type h( std::forward< HandlerType >( handler ) );
+        auto start_load = [ this, key, h ]( void )
+        { engine_.async_load( key, h ); };
+
+        submit( engine_.get_strand(), std::move( start_load ) );
     }
 
     /**
-     *
+     *  @details This method can be called from any thread.
      */
-    std::error_code
-    run
-        ( void )
+    template< typename ValuesType, typename HandlerType >
+    void
+    async_save_many
+        ( ValuesType const& values
+        , HandlerType && handler )
     {
-        // Protect against concurrent invocation of this method.
-        detail::concurrent_guard::sentry s{ concurrent_guard_ };
-        if ( ! s )
-            return make_error_code( ALREADY_RUNNING );
-
-        is_abort_requested_ = false;
+        using handler_type = typename std::decay< HandlerType >::type;
 
-        while ( ! is_abort_requested_ )
-        {
-            io_service_.run_one();
-            io_service_.poll();
-        }
+        handler_type h( std::forward< HandlerType >( handler ) );
+        auto start_saves = [ this, values, h ]( void )
+        { engine_.async_save_many( values, h ); };
 
-        return make_error_code( RUN_ABORTED );
+        submit( engine_.get_strand(), std::move( start_saves ) );
     }
 
     /**
-     *
+     *  @details This method can be called from any thread.
      */
+    template< typename KeysType, typename HandlerType >
     void
-    abort
-        ( void )
+    async_load_many
+        ( KeysType const& keys
+        , HandlerType && handler )
     {
-        auto service_stopper = [ this ] ( void )
-        { is_abort_requested_ = true; };
+        using handler_type = typename std::decay< HandlerType >::type;
 
-        io_service_.post( service_stopper );
+        handler_type h( std::forward< HandlerType >( handler ) );
+        auto start_loads = [ this, keys, h ]( void )
+        { engine_.async_load_many( keys, h ); };
+
+        submit( engine_.get_strand(), std::move( start_loads ) );
     }
 
 private:
-    ///
-    boost::asio::io_service io_service_;
     ///
     engine_type engine_;
-    ///
-    bool is_abort_requested_;
-    ///
-    detail::concurrent_guard concurrent_guard_;
 };
 
 } // namespace detail
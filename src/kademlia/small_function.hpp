@@ -0,0 +1,320 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_SMALL_FUNCTION_HPP
+#define KADEMLIA_SMALL_FUNCTION_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <kademlia/detail/cxx11_macros.hpp>
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief Default inline capacity of small_function,
+ *         enough for the callbacks of the tasks, which
+ *         capture their task and a peer.
+ */
+CXX11_CONSTEXPR std::size_t SMALL_FUNCTION_CAPACITY = 128;
+
+///
+template< typename Signature, std::size_t Capacity = SMALL_FUNCTION_CAPACITY >
+class small_function;
+
+/**
+ *  @brief This class is a move-only std::function
+ *         storing its callable inline.
+ *  @details Callables larger than Capacity are allocated
+ *           on the heap as std::function does.
+ *           Being move-only, it doesn't require the callable
+ *           to be copyable, and never copies it.
+ */
+template< typename ReturnType, typename... Args, std::size_t Capacity >
+class small_function< ReturnType ( Args... ), Capacity > final
+{
+public:
+    /**
+     *
+     */
+    small_function
+        ( void )
+        noexcept
+            : storage_()
+            , vtable_()
+    { }
+
+    /**
+     *
+     */
+    template< typename Callable
+            , typename = typename std::enable_if
+                    < ! std::is_same< typename std::decay< Callable >::type
+                                    , small_function >::value >::type >
+    small_function
+        ( Callable && callable )
+            : storage_()
+            , vtable_()
+    {
+        using callable_type = typename std::decay< Callable >::type;
+        using holder_type = typename std::conditional
+                < is_stored_inline< callable_type >::value
+                , inline_holder< callable_type >
+                , heap_holder< callable_type > >::type;
+
+        holder_type::construct( &storage_, std::forward< Callable >( callable ) );
+        vtable_ = &holder_type::VTABLE;
+    }
+
+    /**
+     *
+     */
+    small_function
+        ( small_function && o )
+            : storage_()
+            , vtable_( o.vtable_ )
+    {
+        if ( vtable_ )
+        {
+            vtable_->move_( &storage_, &o.storage_ );
+            o.vtable_ = nullptr;
+        }
+    }
+
+    /**
+     *
+     */
+    small_function &
+    operator=
+        ( small_function && o )
+    {
+        if ( this != &o )
+        {
+            reset();
+            if ( o.vtable_ )
+            {
+                o.vtable_->move_( &storage_, &o.storage_ );
+                vtable_ = o.vtable_;
+                o.vtable_ = nullptr;
+            }
+        }
+
+        return *this;
+    }
+
+    /**
+     *
+     */
+    small_function
+        ( small_function const& )
+        = delete;
+
+    /**
+     *
+     */
+    small_function &
+    operator=
+        ( small_function const& )
+        = delete;
+
+    /**
+     *
+     */
+    ~small_function
+        ( void )
+    { reset(); }
+
+    /**
+     *  @return true if a callable is stored.
+     */
+    explicit
+    operator bool
+        ( void )
+        const
+        noexcept
+    { return vtable_ != nullptr; }
+
+    /**
+     *  @details Like std::function, the stored callable
+     *           is called even if this object is const.
+     */
+    ReturnType
+    operator()
+        ( Args... args )
+        const
+    { return vtable_->call_( &storage_, std::forward< Args >( args )... ); }
+
+private:
+    ///
+    using storage_type = typename std::aligned_storage< Capacity >::type;
+
+    /// Operations on the stored callable.
+    struct vtable final
+    {
+        ///
+        ReturnType ( * call_ )( void * callable, Args&&... args );
+        /// Move the callable of source into target, leaving source empty.
+        void ( * move_ )( void * target, void * source );
+        ///
+        void ( * destroy_ )( void * callable );
+    };
+
+    ///
+    template< typename Callable >
+    struct is_stored_inline final
+        : std::integral_constant
+            < bool
+            , sizeof( Callable ) <= Capacity
+              && alignof( storage_type ) % alignof( Callable ) == 0 >
+    { };
+
+    ///
+    template< typename Callable >
+    struct inline_holder final
+    {
+        ///
+        template< typename CallableArg >
+        static void
+        construct
+            ( void * storage
+            , CallableArg && callable )
+        { new ( storage ) Callable( std::forward< CallableArg >( callable ) ); }
+
+        ///
+        static ReturnType
+        call
+            ( void * callable
+            , Args&&... args )
+        { return ( *static_cast< Callable * >( callable ) )( std::forward< Args >( args )... ); }
+
+        ///
+        static void
+        move
+            ( void * target
+            , void * source )
+        {
+            auto & c = *static_cast< Callable * >( source );
+            new ( target ) Callable( std::move( c ) );
+            c.~Callable();
+        }
+
+        ///
+        static void
+        destroy
+            ( void * callable )
+        { static_cast< Callable * >( callable )->~Callable(); }
+
+        ///
+        static vtable const VTABLE;
+    };
+
+    ///
+    template< typename Callable >
+    struct heap_holder final
+    {
+        ///
+        static Callable *&
+        get
+            ( void * storage )
+        { return *static_cast< Callable ** >( storage ); }
+
+        ///
+        template< typename CallableArg >
+        static void
+        construct
+            ( void * storage
+            , CallableArg && callable )
+        { new ( storage ) Callable *( new Callable( std::forward< CallableArg >( callable ) ) ); }
+
+        ///
+        static ReturnType
+        call
+            ( void * storage
+            , Args&&... args )
+        { return ( *get( storage ) )( std::forward< Args >( args )... ); }
+
+        ///
+        static void
+        move
+            ( void * target
+            , void * source )
+        { new ( target ) Callable *( get( source ) ); }
+
+        ///
+        static void
+        destroy
+            ( void * storage )
+        { delete get( storage ); }
+
+        ///
+        static vtable const VTABLE;
+    };
+
+private:
+    /**
+     *
+     */
+    void
+    reset
+        ( void )
+    {
+        if ( vtable_ )
+        {
+            vtable_->destroy_( &storage_ );
+            vtable_ = nullptr;
+        }
+    }
+
+private:
+    ///
+    mutable storage_type storage_;
+    ///
+    vtable const* vtable_;
+};
+
+template< typename ReturnType, typename... Args, std::size_t Capacity >
+template< typename Callable >
+typename small_function< ReturnType ( Args... ), Capacity >::vtable const
+small_function< ReturnType ( Args... ), Capacity >::inline_holder< Callable >::VTABLE
+        = { &call, &move, &destroy };
+
+template< typename ReturnType, typename... Args, std::size_t Capacity >
+template< typename Callable >
+typename small_function< ReturnType ( Args... ), Capacity >::vtable const
+small_function< ReturnType ( Args... ), Capacity >::heap_holder< Callable >::VTABLE
+        = { &call, &move, &destroy };
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
@@ -30,14 +30,23 @@
 #   pragma once
 #endif
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
 #include <memory>
+#include <vector>
 #include <type_traits>
 #include <system_error>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
 
 #include "kademlia/lookup_task.hpp"
 #include "kademlia/log.hpp"
 #include "kademlia/message.hpp"
+#include "kademlia/compression.hpp"
 #include "kademlia/constants.hpp"
+#include "kademlia/task_pool.hpp"
 
 namespace kademlia {
 namespace detail {
@@ -46,6 +55,9 @@ namespace detail {
 template< typename SaveHandlerType, typename TrackerType, typename DataType >
 class store_value_task final
     : public lookup_task
+    , public boost::intrusive_ref_counter< store_value_task< SaveHandlerType, TrackerType, DataType >
+                                        , boost::thread_unsafe_counter >
+    , public pooled_task< store_value_task< SaveHandlerType, TrackerType, DataType > >
 {
 public:
     ///
@@ -57,6 +69,20 @@ public:
     ///
     using data_type = DataType;
 
+private:
+    /// State of a value stored by chunks on a replica.
+    struct chunks_upload final
+    {
+        ///
+        peer replica_;
+        ///
+        std::size_t next_chunk_;
+        ///
+        std::size_t acknowledged_chunks_count_;
+        ///
+        bool is_failed_;
+    };
+
 public:
     /**
      *
@@ -68,14 +94,20 @@ public:
         , data_type const& data
         , tracker_type & tracker
         , RoutingTableType & routing_table
-        , save_handler_type handler )
+        , save_handler_type handler
+        , std::size_t write_quorum
+        , std::uint64_t version
+        , std::shared_ptr< candidates_pool > pool )
     {
-        std::shared_ptr< store_value_task > c;
+        boost::intrusive_ptr< store_value_task > c;
         c.reset( new store_value_task( key
                                      , data
                                      , tracker
                                      , routing_table
-                                     , std::move( handler ) ) );
+                                     , std::move( handler )
+                                     , write_quorum
+                                     , version ) );
+        c->use_candidates_pool( std::move( pool ) );
 
         try_to_store_value( c );
     }
@@ -90,13 +122,27 @@ private:
         , data_type const& data
         , tracker_type & tracker
         , RoutingTableType & routing_table
-        , HandlerType && save_handler )
+        , HandlerType && save_handler
+        , std::size_t write_quorum
+        , std::uint64_t version )
             : lookup_task( key
                          , routing_table.find( key )
-                         , routing_table.end() )
+                         , routing_table.end()
+                         , tracker.get_configuration().k_bucket_size() )
             , tracker_( tracker )
             , data_( data )
             , save_handler_( std::forward< HandlerType >( save_handler ) )
+            , write_quorum_( std::max< std::size_t >
+                    ( 1, std::min( write_quorum
+                                 , tracker.get_configuration().redundant_save_count() ) ) )
+            , store_candidates_()
+            , next_store_candidate_()
+            , in_flight_stores_count_()
+            , acknowledged_stores_count_()
+            , is_caller_notified_()
+            , is_lookup_over_()
+            , version_( version )
+            , compressed_chunks_()
     {
         LOG_DEBUG( store_value_task, this )
                 << "create store value task for '"
@@ -110,7 +156,10 @@ private:
     void
     notify_caller
         ( std::error_code const& failure )
-    { save_handler_( failure ); }
+    {
+        is_caller_notified_ = true;
+        save_handler_( failure );
+    }
 
     /**
      *
@@ -121,14 +170,63 @@ private:
         const
     { return data_; }
 
+    /**
+     *  @return The chunk_index chunk of the value compressed,
+     *          empty if it's not worth it.
+     *  @details A value fitting a single message is its only chunk.
+     */
+    data_type const&
+    get_compressed_chunk
+        ( std::size_t chunk_index )
+    {
+        // Compress once, for the first peer supporting it.
+        if ( compressed_chunks_.empty() )
+        {
+            auto const chunks_count = get_chunks_count( data_.size(), CHUNK_SIZE );
+            compressed_chunks_.resize( std::max< std::size_t >( 1, chunks_count ) );
+            for ( std::size_t c = 0; c < chunks_count; ++ c )
+                compress( get_chunk_begin( c ), get_chunk_end( c )
+                        , compressed_chunks_[ c ] );
+        }
+
+        return compressed_chunks_[ chunk_index ];
+    }
+
+    /**
+     *
+     */
+    typename data_type::const_iterator
+    get_chunk_begin
+        ( std::size_t chunk_index )
+        const
+    { return std::next( data_.begin(), chunk_index * CHUNK_SIZE ); }
+
+    /**
+     *
+     */
+    typename data_type::const_iterator
+    get_chunk_end
+        ( std::size_t chunk_index )
+        const
+    {
+        auto const begin = get_chunk_begin( chunk_index );
+        return std::next( begin
+                        , std::min( CHUNK_SIZE
+                                  , std::size_t( std::distance( begin
+                                                              , data_.end() ) ) ) );
+    }
+
     /**
      *
      */
     static void
     try_to_store_value
-        ( std::shared_ptr< store_value_task > task
-        , std::size_t concurrent_requests_count = CONCURRENT_FIND_PEER_REQUESTS_COUNT )
+        ( boost::intrusive_ptr< store_value_task > task )
     {
+        // Late responses are ignored once the value is being stored.
+        if ( task->is_lookup_over_ )
+            return;
+
         LOG_DEBUG( store_value_task, task.get() )
                 << "trying to find closer peer to store '"
                 << task->get_key() << "' value." << std::endl;
@@ -136,16 +234,18 @@ private:
         find_peer_request_body const request{ task->get_key() };
 
         auto const closest_candidates = task->select_new_closest_candidates
-                ( concurrent_requests_count );
+                ( task->tracker_.get_configuration().concurrent_requests_count() );
 
         for ( auto const& c : closest_candidates )
             send_find_peer_to_store_request( request, c, task );
 
-        // If no more requests are in flight
-        // we know the closest peers hence ask
-        // them to store the value.
-        if ( task->have_all_requests_completed() )
-            send_store_requests( task ); 
+        // Once the closest peers have all responded
+        // ask them to store the value.
+        if ( task->is_lookup_complete() )
+        {
+            task->is_lookup_over_ = true;
+            send_store_requests( task );
+        }
     }
 
     /**
@@ -155,7 +255,7 @@ private:
     send_find_peer_to_store_request
         ( find_peer_request_body const& request
         , peer const& current_candidate
-        , std::shared_ptr< store_value_task > task )
+        , boost::intrusive_ptr< store_value_task > task )
     {
         LOG_DEBUG( store_value_task, task.get() )
                 << "sending find peer request to store '"
@@ -185,7 +285,7 @@ private:
 
         task->tracker_.send_request( request
                                    , current_candidate.endpoint_
-                                   , PEER_LOOKUP_TIMEOUT
+                                   , task->tracker_.get_configuration().peer_lookup_timeout()
                                    , on_message_received
                                    , on_error );
     }
@@ -199,7 +299,7 @@ private:
         , header const& h
         , buffer::const_iterator i
         , buffer::const_iterator e
-        , std::shared_ptr< store_value_task > task )
+        , boost::intrusive_ptr< store_value_task > task )
     {
         LOG_DEBUG( store_value_task, task.get() )
                 << "handle find peer to store response from '"
@@ -218,7 +318,7 @@ private:
         };
 
         find_peer_response_body response;
-        if ( auto failure = deserialize( i, e, response ) )
+        if ( auto failure = deserialize( i, e, h.version_, task->get_key(), response ) )
         {
             LOG_DEBUG( store_value_task, task.get() )
                     << "failed to deserialize find peer response ("
@@ -239,18 +339,42 @@ private:
      */
     static void
     send_store_requests
-        ( std::shared_ptr< store_value_task > task )
+        ( boost::intrusive_ptr< store_value_task > task )
     {
-        auto const & candidates
-                = task->select_closest_valid_candidates( REDUNDANT_SAVE_COUNT );
+        // Keep every valid candidate, the ones beyond the
+        // redundant save count replace replicas that fail to ack.
+        task->store_candidates_ = task->select_closest_valid_candidates
+                ( task->tracker_.get_configuration().k_bucket_size() );
 
-        for ( auto c : candidates )
-            send_store_request( c, task );
-
-        if ( candidates.empty() )
+        if ( task->store_candidates_.empty() )
+        {
             task->notify_caller( make_error_code( INITIAL_PEER_FAILED_TO_RESPOND ) );
-        else
-            task->notify_caller( std::error_code{} );
+            return;
+        }
+
+        auto const redundant_save_count
+                = task->tracker_.get_configuration().redundant_save_count();
+        for ( std::size_t i = 0; i < redundant_save_count; ++ i )
+            if ( ! send_store_request_to_next_candidate( task ) )
+                break;
+    }
+
+    /**
+     *
+     */
+    static bool
+    send_store_request_to_next_candidate
+        ( boost::intrusive_ptr< store_value_task > task )
+    {
+        if ( task->next_store_candidate_ == task->store_candidates_.size() )
+            return false;
+
+        auto const& c = task->store_candidates_[ task->next_store_candidate_ ];
+        ++ task->next_store_candidate_;
+
+        send_store_request( c, task );
+
+        return true;
     }
 
     /**
@@ -259,16 +383,237 @@ private:
     static void
     send_store_request
         ( peer const& current_candidate
-        , std::shared_ptr< store_value_task > task )
+        , boost::intrusive_ptr< store_value_task > task )
     {
         LOG_DEBUG( store_value_task, task.get() )
                 << "send store request of '"
                 << task->get_key() << "' to '"
                 << current_candidate << "'." << std::endl;
 
+        ++ task->in_flight_stores_count_;
+
+        // V1 peers don't know chunks nor acknowledge stores, hence
+        // the value is sent whole if it fits, and counted as
+        // stored once sent.
+        if ( task->tracker_.get_peer_version( current_candidate.endpoint_ )
+             < header::V2 )
+        {
+            store_value_request_body const request{ task->get_key()
+                                                  , task->get_data()
+                                                  , std::chrono::seconds::zero()
+                                                  , task->version_ };
+            if ( fits_in_datagram( request ) )
+            {
+                task->tracker_.send_request( request, current_candidate.endpoint_ );
+
+                handle_store_acknowledgement( task );
+                return;
+            }
+        }
+
+        if ( task->get_data().size() > CHUNK_SIZE )
+        {
+            std::shared_ptr< chunks_upload > upload;
+            upload.reset( new chunks_upload{ current_candidate, 0, 0, false } );
+            send_store_chunk_requests( upload, task );
+            return;
+        }
+
+        // On message received, count the ack.
+        auto on_message_received = [ task ]
+            ( ip_endpoint const& s
+            , header const& h
+            , buffer::const_iterator
+            , buffer::const_iterator )
+        {
+            handle_store_response( s, h, task );
+        };
+
+        // On error, replace the replica.
+        auto on_error = [ task ]
+            ( std::error_code const& )
+        {
+            handle_store_failure( task );
+        };
+
+        // Peers supporting compression are sent the
+        // value compressed, if it's worth it.
+        bool const is_compressed
+                = task->tracker_.get_peer_version( current_candidate.endpoint_ )
+                    >= header::V3
+                && ! task->get_compressed_chunk( 0 ).empty();
+
         store_value_request_body const request{ task->get_key()
-                                              , task->get_data() };
-        task->tracker_.send_request( request, current_candidate.endpoint_ );
+                                              , is_compressed
+                                                ? task->get_compressed_chunk( 0 )
+                                                : task->get_data()
+                                              , std::chrono::seconds::zero()
+                                              , task->version_
+                                              , is_compressed
+                                              , true };
+        task->tracker_.send_request( request
+                                   , current_candidate.endpoint_
+                                   , task->tracker_.get_configuration().peer_lookup_timeout()
+                                   , on_message_received
+                                   , on_error );
+    }
+
+    /**
+     *
+     */
+    static void
+    handle_store_response
+        ( ip_endpoint const& s
+        , header const& h
+        , boost::intrusive_ptr< store_value_task > task )
+    {
+        LOG_DEBUG( store_value_task, task.get() )
+                << "handle store response from '"
+                << s << "'." << std::endl;
+
+        if ( h.type_ != header::STORE_RESPONSE )
+        {
+            LOG_DEBUG( store_value_task, task.get() )
+                    << "unexpected store response (type="
+                    << int( h.type_ ) << ")" << std::endl;
+
+            handle_store_failure( task );
+            return;
+        }
+
+        handle_store_acknowledgement( task );
+    }
+
+    /**
+     *  @brief Send the next chunks of the value to a replica,
+     *         keeping up to the configured chunk window size
+     *         of them in flight.
+     */
+    static void
+    send_store_chunk_requests
+        ( std::shared_ptr< chunks_upload > upload
+        , boost::intrusive_ptr< store_value_task > task )
+    {
+        auto const& data = task->get_data();
+        auto const chunks_count = get_chunks_count( data.size(), CHUNK_SIZE );
+
+        while ( upload->next_chunk_ < chunks_count
+              && upload->next_chunk_ - upload->acknowledged_chunks_count_
+                    < task->tracker_.get_configuration().chunk_window_size() )
+        {
+            auto const chunk_index = upload->next_chunk_ ++;
+
+            auto on_message_received = [ task, upload, chunks_count ]
+                ( ip_endpoint const&
+                , header const& h
+                , buffer::const_iterator
+                , buffer::const_iterator )
+            {
+                if ( upload->is_failed_ )
+                    return;
+
+                if ( h.type_ != header::STORE_RESPONSE )
+                {
+                    fail_chunks_upload( upload, task );
+                    return;
+                }
+
+                ++ upload->acknowledged_chunks_count_;
+                if ( upload->acknowledged_chunks_count_ == chunks_count )
+                    handle_store_acknowledgement( task );
+                else
+                    send_store_chunk_requests( upload, task );
+            };
+
+            auto on_error = [ task, upload ]
+                ( std::error_code const& )
+            { fail_chunks_upload( upload, task ); };
+
+            // Peers supporting compression are sent
+            // each chunk compressed, if it's worth it.
+            bool const is_compressed
+                    = task->tracker_.get_peer_version( upload->replica_.endpoint_ )
+                        >= header::V3
+                    && ! task->get_compressed_chunk( chunk_index ).empty();
+
+            store_chunk_request_body const request{ task->get_key()
+                                                  , task->version_
+                                                  , data.size()
+                                                  , chunk_index
+                                                  , is_compressed
+                                                    ? task->get_compressed_chunk( chunk_index )
+                                                    : data_type( task->get_chunk_begin( chunk_index )
+                                                               , task->get_chunk_end( chunk_index ) )
+                                                  , is_compressed };
+            task->tracker_.send_request( request
+                                       , upload->replica_.endpoint_
+                                       , task->tracker_.get_configuration().peer_lookup_timeout()
+                                       , on_message_received
+                                       , on_error );
+        }
+    }
+
+    /**
+     *  @brief Give up the replica once one of its chunks failed.
+     */
+    static void
+    fail_chunks_upload
+        ( std::shared_ptr< chunks_upload > upload
+        , boost::intrusive_ptr< store_value_task > task )
+    {
+        if ( upload->is_failed_ )
+            return;
+
+        LOG_DEBUG( store_value_task, task.get() )
+                << "failed to upload '" << task->get_key()
+                << "' chunks to '" << upload->replica_
+                << "'." << std::endl;
+
+        upload->is_failed_ = true;
+        handle_store_failure( task );
+    }
+
+    /**
+     *
+     */
+    static void
+    handle_store_acknowledgement
+        ( boost::intrusive_ptr< store_value_task > task )
+    {
+        -- task->in_flight_stores_count_;
+        ++ task->acknowledged_stores_count_;
+
+        check_store_completion( task );
+    }
+
+    /**
+     *
+     */
+    static void
+    handle_store_failure
+        ( boost::intrusive_ptr< store_value_task > task )
+    {
+        -- task->in_flight_stores_count_;
+
+        send_store_request_to_next_candidate( task );
+
+        check_store_completion( task );
+    }
+
+    /**
+     *
+     */
+    static void
+    check_store_completion
+        ( boost::intrusive_ptr< store_value_task > task )
+    {
+        if ( task->is_caller_notified_ )
+            return;
+
+        if ( task->acknowledged_stores_count_ >= task->write_quorum_ )
+            task->notify_caller( std::error_code{} );
+        else if ( task->in_flight_stores_count_ == 0 )
+            task->notify_caller( make_error_code( QUORUM_NOT_REACHED ) );
     }
 
 private:
@@ -278,10 +623,34 @@ private:
     data_type data_;
     ///
     save_handler_type save_handler_;
+    ///
+    std::size_t write_quorum_;
+    ///
+    std::vector< peer > store_candidates_;
+    ///
+    std::size_t next_store_candidate_;
+    ///
+    std::size_t in_flight_stores_count_;
+    ///
+    std::size_t acknowledged_stores_count_;
+    ///
+    bool is_caller_notified_;
+    ///
+    bool is_lookup_over_;
+    ///
+    std::uint64_t version_;
+    /// The chunks of data_ compressed, empty if not worth it.
+    std::vector< data_type > compressed_chunks_;
 };
 
 /**
+ *  @brief Store data on the redundant save count peers closest to key.
  *
+ *  The handler is called once write_quorum of them acknowledged
+ *  the store, or with QUORUM_NOT_REACHED when too many failed and
+ *  no closer valid peer was left to replace them.
+ *  Peers keep the value with the highest version.
+ *  The lookup also starts from the closest peers of pool, if any.
  */
 template< typename DataType
         , typename TrackerType
@@ -293,13 +662,19 @@ start_store_value_task
     , DataType const& data
     , TrackerType & tracker
     , RoutingTableType & routing_table
-    , HandlerType && save_handler )
+    , HandlerType && save_handler
+    , std::size_t write_quorum = STORE_WRITE_QUORUM
+    , std::uint64_t version = 0
+    , std::shared_ptr< candidates_pool > pool = nullptr )
 {
     using handler_type = typename std::decay< HandlerType >::type;
     using task = store_value_task< handler_type, TrackerType, DataType >;
 
     task::start( key, data, tracker, routing_table
-               , std::forward< HandlerType >( save_handler ) );
+               , std::forward< HandlerType >( save_handler )
+               , write_quorum
+               , version
+               , std::move( pool ) );
 }
 
 } // namespace detail
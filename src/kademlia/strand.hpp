@@ -0,0 +1,343 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_STRAND_HPP
+#define KADEMLIA_STRAND_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+
+namespace kademlia {
+namespace detail {
+
+template< typename HandlerType >
+class strand_handler;
+
+class strand_service;
+
+/**
+ *  @brief This class serializes the handlers of an engine.
+ *  @details
+ *  Sockets and timers wrap their handlers using wrap(),
+ *  hence an io_service can be run by several threads
+ *  without the state of an engine being accessed
+ *  concurrently, while distinct engines run in parallel.
+ *  As long as the io_service is run by a single thread,
+ *  handlers are called directly, without the strand cost.
+ *  Handlers still pending once the strand is destroyed,
+ *  e.g. with its engine while the io_service is running,
+ *  are dropped rather than called.
+ */
+class strand final
+{
+public:
+    /**
+     *
+     */
+    explicit
+    strand
+        ( boost::asio::io_service & io_service );
+
+    /**
+     *  @param service The strand_service of io_service.
+     */
+    strand
+        ( boost::asio::io_service & io_service
+        , strand_service & service );
+
+    /**
+     *
+     */
+    strand
+        ( strand const& )
+        = delete;
+
+    /**
+     *
+     */
+    strand &
+    operator=
+        ( strand const& )
+        = delete;
+
+    /**
+     *
+     */
+    boost::asio::io_service &
+    get_io_service
+        ( void )
+    { return io_service_; }
+
+    /**
+     *  @return A handler calling handler on the strand.
+     */
+    template< typename HandlerType >
+    strand_handler< typename std::decay< HandlerType >::type >
+    wrap
+        ( HandlerType && handler );
+
+    /**
+     *  @brief Call handler on the strand, later.
+     */
+    template< typename HandlerType >
+    void
+    post
+        ( HandlerType && handler );
+
+    /**
+     *  @return true if handlers can be called right away,
+     *          i.e. the caller is alone or on the strand.
+     */
+    bool
+    can_call_now
+        ( void )
+        const;
+
+    /**
+     *  @brief Call handler on the strand,
+     *         now if the caller is already on it.
+     */
+    template< typename HandlerType >
+    void
+    dispatch
+        ( HandlerType && handler );
+
+private:
+    ///
+    boost::asio::io_service & io_service_;
+    ///
+    strand_service & service_;
+    /// Only shared weakly with the handlers, which
+    /// tells them whether the strand is still alive.
+    std::shared_ptr< boost::asio::io_service::strand > strand_;
+};
+
+/**
+ *  @brief This service tells the strands of an io_service
+ *         whether it is run by several threads.
+ *  @details It also provides the strand of the objects
+ *           not owned by an engine.
+ */
+class strand_service final
+        : public boost::asio::io_service::service
+{
+public:
+    ///
+    static boost::asio::io_service::id id;
+
+public:
+    /**
+     *
+     */
+    explicit
+    strand_service
+        ( boost::asio::io_service & io_service )
+            : boost::asio::io_service::service( io_service )
+            , is_concurrent_()
+            , default_strand_( io_service, *this )
+    { }
+
+    /**
+     *  @brief Set whether the io_service is run by several threads.
+     *  @details Must be called before these threads are started.
+     */
+    void
+    set_concurrent
+        ( bool is_concurrent )
+    { is_concurrent_ = is_concurrent; }
+
+    /**
+     *
+     */
+    bool
+    is_concurrent
+        ( void )
+        const
+    { return is_concurrent_; }
+
+    /**
+     *  @return The strand shared by the objects
+     *          not given their own.
+     */
+    strand &
+    get_default_strand
+        ( void )
+    { return default_strand_; }
+
+private:
+    /**
+     *
+     */
+    void
+    shutdown_service
+        ( void ) override
+    { }
+
+private:
+    ///
+    std::atomic< bool > is_concurrent_;
+    /// Created along this service, hence before
+    /// the io_service can be run by several threads.
+    strand default_strand_;
+};
+
+/**
+ *  @brief This handler dispatches its calls through a strand.
+ *  @details Unlike strand::wrap(), it can be called when const,
+ *           as the fake sockets of the tests do. It doesn't
+ *           keep the strand alive, and drops the call once
+ *           the strand has been destroyed.
+ */
+template< typename HandlerType >
+class strand_handler final
+{
+public:
+    /**
+     *
+     */
+    strand_handler
+        ( strand_service & service
+        , std::weak_ptr< boost::asio::io_service::strand > s
+        , HandlerType handler )
+            : service_( &service )
+            , strand_( std::move( s ) )
+            , handler_( std::move( handler ) )
+    { }
+
+    /**
+     *  @details The handler and its arguments are only copied
+     *           when the call can't be made right away.
+     */
+    template< typename... Args >
+    void
+    operator()
+        ( Args &&... args )
+        const
+    {
+        auto const s = strand_.lock();
+        if ( ! s )
+            return;
+
+        if ( ! service_->is_concurrent() || s->running_in_this_thread() )
+            handler_( std::forward< Args >( args )... );
+        else
+            // Called back through this handler, as the
+            // strand may be destroyed in the meantime.
+            s->dispatch( std::bind( *this, std::forward< Args >( args )... ) );
+    }
+
+private:
+    ///
+    strand_service * service_;
+    ///
+    std::weak_ptr< boost::asio::io_service::strand > strand_;
+    /// Mutable as the handlers posted may be.
+    mutable HandlerType handler_;
+};
+
+/**
+ *  @return The strand_service of the engines run by io_service.
+ */
+inline strand_service &
+get_strand_service
+    ( boost::asio::io_service & io_service )
+{ return boost::asio::use_service< strand_service >( io_service ); }
+
+/**
+ *  @return The strand shared by the objects run by
+ *          io_service which aren't given their own.
+ */
+inline strand &
+get_default_strand
+    ( boost::asio::io_service & io_service )
+{ return get_strand_service( io_service ).get_default_strand(); }
+
+inline
+strand::strand
+    ( boost::asio::io_service & io_service )
+        : strand( io_service, get_strand_service( io_service ) )
+{ }
+
+inline
+strand::strand
+    ( boost::asio::io_service & io_service
+    , strand_service & service )
+        : io_service_( io_service )
+        , service_( service )
+        , strand_( std::make_shared< boost::asio::io_service::strand >( io_service ) )
+{ }
+
+template< typename HandlerType >
+inline strand_handler< typename std::decay< HandlerType >::type >
+strand::wrap
+    ( HandlerType && handler )
+{
+    using handler_type = typename std::decay< HandlerType >::type;
+    return strand_handler< handler_type >{ service_, strand_
+                                         , std::forward< HandlerType >( handler ) };
+}
+
+template< typename HandlerType >
+inline void
+strand::post
+    ( HandlerType && handler )
+{
+    if ( service_.is_concurrent() )
+        strand_->post( wrap( std::forward< HandlerType >( handler ) ) );
+    else
+        io_service_.post( wrap( std::forward< HandlerType >( handler ) ) );
+}
+
+inline bool
+strand::can_call_now
+    ( void )
+    const
+{ return ! service_.is_concurrent() || strand_->running_in_this_thread(); }
+
+template< typename HandlerType >
+inline void
+strand::dispatch
+    ( HandlerType && handler )
+{
+    if ( service_.is_concurrent() )
+        strand_->dispatch( std::forward< HandlerType >( handler ) );
+    else
+        handler();
+}
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
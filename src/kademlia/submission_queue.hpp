@@ -0,0 +1,294 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_SUBMISSION_QUEUE_HPP
+#define KADEMLIA_SUBMISSION_QUEUE_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "kademlia/strand.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class hands over tasks submitted by
+ *         application threads to a strand.
+ *  @details
+ *  Producers push tasks into a lock-free intrusive
+ *  multiple producers single consumer queue (Vyukov's).
+ *  The producer making the queue non empty wakes up the
+ *  engine by posting a single drain handler, which then
+ *  executes up to batch_size tasks at once, hence a burst
+ *  of submissions costs one io_service wake up instead
+ *  of one per task.
+ */
+class submission_queue final
+{
+public:
+    ///
+    using task_type = std::function< void ( void ) >;
+
+public:
+    /**
+     *  @param strand The strand executing the tasks.
+     *  @param batch_size The maximum count of tasks
+     *         executed by a drain before yielding
+     *         to the other handlers.
+     */
+    submission_queue
+        ( strand & strand
+        , std::size_t batch_size )
+            : strand_( strand )
+            , batch_size_( batch_size )
+            , stub_()
+            , head_( &stub_ )
+            , tail_( &stub_ )
+            , is_drain_scheduled_()
+            , drains_count_()
+            , executed_tasks_count_()
+    { }
+
+    /**
+     *
+     */
+    submission_queue
+        ( submission_queue const& )
+        = delete;
+
+    /**
+     *
+     */
+    submission_queue &
+    operator=
+        ( submission_queue const& )
+        = delete;
+
+    /**
+     *
+     */
+    ~submission_queue
+        ( void )
+    {
+        while ( auto n = pop() )
+            delete n;
+    }
+
+    /**
+     *  @brief Submit a task, from any thread.
+     */
+    void
+    push
+        ( task_type task )
+    {
+        push( new node{ std::move( task ) } );
+
+        // Only the first producer to see the drain
+        // unscheduled wakes up the engine.
+        if ( ! is_drain_scheduled_.exchange( true, std::memory_order_acq_rel ) )
+            schedule_drain();
+    }
+
+    /**
+     *  @return The count of drains executed.
+     */
+    std::uint64_t
+    drains_count
+        ( void )
+        const
+    { return drains_count_.load( std::memory_order_relaxed ); }
+
+    /**
+     *  @return The count of tasks executed.
+     */
+    std::uint64_t
+    executed_tasks_count
+        ( void )
+        const
+    { return executed_tasks_count_.load( std::memory_order_relaxed ); }
+
+private:
+    ///
+    struct node final
+    {
+        ///
+        node
+            ( void )
+                : next_()
+                , task_()
+        { }
+
+        ///
+        explicit
+        node
+            ( task_type task )
+                : next_()
+                , task_( std::move( task ) )
+        { }
+
+        ///
+        std::atomic< node * > next_;
+        ///
+        task_type task_;
+    };
+
+private:
+    /**
+     *
+     */
+    void
+    push
+        ( node * n )
+    {
+        n->next_.store( nullptr, std::memory_order_relaxed );
+        auto const previous = head_.exchange( n, std::memory_order_acq_rel );
+        previous->next_.store( n, std::memory_order_release );
+    }
+
+    /**
+     *  @return The oldest node or nullptr if the queue is empty
+     *          or a producer is in the middle of a push.
+     */
+    node *
+    pop
+        ( void )
+    {
+        auto tail = tail_;
+        auto next = tail->next_.load( std::memory_order_acquire );
+
+        if ( tail == &stub_ )
+        {
+            if ( ! next )
+                return nullptr;
+
+            tail_ = next;
+            tail = next;
+            next = next->next_.load( std::memory_order_acquire );
+        }
+
+        if ( next )
+        {
+            tail_ = next;
+            return tail;
+        }
+
+        // A producer exchanged head_ but didn't link its node yet.
+        if ( tail != head_.load( std::memory_order_acquire ) )
+            return nullptr;
+
+        push( &stub_ );
+
+        next = tail->next_.load( std::memory_order_acquire );
+        if ( ! next )
+            return nullptr;
+
+        tail_ = next;
+        return tail;
+    }
+
+    /**
+     *
+     */
+    bool
+    is_empty
+        ( void )
+        const
+    {
+        return tail_ == head_.load( std::memory_order_acquire )
+                && tail_ == &stub_;
+    }
+
+    /**
+     *
+     */
+    void
+    schedule_drain
+        ( void )
+    { strand_.post( [ this ]( void ) { drain(); } ); }
+
+    /**
+     *  @brief Execute the pending tasks, on the strand.
+     */
+    void
+    drain
+        ( void )
+    {
+        drains_count_.fetch_add( 1, std::memory_order_relaxed );
+
+        // Producers pushing from now on schedule another drain.
+        // This exchange acquires the pushes of the producers
+        // which saw the drain already scheduled.
+        is_drain_scheduled_.exchange( false, std::memory_order_acq_rel );
+
+        for ( std::size_t i = 0; i < batch_size_; ++ i )
+        {
+            auto const n = pop();
+            if ( ! n )
+                break;
+
+            executed_tasks_count_.fetch_add( 1, std::memory_order_relaxed );
+            auto const task = std::move( n->task_ );
+            delete n;
+            task();
+        }
+
+        // Tasks left behind, either beyond the batch or
+        // half pushed, are handled by a following drain.
+        if ( ! is_empty()
+           && ! is_drain_scheduled_.exchange( true, std::memory_order_acq_rel ) )
+            schedule_drain();
+    }
+
+private:
+    ///
+    strand & strand_;
+    ///
+    std::size_t batch_size_;
+    ///
+    node stub_;
+    /// Last pushed node, shared by the producers.
+    std::atomic< node * > head_;
+    /// Next node to pop, owned by the consumer.
+    node * tail_;
+    ///
+    std::atomic< bool > is_drain_scheduled_;
+    /// Read by the statistics from any thread.
+    std::atomic< std::uint64_t > drains_count_;
+    ///
+    std::atomic< std::uint64_t > executed_tasks_count_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
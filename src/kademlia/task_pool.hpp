@@ -0,0 +1,151 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_TASK_POOL_HPP
+#define KADEMLIA_TASK_POOL_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+#include "kademlia/constants.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class recycles the storage of the Task
+ *         objects it is a base of.
+ *  @details Tasks are created and destroyed at the rate
+ *           of the lookups. The storage of the last
+ *           TASK_POOL_CAPACITY tasks destroyed by a thread
+ *           is kept for the next tasks it creates.
+ */
+template< typename Task >
+class pooled_task
+{
+public:
+    /**
+     *
+     */
+    static void *
+    operator new
+        ( std::size_t size )
+    {
+        assert( size == sizeof( Task ) );
+
+        auto & blocks = get_free_blocks();
+        if ( ! blocks.first_ )
+            return ::operator new( size );
+
+        auto const block = blocks.first_;
+        blocks.first_ = block->next_;
+        -- blocks.count_;
+
+        return block;
+    }
+
+    /**
+     *
+     */
+    static void
+    operator delete
+        ( void * p )
+    {
+        if ( ! p )
+            return;
+
+        auto & blocks = get_free_blocks();
+        if ( blocks.count_ >= TASK_POOL_CAPACITY )
+        {
+            ::operator delete( p );
+            return;
+        }
+
+        blocks.first_ = new ( p ) free_block{ blocks.first_ };
+        ++ blocks.count_;
+    }
+
+protected:
+    /**
+     *
+     */
+    ~pooled_task
+        ( void )
+        = default;
+
+private:
+    ///
+    struct free_block final
+    {
+        ///
+        free_block * next_;
+    };
+
+    ///
+    struct free_blocks final
+    {
+        /**
+         *
+         */
+        ~free_blocks
+            ( void )
+        {
+            while ( first_ )
+            {
+                auto const block = first_;
+                first_ = block->next_;
+                ::operator delete( block );
+            }
+        }
+
+        ///
+        free_block * first_;
+        ///
+        std::size_t count_;
+    };
+
+private:
+    /**
+     *
+     */
+    static free_blocks &
+    get_free_blocks
+        ( void )
+    {
+        static thread_local free_blocks blocks{ nullptr, 0 };
+        return blocks;
+    }
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
+
@@ -27,18 +27,36 @@
 
 #include "kademlia/error_impl.hpp"
 #include "kademlia/log.hpp"
+#include "kademlia/strand.hpp"
 
 namespace kademlia {
 namespace detail {
 
-timer::timer
-    ( boost::asio::io_service & io_service )
-    : timer_{ io_service }
+timer_queue::timer_queue
+    ( strand & s )
+    : timer_{ s.get_io_service() }
+    , strand_( s )
+    , mutex_{}
     , timeouts_{}
 {}
 
 void
-timer::schedule_next_tick
+timer_queue::push
+    ( time_point const& expiration_time
+    , callback on_timer_expired )
+{
+    std::lock_guard< std::mutex > lock{ mutex_ };
+
+    // If the current expiration time will be the sooner to expires
+    // then cancel any pending wait and schedule this one instead.
+    if ( timeouts_.empty() || expiration_time < timeouts_.begin()->first )
+        schedule_next_tick( expiration_time );
+
+    timeouts_.emplace( expiration_time, std::move( on_timer_expired ) );
+}
+
+void
+timer_queue::schedule_next_tick
     ( time_point const& expiration_time )
 {
     // This will cancel any pending task.
@@ -58,35 +76,67 @@ timer::schedule_next_tick
         if ( failure )
             throw std::system_error{ make_error_code( TIMER_MALFUNCTION ) };
 
-        // The callbacks to execute are the first
-        // n callbacks with the same keys.
-        auto begin = timeouts_.begin();
-        auto end = timeouts_.upper_bound( begin->first );
-        // Call the user callbacks.
-        for ( auto i = begin; i != end; ++ i )
-            i->second();
-
-        LOG_DEBUG( timer, this )
-                << "remove " << std::distance( begin, end )
-                << " callback(s) scheduled at "
-                << begin->first.time_since_epoch().count()
-                << "." << std::endl;
-
-        // And remove the timeout.
-        timeouts_.erase( begin, end );
-
-        // If there is a remaining timeout, schedule it.
-        if ( ! timeouts_.empty() )
-        {
-            LOG_DEBUG( timer, this )
-                    << "schedule remaining timers" << std::endl;
-            schedule_next_tick( timeouts_.begin()->first );
-        }
+        call_expired_callbacks();
     };
 
-    timer_.async_wait( on_fire );
+    timer_.async_wait( strand_.wrap( on_fire ) );
 }
 
+void
+timer_queue::call_expired_callbacks
+    ( void )
+{
+    // A wait canceled after its completion still fires,
+    // hence only the callbacks expired by now are called.
+    auto const now = clock::now();
+
+    LOG_DEBUG( timer, this )
+            << "call callback(s) scheduled until "
+            << now.time_since_epoch().count()
+            << "." << std::endl;
+
+    std::unique_lock< std::mutex > lock{ mutex_ };
+
+    // Remove each callback before calling it unlocked, as a
+    // callback scheduling a new timeout would otherwise
+    // insert it in the range being called.
+    while ( ! timeouts_.empty() && timeouts_.begin()->first <= now )
+    {
+        auto c = std::move( timeouts_.begin()->second );
+        timeouts_.erase( timeouts_.begin() );
+
+        lock.unlock();
+        c();
+        lock.lock();
+    }
+
+    // If there is a remaining timeout, schedule it.
+    if ( ! timeouts_.empty() )
+    {
+        LOG_DEBUG( timer, this )
+                << "schedule remaining timers" << std::endl;
+        schedule_next_tick( timeouts_.begin()->first );
+    }
+}
+
+timer::timer
+    ( boost::asio::io_service & io_service )
+    : timer( get_default_strand( io_service ) )
+{}
+
+timer::timer
+    ( strand & s )
+    : timer( s, nullptr )
+{}
+
+timer::timer
+    ( strand & s
+    , timer_queue * shared_queue )
+    : strand_( s )
+    , own_queue_( shared_queue ? nullptr : new timer_queue{ s } )
+    , queue_( shared_queue ? *shared_queue : *own_queue_ )
+{}
+
 } // namespace detail
 } // namespace kademlia
 
@@ -31,48 +31,77 @@
 #endif
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <chrono>
-#include <functional>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/basic_waitable_timer.hpp>
 
+#include "kademlia/small_function.hpp"
+#include "kademlia/strand.hpp"
+
 namespace kademlia {
 namespace detail {
 
-///
-class timer final
+/**
+ *  @brief This class calls callbacks once their expiration
+ *         time passed, waiting on a single deadline timer.
+ *  @details Callbacks can be pushed from any strand, hence
+ *           the engines sharing an io_service can share
+ *           a queue. They are called on the queue strand.
+ */
+class timer_queue final
 {
 public:
     ///
     using clock = std::chrono::steady_clock;
 
     ///
-    using duration = clock::duration;
+    using time_point = clock::time_point;
+
+    ///
+    using callback = small_function< void ( void ) >;
 
 public:
     /**
-     *
+     *  @brief Call the callbacks on s.
      */
     explicit
-    timer
-        ( boost::asio::io_service & io_service );
+    timer_queue
+        ( strand & s );
 
     /**
      *
      */
-    template< typename Callback >
-    void
-    expires_from_now
-        ( duration const& timeout
-        , Callback const& on_timer_expired );
+    timer_queue
+        ( timer_queue const& )
+        = delete;
 
-private:
-    ///
-    using time_point = clock::time_point;
+    /**
+     *
+     */
+    timer_queue &
+    operator=
+        ( timer_queue const& )
+        = delete;
 
-    ///
-    using callback = std::function< void ( void ) >;
+    /**
+     *
+     */
+    strand &
+    get_strand
+        ( void )
+    { return strand_; }
 
+    /**
+     *  @brief Call on_timer_expired once expiration_time passed.
+     */
+    void
+    push
+        ( time_point const& expiration_time
+        , callback on_timer_expired );
+
+private:
     ///
     using timeouts = std::multimap< time_point, callback >;
 
@@ -81,33 +110,99 @@ private:
 
 private:
     /**
-     *
+     *  @details mutex_ must be held.
      */
     void
     schedule_next_tick
         ( time_point const& expiration_time );
 
+    /**
+     *
+     */
+    void
+    call_expired_callbacks
+        ( void );
+
 private:
     ///
     deadline_timer timer_;
     ///
+    strand & strand_;
+    /// Guards timer_ and timeouts_, which
+    /// other strands push callbacks to.
+    std::mutex mutex_;
+    ///
     timeouts timeouts_;
 };
 
+///
+class timer final
+{
+public:
+    ///
+    using clock = timer_queue::clock;
+
+    ///
+    using duration = clock::duration;
+
+public:
+    /**
+     *  @brief Call the callbacks on the default strand of io_service.
+     */
+    explicit
+    timer
+        ( boost::asio::io_service & io_service );
+
+    /**
+     *  @brief Call the callbacks on s.
+     */
+    explicit
+    timer
+        ( strand & s );
+
+    /**
+     *  @brief Call the callbacks on s.
+     *  @param shared_queue The queue shared with the timers of
+     *         other strands, or nullptr to use a queue of its own.
+     */
+    timer
+        ( strand & s
+        , timer_queue * shared_queue );
+
+    /**
+     *
+     */
+    template< typename Callback >
+    void
+    expires_from_now
+        ( duration const& timeout
+        , Callback && on_timer_expired );
+
+private:
+    ///
+    strand & strand_;
+    /// Only set when the queue isn't shared.
+    std::unique_ptr< timer_queue > own_queue_;
+    ///
+    timer_queue & queue_;
+};
+
 template< typename Callback >
 void
 timer::expires_from_now
     ( duration const& timeout
-    , Callback const& on_timer_expired )
+    , Callback && on_timer_expired )
 {
-    auto expiration_time = clock::now() + timeout;
-
-    // If the current expiration time will be the sooner to expires
-    // then cancel any pending wait and schedule this one instead.
-    if ( timeouts_.empty() || expiration_time < timeouts_.begin()->first )
-        schedule_next_tick( expiration_time );
-
-    timeouts_.emplace( expiration_time, on_timer_expired );
+    auto const expiration_time = clock::now() + timeout;
+
+    if ( &queue_.get_strand() == &strand_ )
+        queue_.push( expiration_time
+                   , std::forward< Callback >( on_timer_expired ) );
+    else
+        // A shared queue calls the callbacks on its
+        // own strand, hence move them to this one.
+        queue_.push( expiration_time
+                   , strand_.wrap( std::forward< Callback >( on_timer_expired ) ) );
 }
 
 } // namespace detail
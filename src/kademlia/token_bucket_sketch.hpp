@@ -0,0 +1,169 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_TOKEN_BUCKET_SKETCH_HPP
+#define KADEMLIA_TOKEN_BUCKET_SKETCH_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class rate limits an unbounded set
+ *         of keys using a fixed amount of memory.
+ *  @details
+ *  Like a count-min sketch, each key maps to one token
+ *  bucket per row and is limited by the fullest one.
+ *  Keys sharing a bucket share its tokens, hence a key
+ *  is wrongly limited only if its buckets are all shared
+ *  with busy keys.
+ */
+class token_bucket_sketch final
+{
+public:
+    ///
+    using clock = std::chrono::steady_clock;
+
+public:
+    /**
+     *  @param depth The count of rows.
+     *  @param width The count of buckets per row.
+     *  @param rate The tokens per second regained by a bucket.
+     *  @param burst The maximum count of tokens of a bucket.
+     */
+    token_bucket_sketch
+        ( std::size_t depth
+        , std::size_t width
+        , std::size_t rate
+        , std::size_t burst )
+            : width_( width )
+            , rate_( rate )
+            , burst_( burst )
+            , buckets_( depth * width )
+    { }
+
+    /**
+     *  @brief Take a token from each bucket of key_hash.
+     *  @return false if all these buckets are empty.
+     */
+    bool
+    consume
+        ( std::size_t key_hash
+        , clock::time_point const& now )
+    {
+        if ( buckets_.empty() )
+            return true;
+
+        double tokens = 0.;
+        auto const depth = buckets_.size() / width_;
+        for ( std::size_t row = 0; row < depth; ++ row )
+            tokens = std::max( tokens
+                             , refill( get_bucket( row, key_hash ), now ) );
+
+        if ( tokens < 1. )
+            return false;
+
+        for ( std::size_t row = 0; row < depth; ++ row )
+        {
+            auto & b = get_bucket( row, key_hash );
+            b.tokens_ = std::max( 0., b.tokens_ - 1. );
+        }
+
+        return true;
+    }
+
+private:
+    ///
+    struct bucket final
+    {
+        ///
+        double tokens_;
+        ///
+        clock::time_point last_refill_time_;
+    };
+
+private:
+    /**
+     *
+     */
+    bucket &
+    get_bucket
+        ( std::size_t row
+        , std::size_t key_hash )
+    {
+        // Each row uses its own hash function,
+        // the MurmurHash3 finalizer of a row specific key.
+        auto h = std::uint64_t( key_hash ) + row * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+
+        return buckets_[ row * width_ + h % width_ ];
+    }
+
+    /**
+     *  @return The tokens of b.
+     */
+    double
+    refill
+        ( bucket & b
+        , clock::time_point const& now )
+    {
+        // An unused bucket is refilled up to the burst size
+        // as its last refill time is the clock epoch.
+        auto const elapsed = std::chrono::duration< double >
+                ( now - b.last_refill_time_ ).count();
+        b.tokens_ = std::min( double( burst_ )
+                            , b.tokens_ + elapsed * rate_ );
+        b.last_refill_time_ = now;
+
+        return b.tokens_;
+    }
+
+private:
+    ///
+    std::size_t width_;
+    ///
+    std::size_t rate_;
+    ///
+    std::size_t burst_;
+    ///
+    std::vector< bucket > buckets_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
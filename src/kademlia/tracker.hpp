@@ -30,6 +30,11 @@
 #   pragma once
 #endif
 
+#include <list>
+#include <map>
+
+#include <kademlia/configuration.hpp>
+
 #include "kademlia/log.hpp"
 #include "kademlia/message_serializer.hpp"
 #include "kademlia/response_router.hpp"
@@ -60,17 +65,24 @@ public:
 
 public:
     /**
-     *
+     *  @param s The strand calling the response callbacks.
+     *  @param timers The timer queue shared with other
+     *         strands, or nullptr.
      */
     tracker
-        ( boost::asio::io_service & io_service
+        ( strand & s
         , id const& my_id
         , network_type & network
-        , random_engine_type & random_engine )
-            : response_router_( io_service )
+        , random_engine_type & random_engine
+        , configuration const& config
+        , timer_queue * timers = nullptr )
+            : response_router_( s, timers )
             , message_serializer_( my_id )
             , network_( network )
             , random_engine_( random_engine )
+            , configuration_( config )
+            , peer_versions_()
+            , peer_versions_lru_()
     { }
 
     /**
@@ -102,7 +114,9 @@ public:
     {
         id const response_id( random_engine_ );
         // Generate the request buffer.
-        auto message = message_serializer_.serialize( request, response_id );
+        auto message = message_serializer_.serialize( request
+                                                    , response_id
+                                                    , get_send_version( e, request ) );
 
         // This lamba will keep the request message alive.
         auto on_request_sent = [ this, response_id
@@ -119,7 +133,7 @@ public:
         };
 
         // Serialize the request and send it.
-        network_.send( message, e, on_request_sent );
+        network_.send( std::move( message ), e, on_request_sent );
     }
 
     /**
@@ -145,13 +159,15 @@ public:
         , Response const& response
         , endpoint_type const& e )
     {
-        auto message = message_serializer_.serialize( response, response_id );
+        auto message = message_serializer_.serialize( response
+                                                    , response_id
+                                                    , get_send_version( e, response ) );
 
         auto on_response_sent = []
             ( std::error_code const& /* failure */ )
         { };
 
-        network_.send( message, e, on_response_sent );
+        network_.send( std::move( message ), e, on_response_sent );
     }
 
     /**
@@ -165,6 +181,156 @@ public:
         , buffer::const_iterator e )
     { response_router_.handle_new_response( s, h, i, e ); }
 
+    /**
+     *  @return true if a response with this id is awaited.
+     */
+    bool
+    is_awaited_response
+        ( id const& response_id )
+        const
+    { return response_router_.is_awaited_response( response_id ); }
+
+    /**
+     *  @brief Remember the highest protocol version spoken
+     *         by the peer listening on e.
+     *  @details Messages sent to e then use this version.
+     *           Once full, the peer heard from the least
+     *           recently is forgotten.
+     */
+    void
+    record_peer_version
+        ( endpoint_type const& e
+        , header::version const& version )
+    {
+        auto const i = peer_versions_.find( e );
+        if ( i != peer_versions_.end() )
+        {
+            i->second.version_ = version;
+            // Move the peer in front of the LRU list.
+            peer_versions_lru_.splice( peer_versions_lru_.begin()
+                                     , peer_versions_lru_
+                                     , i->second.lru_position_ );
+            return;
+        }
+
+        if ( peer_versions_.size() >= PEER_VERSIONS_CAPACITY )
+        {
+            peer_versions_.erase( peer_versions_lru_.back() );
+            peer_versions_lru_.pop_back();
+        }
+
+        peer_versions_lru_.push_front( e );
+        peer_versions_.emplace( e, peer_version{ version
+                                               , peer_versions_lru_.begin() } );
+    }
+
+    /**
+     *  @brief Move the peer listening on e in front of
+     *         the LRU list, if its version is known.
+     *  @details This is called for each message heard
+     *           from e, so that a peer still talking
+     *           keeps its version.
+     */
+    void
+    touch_peer_version
+        ( endpoint_type const& e )
+    {
+        auto const i = peer_versions_.find( e );
+        if ( i != peer_versions_.end() )
+            peer_versions_lru_.splice( peer_versions_lru_.begin()
+                                     , peer_versions_lru_
+                                     , i->second.lru_position_ );
+    }
+
+    /**
+     *  @return true if the version of the peer listening
+     *          on e is known, and set version to it.
+     */
+    bool
+    find_peer_version
+        ( endpoint_type const& e
+        , header::version & version )
+        const
+    {
+        auto const i = peer_versions_.find( e );
+        if ( i == peer_versions_.end() )
+            return false;
+
+        version = i->second.version_;
+        return true;
+    }
+
+    /**
+     *  @return The highest version known to be spoken
+     *          by the peer listening on e, V1 by default.
+     */
+    header::version
+    get_peer_version
+        ( endpoint_type const& e )
+        const
+    {
+        auto version = header::V1;
+        find_peer_version( e, version );
+
+        return version;
+    }
+
+    /**
+     *  @return The protocol parameters the tasks use.
+     */
+    configuration const&
+    get_configuration
+        ( void )
+        const
+    { return configuration_; }
+
+private:
+    ///
+    using peer_versions_lru_type = std::list< endpoint_type >;
+
+    ///
+    struct peer_version final
+    {
+        ///
+        header::version version_;
+        ///
+        typename peer_versions_lru_type::iterator lru_position_;
+    };
+
+private:
+    /**
+     *  @return The version of the header of message sent to e.
+     *  @details Messages requiring V2 are sent with our latest
+     *           version to peers not known yet, so they learn it.
+     */
+    template< typename Message >
+    header::version
+    get_send_version
+        ( endpoint_type const& e
+        , Message const& )
+        const
+    {
+        auto const type = message_traits< Message >::TYPE_ID;
+        return get_send_version( e, type );
+    }
+
+    /**
+     *
+     */
+    header::version
+    get_send_version
+        ( endpoint_type const& e
+        , header::type const& type )
+        const
+    {
+        auto version = get_version( type ) > header::V1
+                     ? get_latest_version()
+                     : header::V1;
+        find_peer_version( e, version );
+
+        return version;
+    }
+
 private:
     ///
     response_router response_router_;
@@ -174,6 +340,12 @@ private:
     network_type & network_;
     ///
     random_engine_type & random_engine_;
+    ///
+    configuration const& configuration_;
+    /// Peers speaking V2, or not answering V2 messages.
+    std::map< endpoint_type, peer_version > peer_versions_;
+    /// The peers of peer_versions_, most recently heard from first.
+    peer_versions_lru_type peer_versions_lru_;
 };
 
 } // namespace detail
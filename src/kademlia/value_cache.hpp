@@ -0,0 +1,330 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_VALUE_CACHE_HPP
+#define KADEMLIA_VALUE_CACHE_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+#include <kademlia/detail/cxx11_macros.hpp>
+
+#include "kademlia/value_store.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/**
+ *  @brief This class keeps recently loaded values.
+ *  @details
+ *  Entries expire after a fixed time to live and the
+ *  least recently used ones are evicted once the sum
+ *  of the cached data sizes exceeds the capacity.
+ *  Each entry is also charged its bookkeeping so
+ *  empty or small values can't grow the cache
+ *  without bound.
+ */
+template< typename KeyType, typename DataType >
+class value_cache final
+{
+public:
+    ///
+    using key_type = KeyType;
+
+    ///
+    using data_type = DataType;
+
+    ///
+    using clock = std::chrono::steady_clock;
+
+    ///
+    using duration = clock::duration;
+
+    ///
+    struct statistics final
+    {
+        ///
+        std::uint64_t hits_count_;
+        ///
+        std::uint64_t misses_count_;
+        ///
+        std::uint64_t evictions_count_;
+        ///
+        std::uint64_t invalidations_count_;
+        ///
+        std::uint64_t expirations_count_;
+    };
+
+public:
+    /**
+     *  @param capacity The maximum count of cached bytes,
+     *         0 disables the cache.
+     *  @param ttl The time an entry is valid once inserted.
+     */
+    value_cache
+        ( std::size_t capacity
+        , duration const& ttl )
+            : capacity_( capacity )
+            , ttl_( ttl )
+            , size_()
+            , entries_()
+            , expirations_()
+            , index_()
+            , statistics_()
+    { }
+
+    /**
+     *
+     */
+    value_cache
+        ( value_cache const& )
+        = delete;
+
+    /**
+     *
+     */
+    value_cache &
+    operator=
+        ( value_cache const& )
+        = delete;
+
+    /**
+     *  @return A pointer to the cached data or nullptr
+     *          if the key is unknown or expired.
+     *  @note The pointer is invalidated by the next
+     *        call to a non-const method.
+     */
+    data_type const*
+    find
+        ( key_type const& key )
+    {
+        auto i = index_.find( key );
+        if ( i == index_.end() )
+        {
+            ++ statistics_.misses_count_;
+            return nullptr;
+        }
+
+        if ( i->second->expiration_time_ <= clock::now() )
+        {
+            erase( i );
+            ++ statistics_.misses_count_;
+            return nullptr;
+        }
+
+        // Move the entry in front of the LRU list.
+        entries_.splice( entries_.begin(), entries_, i->second );
+        ++ statistics_.hits_count_;
+
+        return &i->second->data_;
+    }
+
+    /**
+     *
+     */
+    void
+    insert
+        ( key_type const& key
+        , data_type const& data )
+    {
+        invalidate_entry( key );
+
+        auto const now = clock::now();
+        erase_expired_entries( now );
+
+        // Don't flush the whole cache for a single entry.
+        auto const charged_size = get_charged_size( data );
+        if ( capacity_ == 0 || charged_size > capacity_ / 2 )
+            return;
+
+        while ( size_ + charged_size > capacity_ )
+        {
+            erase( index_.find( entries_.back().key_ ) );
+            ++ statistics_.evictions_count_;
+        }
+
+        // The TTL is fixed, hence the insertion order
+        // is the expiration order.
+        expirations_.push_back( key );
+        entries_.push_front( entry{ key, data, now + ttl_
+                                  , std::prev( expirations_.end() ) } );
+        index_.emplace( key, entries_.begin() );
+        size_ += charged_size;
+    }
+
+    /**
+     *
+     */
+    void
+    invalidate
+        ( key_type const& key )
+    {
+        if ( invalidate_entry( key ) )
+            ++ statistics_.invalidations_count_;
+    }
+
+    /**
+     *  @return The sum of the cached data sizes,
+     *          entries overhead included.
+     */
+    std::size_t
+    size
+        ( void )
+        const
+    { return size_; }
+
+    /**
+     *
+     */
+    statistics const&
+    get_statistics
+        ( void )
+        const
+    { return statistics_; }
+
+    /**
+     *  @return The bytes charged to an entry
+     *          on top of its data size.
+     */
+    static CXX11_CONSTEXPR std::size_t
+    get_entry_overhead
+        ( void )
+    {
+        // The LRU list node, the key copies of the
+        // expiration list and index nodes, and their
+        // links, index iterator, hash and bucket.
+        return sizeof( entry ) + 2 * sizeof( key_type )
+                + 8 * sizeof( void * );
+    }
+
+private:
+    ///
+    using expirations_type = std::list< key_type >;
+
+    ///
+    struct entry final
+    {
+        ///
+        key_type key_;
+        ///
+        data_type data_;
+        ///
+        clock::time_point expiration_time_;
+        ///
+        typename expirations_type::iterator expiration_;
+    };
+
+    ///
+    using entries_type = std::list< entry >;
+
+    ///
+    using index_type = std::unordered_map
+            < key_type
+            , typename entries_type::iterator
+            , value_store_key_hasher< key_type > >;
+
+private:
+    /**
+     *
+     */
+    static std::size_t
+    get_charged_size
+        ( data_type const& data )
+    { return data.size() + get_entry_overhead(); }
+
+    /**
+     *
+     */
+    void
+    erase_expired_entries
+        ( clock::time_point const& now )
+    {
+        while ( ! expirations_.empty() )
+        {
+            auto i = index_.find( expirations_.front() );
+            if ( i->second->expiration_time_ > now )
+                break;
+
+            erase( i );
+            ++ statistics_.expirations_count_;
+        }
+    }
+
+    /**
+     *
+     */
+    bool
+    invalidate_entry
+        ( key_type const& key )
+    {
+        auto i = index_.find( key );
+        if ( i == index_.end() )
+            return false;
+
+        erase( i );
+        return true;
+    }
+
+    /**
+     *
+     */
+    void
+    erase
+        ( typename index_type::iterator i )
+    {
+        size_ -= get_charged_size( i->second->data_ );
+        expirations_.erase( i->second->expiration_ );
+        entries_.erase( i->second );
+        index_.erase( i );
+    }
+
+private:
+    ///
+    std::size_t capacity_;
+    ///
+    duration ttl_;
+    ///
+    std::size_t size_;
+    ///
+    entries_type entries_;
+    ///
+    expirations_type expirations_;
+    ///
+    index_type index_;
+    ///
+    statistics statistics_;
+};
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
@@ -30,6 +30,7 @@
 #   pragma once
 #endif
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <unordered_map>
@@ -52,6 +53,43 @@ struct value_store_key_hasher
     { return boost::hash_range( key.begin(), key.end() ); }
 };
 
+/// A chunk of a value stored by chunks.
+template< typename DataType >
+struct value_chunk final
+{
+    ///
+    DataType data_;
+    /// data_ is kept as compressed by the peer which sent it.
+    bool is_compressed_;
+    /// The chunks of a value received by chunks, data_ is then empty.
+    std::vector< value_chunk< DataType > > chunks_;
+    /// The size of the value held by chunks_, once uncompressed.
+    std::size_t chunked_value_size_;
+};
+
+///
+template< typename DataType >
+struct value_store_entry final
+{
+    ///
+    using clock = std::chrono::steady_clock;
+
+    ///
+    DataType data_;
+    /// time_point::max() if the value doesn't expire.
+    clock::time_point expiration_time_;
+    /// Version set by the publisher, 0 if unknown.
+    std::uint64_t version_;
+    /// When the value must be saved again on the closest peers.
+    clock::time_point republish_time_;
+    /// data_ is kept as compressed by the peer which sent it.
+    bool is_compressed_;
+    /// The chunks of a value received by chunks, data_ is then empty.
+    std::vector< value_chunk< DataType > > chunks_;
+    /// The size of the value held by chunks_, once uncompressed.
+    std::size_t chunked_value_size_;
+};
+
 ///
 template< typename Key, typename Value >
 using value_store = std::unordered_map
@@ -0,0 +1,134 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_VARINT_HPP
+#define KADEMLIA_VARINT_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <cstdint>
+#include <iterator>
+#include <system_error>
+
+#include <kademlia/detail/cxx11_macros.hpp>
+
+#include "kademlia/error_impl.hpp"
+#include "kademlia/buffer.hpp"
+
+namespace kademlia {
+namespace detail {
+
+/// Longest LEB128 encoding of a 64 bits integer.
+CXX11_CONSTEXPR std::size_t VARINT_MAX_SIZE = 10;
+
+/**
+ *  @return The count of bytes used to encode value.
+ */
+inline std::size_t
+get_varint_size
+    ( std::uint64_t value )
+{
+    std::size_t size = 1;
+    for ( ; value >= 0x80; value >>= 7 )
+        ++ size;
+
+    return size;
+}
+
+/**
+ *  @brief Append value to b, 7 bits per byte,
+ *         least significant bits first.
+ *  @details Values below 128 use a single byte.
+ */
+inline void
+serialize_varint
+    ( std::uint64_t value
+    , buffer & b )
+{
+    for ( ; value >= 0x80; value >>= 7 )
+        b.push_back( std::uint8_t( value | 0x80 ) );
+
+    b.push_back( std::uint8_t( value ) );
+}
+
+/**
+ *  @brief Decode an integer encoded by serialize_varint().
+ *  @return TRUNCATED_SIZE if e is reached before the last byte,
+ *          CORRUPTED_BODY if the integer doesn't fit 64 bits or
+ *          isn't encoded with the fewest bytes.
+ */
+inline std::error_code
+deserialize_varint
+    ( buffer::const_iterator & i
+    , buffer::const_iterator e
+    , std::uint64_t & value )
+{
+    value = 0;
+
+    // Most integers are counts below 128.
+    if ( i != e && *i < 0x80 )
+    {
+        value = *i++;
+        return std::error_code{};
+    }
+
+    // Bound the scan to the longest encoding, hence a single
+    // comparison per byte detects both truncated and overlong
+    // integers.
+    auto const available = std::distance( i, e );
+    auto const last = available >= std::ptrdiff_t( VARINT_MAX_SIZE )
+            ? std::next( i, VARINT_MAX_SIZE )
+            : e;
+
+    auto j = i;
+    std::uint8_t byte;
+    unsigned shift = 0;
+    do
+    {
+        if ( j == last )
+            return make_error_code( j == e ? TRUNCATED_SIZE : CORRUPTED_BODY );
+
+        byte = *j++;
+        value |= std::uint64_t( byte & 0x7f ) << shift;
+        shift += 7;
+    }
+    while ( byte & 0x80 );
+
+    // The 10th byte holds the 64th bit only, and a last
+    // byte of 0 means a shorter encoding exists.
+    if ( ( shift == 7 * VARINT_MAX_SIZE && byte > 1 ) || byte == 0 )
+        return make_error_code( CORRUPTED_BODY );
+
+    i = j;
+
+    return std::error_code{};
+}
+
+} // namespace detail
+} // namespace kademlia
+
+#endif
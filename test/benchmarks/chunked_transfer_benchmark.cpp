@@ -0,0 +1,143 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This benchmark measures the throughput of values stored and
+ *  loaded by chunks over the fake network. As the fake network
+ *  has neither latency nor losses, it reports the processing
+ *  cost of the chunked transfer protocol.
+ *
+ *  Usage: chunked_transfer_benchmark [--nodes-count=N] [--rounds=N]
+ */
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+
+using clock = std::chrono::steady_clock;
+
+/**
+ *
+ */
+double
+to_megabytes_per_second
+    ( std::size_t bytes_count
+    , clock::duration const& duration )
+{
+    auto const seconds = std::chrono::duration< double >( duration ).count();
+    return bytes_count / ( 1024. * 1024. ) / seconds;
+}
+
+/**
+ *
+ */
+void
+benchmark_value_size
+    ( t::engine_network & network
+    , std::size_t value_size
+    , std::size_t rounds )
+{
+    std::string value( value_size, 0 );
+    for ( auto & c : value )
+        c = char( network.random_engine()() );
+
+    clock::duration save_duration{}, load_duration{};
+    std::size_t messages_count = 0;
+    for ( std::size_t r = 0; r < rounds; ++ r )
+    {
+        auto const key = "key " + std::to_string( value_size )
+                       + " " + std::to_string( r );
+
+        auto on_save = []( std::error_code const& failure )
+        { if ( failure ) throw std::system_error{ failure }; };
+
+        t::clear_packets();
+        auto const save_start = clock::now();
+        network[ 0 ].async_save( key, value, on_save );
+        network.poll();
+        save_duration += clock::now() - save_start;
+
+        bool is_loaded = false;
+        auto on_load = [ &value, &is_loaded ]( std::error_code const& failure
+                                             , std::string const& data )
+        {
+            if ( failure ) throw std::system_error{ failure };
+            if ( data != value ) throw std::runtime_error{ "corrupted value" };
+            is_loaded = true;
+        };
+
+        auto const load_start = clock::now();
+        network[ network.size() - 1 ].async_load( key, on_load );
+        network.poll();
+        load_duration += clock::now() - load_start;
+
+        if ( ! is_loaded )
+            throw std::runtime_error{ "the value hasn't been loaded" };
+
+        messages_count += t::count_packets();
+    }
+
+    std::cout << std::setw( 8 ) << value_size / 1024 << " KiB"
+              << std::setw( 12 ) << std::fixed << std::setprecision( 1 )
+              << to_megabytes_per_second( value_size * rounds, save_duration )
+              << std::setw( 12 )
+              << to_megabytes_per_second( value_size * rounds, load_duration )
+              << std::setw( 12 ) << messages_count / rounds << std::endl;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const nodes_count = t::get_option( argc, argv, "nodes-count", 16 );
+    auto const rounds = t::get_option( argc, argv, "rounds", 3 );
+
+    t::engine_network network{ nodes_count };
+
+    std::cout << "nodes: " << nodes_count
+              << ", chunk size: " << kd::CHUNK_SIZE
+              << ", window: " << kd::CHUNK_WINDOW_SIZE
+              << ", replicas: " << kd::REDUNDANT_SAVE_COUNT << std::endl
+              << "      value   save MB/s   load MB/s    messages" << std::endl;
+
+    benchmark_value_size( network, 1024 * 1024, rounds );
+    benchmark_value_size( network, 16 * 1024 * 1024, rounds );
+
+    return 0;
+}
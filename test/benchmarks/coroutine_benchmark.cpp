@@ -0,0 +1,332 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This benchmark compares the front-ends of the session API
+ *  on a chain of dependent loads, each one issued once the
+ *  previous completed: nested callbacks, C++20 coroutines
+ *  awaiting kademlia::load() and futures from
+ *  kademlia::load_future(). It reports the loads per second
+ *  and the heap allocations per load of the whole process.
+ *
+ *  The session loads from a first_session over the loopback
+ *  interface. An unmeasured pass first fills the session value
+ *  cache, so that the measured loads are served from it and
+ *  the front-ends overhead isn't hidden by the network.
+ *
+ *  Usage: coroutine_benchmark [--loads=N] [--port=N] [--warm-up-ms=N]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <kademlia/awaitable.hpp>
+#include <kademlia/first_session.hpp>
+#include <kademlia/future.hpp>
+#include <kademlia/session.hpp>
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace t = k::test;
+
+using clock = std::chrono::steady_clock;
+
+///
+std::atomic< std::uint64_t > allocations_count{};
+
+} // anonymous namespace
+
+void *
+operator new
+    ( std::size_t size )
+{
+    allocations_count.fetch_add( 1, std::memory_order_relaxed );
+    if ( auto p = std::malloc( size ? size : 1 ) )
+        return p;
+
+    throw std::bad_alloc{};
+}
+
+void
+operator delete
+    ( void * p )
+    noexcept
+{ std::free( p ); }
+
+void
+operator delete
+    ( void * p
+    , std::size_t )
+    noexcept
+{ std::free( p ); }
+
+namespace {
+
+/**
+ *  @brief Signal the end of a chain of loads.
+ */
+class completion final
+{
+public:
+    /**
+     *
+     */
+    void
+    notify
+        ( void )
+    {
+        std::lock_guard< std::mutex > lock{ mutex_ };
+        is_done_ = true;
+        condition_.notify_all();
+    }
+
+    /**
+     *
+     */
+    void
+    wait
+        ( void )
+    {
+        std::unique_lock< std::mutex > lock{ mutex_ };
+        condition_.wait( lock, [ this ]( void ) { return is_done_; } );
+    }
+
+private:
+    ///
+    std::mutex mutex_;
+    ///
+    std::condition_variable condition_;
+    ///
+    bool is_done_ = false;
+};
+
+/**
+ *  @brief A coroutine started on creation and
+ *         destroyed on completion.
+ */
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task
+        get_return_object
+            ( void )
+        { return {}; }
+
+        std::suspend_never
+        initial_suspend
+            ( void )
+            noexcept
+        { return {}; }
+
+        std::suspend_never
+        final_suspend
+            ( void )
+            noexcept
+        { return {}; }
+
+        void
+        return_void
+            ( void )
+        { }
+
+        void
+        unhandled_exception
+            ( void )
+        { std::terminate(); }
+    };
+};
+
+/**
+ *
+ */
+k::session::key_type
+make_key
+    ( std::size_t index )
+{
+    auto const key = std::to_string( index );
+    return k::session::key_type{ key.begin(), key.end() };
+}
+
+/**
+ *  @brief Load keys[ i ] then the following ones
+ *         from the load handler.
+ */
+void
+load_with_callbacks
+    ( k::session & s
+    , std::vector< k::session::key_type > const& keys
+    , std::size_t i
+    , completion & done )
+{
+    if ( i == keys.size() )
+        return done.notify();
+
+    auto on_load = [ &s, &keys, i, &done ]( std::error_code const& failure
+                                          , k::session::data_type const& )
+    {
+        if ( failure )
+            throw std::system_error{ failure };
+
+        load_with_callbacks( s, keys, i + 1, done );
+    };
+
+    s.async_load( keys[ i ], on_load );
+}
+
+/**
+ *
+ */
+detached_task
+load_with_coroutine
+    ( k::session & s
+    , std::vector< k::session::key_type > const& keys
+    , completion & done )
+{
+    for ( auto const& key : keys )
+        co_await k::load( s, key );
+
+    done.notify();
+}
+
+/**
+ *
+ */
+void
+load_with_futures
+    ( k::session & s
+    , std::vector< k::session::key_type > const& keys )
+{
+    for ( auto const& key : keys )
+        k::load_future( s, key ).get();
+}
+
+/**
+ *
+ */
+template< typename LoadsType >
+void
+benchmark_loads
+    ( char const* name
+    , std::size_t loads_count
+    , LoadsType loads )
+{
+    auto const allocations_before = allocations_count.load();
+    auto const start = clock::now();
+
+    loads();
+
+    auto const seconds = std::chrono::duration< double >
+            ( clock::now() - start ).count();
+    auto const allocations = allocations_count.load() - allocations_before;
+
+    std::cout << std::setw( 10 ) << name
+              << std::setw( 12 ) << std::fixed << std::setprecision( 0 )
+              << loads_count / seconds
+              << std::setw( 16 ) << std::setprecision( 1 )
+              << double( allocations ) / loads_count << std::endl;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const loads_count = t::get_option( argc, argv, "loads", 1000 );
+    auto const port = std::uint16_t( t::get_option( argc, argv, "port", 29000 ) );
+    auto const warm_up_duration = std::chrono::milliseconds
+            ( t::get_option( argc, argv, "warm-up-ms", 1000 ) );
+
+    k::endpoint const first_ipv4{ "127.0.0.1", port };
+    k::first_session first{ first_ipv4, k::endpoint{ "::1", port } };
+    k::session s{ first_ipv4
+                , k::endpoint{ "127.0.0.1", std::uint16_t( port + 1 ) }
+                , k::endpoint{ "::1", std::uint16_t( port + 1 ) } };
+
+    auto first_result = std::async( std::launch::async
+                                  , &k::first_session::run, &first );
+    auto result = std::async( std::launch::async
+                            , &k::session::run, &s );
+
+    // Let the session discover its neighbors before measuring.
+    std::this_thread::sleep_for( warm_up_duration );
+
+    std::vector< k::session::key_type > keys;
+    k::session::data_type const data( 256, 'x' );
+    for ( std::size_t i = 0; i < loads_count; ++ i )
+    {
+        keys.push_back( make_key( i ) );
+        k::save_future( s, keys.back(), data ).get();
+    }
+
+    load_with_futures( s, keys );
+
+    std::cout << "loads: " << loads_count << std::endl
+              << "front-end     loads/s  allocations/load" << std::endl;
+
+    benchmark_loads( "callback", loads_count, [ & ]( void )
+    {
+        completion done;
+        load_with_callbacks( s, keys, 0, done );
+        done.wait();
+    } );
+
+    benchmark_loads( "coroutine", loads_count, [ & ]( void )
+    {
+        completion done;
+        load_with_coroutine( s, keys, done );
+        done.wait();
+    } );
+
+    benchmark_loads( "future", loads_count, [ & ]( void )
+    { load_with_futures( s, keys ); } );
+
+    s.abort();
+    first.abort();
+    result.get();
+    first_result.get();
+
+    return 0;
+}
+
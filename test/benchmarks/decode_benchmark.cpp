@@ -0,0 +1,278 @@
+// Copyright (c) 2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This benchmark measures the messages decoding throughput
+ *  on a packets corpus, either recorded into a directory (one
+ *  packet per file, as libFuzzer corpora) or generated: valid
+ *  messages of every type and hostile ones declaring huge lists.
+ *
+ *  Usage: decode_benchmark [--corpus=DIR] [--write-corpus=DIR]
+ *                          [--rounds=N]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "kademlia/message_serializer.hpp"
+
+#include "message_decoder.hpp"
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+namespace filesystem = boost::filesystem;
+
+using clock = std::chrono::steady_clock;
+
+/**
+ *
+ */
+struct packet final
+{
+    ///
+    std::string kind_;
+    ///
+    kd::buffer data_;
+};
+
+/**
+ *
+ */
+std::string
+get_string_option
+    ( int argc
+    , char * argv[]
+    , std::string const& name )
+{
+    auto const prefix = "--" + name + "=";
+
+    for ( int i = 1; i < argc; ++ i )
+    {
+        std::string const arg{ argv[ i ] };
+        if ( arg.compare( 0, prefix.size(), prefix ) == 0 )
+            return arg.substr( prefix.size() );
+    }
+
+    return std::string{};
+}
+
+/**
+ *
+ */
+std::vector< packet >
+read_corpus
+    ( std::string const& directory )
+{
+    std::vector< packet > packets;
+
+    for ( filesystem::directory_iterator i{ directory }, e; i != e; ++ i )
+    {
+        std::ifstream file{ i->path().string(), std::ios::binary };
+        kd::buffer data{ std::istreambuf_iterator< char >{ file }
+                       , std::istreambuf_iterator< char >{} };
+        packets.push_back( packet{ i->path().filename().string()
+                                 , std::move( data ) } );
+    }
+
+    return packets;
+}
+
+/**
+ *
+ */
+void
+write_corpus
+    ( std::string const& directory
+    , std::vector< packet > const& packets )
+{
+    filesystem::create_directories( directory );
+
+    for ( std::size_t i = 0; i < packets.size(); ++ i )
+    {
+        auto const path = filesystem::path{ directory }
+                        / ( packets[ i ].kind_ + "_" + std::to_string( i ) );
+        std::ofstream file{ path.string(), std::ios::binary };
+        file.write( reinterpret_cast< char const* >( packets[ i ].data_.data() )
+                  , std::streamsize( packets[ i ].data_.size() ) );
+    }
+}
+
+/**
+ *
+ */
+std::vector< kd::peer >
+generate_peers
+    ( std::default_random_engine & random_engine )
+{
+    std::vector< kd::peer > peers;
+    for ( std::size_t i = 0; i < kd::ROUTING_TABLE_BUCKET_SIZE; ++ i )
+    {
+        auto const address = i % 2
+                ? boost::asio::ip::address::from_string( "2001:db8::1" )
+                : boost::asio::ip::address::from_string( "192.0.2.1" );
+        peers.push_back( kd::peer{ kd::id{ random_engine }
+                                 , kd::ip_endpoint{ address
+                                                  , std::uint16_t( 27980 + i ) } } );
+    }
+
+    return peers;
+}
+
+/**
+ *
+ */
+std::vector< packet >
+generate_corpus
+    ( void )
+{
+    std::default_random_engine random_engine;
+    kd::id const my_id{ random_engine };
+    kd::message_serializer serializer{ my_id };
+    kd::id const token{ random_engine };
+    kd::id const key{ random_engine };
+    std::vector< std::uint8_t > const value( 512, 'v' );
+
+    std::vector< packet > packets;
+    auto add = [ & ]( std::string const& kind, kd::buffer data )
+    { packets.push_back( packet{ kind, std::move( data ) } ); };
+
+    add( "ping", serializer.serialize( kd::header::PING_REQUEST, token ) );
+    add( "find_peer"
+       , serializer.serialize( kd::find_peer_request_body{ key }, token ) );
+    add( "peers_v1"
+       , serializer.serialize( kd::find_peer_response_body
+                                    { generate_peers( random_engine ) }
+                             , token ) );
+    add( "peers_v2"
+       , serializer.serialize( kd::find_peer_compact_response_body
+                                    { token, generate_peers( random_engine ) }
+                             , token, kd::header::V2 ) );
+    add( "store"
+       , serializer.serialize( kd::store_value_request_body
+                                    { key, value, std::chrono::seconds{ 0 }, 1 }
+                             , token ) );
+    add( "value"
+       , serializer.serialize( kd::find_value_response_body{ value, 1 }, token ) );
+
+    std::vector< kd::id > keys;
+    for ( std::size_t i = 0; i < 32; ++ i )
+        keys.push_back( kd::id{ random_engine } );
+    add( "find_values"
+       , serializer.serialize( kd::find_values_request_body{ keys }, token ) );
+
+    // Hostile packets declaring huge lists.
+    auto huge_peers = serializer.serialize( kd::header::FIND_PEER_RESPONSE, token );
+    huge_peers.insert( huge_peers.end(), 8, 0xff );
+    add( "huge_peers_v1", huge_peers );
+
+    auto huge_keys = serializer.serialize( kd::header::FIND_VALUES_REQUEST, token );
+    huge_keys.insert( huge_keys.end(), { 0xff, 0xff, 0xff, 0xff, 0x0f } );
+    add( "huge_keys", huge_keys );
+
+    // An unknown address protocol.
+    auto bad_address = serializer.serialize( kd::find_peer_response_body
+                                                  { generate_peers( random_engine ) }
+                                           , token );
+    auto const protocol_offset = 1 + 2 * kd::id::BLOCKS_COUNT // Header.
+                               + 8 // Peers count.
+                               + kd::id::BLOCKS_COUNT + 2; // Id and port.
+    bad_address[ protocol_offset ] = 7;
+    add( "bad_address", bad_address );
+
+    return packets;
+}
+
+/**
+ *
+ */
+void
+benchmark_decoding
+    ( std::string const& kind
+    , std::vector< packet > const& packets
+    , std::size_t rounds )
+{
+    std::size_t bytes_count = 0, failures_count = 0;
+    for ( auto const& p : packets )
+        bytes_count += p.data_.size();
+
+    auto const start = clock::now();
+    for ( std::size_t r = 0; r < rounds; ++ r )
+        for ( auto const& p : packets )
+            if ( t::decode_message( p.data_.cbegin(), p.data_.cend() ) )
+                ++ failures_count;
+    auto const seconds = std::chrono::duration< double >( clock::now() - start ).count();
+
+    auto const count = packets.size() * rounds;
+    std::cout << std::setw( 16 ) << kind
+              << std::setw( 10 ) << packets.size()
+              << std::setw( 12 ) << std::fixed << std::setprecision( 2 )
+              << count / 1e6 / seconds
+              << std::setw( 12 )
+              << bytes_count * rounds / 1e6 / seconds
+              << std::setw( 12 ) << std::setprecision( 0 )
+              << 100. * failures_count / count << std::endl;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const rounds = t::get_option( argc, argv, "rounds", 100000 );
+    auto const corpus_directory = get_string_option( argc, argv, "corpus" );
+    auto const output_directory = get_string_option( argc, argv, "write-corpus" );
+
+    auto const packets = corpus_directory.empty()
+                       ? generate_corpus()
+                       : read_corpus( corpus_directory );
+
+    if ( ! output_directory.empty() )
+        write_corpus( output_directory, packets );
+
+    std::cout << "            kind   packets   Mpkt/s        MB/s  rejected %"
+              << std::endl;
+
+    benchmark_decoding( "all", packets, rounds );
+    for ( auto const& p : packets )
+        benchmark_decoding( p.kind_, { p }, rounds );
+
+    return 0;
+}
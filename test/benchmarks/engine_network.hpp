@@ -0,0 +1,173 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_TEST_BENCHMARKS_ENGINE_NETWORK_HPP
+#define KADEMLIA_TEST_BENCHMARKS_ENGINE_NETWORK_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+
+#include "test_engine.hpp"
+
+namespace kademlia {
+namespace test {
+
+/**
+ *  @brief A network of engines connected through fake sockets.
+ */
+class engine_network final
+{
+public:
+    /**
+     *  @brief Create and bootstrap nodes_count engines.
+     */
+    explicit
+    engine_network
+        ( std::size_t nodes_count
+        , std::default_random_engine::result_type seed = 0 )
+            : io_service_()
+            , random_engine_( seed )
+            , engines_()
+    {
+        endpoint const ipv4{ "127.0.0.1", session_base::DEFAULT_PORT };
+        endpoint const ipv6{ "::1", session_base::DEFAULT_PORT };
+
+        use_own_ipv4_network( 0 );
+        engines_.emplace_back( new test_engine{ io_service_
+                                              , ipv4, ipv6
+                                              , detail::id{ random_engine_ } } );
+
+        for ( std::size_t i = 1; i < nodes_count; ++ i )
+        {
+            use_own_ipv4_network( i );
+            engines_.emplace_back( new test_engine{ io_service_
+                                                  , engines_.front()->ipv4()
+                                                  , ipv4, ipv6
+                                                  , detail::id{ random_engine_ } } );
+            poll();
+        }
+    }
+
+    /**
+     *
+     */
+    test_engine &
+    operator[]
+        ( std::size_t index )
+    { return *engines_[ index ]; }
+
+    /**
+     *
+     */
+    std::size_t
+    size
+        ( void )
+        const
+    { return engines_.size(); }
+
+    /**
+     *
+     */
+    std::default_random_engine &
+    random_engine
+        ( void )
+    { return random_engine_; }
+
+    /**
+     *  @brief Execute handlers until the network is idle.
+     *  @return The count of executed handlers.
+     */
+    std::size_t
+    poll
+        ( void )
+    {
+        std::size_t count = 0;
+        while ( auto const c = io_service_.poll() )
+            count += c;
+
+        return count;
+    }
+
+private:
+    /**
+     *  @brief Make the next engine listen on the first
+     *         address of the index-th /24 network.
+     *  @details Engines then look like peers spread over
+     *           the Internet to the rate limits of others,
+     *           rather than a flooding network prefix.
+     */
+    static void
+    use_own_ipv4_network
+        ( std::size_t index )
+    {
+        auto bytes = fake_socket::get_first_ipv4().to_bytes();
+        bytes[ 1 ] = std::uint8_t( index >> 8 );
+        bytes[ 2 ] = std::uint8_t( index );
+
+        fake_socket::get_last_allocated_ipv4()
+                = boost::asio::ip::address_v4{ bytes };
+    }
+
+private:
+    ///
+    boost::asio::io_service io_service_;
+    ///
+    std::default_random_engine random_engine_;
+    ///
+    std::vector< std::unique_ptr< test_engine > > engines_;
+};
+
+/**
+ *  @brief Read a "--name=value" numeric command line option.
+ */
+inline std::size_t
+get_option
+    ( int argc
+    , char * argv[]
+    , std::string const& name
+    , std::size_t default_value )
+{
+    auto const prefix = "--" + name + "=";
+
+    for ( int i = 1; i < argc; ++ i )
+    {
+        std::string const arg{ argv[ i ] };
+        if ( arg.compare( 0, prefix.size(), prefix ) == 0 )
+            return std::strtoull( arg.c_str() + prefix.size(), nullptr, 10 );
+    }
+
+    return default_value;
+}
+
+} // namespace test
+} // namespace kademlia
+
+#endif
@@ -0,0 +1,182 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This benchmark measures the resident memory and the file
+ *  descriptors of each additional identity, hosted either as
+ *  a tenant of a single host or as a first_session of its own.
+ *  Each identity listens on its own port over the loopback
+ *  interface. A first_session also needs a thread to run,
+ *  which isn't accounted here.
+ *
+ *  Tenants share the io_service and its threads, a timer
+ *  queue and the reception buffers, which their sockets
+ *  borrow only while a message is handled, hence each
+ *  tenant saves the two 64 KiB reception buffers of a
+ *  first_session. Both kinds still own their sockets, as
+ *  messages don't carry their recipient id, and their
+ *  rate limit sketches.
+ *
+ *  Both are read from /proc/self, hence this benchmark
+ *  reports 0 on other systems.
+ *
+ *  Usage: host_memory_benchmark [--identities=N] [--port=N]
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/system/error_code.hpp>
+#include <unistd.h>
+
+#include <kademlia/first_session.hpp>
+#include <kademlia/host.hpp>
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace t = k::test;
+
+/**
+ *  @return The resident memory of this process, in bytes.
+ */
+std::size_t
+get_resident_memory
+    ( void )
+{
+    std::ifstream statm{ "/proc/self/statm" };
+    std::size_t total_pages = 0, resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+
+    return resident_pages * std::size_t( ::sysconf( _SC_PAGESIZE ) );
+}
+
+/**
+ *  @return The count of file descriptors opened by this process.
+ */
+std::size_t
+get_file_descriptors_count
+    ( void )
+{
+    boost::system::error_code failure;
+    boost::filesystem::directory_iterator i{ "/proc/self/fd", failure };
+    if ( failure )
+        return 0;
+
+    return std::size_t( std::distance( i, {} ) );
+}
+
+/**
+ *  @brief Resources used by the process.
+ */
+struct usage final
+{
+    ///
+    std::size_t resident_memory_;
+    ///
+    std::size_t file_descriptors_count_;
+};
+
+/**
+ *
+ */
+usage
+get_usage
+    ( void )
+{ return usage{ get_resident_memory(), get_file_descriptors_count() }; }
+
+/**
+ *
+ */
+void
+print_usage
+    ( char const* name
+    , std::size_t identities_count
+    , usage const& before
+    , usage const& after )
+{
+    auto const kib_per_identity
+            = double( after.resident_memory_ - before.resident_memory_ )
+            / identities_count / 1024;
+    auto const fds_per_identity
+            = double( after.file_descriptors_count_
+                    - before.file_descriptors_count_ )
+            / identities_count;
+
+    std::cout << std::setw( 16 ) << name
+              << std::setw( 14 ) << std::fixed << std::setprecision( 1 )
+              << kib_per_identity
+              << std::setw( 14 ) << std::setprecision( 2 )
+              << fds_per_identity << std::endl;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const identities_count = t::get_option( argc, argv, "identities", 256 );
+    auto const port = std::uint16_t( t::get_option( argc, argv, "port", 28000 ) );
+
+    std::cout << "identities: " << identities_count << std::endl
+              << "            kind  KiB/identity  fds/identity" << std::endl;
+
+    // Both kinds are kept alive so that the second one
+    // doesn't reuse the memory released by the first.
+    auto const host_before = get_usage();
+    k::host h;
+    for ( std::size_t i = 0; i < identities_count; ++ i )
+    {
+        auto const p = std::uint16_t( port + i );
+        h.add_tenant( k::endpoint{ "127.0.0.1", p }
+                    , k::endpoint{ "::1", p } );
+    }
+    print_usage( "host tenant", identities_count
+               , host_before, get_usage() );
+
+    auto const sessions_before = get_usage();
+    std::vector< std::unique_ptr< k::first_session > > sessions;
+    for ( std::size_t i = 0; i < identities_count; ++ i )
+    {
+        auto const p = std::uint16_t( port + identities_count + i );
+        sessions.emplace_back( new k::first_session{ k::endpoint{ "127.0.0.1", p }
+                                                   , k::endpoint{ "::1", p } } );
+    }
+    print_usage( "first_session", identities_count
+               , sessions_before, get_usage() );
+
+    return 0;
+}
+
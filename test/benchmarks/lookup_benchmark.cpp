@@ -0,0 +1,89 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This simulation measures the cost of iterative lookups.
+ *  find_value_task looks up missing keys in a network of
+ *  simulated nodes, each knowing up to k peers per k-bucket.
+ *  A response takes between 1 and max-latency ticks, a timeout
+ *  twice max-latency. The requests sent and the ticks elapsed
+ *  until the lookup completes are reported, ticks being round
+ *  trips when max-latency is 1.
+ *
+ *  Usage: lookup_benchmark [--nodes-count=N] [--lookups-count=N]
+ *                          [--unresponsive-percent=N] [--max-latency=N]
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include <kademlia/configuration.hpp>
+
+#include "engine_network.hpp"
+#include "simulated_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace t = k::test;
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const nodes_count = t::get_option( argc, argv, "nodes-count", 10000 );
+    auto const lookups_count = t::get_option( argc, argv, "lookups-count", 200 );
+    auto const unresponsive_percent = t::get_option( argc, argv
+                                                   , "unresponsive-percent", 10 );
+    auto const max_latency = t::get_option( argc, argv, "max-latency", 1 );
+
+    k::configuration config;
+    config.peer_lookup_timeout( std::chrono::milliseconds( 2 * max_latency ) );
+
+    t::simulated_network network{ nodes_count, unresponsive_percent
+                                , 1, max_latency
+                                , config.k_bucket_size() };
+    network.set_configuration( config );
+
+    auto const statistics = t::measure_lookups( network, lookups_count );
+
+    std::cout << "nodes: " << nodes_count
+              << ", lookups: " << lookups_count
+              << ", unresponsive nodes: " << unresponsive_percent << "%"
+              << ", max latency: " << max_latency << " ticks" << std::endl
+              << std::fixed << std::setprecision( 1 )
+              << "requests/lookup: "
+              << double( statistics.requests_count_ ) / lookups_count
+              << ", ticks/lookup: "
+              << double( statistics.ticks_count_ ) / lookups_count
+              << " (max " << statistics.max_ticks_count_ << ")" << std::endl;
+
+    return 0;
+}
+
@@ -0,0 +1,124 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This simulation sweeps the protocol parameters of the
+ *  configuration and reports, for each setting, the cost of
+ *  looking up missing keys in a network of simulated nodes.
+ *  The simulated nodes use the swept k too. A response takes
+ *  between min-latency and max-latency milliseconds, requests
+ *  to unresponsive nodes or slower than the lookup timeout
+ *  fail once it elapsed.
+ *
+ *  Usage: parameter_sweep_benchmark [--nodes-count=N] [--lookups-count=N]
+ *                                   [--unresponsive-percent=N]
+ *                                   [--min-latency=N] [--max-latency=N]
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+
+#include <kademlia/configuration.hpp>
+
+#include "engine_network.hpp"
+#include "simulated_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace t = k::test;
+
+std::size_t const K_BUCKET_SIZES[] = { 10, 20, 30 };
+std::size_t const CONCURRENT_REQUESTS_COUNTS[] = { 1, 3, 5 };
+std::chrono::milliseconds const PEER_LOOKUP_TIMEOUTS[] =
+        { std::chrono::milliseconds{ 50 }
+        , std::chrono::milliseconds{ 100 }
+        , std::chrono::milliseconds{ 200 } };
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const nodes_count = t::get_option( argc, argv, "nodes-count", 5000 );
+    auto const lookups_count = t::get_option( argc, argv, "lookups-count", 200 );
+    auto const unresponsive_percent = t::get_option( argc, argv
+                                                   , "unresponsive-percent", 10 );
+    auto const min_latency = t::get_option( argc, argv, "min-latency", 10 );
+    auto const max_latency = t::get_option( argc, argv, "max-latency", 100 );
+
+    std::cout << "nodes: " << nodes_count
+              << ", lookups: " << lookups_count
+              << ", unresponsive nodes: " << unresponsive_percent << "%"
+              << ", latency: " << min_latency << "-" << max_latency << " ms"
+              << std::endl
+              << std::setw( 4 ) << "k"
+              << std::setw( 7 ) << "alpha"
+              << std::setw( 13 ) << "timeout(ms)"
+              << std::setw( 18 ) << "messages/lookup"
+              << std::setw( 20 ) << "latency(ms)/lookup"
+              << std::setw( 16 ) << "max latency(ms)" << std::endl;
+
+    for ( auto const k_bucket_size : K_BUCKET_SIZES )
+    {
+        t::simulated_network network{ nodes_count, unresponsive_percent
+                                    , min_latency, max_latency
+                                    , k_bucket_size };
+
+        for ( auto const concurrent_requests_count : CONCURRENT_REQUESTS_COUNTS )
+            for ( auto const& peer_lookup_timeout : PEER_LOOKUP_TIMEOUTS )
+            {
+                k::configuration config;
+                config.k_bucket_size( k_bucket_size );
+                config.concurrent_requests_count( concurrent_requests_count );
+                config.peer_lookup_timeout( peer_lookup_timeout );
+                network.set_configuration( config );
+
+                auto const statistics = t::measure_lookups( network, lookups_count );
+
+                // Requests and their responses.
+                auto const messages_count = statistics.requests_count_
+                                          + statistics.responses_count_;
+
+                std::cout << std::fixed << std::setprecision( 1 )
+                          << std::setw( 4 ) << k_bucket_size
+                          << std::setw( 7 ) << concurrent_requests_count
+                          << std::setw( 13 ) << peer_lookup_timeout.count()
+                          << std::setw( 18 )
+                          << double( messages_count ) / lookups_count
+                          << std::setw( 20 )
+                          << double( statistics.ticks_count_ ) / lookups_count
+                          << std::setw( 16 ) << statistics.max_ticks_count_
+                          << std::endl;
+            }
+    }
+
+    return 0;
+}
+
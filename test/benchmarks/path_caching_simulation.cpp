@@ -0,0 +1,191 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This simulation measures how path caching spreads a hot
+ *  key: every node of the network loads the same key, batch
+ *  after batch, and the load on the key's home nodes (the
+ *  peers the publisher stored the value on) is reported.
+ *
+ *  Usage: path_caching_simulation [--nodes-count=N] [--batch-size=N]
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+
+using endpoints = std::set< t::fake_socket::endpoint_type >;
+
+///
+struct batch_statistics final
+{
+    std::size_t home_requests_count_;
+    std::size_t home_responses_count_;
+    std::size_t cache_responses_count_;
+    std::size_t cache_stores_count_;
+};
+
+/**
+ *
+ */
+endpoints
+pop_store_destinations
+    ( void )
+{
+    endpoints destinations;
+
+    auto & packets = t::fake_socket::get_logged_packets();
+    for ( ; ! packets.empty(); packets.pop() )
+    {
+        auto const& p = packets.front();
+        if ( t::extract_kademlia_header( p ).type_ == kd::header::STORE_REQUEST )
+            destinations.insert( p.to_ );
+    }
+
+    return destinations;
+}
+
+/**
+ *
+ */
+batch_statistics
+pop_batch_statistics
+    ( endpoints const& home_nodes )
+{
+    batch_statistics s{};
+
+    auto & packets = t::fake_socket::get_logged_packets();
+    for ( ; ! packets.empty(); packets.pop() )
+    {
+        auto const& p = packets.front();
+        switch ( t::extract_kademlia_header( p ).type_ )
+        {
+            case kd::header::FIND_VALUE_REQUEST:
+                s.home_requests_count_ += home_nodes.count( p.to_ );
+                break;
+            case kd::header::FIND_VALUE_RESPONSE:
+                if ( home_nodes.count( p.from_ ) )
+                    ++ s.home_responses_count_;
+                else
+                    ++ s.cache_responses_count_;
+                break;
+            case kd::header::STORE_REQUEST:
+                ++ s.cache_stores_count_;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return s;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const nodes_count = t::get_option( argc, argv, "nodes-count", 128 );
+    auto const batch_size = t::get_option( argc, argv, "batch-size", 16 );
+
+    t::engine_network network{ nodes_count };
+
+    // Publish the hot key from the first node.
+    t::clear_packets();
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    network[ 0 ].async_save( "hot key", "hot value", on_save );
+    network.poll();
+
+    auto const home_nodes = pop_store_destinations();
+    if ( home_nodes.empty() )
+        throw std::runtime_error{ "the hot key hasn't been stored" };
+
+    // Each node but the publisher loads the key once,
+    // the next loads are served by their local cache.
+    std::vector< std::size_t > loaders;
+    for ( std::size_t i = 1; i < network.size(); ++ i )
+        loaders.push_back( i );
+    std::shuffle( loaders.begin(), loaders.end(), network.random_engine() );
+
+    std::cout << "nodes: " << nodes_count
+              << ", home nodes: " << home_nodes.size()
+              << ", batch size: " << batch_size << std::endl
+              << "batch  home requests  home responses"
+                 "  cached responses  cache stores" << std::endl;
+
+    std::size_t failures_count = 0;
+    auto on_load = [ &failures_count ]( std::error_code const& failure
+                                      , std::string const& )
+    { if ( failure ) ++ failures_count; };
+
+    batch_statistics total{};
+    for ( std::size_t b = 0; b * batch_size < loaders.size(); ++ b )
+    {
+        auto const begin = b * batch_size;
+        auto const end = std::min( begin + batch_size, loaders.size() );
+        for ( auto i = begin; i != end; ++ i )
+            network[ loaders[ i ] ].async_load( "hot key", on_load );
+
+        network.poll();
+
+        auto const s = pop_batch_statistics( home_nodes );
+        std::cout << std::setw( 5 ) << b
+                  << std::setw( 15 ) << s.home_requests_count_
+                  << std::setw( 16 ) << s.home_responses_count_
+                  << std::setw( 18 ) << s.cache_responses_count_
+                  << std::setw( 14 ) << s.cache_stores_count_ << std::endl;
+
+        total.home_requests_count_ += s.home_requests_count_;
+        total.home_responses_count_ += s.home_responses_count_;
+        total.cache_responses_count_ += s.cache_responses_count_;
+    }
+
+    auto const responses_count = total.home_responses_count_
+                               + total.cache_responses_count_;
+    std::cout << "total: " << total.home_requests_count_
+              << " home requests, "
+              << ( 100 * total.cache_responses_count_
+                 / std::max< std::size_t >( responses_count, 1 ) )
+              << "% of the values served by cached copies, "
+              << failures_count << " failed loads." << std::endl;
+
+    return 0;
+}
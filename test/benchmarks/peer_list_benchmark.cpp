@@ -0,0 +1,238 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/**
+ *  This benchmark compares the compact peer lists sent to V2
+ *  peers with the V1 find peer responses: bytes per response,
+ *  and encode/decode cost, for responses made of the peers
+ *  closest to the requested id within a network of N peers.
+ *
+ *  Usage: peer_list_benchmark [--network-size=N] [--responses-count=N]
+ *                             [--rounds=N]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <kademlia/session_base.hpp>
+
+#include "kademlia/message.hpp"
+#include "kademlia/constants.hpp"
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+
+using clock = std::chrono::steady_clock;
+
+/**
+ *
+ */
+struct response final
+{
+    ///
+    kd::id target_;
+    ///
+    std::vector< kd::peer > peers_;
+};
+
+/**
+ *  @param v4_ratio The ratio of IPv4 peers.
+ */
+std::vector< response >
+generate_responses
+    ( std::size_t count
+    , std::size_t network_size
+    , double v4_ratio )
+{
+    std::default_random_engine random_engine;
+    std::bernoulli_distribution is_v4( v4_ratio );
+    // Most peers listen on the default port.
+    std::bernoulli_distribution is_default_port( 0.75 );
+    std::uniform_int_distribution< std::uint16_t > port( 1024 );
+    std::uniform_int_distribution< std::uint32_t > address_block;
+
+    // The closest peers to an id share about
+    // log2( network_size ) bits with it.
+    auto const shared_bytes
+            = std::size_t( std::log2( network_size ) ) / 8;
+
+    std::vector< response > responses( count );
+    for ( auto & r : responses )
+    {
+        r.target_ = kd::id{ random_engine };
+
+        for ( std::size_t i = 0; i < kd::ROUTING_TABLE_BUCKET_SIZE; ++ i )
+        {
+            kd::id id{ random_engine };
+            std::copy_n( r.target_.begin(), shared_bytes, id.begin() );
+
+            kd::ip_endpoint endpoint;
+            if ( is_v4( random_engine ) )
+                endpoint.address_ = boost::asio::ip::address_v4
+                        { address_block( random_engine ) };
+            else
+            {
+                boost::asio::ip::address_v6::bytes_type bytes;
+                for ( auto & b : bytes )
+                    b = std::uint8_t( address_block( random_engine ) );
+                endpoint.address_ = boost::asio::ip::address_v6{ bytes };
+            }
+
+            endpoint.port_ = is_default_port( random_engine )
+                           ? k::session_base::DEFAULT_PORT
+                           : port( random_engine );
+
+            r.peers_.push_back( kd::peer{ id, endpoint } );
+        }
+    }
+
+    return responses;
+}
+
+/**
+ *
+ */
+double
+to_microseconds_per_response
+    ( std::size_t count
+    , clock::duration const& duration )
+{
+    auto const microseconds
+            = std::chrono::duration< double, std::micro >( duration ).count();
+    return microseconds / count;
+}
+
+/**
+ *
+ */
+template< typename Serialize >
+void
+benchmark_codec
+    ( std::string const& name
+    , std::vector< response > const& responses
+    , std::size_t rounds
+    , kd::header::version version
+    , Serialize serialize )
+{
+    std::vector< kd::buffer > buffers( responses.size() );
+
+    clock::duration encode_duration{}, decode_duration{};
+    std::size_t bytes_count = 0, peers_count = 0;
+    for ( std::size_t r = 0; r < rounds; ++ r )
+    {
+        auto const encode_start = clock::now();
+        for ( std::size_t i = 0; i < responses.size(); ++ i )
+        {
+            buffers[ i ].clear();
+            serialize( responses[ i ], buffers[ i ] );
+        }
+        encode_duration += clock::now() - encode_start;
+
+        auto const decode_start = clock::now();
+        for ( std::size_t i = 0; i < responses.size(); ++ i )
+        {
+            kd::find_peer_response_body body;
+            auto b = buffers[ i ].cbegin(), e = buffers[ i ].cend();
+            if ( kd::deserialize( b, e, version, responses[ i ].target_, body ) )
+                throw std::runtime_error{ "failed to decode" };
+            peers_count += body.peers_.size();
+        }
+        decode_duration += clock::now() - decode_start;
+    }
+
+    if ( peers_count != rounds * responses.size() * kd::ROUTING_TABLE_BUCKET_SIZE )
+        throw std::runtime_error{ "unexpected peers count" };
+
+    for ( auto const& b : buffers )
+        bytes_count += b.size();
+
+    auto const count = responses.size() * rounds;
+    std::cout << std::setw( 10 ) << name
+              << std::setw( 12 ) << std::fixed << std::setprecision( 1 )
+              << double( bytes_count ) / responses.size()
+              << std::setw( 14 ) << std::setprecision( 2 )
+              << to_microseconds_per_response( count, encode_duration )
+              << std::setw( 14 )
+              << to_microseconds_per_response( count, decode_duration )
+              << std::endl;
+}
+
+/**
+ *
+ */
+void
+benchmark_responses
+    ( std::string const& kind
+    , std::vector< response > const& responses
+    , std::size_t rounds )
+{
+    std::cout << kind << std::endl;
+
+    benchmark_codec( "v1", responses, rounds, kd::header::V1
+                   , []( response const& r, kd::buffer & b )
+                   { kd::serialize( kd::find_peer_response_body{ r.peers_ }, b ); } );
+
+    benchmark_codec( "compact", responses, rounds, kd::header::V2
+                   , []( response const& r, kd::buffer & b )
+                   {
+                       kd::serialize( kd::find_peer_compact_response_body
+                                            { r.target_, r.peers_ }, b );
+                   } );
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const network_size = t::get_option( argc, argv, "network-size", 10000 );
+    auto const count = t::get_option( argc, argv, "responses-count", 10000 );
+    auto const rounds = t::get_option( argc, argv, "rounds", 10 );
+
+    std::cout << "     codec  bytes/resp  encode us/resp  decode us/resp"
+              << std::endl;
+
+    benchmark_responses( "IPv4 peers"
+                       , generate_responses( count, network_size, 1. ), rounds );
+    benchmark_responses( "IPv6 peers"
+                       , generate_responses( count, network_size, 0. ), rounds );
+    benchmark_responses( "mixed peers"
+                       , generate_responses( count, network_size, .5 ), rounds );
+
+    return 0;
+}
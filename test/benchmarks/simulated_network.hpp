@@ -0,0 +1,493 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_TEST_BENCHMARKS_SIMULATED_NETWORK_HPP
+#define KADEMLIA_TEST_BENCHMARKS_SIMULATED_NETWORK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <kademlia/configuration.hpp>
+#include <kademlia/error.hpp>
+
+#include "kademlia/find_value_task.hpp"
+#include "kademlia/id.hpp"
+#include "kademlia/ip_endpoint.hpp"
+#include "kademlia/message.hpp"
+
+namespace kademlia {
+namespace test {
+
+/**
+ *  @brief A node of the simulated network.
+ */
+struct simulated_node final
+{
+    detail::id id_;
+    detail::ip_endpoint endpoint_;
+    bool is_responsive_;
+    /// Indexes of the peers in its routing table.
+    std::vector< std::uint32_t > known_peers_;
+};
+
+/**
+ *  @return The index of the k-bucket of a peer at distance d.
+ */
+inline std::size_t
+get_bucket_index
+    ( detail::id const& d )
+{
+    std::size_t index = 0;
+    for ( auto block : d )
+    {
+        if ( block == 0 )
+        {
+            index += 8;
+            continue;
+        }
+
+        for ( ; ( block & 0x80 ) == 0; block <<= 1 )
+            ++ index;
+
+        break;
+    }
+
+    return index;
+}
+
+/**
+ *  @brief Simulated nodes answering the find value requests
+ *         of the task being measured.
+ *  @details Time is counted in ticks of one millisecond.
+ *           A response takes between min and max latency ticks.
+ *           Requests to unresponsive nodes, or slower than
+ *           the lookup timeout, fail once it elapsed.
+ */
+class simulated_network final
+{
+public:
+    ///
+    using endpoint_type = detail::ip_endpoint;
+
+    ///
+    using routing_table_entries = std::vector< std::pair< detail::id, endpoint_type > >;
+
+public:
+    /**
+     *  @param k_bucket_size The k of the simulated nodes.
+     */
+    simulated_network
+        ( std::size_t nodes_count
+        , std::size_t unresponsive_percent
+        , std::uint64_t min_latency
+        , std::uint64_t max_latency
+        , std::size_t k_bucket_size )
+            : random_engine_()
+            , latency_{ min_latency, max_latency }
+            , k_bucket_size_( k_bucket_size )
+            , configuration_()
+            , nodes_()
+            , events_()
+            , now_()
+            , requests_count_()
+            , responses_count_()
+    {
+        std::uniform_int_distribution< std::size_t > percent{ 0, 99 };
+        for ( std::uint32_t i = 0; i < nodes_count; ++ i )
+            nodes_.push_back( simulated_node{ detail::id{ random_engine_ }
+                                            , create_endpoint( i )
+                                            , percent( random_engine_ ) >= unresponsive_percent
+                                            , {} } );
+
+        // Each node knows the first k peers met per k-bucket,
+        // starting from a random peer.
+        std::uniform_int_distribution< std::size_t > first{ 0, nodes_count - 1 };
+        for ( auto & n : nodes_ )
+        {
+            std::vector< std::size_t > buckets( detail::id::BIT_SIZE + 1 );
+            auto const offset = first( random_engine_ );
+            for ( std::size_t j = 0; j < nodes_count; ++ j )
+            {
+                auto const p = ( offset + j ) % nodes_count;
+                auto const b = get_bucket_index( detail::distance( n.id_, nodes_[ p ].id_ ) );
+                if ( b == detail::id::BIT_SIZE || buckets[ b ] == k_bucket_size_ )
+                    continue;
+
+                ++ buckets[ b ];
+                n.known_peers_.push_back( std::uint32_t( p ) );
+            }
+        }
+
+        configuration_.k_bucket_size( k_bucket_size_ );
+    }
+
+    /**
+     *  @return The routing table of the responsive node n,
+     *          closest peers to key first.
+     */
+    routing_table_entries
+    get_routing_table
+        ( std::size_t n
+        , detail::id const& key )
+    {
+        routing_table_entries entries;
+        for ( auto p : find_closest_peers( nodes_[ n ], key
+                                         , nodes_[ n ].known_peers_.size() ) )
+            entries.emplace_back( nodes_[ p ].id_, nodes_[ p ].endpoint_ );
+
+        return entries;
+    }
+
+    /**
+     *
+     */
+    template< typename RandomEngine >
+    std::size_t
+    get_responsive_node
+        ( RandomEngine & random_engine )
+    {
+        std::uniform_int_distribution< std::size_t > index{ 0, nodes_.size() - 1 };
+        for ( ;; )
+        {
+            auto const n = index( random_engine );
+            if ( nodes_[ n ].is_responsive_ )
+                return n;
+        }
+    }
+
+    /**
+     *  @brief Set the parameters of the node starting the lookups.
+     */
+    void
+    set_configuration
+        ( configuration const& config )
+    { configuration_ = config; }
+
+    /**
+     *  @brief Run the pending responses and timeouts.
+     */
+    void
+    run
+        ( void )
+    {
+        while ( ! events_.empty() )
+        {
+            auto const i = events_.begin();
+            now_ = i->first;
+            auto const e = std::move( i->second );
+            events_.erase( i );
+            e();
+        }
+    }
+
+    /**
+     *
+     */
+    std::uint64_t
+    now
+        ( void )
+        const
+    { return now_; }
+
+    /**
+     *
+     */
+    std::uint64_t
+    requests_count
+        ( void )
+        const
+    { return requests_count_; }
+
+    /**
+     *
+     */
+    std::uint64_t
+    responses_count
+        ( void )
+        const
+    { return responses_count_; }
+
+    // The tracker interface used by the tasks.
+
+    /**
+     *
+     */
+    template< typename OnResponseReceived, typename OnError >
+    void
+    send_request
+        ( detail::find_value_request_body const& request
+        , endpoint_type const& e
+        , std::chrono::milliseconds const& timeout
+        , OnResponseReceived const& on_response_received
+        , OnError const& on_error )
+    {
+        ++ requests_count_;
+
+        auto const& n = nodes_[ get_node_index( e ) ];
+        auto const latency = latency_( random_engine_ );
+        if ( ! n.is_responsive_ || latency > std::uint64_t( timeout.count() ) )
+        {
+            auto on_timeout = [ on_error ]( void )
+            { on_error( make_error_code( std::errc::timed_out ) ); };
+
+            events_.emplace( now_ + timeout.count(), on_timeout );
+            return;
+        }
+
+        ++ responses_count_;
+
+        detail::find_peer_response_body response;
+        for ( auto p : find_closest_peers( n, request.value_to_find_
+                                         , k_bucket_size_ ) )
+            response.peers_.push_back( detail::peer{ nodes_[ p ].id_
+                                                   , nodes_[ p ].endpoint_ } );
+
+        detail::header const h{ detail::header::V1
+                              , detail::header::FIND_PEER_RESPONSE
+                              , n.id_ };
+        auto on_response = [ on_response_received, h, e, response ]( void )
+        {
+            detail::buffer b;
+            detail::serialize( response, b );
+            on_response_received( e, h, b.begin(), b.end() );
+        };
+
+        events_.emplace( now_ + latency, on_response );
+    }
+
+    /**
+     *  @brief Chunks are never requested as values are missing.
+     */
+    template< typename Request, typename OnResponseReceived, typename OnError >
+    void
+    send_request
+        ( Request const&
+        , endpoint_type const&
+        , std::chrono::milliseconds const&
+        , OnResponseReceived const&
+        , OnError const& )
+    { throw std::logic_error{ "unexpected request" }; }
+
+    /**
+     *
+     */
+    template< typename Request >
+    void
+    send_request
+        ( Request const&
+        , endpoint_type const& )
+    { ++ requests_count_; }
+
+    /**
+     *
+     */
+    detail::header::version
+    get_peer_version
+        ( endpoint_type const& )
+        const
+    { return detail::header::V1; }
+
+    /**
+     *
+     */
+    configuration const&
+    get_configuration
+        ( void )
+        const
+    { return configuration_; }
+
+private:
+    /**
+     *
+     */
+    static endpoint_type
+    create_endpoint
+        ( std::uint32_t index )
+    {
+        boost::asio::ip::address_v4 const a{ 0x0a000000 + index };
+        return endpoint_type{ a, 5000 };
+    }
+
+    /**
+     *
+     */
+    static std::size_t
+    get_node_index
+        ( endpoint_type const& e )
+    { return e.address_.to_v4().to_ulong() - 0x0a000000; }
+
+    /**
+     *
+     */
+    std::vector< std::uint32_t >
+    find_closest_peers
+        ( simulated_node const& n
+        , detail::id const& key
+        , std::size_t count )
+    {
+        auto peers = n.known_peers_;
+        count = std::min( count, peers.size() );
+
+        auto const is_closer = [ this, &key ]( std::uint32_t a, std::uint32_t b )
+        {
+            return detail::distance( nodes_[ a ].id_, key )
+                 < detail::distance( nodes_[ b ].id_, key );
+        };
+        std::partial_sort( peers.begin(), peers.begin() + count, peers.end()
+                         , is_closer );
+        peers.resize( count );
+
+        return peers;
+    }
+
+private:
+    ///
+    std::default_random_engine random_engine_;
+    ///
+    std::uniform_int_distribution< std::uint64_t > latency_;
+    ///
+    std::size_t k_bucket_size_;
+    ///
+    configuration configuration_;
+    ///
+    std::vector< simulated_node > nodes_;
+    ///
+    std::multimap< std::uint64_t, std::function< void ( void ) > > events_;
+    ///
+    std::uint64_t now_;
+    ///
+    std::uint64_t requests_count_;
+    ///
+    std::uint64_t responses_count_;
+};
+
+/**
+ *  @brief The routing table of the node starting a lookup.
+ */
+struct simulated_routing_table final
+{
+    ///
+    using entries = simulated_network::routing_table_entries;
+
+    ///
+    entries::const_iterator
+    find
+        ( detail::id const& )
+        const
+    { return entries_.begin(); }
+
+    ///
+    entries::const_iterator
+    end
+        ( void )
+        const
+    { return entries_.end(); }
+
+    ///
+    entries entries_;
+};
+
+/**
+ *  @brief Costs of the lookups run by measure_lookups().
+ */
+struct lookups_statistics final
+{
+    ///
+    std::uint64_t requests_count_;
+    ///
+    std::uint64_t responses_count_;
+    ///
+    std::uint64_t ticks_count_;
+    ///
+    std::uint64_t max_ticks_count_;
+};
+
+/**
+ *  @brief Look up lookups_count missing keys from random
+ *         responsive nodes of network.
+ *  @details The keys and starting nodes only depend on
+ *           lookups_count, so that settings can be compared.
+ */
+inline lookups_statistics
+measure_lookups
+    ( simulated_network & network
+    , std::size_t lookups_count )
+{
+    using data_type = std::vector< std::uint8_t >;
+
+    std::default_random_engine random_engine;
+    lookups_statistics statistics{};
+
+    for ( std::size_t i = 0; i < lookups_count; ++ i )
+    {
+        detail::id const key{ random_engine };
+        simulated_routing_table table{ network.get_routing_table
+                ( network.get_responsive_node( random_engine ), key ) };
+
+        auto const start_requests_count = network.requests_count();
+        auto const start_responses_count = network.responses_count();
+        auto const start_time = network.now();
+
+        bool is_completed = false;
+        std::uint64_t completion_time = 0;
+        auto on_load = [ & ]( std::error_code const& failure
+                            , data_type const& )
+        {
+            if ( failure != VALUE_NOT_FOUND )
+                throw std::runtime_error{ "unexpected lookup result" };
+
+            is_completed = true;
+            completion_time = network.now();
+        };
+
+        detail::start_find_value_task< data_type >( key, network, table, on_load );
+        network.run();
+
+        if ( ! is_completed )
+            throw std::runtime_error{ "lookup didn't complete" };
+
+        statistics.requests_count_ += network.requests_count() - start_requests_count;
+        statistics.responses_count_ += network.responses_count() - start_responses_count;
+        statistics.ticks_count_ += completion_time - start_time;
+        statistics.max_ticks_count_ = std::max( statistics.max_ticks_count_
+                                              , completion_time - start_time );
+    }
+
+    return statistics;
+}
+
+} // namespace test
+} // namespace kademlia
+
+#endif
+
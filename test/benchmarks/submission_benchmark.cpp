@@ -0,0 +1,158 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This benchmark measures the throughput of the tasks submitted
+ *  from application threads to the engine loop, through the
+ *  submission queue versus a plain io_service post per task,
+ *  for 1 up to --max-producers producer threads.
+ *
+ *  Usage: submission_benchmark [--max-producers=N]
+ *                              [--tasks-per-producer=N] [--batch-size=N]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+
+#include "kademlia/submission_queue.hpp"
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+
+using clock = std::chrono::steady_clock;
+
+/**
+ *  @brief Run the consumer loop until all tasks are executed.
+ *  @return The tasks per second.
+ */
+template< typename SubmitType >
+double
+benchmark_submissions
+    ( boost::asio::io_service & io_service
+    , std::atomic< std::uint64_t > & executed_tasks_count
+    , std::size_t producers_count
+    , std::size_t tasks_per_producer
+    , SubmitType submit )
+{
+    auto const tasks_count = producers_count * tasks_per_producer;
+    executed_tasks_count = 0;
+    io_service.reset();
+
+    boost::asio::io_service::work work{ io_service };
+    std::thread consumer{ [ &io_service ]( void ) { io_service.run(); } };
+
+    auto const start = clock::now();
+
+    std::vector< std::thread > producers;
+    for ( std::size_t i = 0; i < producers_count; ++ i )
+        producers.emplace_back( [ &submit, tasks_per_producer ]( void )
+        {
+            for ( std::size_t j = 0; j < tasks_per_producer; ++ j )
+                submit();
+        } );
+
+    for ( auto & producer : producers )
+        producer.join();
+
+    while ( executed_tasks_count.load() < tasks_count )
+        std::this_thread::yield();
+
+    auto const seconds = std::chrono::duration< double >
+            ( clock::now() - start ).count();
+
+    io_service.stop();
+    consumer.join();
+
+    return tasks_count / seconds;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const max_producers = t::get_option( argc, argv, "max-producers", 8 );
+    auto const tasks_per_producer = t::get_option( argc, argv
+                                                 , "tasks-per-producer"
+                                                 , 200000 );
+    auto const batch_size = t::get_option( argc, argv, "batch-size", 64 );
+
+    boost::asio::io_service io_service;
+    kd::submission_queue queue{ kd::get_default_strand( io_service )
+                              , batch_size };
+    std::atomic< std::uint64_t > executed_tasks_count{};
+
+    auto const task = [ &executed_tasks_count ]( void )
+    { executed_tasks_count.fetch_add( 1, std::memory_order_relaxed ); };
+
+    std::cout << "tasks per producer: " << tasks_per_producer
+              << ", batch size: " << batch_size
+              << ", hardware threads: " << std::thread::hardware_concurrency()
+              << std::endl
+              << "producers      post/s     queue/s  tasks/drain" << std::endl;
+
+    for ( std::size_t producers_count = 1
+        ; producers_count <= max_producers
+        ; producers_count *= 2 )
+    {
+        auto const post_rate = benchmark_submissions
+                ( io_service, executed_tasks_count
+                , producers_count, tasks_per_producer
+                , [ &io_service, &task ]( void ) { io_service.post( task ); } );
+
+        auto const drains_count = queue.drains_count();
+        auto const queue_rate = benchmark_submissions
+                ( io_service, executed_tasks_count
+                , producers_count, tasks_per_producer
+                , [ &queue, &task ]( void ) { queue.push( task ); } );
+
+        auto const tasks_per_drain = double( producers_count * tasks_per_producer )
+                                   / ( queue.drains_count() - drains_count );
+
+        std::cout << std::setw( 9 ) << producers_count
+                  << std::setw( 12 ) << std::fixed << std::setprecision( 0 )
+                  << post_rate
+                  << std::setw( 12 ) << queue_rate
+                  << std::setw( 13 ) << std::setprecision( 1 )
+                  << tasks_per_drain << std::endl;
+    }
+
+    return 0;
+}
+
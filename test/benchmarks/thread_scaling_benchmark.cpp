@@ -0,0 +1,251 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This benchmark measures how the throughput of a session
+ *  scales with the count of threads running its main loop.
+ *  The session saves then loads values on a first_session
+ *  over the loopback interface, both running with the same
+ *  count of threads, from 1 up to --max-threads.
+ *
+ *  Usage: thread_scaling_benchmark [--max-threads=N] [--requests=N]
+ *                                  [--window=N] [--port=N] [--warm-up-ms=N]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <kademlia/first_session.hpp>
+#include <kademlia/session.hpp>
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace t = k::test;
+
+using clock = std::chrono::steady_clock;
+
+/**
+ *  @brief Wait for the completion of a count of requests.
+ */
+class completion_counter final
+{
+public:
+    /**
+     *
+     */
+    explicit
+    completion_counter
+        ( std::size_t expected_count )
+            : mutex_()
+            , condition_()
+            , remaining_count_( expected_count )
+            , failures_count_()
+    { }
+
+    /**
+     *
+     */
+    void
+    notify
+        ( std::error_code const& failure )
+    {
+        std::lock_guard< std::mutex > lock{ mutex_ };
+        if ( failure )
+            ++ failures_count_;
+
+        if ( -- remaining_count_ == 0 )
+            condition_.notify_all();
+    }
+
+    /**
+     *  @return The count of failed requests.
+     */
+    std::size_t
+    wait
+        ( void )
+    {
+        std::unique_lock< std::mutex > lock{ mutex_ };
+        condition_.wait( lock, [ this ]( void )
+                         { return remaining_count_ == 0; } );
+        return failures_count_;
+    }
+
+private:
+    ///
+    std::mutex mutex_;
+    ///
+    std::condition_variable condition_;
+    ///
+    std::size_t remaining_count_;
+    ///
+    std::size_t failures_count_;
+};
+
+/**
+ *
+ */
+k::session::key_type
+make_key
+    ( std::size_t threads_count
+    , std::size_t index )
+{
+    auto const key = std::to_string( threads_count )
+                   + " " + std::to_string( index );
+    return k::session::key_type{ key.begin(), key.end() };
+}
+
+/**
+ *  @return The requests per second.
+ */
+double
+benchmark_requests
+    ( k::session & s
+    , std::size_t threads_count
+    , std::size_t requests_count
+    , std::size_t window_size
+    , bool is_load )
+{
+    k::session::data_type const data( 256, 'x' );
+    std::size_t failures_count = 0;
+
+    auto const start = clock::now();
+    // Requests are sent by batches of window_size
+    // to keep the lookups within their timeouts.
+    for ( std::size_t i = 0; i < requests_count; i += window_size )
+    {
+        auto const batch_size = std::min( window_size, requests_count - i );
+        completion_counter counter{ batch_size };
+
+        auto on_save = [ &counter ]( std::error_code const& failure )
+        { counter.notify( failure ); };
+        auto on_load = [ &counter ]( std::error_code const& failure
+                                   , k::session::data_type const& )
+        { counter.notify( failure ); };
+
+        for ( std::size_t j = i; j < i + batch_size; ++ j )
+        {
+            if ( is_load )
+                s.async_load( make_key( threads_count, j ), on_load );
+            else
+                s.async_save( make_key( threads_count, j ), data, on_save );
+        }
+
+        failures_count += counter.wait();
+    }
+
+    if ( failures_count )
+        std::cerr << failures_count << " request(s) failed." << std::endl;
+
+    auto const seconds = std::chrono::duration< double >
+            ( clock::now() - start ).count();
+    return requests_count / seconds;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const max_threads = t::get_option( argc, argv, "max-threads", 16 );
+    auto const requests_count = t::get_option( argc, argv, "requests", 1000 );
+    auto const window_size = t::get_option( argc, argv, "window", 16 );
+    auto const port = std::uint16_t( t::get_option( argc, argv, "port", 27000 ) );
+    auto const warm_up_duration = std::chrono::milliseconds
+            ( t::get_option( argc, argv, "warm-up-ms", 1000 ) );
+
+    k::endpoint const first_ipv4{ "127.0.0.1", port };
+    k::endpoint const first_ipv6{ "::1", port };
+    k::first_session first{ first_ipv4, first_ipv6 };
+
+    k::session s{ first_ipv4
+                , k::endpoint{ "127.0.0.1", std::uint16_t( port + 1 ) }
+                , k::endpoint{ "::1", std::uint16_t( port + 1 ) } };
+
+    // Let the session discover its neighbors before measuring.
+    {
+        auto first_result = std::async( std::launch::async
+                                      , &k::first_session::run, &first );
+        auto result = std::async( std::launch::async
+                                , &k::session::run, &s );
+        std::this_thread::sleep_for( warm_up_duration );
+
+        s.abort();
+        first.abort();
+        result.get();
+        first_result.get();
+    }
+
+    std::cout << "requests: " << requests_count
+              << ", window: " << window_size
+              << ", hardware threads: " << std::thread::hardware_concurrency()
+              << std::endl
+              << " threads     saves/s     loads/s" << std::endl;
+
+    for ( std::size_t threads_count = 1
+        ; threads_count <= max_threads
+        ; threads_count *= 2 )
+    {
+        auto first_result = std::async( std::launch::async
+                                      , &k::first_session::run_with_threads
+                                      , &first, threads_count );
+        auto result = std::async( std::launch::async
+                                , &k::session::run_with_threads
+                                , &s, threads_count );
+
+        auto const saves_rate = benchmark_requests( s, threads_count
+                                                  , requests_count
+                                                  , window_size, false );
+        auto const loads_rate = benchmark_requests( s, threads_count
+                                                  , requests_count
+                                                  , window_size, true );
+
+        s.abort();
+        first.abort();
+        result.get();
+        first_result.get();
+
+        std::cout << std::setw( 8 ) << threads_count
+                  << std::setw( 12 ) << std::fixed << std::setprecision( 0 )
+                  << saves_rate
+                  << std::setw( 12 ) << loads_rate << std::endl;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,209 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ *  This benchmark compares the varints of the V2 messages with
+ *  the fixed 8 bytes integers of the V1 messages: bytes used per
+ *  integer, and encode/decode throughput, for the kinds of
+ *  integers messages carry.
+ *
+ *  Usage: varint_benchmark [--integers-count=N] [--rounds=N]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "kademlia/varint.hpp"
+
+#include "engine_network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+
+using clock = std::chrono::steady_clock;
+
+/**
+ *  @brief Encode as V1 messages do.
+ */
+void
+serialize_fixed
+    ( std::uint64_t value
+    , kd::buffer & b )
+{
+    for ( auto i = 0u; i < sizeof( value ); ++i )
+    {
+        b.push_back( kd::buffer::value_type( value ) );
+        value >>= 8;
+    }
+}
+
+/**
+ *
+ */
+std::error_code
+deserialize_fixed
+    ( kd::buffer::const_iterator & i
+    , kd::buffer::const_iterator e
+    , std::uint64_t & value )
+{
+    value = 0;
+
+    if ( std::size_t( std::distance( i, e ) ) < sizeof( value ) )
+        return kd::make_error_code( k::TRUNCATED_SIZE );
+
+    for ( auto j = 0u; j < sizeof( value ); ++j )
+        value |= std::uint64_t{ *i++ } << 8 * j;
+
+    return std::error_code{};
+}
+
+/**
+ *
+ */
+double
+to_millions_per_second
+    ( std::size_t count
+    , clock::duration const& duration )
+{
+    auto const seconds = std::chrono::duration< double >( duration ).count();
+    return count / 1e6 / seconds;
+}
+
+/**
+ *
+ */
+template< typename Serialize, typename Deserialize >
+void
+benchmark_codec
+    ( std::string const& name
+    , std::vector< std::uint64_t > const& integers
+    , std::size_t rounds
+    , Serialize serialize
+    , Deserialize deserialize )
+{
+    kd::buffer b;
+    b.reserve( integers.size() * kd::VARINT_MAX_SIZE );
+
+    clock::duration encode_duration{}, decode_duration{};
+    std::uint64_t checksum = 0;
+    for ( std::size_t r = 0; r < rounds; ++ r )
+    {
+        b.clear();
+        auto const encode_start = clock::now();
+        for ( auto const v : integers )
+            serialize( v, b );
+        encode_duration += clock::now() - encode_start;
+
+        auto const decode_start = clock::now();
+        auto i = b.cbegin(), e = b.cend();
+        for ( std::uint64_t v; i != e; checksum += v )
+            if ( deserialize( i, e, v ) )
+                throw std::runtime_error{ "failed to decode" };
+        decode_duration += clock::now() - decode_start;
+    }
+
+    if ( checksum == 0 )
+        throw std::runtime_error{ "unexpected checksum" };
+
+    auto const count = integers.size() * rounds;
+    std::cout << std::setw( 8 ) << name
+              << std::setw( 12 ) << std::fixed << std::setprecision( 2 )
+              << double( b.size() ) / integers.size()
+              << std::setw( 14 ) << std::setprecision( 1 )
+              << to_millions_per_second( count, encode_duration )
+              << std::setw( 14 )
+              << to_millions_per_second( count, decode_duration ) << std::endl;
+}
+
+/**
+ *
+ */
+void
+benchmark_integers
+    ( std::string const& kind
+    , std::vector< std::uint64_t > const& integers
+    , std::size_t rounds )
+{
+    std::cout << kind << std::endl;
+    benchmark_codec( "fixed", integers, rounds, serialize_fixed, deserialize_fixed );
+    benchmark_codec( "varint", integers, rounds
+                   , kd::serialize_varint, kd::deserialize_varint );
+}
+
+/**
+ *
+ */
+std::vector< std::uint64_t >
+generate_integers
+    ( std::size_t count
+    , std::uint64_t min
+    , std::uint64_t max )
+{
+    std::default_random_engine random_engine;
+    std::uniform_int_distribution< std::uint64_t > distribution( min, max );
+
+    std::vector< std::uint64_t > integers( count );
+    for ( auto & i : integers )
+        i = distribution( random_engine );
+
+    return integers;
+}
+
+} // anonymous namespace
+
+int
+main
+    ( int argc
+    , char * argv[] )
+{
+    auto const count = t::get_option( argc, argv, "integers-count", 1000000 );
+    auto const rounds = t::get_option( argc, argv, "rounds", 10 );
+
+    std::cout << "   codec  bytes/int  encode M/s    decode M/s" << std::endl;
+
+    // Peers and keys counts.
+    benchmark_integers( "counts (1 - 20)"
+                      , generate_integers( count, 1, 20 ), rounds );
+    // Sizes of values sent within a single datagram.
+    benchmark_integers( "sizes (0 - 1232)"
+                      , generate_integers( count, 0, 1232 ), rounds );
+    // Versions are microseconds since the epoch.
+    benchmark_integers( "versions (2^50 - 2^51)"
+                      , generate_integers( count
+                                         , std::uint64_t( 1 ) << 50
+                                         , std::uint64_t( 1 ) << 51 )
+                      , rounds );
+
+    return 0;
+}
@@ -201,7 +201,8 @@ public:
             // No packet are waiting, hence register that
             // the current socket is waiting for packet.
             pending_reads_.push_back( { buffer, from
-                                      , std::forward< Callback >( callback ) } );
+                                      , std::forward< Callback >( callback )
+                                      , false } );
         }
         else
         {
@@ -215,6 +216,66 @@ public:
         }
     }
 
+    /**
+     *  @brief Wait for a packet, which is read by receive_from().
+     */
+    template< typename Callback >
+    void
+    async_receive_from
+        ( boost::asio::null_buffers const&
+        , endpoint_type & from
+        , Callback && callback )
+    {
+        if ( pending_writes_.empty() )
+            pending_reads_.push_back( { boost::asio::mutable_buffer{}, from
+                                      , std::forward< Callback >( callback )
+                                      , true } );
+        else
+        {
+            callback_type c( std::forward< Callback >( callback ) );
+            io_service_.post( [ c ]( void )
+            { c( boost::system::error_code(), 0 ); } );
+        }
+    }
+
+    /**
+     *
+     */
+    std::size_t
+    receive_from
+        ( boost::asio::mutable_buffer const& buffer
+        , endpoint_type & from
+        , int /* flags */
+        , boost::system::error_code & failure )
+    {
+        if ( pending_writes_.empty() )
+        {
+            failure = boost::asio::error::would_block;
+            return 0;
+        }
+
+        pending_write & w = pending_writes_.front();
+
+        from = w.source_;
+        auto const copied_bytes_count = copy_buffer( w.buffer_, buffer );
+
+        w.callback_( boost::system::error_code()
+                   , copied_bytes_count );
+
+        pending_writes_.pop_front();
+        failure = boost::system::error_code();
+
+        return copied_bytes_count;
+    }
+
+    /**
+     *
+     */
+    void
+    non_blocking
+        ( bool )
+    { }
+
     /**
      *
      */
@@ -321,6 +382,8 @@ private:
         boost::asio::mutable_buffer buffer_;
         endpoint_type & source_;
         callback_type callback_;
+        /// The packet is left for receive_from().
+        bool is_readiness_only_;
     };
 
     ///
@@ -541,6 +604,16 @@ private:
             assert( ! target->pending_reads_.empty() );
             pending_read & p = target->pending_reads_.front();
 
+            if ( p.is_readiness_only_ )
+            {
+                // The reader reads the packet itself.
+                target->pending_writes_.push_back( { buffer, local_endpoint_
+                                                   , callback } );
+                p.callback_( boost::system::error_code(), 0 );
+                target->pending_reads_.pop_front();
+                return;
+            }
+
             // Fill the read task buffer and endpoint.
             auto const copied_bytes_count = copy_buffer( buffer, p.buffer_ );
             p.source_ = local_endpoint_;
@@ -0,0 +1,143 @@
+// Copyright (c) 2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KADEMLIA_MESSAGE_DECODER_HPP
+#define KADEMLIA_MESSAGE_DECODER_HPP
+
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#include <system_error>
+
+#include "kademlia/buffer.hpp"
+#include "kademlia/message.hpp"
+#include "kademlia/request_decoder.hpp"
+
+namespace kademlia {
+namespace test {
+
+/**
+ *  @brief Deserialize a body of type BodyType.
+ */
+template< typename BodyType >
+std::error_code
+decode_body
+    ( detail::buffer::const_iterator i
+    , detail::buffer::const_iterator e )
+{
+    BodyType body;
+    return detail::deserialize( i, e, body );
+}
+
+/**
+ *  @brief Decode a response body as the tasks awaiting it do.
+ */
+inline std::error_code
+decode_response
+    ( detail::header const& h
+    , detail::buffer::const_iterator i
+    , detail::buffer::const_iterator e )
+{
+    namespace d = detail;
+
+    switch ( h.type_ )
+    {
+        case d::header::FIND_PEER_RESPONSE:
+        {
+            // Tasks know the requested id, any will do.
+            d::find_peer_response_body body;
+            return d::deserialize( i, e, h.version_, h.random_token_, body );
+        }
+        case d::header::FIND_VALUE_RESPONSE:
+            return decode_body< d::find_value_response_body >( i, e );
+        case d::header::FIND_CHUNK_RESPONSE:
+            return decode_body< d::find_chunk_response_body >( i, e );
+        case d::header::FIND_VALUES_RESPONSE:
+            return decode_body< d::find_values_response_body >( i, e );
+        case d::header::STORE_VALUES_RESPONSE:
+            return decode_body< d::store_values_response_body >( i, e );
+        default:
+            return std::error_code{};
+    }
+}
+
+/**
+ *  @brief Keeps the outcome of detail::decode_request().
+ */
+struct decoding_handler final
+{
+    void
+    handle_request
+        ( detail::header const& )
+    { }
+
+    template< typename BodyType >
+    void
+    handle_request
+        ( detail::header const&
+        , BodyType && )
+    { }
+
+    void
+    handle_invalid_request
+        ( detail::header const&
+        , std::error_code const& failure )
+    { failure_ = failure; }
+
+    void
+    handle_response
+        ( detail::header const& h
+        , detail::buffer::const_iterator i
+        , detail::buffer::const_iterator e )
+    { failure_ = decode_response( h, i, e ); }
+
+    std::error_code failure_;
+};
+
+/**
+ *  @brief Decode a datagram as the engine and its tasks do.
+ *  @details Used by the fuzzer and the decoding benchmark.
+ */
+inline std::error_code
+decode_message
+    ( detail::buffer::const_iterator i
+    , detail::buffer::const_iterator e )
+{
+    detail::header h;
+    if ( auto failure = detail::deserialize( i, e, h ) )
+        return failure;
+
+    decoding_handler handler;
+    detail::decode_request( h, i, e, handler );
+
+    return handler.failure_;
+}
+
+} // namespace test
+} // namespace kademlia
+
+#endif
+
@@ -27,6 +27,7 @@
 
 #include <boost/asio/io_service.hpp>
 
+#include <kademlia/configuration.hpp>
 #include <kademlia/session_base.hpp>
 #include <kademlia/endpoint.hpp>
 
@@ -46,10 +47,14 @@ public:
         ( boost::asio::io_service & service
         , endpoint const & ipv4
         , endpoint const & ipv6
-        , detail::id const& new_id )
+        , detail::id const& new_id
+        , configuration const& config = configuration{}
+        , detail::timer_queue * timers = nullptr
+        , detail::reception_buffer_pool * reception_buffers = nullptr )
             : work_( service )
             , engine_( service
-                     , ipv4, ipv6, new_id )
+                     , ipv4, ipv6, new_id, config
+                     , timers, reception_buffers )
             , listen_ipv4_( fake_socket::get_last_allocated_ipv4()
                           , session_base::DEFAULT_PORT )
             , listen_ipv6_( fake_socket::get_last_allocated_ipv6()
@@ -61,12 +66,17 @@ public:
         , endpoint const & initial_peer
         , endpoint const & ipv4
         , endpoint const & ipv6
-        , detail::id const& new_id )
+        , detail::id const& new_id
+        , configuration const& config = configuration{}
+        , detail::timer_queue * timers = nullptr
+        , detail::reception_buffer_pool * reception_buffers = nullptr )
             : work_( service )
             , engine_( service
                      , initial_peer
                      , ipv4, ipv6
-                     , new_id )
+                     , new_id
+                     , config
+                     , timers, reception_buffers )
             , listen_ipv4_( fake_socket::get_last_allocated_ipv4()
                           , session_base::DEFAULT_PORT )
             , listen_ipv6_( fake_socket::get_last_allocated_ipv6()
@@ -101,6 +111,83 @@ public:
         engine_.async_load( k, c );
     }
 
+    template< typename Callable >
+    void
+    async_save_many
+        ( std::vector< std::pair< std::string, std::string > > const& values
+        , Callable & callable )
+    {
+        std::vector< std::pair< impl::key_type, impl::data_type > > vs;
+        for ( auto const& v : values )
+            vs.emplace_back( impl::key_type{ v.first.begin(), v.first.end() }
+                           , impl::data_type{ v.second.begin(), v.second.end() } );
+
+        auto c = [ callable ]( std::error_code const& failure
+                             , impl::key_type const& key )
+        {
+            callable( failure, std::string{ key.begin(), key.end() } );
+        };
+
+        engine_.async_save_many( vs, c );
+    }
+
+    template< typename Callable >
+    void
+    async_load_many
+        ( std::vector< std::string > const& keys
+        , Callable & callable )
+    {
+        std::vector< impl::key_type > ks;
+        for ( auto const& k : keys )
+            ks.emplace_back( k.begin(), k.end() );
+
+        auto c = [ callable ]( std::error_code const& failure
+                             , impl::key_type const& key
+                             , impl::data_type const& data )
+        {
+            callable( failure
+                    , std::string{ key.begin(), key.end() }
+                    , std::string{ data.begin(), data.end() } );
+        };
+
+        engine_.async_load_many( ks, c );
+    }
+
+    std::uint64_t
+    coalesced_saves_count
+        ( void )
+        const
+    { return engine_.coalesced_saves_count(); }
+
+    std::uint64_t
+    coalesced_loads_count
+        ( void )
+        const
+    { return engine_.coalesced_loads_count(); }
+
+    detail::value_cache< detail::id, std::vector< std::uint8_t > >::statistics const&
+    get_value_cache_statistics
+        ( void )
+        const
+    { return engine_.get_value_cache_statistics(); }
+
+    detail::message_filter::statistics const&
+    get_message_filter_statistics
+        ( void )
+        const
+    { return engine_.get_message_filter_statistics(); }
+
+    detail::engine< fake_socket >::republish_statistics const&
+    get_republish_statistics
+        ( void )
+        const
+    { return engine_.get_republish_statistics(); }
+
+    void
+    republish_values
+        ( std::chrono::steady_clock::time_point const& now )
+    { engine_.republish_values( now ); }
+
     endpoint
     ipv4
         ( void )
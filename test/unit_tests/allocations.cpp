@@ -0,0 +1,81 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+///
+std::atomic< std::uint64_t > allocations_count{};
+///
+std::atomic< std::uint64_t > allocated_bytes_count{};
+
+} // anonymous namespace
+
+void *
+operator new
+    ( std::size_t size )
+{
+    allocations_count.fetch_add( 1, std::memory_order_relaxed );
+    allocated_bytes_count.fetch_add( size, std::memory_order_relaxed );
+    if ( auto p = std::malloc( size ? size : 1 ) )
+        return p;
+
+    throw std::bad_alloc{};
+}
+
+void
+operator delete
+    ( void * p )
+    noexcept
+{ std::free( p ); }
+
+void
+operator delete
+    ( void * p
+    , std::size_t )
+    noexcept
+{ std::free( p ); }
+
+namespace kademlia {
+namespace test {
+
+std::uint64_t
+get_allocations_count
+    ( void )
+{ return allocations_count.load( std::memory_order_relaxed ); }
+
+std::uint64_t
+get_allocated_bytes_count
+    ( void )
+{ return allocated_bytes_count.load( std::memory_order_relaxed ); }
+
+} // namespace test
+} // namespace kademlia
+
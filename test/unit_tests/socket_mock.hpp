@@ -142,6 +142,39 @@ public:
         , Callback && callback )
     { }
 
+    /**
+     *
+     */
+    template< typename Callback >
+    void
+    async_receive_from
+        ( boost::asio::null_buffers const&
+        , endpoint_type & from
+        , Callback && callback )
+    { }
+
+    /**
+     *
+     */
+    std::size_t
+    receive_from
+        ( boost::asio::mutable_buffer const& buffer
+        , endpoint_type & from
+        , int flags
+        , boost::system::error_code & failure )
+    {
+        failure = boost::asio::error::would_block;
+        return 0;
+    }
+
+    /**
+     *
+     */
+    void
+    non_blocking
+        ( bool )
+    { }
+
     /**
      *
      */
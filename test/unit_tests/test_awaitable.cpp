@@ -0,0 +1,188 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <kademlia/awaitable.hpp>
+
+// This test requires C++20 coroutines.
+#if defined( __cpp_impl_coroutine ) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <cstdint>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <system_error>
+#include <thread>
+
+#include <kademlia/first_session.hpp>
+#include <kademlia/session.hpp>
+
+#include "common.hpp"
+#include "network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+
+/**
+ *  @brief A session bootstrapped from a first_session,
+ *         both running on their own thread.
+ */
+struct fixture
+{
+    fixture()
+        : port1_{ k::test::get_temporary_listening_port() }
+        , port2_{ k::test::get_temporary_listening_port( port1_ ) }
+        , first_{ k::endpoint{ "127.0.0.1", port1_ }
+                , k::endpoint{ "::1", port1_ } }
+        , session_{ k::endpoint{ "127.0.0.1", port1_ }
+                  , k::endpoint{ "127.0.0.1", port2_ }
+                  , k::endpoint{ "::1", port2_ } }
+        , first_result_{ std::async( std::launch::async
+                                   , &k::first_session::run, &first_ ) }
+        , session_result_{ std::async( std::launch::async
+                                     , &k::session::run, &session_ ) }
+    {
+        // Let the bootstrap refreshes complete, as they
+        // delay the following lookups beyond their timeout.
+        std::this_thread::sleep_for( std::chrono::milliseconds( 500 ) );
+    }
+
+    ~fixture()
+    {
+        session_.abort();
+        first_.abort();
+        session_result_.get();
+        first_result_.get();
+    }
+
+    std::uint16_t port1_;
+    std::uint16_t port2_;
+    k::first_session first_;
+    k::session session_;
+    std::future< std::error_code > first_result_;
+    std::future< std::error_code > session_result_;
+};
+
+/**
+ *  @brief A coroutine started on creation and
+ *         destroyed on completion.
+ */
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task
+        get_return_object
+            ( void )
+        { return {}; }
+
+        std::suspend_never
+        initial_suspend
+            ( void )
+            noexcept
+        { return {}; }
+
+        std::suspend_never
+        final_suspend
+            ( void )
+            noexcept
+        { return {}; }
+
+        void
+        return_void
+            ( void )
+        { }
+
+        void
+        unhandled_exception
+            ( void )
+        { std::terminate(); }
+    };
+};
+
+/**
+ *
+ */
+detached_task
+save_then_load
+    ( k::session & s
+    , k::session::key_type const key
+    , k::session::data_type const data
+    , std::promise< k::session::data_type > & result )
+{
+    try
+    {
+        co_await k::save( s, key, data );
+        result.set_value( co_await k::load( s, key ) );
+    }
+    catch ( ... )
+    {
+        result.set_exception( std::current_exception() );
+    }
+}
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_FIXTURE_TEST_CASE( coroutine_can_save_then_load, fixture )
+{
+    k::session::key_type const key{ 1, 2, 3 };
+    k::session::data_type const data{ 4, 5, 6 };
+
+    std::promise< k::session::data_type > result;
+    save_then_load( session_, key, data, result );
+
+    BOOST_REQUIRE( result.get_future().get() == data );
+}
+
+BOOST_FIXTURE_TEST_CASE( coroutine_load_throws_on_failure, fixture )
+{
+    k::session::key_type const key{ 7, 8, 9 };
+
+    std::promise< k::session::data_type > result;
+    [ & ]( void ) -> detached_task
+    {
+        try
+        {
+            result.set_value( co_await k::load( session_, key ) );
+        }
+        catch ( ... )
+        {
+            result.set_exception( std::current_exception() );
+        }
+    }();
+
+    BOOST_REQUIRE_THROW( result.get_future().get(), std::system_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
+#endif
+
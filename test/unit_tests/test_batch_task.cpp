@@ -0,0 +1,160 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kademlia/batch_task.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+using completion_type = std::function< void ( void ) >;
+
+struct started_request final
+{
+    std::size_t key_index_;
+    std::shared_ptr< kd::candidates_pool > pool_;
+    completion_type on_completion_;
+};
+
+kd::id
+create_key
+    ( std::string const& prefix )
+{ return kd::id{ prefix + std::string( 40 - prefix.size(), '0' ) }; }
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( group_leaders_are_looked_up_first )
+{
+    std::vector< kd::id > const keys{ create_key( "aa1" ), create_key( "ba1" )
+                                    , create_key( "aa2" ), create_key( "aa3" ) };
+    std::vector< started_request > started;
+    auto start = [ &started ]( std::size_t key_index
+                             , std::shared_ptr< kd::candidates_pool > pool
+                             , completion_type on_completion )
+    { started.push_back( { key_index, pool, on_completion } ); };
+
+    kd::start_batch_task( keys, start );
+
+    // "aa1", "aa2" and "aa3" share their first byte, hence their peers.
+    BOOST_REQUIRE_EQUAL( 2, started.size() );
+    BOOST_REQUIRE_EQUAL( 0, started[ 0 ].key_index_ );
+    BOOST_REQUIRE_EQUAL( 1, started[ 1 ].key_index_ );
+    BOOST_REQUIRE( started[ 0 ].pool_ != started[ 1 ].pool_ );
+
+    started[ 1 ].on_completion_();
+    BOOST_REQUIRE_EQUAL( 2, started.size() );
+
+    started[ 0 ].on_completion_();
+    BOOST_REQUIRE_EQUAL( 4, started.size() );
+    BOOST_REQUIRE_EQUAL( 2, started[ 2 ].key_index_ );
+    BOOST_REQUIRE_EQUAL( 3, started[ 3 ].key_index_ );
+    BOOST_REQUIRE( started[ 0 ].pool_ == started[ 2 ].pool_ );
+    BOOST_REQUIRE( started[ 0 ].pool_ == started[ 3 ].pool_ );
+}
+
+BOOST_AUTO_TEST_CASE( groups_are_prepared_before_their_followers_start )
+{
+    std::vector< kd::id > const keys{ create_key( "aa1" ), create_key( "aa2" )
+                                    , create_key( "aa3" ), create_key( "ba1" ) };
+    std::vector< started_request > started;
+    auto start = [ &started ]( std::size_t key_index
+                             , std::shared_ptr< kd::candidates_pool > pool
+                             , completion_type on_completion )
+    { started.push_back( { key_index, pool, on_completion } ); };
+
+    std::vector< std::size_t > prepared_keys;
+    completion_type on_prepared;
+    auto prepare = [ &prepared_keys, &on_prepared ]
+        ( std::vector< std::size_t > const& key_indexes
+        , std::shared_ptr< kd::candidates_pool >
+        , completion_type on_completion )
+    {
+        prepared_keys = key_indexes;
+        on_prepared = on_completion;
+    };
+
+    kd::start_batch_task( keys, start, prepare );
+    BOOST_REQUIRE_EQUAL( 2, started.size() );
+
+    // "ba1" has no follower to prepare.
+    started[ 1 ].on_completion_();
+    BOOST_REQUIRE( prepared_keys.empty() );
+
+    started[ 0 ].on_completion_();
+    BOOST_REQUIRE_EQUAL( 2, started.size() );
+    BOOST_REQUIRE( ( std::vector< std::size_t >{ 1, 2 } ) == prepared_keys );
+
+    on_prepared();
+    BOOST_REQUIRE_EQUAL( 4, started.size() );
+}
+
+BOOST_AUTO_TEST_CASE( batch_lookups_in_flight_are_bounded )
+{
+    std::vector< kd::id > keys;
+    for ( std::size_t i = 0; i != 2 * kd::BATCH_CONCURRENT_REQUESTS_COUNT; ++ i )
+        keys.emplace_back( kd::id{} );
+
+    std::vector< started_request > started;
+    auto start = [ &started ]( std::size_t key_index
+                             , std::shared_ptr< kd::candidates_pool > pool
+                             , completion_type on_completion )
+    { started.push_back( { key_index, pool, on_completion } ); };
+
+    kd::start_batch_task( keys, start );
+    BOOST_REQUIRE_EQUAL( 1, started.size() );
+
+    started[ 0 ].on_completion_();
+    BOOST_REQUIRE_EQUAL( 1 + kd::BATCH_CONCURRENT_REQUESTS_COUNT, started.size() );
+
+    started[ 1 ].on_completion_();
+    BOOST_REQUIRE_EQUAL( 2 + kd::BATCH_CONCURRENT_REQUESTS_COUNT, started.size() );
+}
+
+BOOST_AUTO_TEST_CASE( pool_returns_the_closest_responsive_peers )
+{
+    kd::candidates_pool pool;
+    kd::ip_endpoint const endpoint{};
+    pool.add( kd::peer{ kd::id{ "1" }, endpoint } );
+    pool.add( kd::peer{ kd::id{ "e" }, endpoint } );
+    pool.add( kd::peer{ kd::id{ "b" }, endpoint } );
+    pool.remove( kd::id{ "e" } );
+
+    auto const closest = pool.find_closest( kd::id{ "a" }, 1 );
+    BOOST_REQUIRE_EQUAL( 2, pool.size() );
+    BOOST_REQUIRE_EQUAL( 1, closest.size() );
+    BOOST_REQUIRE_EQUAL( kd::id{ "b" }, closest.front().id_ );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
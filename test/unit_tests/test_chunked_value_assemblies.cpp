@@ -0,0 +1,196 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <string>
+
+#include "kademlia/chunked_value_assemblies.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+using assemblies_type = kd::chunked_value_assemblies< std::string, std::string >;
+using clock = assemblies_type::clock;
+
+std::size_t const CHUNK_SIZE = 4;
+
+assemblies_type::sender_type
+create_sender
+    ( std::string const& address )
+{ return assemblies_type::sender_type::from_string( address ); }
+
+std::string
+join
+    ( assemblies_type::chunks_type const& chunks )
+{
+    std::string value;
+    for ( auto const& c : chunks )
+        value += c.data_;
+
+    return value;
+}
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( values_are_assembled_from_their_chunks )
+{
+    assemblies_type a{ CHUNK_SIZE, 64, 64, std::chrono::seconds{ 60 } };
+    auto const s = create_sender( "10.0.0.1" );
+    auto const now = clock::now();
+
+    assemblies_type::chunks_type chunks;
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "a", s, 1, 10, 2, "89", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "a", s, 1, 10, 0, "0123", false, now, chunks ) );
+    // A duplicate is acknowledged again.
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "a", s, 1, 10, 0, "0123", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( 2 * CHUNK_SIZE, a.size() );
+
+    BOOST_REQUIRE_EQUAL( assemblies_type::VALUE_COMPLETED
+                       , a.add_chunk( "a", s, 1, 10, 1, "4567", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( "0123456789", join( chunks ) );
+    BOOST_REQUIRE_EQUAL( 0, a.size() );
+    BOOST_REQUIRE_EQUAL( 0, a.assemblies_count() );
+}
+
+BOOST_AUTO_TEST_CASE( chunks_are_kept_as_received )
+{
+    assemblies_type a{ CHUNK_SIZE, 64, 64, std::chrono::seconds{ 60 } };
+    auto const s = create_sender( "10.0.0.1" );
+    auto const now = clock::now();
+
+    // The size of a compressed chunk is checked by the caller.
+    assemblies_type::chunks_type chunks;
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "a", s, 1, 6, 1, "z", true, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( assemblies_type::VALUE_COMPLETED
+                       , a.add_chunk( "a", s, 1, 6, 0, "0123", false, now, chunks ) );
+
+    BOOST_REQUIRE_EQUAL( 2, chunks.size() );
+    BOOST_REQUIRE_EQUAL( "0123", chunks[ 0 ].data_ );
+    BOOST_REQUIRE( ! chunks[ 0 ].is_compressed_ );
+    BOOST_REQUIRE_EQUAL( "z", chunks[ 1 ].data_ );
+    BOOST_REQUIRE( chunks[ 1 ].is_compressed_ );
+}
+
+BOOST_AUTO_TEST_CASE( forged_chunks_for_many_keys_are_bounded )
+{
+    assemblies_type a{ CHUNK_SIZE, 16, 8, std::chrono::seconds{ 60 } };
+    auto const now = clock::now();
+    assemblies_type::chunks_type chunks;
+
+    // The forger announces huge values, only
+    // the received chunks are charged.
+    auto const forger = create_sender( "10.0.0.1" );
+    std::size_t accepted_count = 0;
+    for ( std::size_t i = 0; i < 1000; ++ i )
+        if ( a.add_chunk( std::to_string( i ), forger, 1, 1 << 30, 0, "0123"
+                        , false, now, chunks ) == assemblies_type::CHUNK_ACCEPTED )
+            ++ accepted_count;
+
+    BOOST_REQUIRE_EQUAL( 2, accepted_count );
+    BOOST_REQUIRE_EQUAL( 2, a.assemblies_count() );
+    BOOST_REQUIRE_EQUAL( 8, a.size() );
+    BOOST_REQUIRE_EQUAL( 998, a.get_statistics().refused_chunks_count_ );
+
+    // Other senders have their own quota.
+    auto const s1 = create_sender( "10.0.0.2" );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "b", s1, 1, 8, 0, "0123", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( assemblies_type::VALUE_COMPLETED
+                       , a.add_chunk( "b", s1, 1, 8, 1, "4567", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( 8, a.size() );
+
+    // But share the global one.
+    auto const s2 = create_sender( "10.0.0.3" );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "c", s1, 1, 8, 0, "0123", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "d", s2, 1, 8, 0, "0123", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( 16, a.size() );
+
+    auto const s3 = create_sender( "10.0.0.4" );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_REFUSED
+                       , a.add_chunk( "e", s3, 1, 8, 0, "0123", false, now, chunks ) );
+}
+
+BOOST_AUTO_TEST_CASE( other_values_dont_wipe_an_assembly_in_progress )
+{
+    assemblies_type a{ CHUNK_SIZE, 64, 64, std::chrono::seconds{ 60 } };
+    auto const s1 = create_sender( "10.0.0.1" );
+    auto const s2 = create_sender( "10.0.0.2" );
+    auto const now = clock::now();
+    assemblies_type::chunks_type chunks;
+
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "a", s1, 1, 6, 0, "0123", false, now, chunks ) );
+
+    // Another version, size or sender is refused.
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_REFUSED
+                       , a.add_chunk( "a", s1, 2, 6, 0, "abcd", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_REFUSED
+                       , a.add_chunk( "a", s1, 1, 7, 1, "abc", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_REFUSED
+                       , a.add_chunk( "a", s2, 1, 6, 1, "ab", false, now, chunks ) );
+
+    BOOST_REQUIRE_EQUAL( assemblies_type::VALUE_COMPLETED
+                       , a.add_chunk( "a", s1, 1, 6, 1, "45", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( "012345", join( chunks ) );
+}
+
+BOOST_AUTO_TEST_CASE( expired_assemblies_are_dropped )
+{
+    assemblies_type a{ CHUNK_SIZE, 64, 4, std::chrono::seconds{ 60 } };
+    auto const s = create_sender( "10.0.0.1" );
+    auto const now = clock::now();
+    assemblies_type::chunks_type chunks;
+
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "a", s, 1, 6, 0, "0123", false, now, chunks ) );
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_REFUSED
+                       , a.add_chunk( "b", s, 1, 6, 0, "0123", false, now, chunks ) );
+
+    a.drop_expired( now + std::chrono::seconds{ 59 } );
+    BOOST_REQUIRE_EQUAL( 1, a.assemblies_count() );
+
+    a.drop_expired( now + std::chrono::seconds{ 60 } );
+    BOOST_REQUIRE_EQUAL( 0, a.assemblies_count() );
+    BOOST_REQUIRE_EQUAL( 0, a.size() );
+    BOOST_REQUIRE_EQUAL( 1, a.get_statistics().expired_assemblies_count_ );
+
+    // The sender has room again.
+    BOOST_REQUIRE_EQUAL( assemblies_type::CHUNK_ACCEPTED
+                       , a.add_chunk( "b", s, 1, 6, 0, "0123", false, now, chunks ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
@@ -0,0 +1,143 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "kademlia/compression.hpp"
+#include "kademlia/error_impl.hpp"
+#include "kademlia/constants.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+using data_type = std::vector< std::uint8_t >;
+
+data_type
+create_json_value
+    ( std::size_t size )
+{
+    std::string const pattern = "{\"name\":\"peer\",\"port\":27980},";
+
+    data_type value;
+    while ( value.size() < size )
+        value.push_back( std::uint8_t( pattern[ value.size() % pattern.size() ] ) );
+
+    return value;
+}
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( compressed_values_can_be_decompressed )
+{
+    auto const value = create_json_value( kd::CHUNK_SIZE );
+
+    data_type compressed;
+    BOOST_REQUIRE_EQUAL( kd::is_compression_enabled()
+                       , kd::compress( value, compressed ) );
+
+    if ( ! kd::is_compression_enabled() )
+        return;
+
+    BOOST_REQUIRE_LT( compressed.size(), value.size() / 3 );
+
+    data_type decompressed;
+    BOOST_REQUIRE( ! kd::decompress( compressed, decompressed ) );
+    BOOST_REQUIRE( value == decompressed );
+}
+
+BOOST_AUTO_TEST_CASE( chunks_of_large_values_can_be_compressed )
+{
+    auto const value = create_json_value( 4 * kd::CHUNK_SIZE );
+    auto const chunk_begin = std::next( value.begin(), kd::CHUNK_SIZE );
+    auto const chunk_end = std::next( chunk_begin, kd::CHUNK_SIZE );
+
+    data_type compressed;
+    BOOST_REQUIRE_EQUAL( kd::is_compression_enabled()
+                       , kd::compress( chunk_begin, chunk_end, compressed ) );
+
+    if ( ! kd::is_compression_enabled() )
+        return;
+
+    data_type decompressed;
+    BOOST_REQUIRE( ! kd::decompress( compressed, decompressed ) );
+    BOOST_REQUIRE( data_type( chunk_begin, chunk_end ) == decompressed );
+
+    // A whole chunked value exceeds what is decompressed at once.
+    BOOST_REQUIRE( kd::compress( value, compressed ) );
+    BOOST_REQUIRE_EQUAL( kd::make_error_code( k::CORRUPTED_BODY )
+                       , kd::decompress( compressed, decompressed ) );
+}
+
+BOOST_AUTO_TEST_CASE( values_not_worth_it_are_not_compressed )
+{
+    data_type compressed;
+
+    // Too small.
+    BOOST_REQUIRE( ! kd::compress( create_json_value( kd::COMPRESSION_MIN_SIZE - 1 )
+                                 , compressed ) );
+
+    // Not shrinking.
+    data_type random_value( kd::COMPRESSION_MIN_SIZE );
+    std::uint32_t seed = 42;
+    for ( auto & b : random_value )
+    {
+        seed = seed * 1103515245 + 12345;
+        b = std::uint8_t( seed >> 16 );
+    }
+    BOOST_REQUIRE( ! kd::compress( random_value, compressed ) );
+    BOOST_REQUIRE( compressed.empty() );
+}
+
+BOOST_AUTO_TEST_CASE( corrupted_compressed_values_are_rejected )
+{
+    auto const corrupted = kd::make_error_code( k::CORRUPTED_BODY );
+    data_type decompressed;
+
+    BOOST_REQUIRE_EQUAL( corrupted
+                       , kd::decompress( create_json_value( 64 )
+                                       , decompressed ) );
+
+    if ( ! kd::is_compression_enabled() )
+        return;
+
+    // A truncated value.
+    data_type compressed;
+    BOOST_REQUIRE( kd::compress( create_json_value( kd::CHUNK_SIZE )
+                               , compressed ) );
+    compressed.pop_back();
+    BOOST_REQUIRE_EQUAL( corrupted
+                       , kd::decompress( compressed, decompressed ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
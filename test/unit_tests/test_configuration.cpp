@@ -0,0 +1,106 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+#include <kademlia/configuration.hpp>
+
+#include "kademlia/constants.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+BOOST_AUTO_TEST_SUITE( test_construction )
+
+BOOST_AUTO_TEST_CASE( configuration_uses_the_default_parameters )
+{
+    k::configuration const c;
+    BOOST_REQUIRE_EQUAL( kd::ROUTING_TABLE_BUCKET_SIZE, c.k_bucket_size() );
+    BOOST_REQUIRE_EQUAL( kd::CONCURRENT_FIND_PEER_REQUESTS_COUNT
+                       , c.concurrent_requests_count() );
+    BOOST_REQUIRE_EQUAL( kd::REDUNDANT_SAVE_COUNT, c.redundant_save_count() );
+    BOOST_REQUIRE_EQUAL( kd::STORE_WRITE_QUORUM, c.write_quorum() );
+    BOOST_REQUIRE_EQUAL( kd::LOAD_READ_QUORUM, c.read_quorum() );
+    BOOST_REQUIRE( kd::INITIAL_CONTACT_RECEIVE_TIMEOUT == c.initial_contact_timeout() );
+    BOOST_REQUIRE( kd::PEER_LOOKUP_TIMEOUT == c.peer_lookup_timeout() );
+    BOOST_REQUIRE_EQUAL( kd::CHUNK_WINDOW_SIZE, c.chunk_window_size() );
+    BOOST_REQUIRE_EQUAL( kd::VALUE_CACHE_CAPACITY, c.value_cache_capacity() );
+    BOOST_REQUIRE( kd::VALUE_CACHE_TTL == c.value_cache_ttl() );
+    BOOST_REQUIRE( kd::PATH_CACHING_TTL == c.path_caching_ttl() );
+    BOOST_REQUIRE( kd::PUBLISHER_REPUBLISH_INTERVAL
+                   == c.publisher_republish_interval() );
+    BOOST_REQUIRE( kd::REPLICA_REPUBLISH_INTERVAL
+                   == c.replica_republish_interval() );
+    BOOST_REQUIRE( kd::PUBLISHED_VALUE_TTL == c.published_value_ttl() );
+    BOOST_REQUIRE( kd::REPUBLISH_BATCH_INTERVAL == c.republish_batch_interval() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( test_getter_and_setters )
+
+BOOST_AUTO_TEST_CASE( configuration_can_be_inspected_and_modified )
+{
+    k::configuration c;
+    c.k_bucket_size( 8 );
+    c.concurrent_requests_count( 5 );
+    c.redundant_save_count( 2 );
+    c.write_quorum( 2 );
+    c.read_quorum( 2 );
+    c.initial_contact_timeout( std::chrono::milliseconds{ 500 } );
+    c.peer_lookup_timeout( std::chrono::milliseconds{ 100 } );
+    c.chunk_window_size( 2 );
+    c.value_cache_capacity( 0 );
+    c.value_cache_ttl( std::chrono::milliseconds{ 200 } );
+    c.path_caching_ttl( std::chrono::milliseconds{ 0 } );
+    c.publisher_republish_interval( std::chrono::milliseconds{ 3000 } );
+    c.replica_republish_interval( std::chrono::milliseconds{ 4000 } );
+    c.published_value_ttl( std::chrono::milliseconds{ 5000 } );
+    c.republish_batch_interval( std::chrono::milliseconds{ 50 } );
+
+    BOOST_REQUIRE_EQUAL( 8, c.k_bucket_size() );
+    BOOST_REQUIRE_EQUAL( 5, c.concurrent_requests_count() );
+    BOOST_REQUIRE_EQUAL( 2, c.redundant_save_count() );
+    BOOST_REQUIRE_EQUAL( 2, c.write_quorum() );
+    BOOST_REQUIRE_EQUAL( 2, c.read_quorum() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 500 } == c.initial_contact_timeout() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 100 } == c.peer_lookup_timeout() );
+    BOOST_REQUIRE_EQUAL( 2, c.chunk_window_size() );
+    BOOST_REQUIRE_EQUAL( 0, c.value_cache_capacity() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 200 } == c.value_cache_ttl() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 0 } == c.path_caching_ttl() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 3000 }
+                   == c.publisher_republish_interval() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 4000 }
+                   == c.replica_republish_interval() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 5000 } == c.published_value_ttl() );
+    BOOST_REQUIRE( std::chrono::milliseconds{ 50 } == c.republish_batch_interval() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
@@ -23,12 +23,17 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <thread>
 
 #include <boost/asio/io_service.hpp>
 
 #include "test_engine.hpp"
 
+#include "allocations.hpp"
 #include "common.hpp"
 
 namespace {
@@ -39,9 +44,10 @@ namespace t = k::test;
 
 template<typename ... InitialPeer >
 std::unique_ptr< t::test_engine >
-create_test_engine( boost::asio::io_service & io_service
-                  , d::id const& id
-                  , InitialPeer &&... initial_peer )
+create_configured_test_engine( boost::asio::io_service & io_service
+                             , k::configuration const& config
+                             , d::id const& id
+                             , InitialPeer &&... initial_peer )
 {
     k::endpoint ipv4_endpoint{ "127.0.0.1", k::session_base::DEFAULT_PORT };
     k::endpoint ipv6_endpoint{ "::1", k::session_base::DEFAULT_PORT };
@@ -51,10 +57,72 @@ create_test_engine( boost::asio::io_service & io_service
     engine_ptr t{ new t::test_engine{ io_service
                                     , std::forward< InitialPeer >( initial_peer )...
                                     , ipv4_endpoint, ipv6_endpoint
-                                    , id } };
+                                    , id, config } };
     return std::move( t );
 }
 
+template<typename ... InitialPeer >
+std::unique_ptr< t::test_engine >
+create_test_engine( boost::asio::io_service & io_service
+                  , d::id const& id
+                  , InitialPeer &&... initial_peer )
+{
+    return create_configured_test_engine( io_service
+                                        , k::configuration{}
+                                        , id
+                                        , std::forward< InitialPeer >( initial_peer )... );
+}
+
+/**
+ *  @return count values whose keys hash share their first
+ *          byte, hence belong to the same group.
+ */
+std::vector< std::pair< std::string, std::string > >
+create_nearby_values
+    ( std::size_t count )
+{
+    std::vector< std::pair< std::string, std::string > > values;
+    auto const first_byte = *d::id{ std::vector< std::uint8_t >{ '0' } }.begin();
+    for ( int i = 0; values.size() != count; ++ i )
+    {
+        auto const key = std::to_string( i );
+        if ( *d::id{ std::vector< std::uint8_t >{ key.begin(), key.end() } }.begin()
+             == first_byte )
+            values.emplace_back( key, "data" + key );
+    }
+
+    return values;
+}
+
+/**
+ *  @return A zlib stream holding data within a single stored
+ *          block, hence unlike what d::compress() outputs.
+ */
+std::vector< std::uint8_t >
+create_stored_zlib_stream
+    ( std::vector< std::uint8_t > const& data )
+{
+    auto const size = std::uint16_t( data.size() );
+    std::vector< std::uint8_t > stream{ 0x78, 0x01, 0x01
+                                      , std::uint8_t( size )
+                                      , std::uint8_t( size >> 8 )
+                                      , std::uint8_t( ~size )
+                                      , std::uint8_t( ~size >> 8 ) };
+    stream.insert( stream.end(), data.begin(), data.end() );
+
+    std::uint32_t a = 1, b = 0;
+    for ( auto const c : data )
+    {
+        a = ( a + c ) % 65521;
+        b = ( b + a ) % 65521;
+    }
+
+    for ( auto const byte : { b >> 8, b, a >> 8, a } )
+        stream.push_back( std::uint8_t( byte ) );
+
+    return stream;
+}
+
 /**
  *
  */
@@ -171,6 +239,1239 @@ BOOST_AUTO_TEST_CASE( two_engines_can_save_and_load )
     e2->async_load( "key", on_load );
 
     BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // Expected traffic isn't filtered.
+    for ( auto const& e : { e1.get(), e2.get() } )
+    {
+        auto const& statistics = e->get_message_filter_statistics();
+        BOOST_REQUIRE_EQUAL( 0, statistics.invalid_headers_count_ );
+        BOOST_REQUIRE_EQUAL( 0, statistics.unassociated_responses_count_ );
+        BOOST_REQUIRE_EQUAL( 0, statistics.shed_stores_count_ );
+        BOOST_REQUIRE_EQUAL( 0, statistics.shed_find_values_count_ );
+        BOOST_REQUIRE_EQUAL( 0, statistics.rate_limited_addresses_count_ );
+        BOOST_REQUIRE_EQUAL( 0, statistics.rate_limited_prefixes_count_ );
+        BOOST_REQUIRE_EQUAL( 0, statistics.rate_limited_chunks_count_ );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( engines_can_share_timers_and_reception_buffers )
+{
+    boost::asio::io_service io_service;
+    d::timer_queue timers{ d::get_default_strand( io_service ) };
+    d::reception_buffer_pool reception_buffers
+            { d::message_socket< t::fake_socket >::INPUT_BUFFER_SIZE };
+
+    k::endpoint const ipv4_endpoint{ "127.0.0.1", k::session_base::DEFAULT_PORT };
+    k::endpoint const ipv6_endpoint{ "::1", k::session_base::DEFAULT_PORT };
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    t::test_engine e1{ io_service, ipv4_endpoint, ipv6_endpoint, id1
+                     , k::configuration{}, &timers, &reception_buffers };
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    t::test_engine e2{ io_service, e1.ipv4(), ipv4_endpoint, ipv6_endpoint, id2
+                     , k::configuration{}, &timers, &reception_buffers };
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::error_code save_failure, load_failure;
+    std::string loaded_data;
+    auto on_save = [ & ]( std::error_code const& failure )
+    { save_failure = failure; };
+    e1.async_save( "key", "data", on_save );
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto on_load = [ & ]( std::error_code const& failure
+                        , std::string const& data )
+    {
+        load_failure = failure;
+        loaded_data = data;
+    };
+    e2.async_load( "key", on_load );
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    BOOST_REQUIRE_MESSAGE( ! save_failure, save_failure.message() );
+    BOOST_REQUIRE_MESSAGE( ! load_failure, load_failure.message() );
+    BOOST_REQUIRE_EQUAL( "data", loaded_data );
+    // Messages are handled one at a time, hence
+    // the four sockets borrow a single buffer.
+    BOOST_REQUIRE_EQUAL( 1, reception_buffers.buffers_count() );
+}
+
+BOOST_AUTO_TEST_CASE( flooding_senders_are_rate_limited )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    auto create_peer = [ &io_service ]( void )
+    {
+        std::unique_ptr< t::fake_socket > peer
+                { new t::fake_socket{ io_service, boost::asio::ip::udp::v4() } };
+        BOOST_REQUIRE( ! peer->bind( { boost::asio::ip::address_v4{}
+                                     , t::fake_socket::FIXED_PORT } ) );
+        return peer;
+    };
+    auto flooder = create_peer(), other_peer = create_peer();
+
+    boost::asio::ip::udp::endpoint const e1_endpoint
+            { boost::asio::ip::address::from_string( e1->ipv4().address() )
+            , k::session_base::DEFAULT_PORT };
+    auto on_send = []( boost::system::error_code const& failure, std::size_t )
+    { if ( failure ) throw boost::system::system_error{ failure }; };
+    d::id const token{ "1234" };
+    d::find_peer_request_body const request{ id1 };
+    auto const message = d::message_serializer{ token }.serialize( request, token );
+
+    auto count_responses = [ &io_service ]( t::fake_socket const& peer )
+    {
+        BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+        std::size_t responses_count = 0;
+        for ( ; t::count_packets() > 0; t::pop_packet() )
+            if ( t::fake_socket::get_logged_packets().front().to_
+                    == peer.local_endpoint() )
+                ++ responses_count;
+
+        return responses_count;
+    };
+
+    t::clear_packets();
+    auto const requests_count = 4 * d::SOURCE_REQUESTS_BURST;
+    for ( std::size_t i = 0; i != requests_count; ++ i )
+        flooder->async_send_to( boost::asio::buffer( message ), e1_endpoint, on_send );
+
+    // Past its burst, the flooder is only answered at a
+    // sustained rate of tens of requests per second.
+    BOOST_REQUIRE_LT( d::SOURCE_REQUESTS_RATE, 100 );
+    auto const flooder_responses_count = count_responses( *flooder );
+    BOOST_REQUIRE_GE( flooder_responses_count, d::SOURCE_REQUESTS_BURST );
+    BOOST_REQUIRE_LT( flooder_responses_count
+                    , d::SOURCE_REQUESTS_BURST + d::SOURCE_REQUESTS_RATE );
+    BOOST_REQUIRE_EQUAL( requests_count - flooder_responses_count
+                       , e1->get_message_filter_statistics()
+                            .rate_limited_addresses_count_ );
+
+    // While another sender is unaffected.
+    for ( std::size_t i = 0; i != d::SOURCE_REQUESTS_BURST; ++ i )
+        other_peer->async_send_to( boost::asio::buffer( message ), e1_endpoint, on_send );
+
+    BOOST_REQUIRE_EQUAL( d::SOURCE_REQUESTS_BURST, count_responses( *other_peer ) );
+}
+
+BOOST_AUTO_TEST_CASE( poll_driven_engines_accept_stores )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // The application polls the engines long after
+    // their lag probe expired, while they were idle.
+    std::this_thread::sleep_for( 2 * ( d::EVENT_LOOP_LAG_PROBE_INTERVAL
+                                     + d::STORE_SHEDDING_LAG ) );
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    bool is_saved = false;
+    auto on_save = [ &is_saved ]( std::error_code const& failure )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        is_saved = true;
+    };
+    e2->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE( is_saved );
+    BOOST_REQUIRE_EQUAL( 0, e1->get_message_filter_statistics().shed_stores_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( a_load_performs_a_bounded_count_of_allocations )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key1", "data", on_save );
+    e1->async_save( "key2", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::size_t loads_count = 0;
+    auto on_load = [ &loads_count ]( std::error_code const& failure
+                                   , std::string const& )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        ++ loads_count;
+    };
+
+    // The first load fills the pools.
+    e2->async_load( "key1", on_load );
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto const allocations_before = t::get_allocations_count();
+    e2->async_load( "key2", on_load );
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    auto const allocations = t::get_allocations_count() - allocations_before;
+
+    BOOST_REQUIRE_EQUAL( 2, loads_count );
+    BOOST_TEST_MESSAGE( "allocations per load: " << allocations );
+    // 36 measured, both engines and the fake sockets included.
+    BOOST_REQUIRE_LE( allocations, 40 );
+}
+
+BOOST_AUTO_TEST_CASE( versions_are_negotiated_by_single_key_lookups )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    t::clear_packets();
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e2->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // The bootstrap lookups told each engine the other's version.
+    std::size_t store_requests_count = 0;
+    for ( ; t::count_packets() > 0; t::pop_packet() )
+    {
+        auto const& p = t::fake_socket::get_logged_packets().front();
+        auto const h = t::extract_kademlia_header( p );
+        if ( p.from_ == p.to_ )
+            continue;
+
+        BOOST_REQUIRE_EQUAL( d::get_latest_version(), h.version_ );
+        if ( h.type_ == d::header::STORE_REQUEST )
+            ++ store_requests_count;
+    }
+    BOOST_REQUIRE_EQUAL( 1, store_requests_count );
+}
+
+BOOST_AUTO_TEST_CASE( stores_reach_the_quorum_once_acknowledged )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    k::configuration config;
+    config.write_quorum( 2 );
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_configured_test_engine( io_service, config, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    t::clear_packets();
+
+    // Count the acks sent by e1 until the handler is called.
+    std::size_t acks_count = 0;
+    bool is_saved = false;
+    auto on_save = [ &acks_count, &is_saved ]( std::error_code const& failure )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        for ( ; t::count_packets() > 0; t::pop_packet() )
+        {
+            auto const& p = t::fake_socket::get_logged_packets().front();
+            if ( p.from_ != p.to_
+               && t::extract_kademlia_header( p ).type_
+                  == d::header::STORE_RESPONSE )
+                ++ acks_count;
+        }
+        is_saved = true;
+    };
+    e2->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE( is_saved );
+    BOOST_REQUIRE_EQUAL( 1, acks_count );
+}
+
+BOOST_AUTO_TEST_CASE( concurrent_loads_of_the_same_key_are_coalesced )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // The latest save wins.
+    std::string const expected_data{ "other data" };
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", "data", on_save );
+    e1->async_save( "key", "data", on_save );
+    e1->async_save( "key", expected_data, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( 1, e1->coalesced_saves_count() );
+
+    t::clear_packets();
+
+    std::size_t load_count = 0;
+    auto on_load = [ &expected_data, &load_count ]
+        ( std::error_code const& failure
+        , std::string const& actual_data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        BOOST_REQUIRE_EQUAL( expected_data, actual_data );
+        ++ load_count;
+    };
+    e2->async_load( "key", on_load );
+    e2->async_load( "key", on_load );
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( 3, load_count );
+    BOOST_REQUIRE_EQUAL( 2, e2->coalesced_loads_count() );
+
+    // A single lookup has been sent on the wire.
+    std::size_t find_value_requests_count = 0;
+    while ( t::count_packets() > 0 )
+    {
+        auto const p = t::pop_packet();
+        if ( p.type() == d::header::FIND_VALUE_REQUEST && p.to() == e1->ipv4() )
+            ++ find_value_requests_count;
+    }
+    BOOST_REQUIRE_EQUAL( 1, find_value_requests_count );
+
+    // Once completed, a new load is no longer coalesced.
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( 4, load_count );
+    BOOST_REQUIRE_EQUAL( 2, e2->coalesced_loads_count() );
+}
+
+BOOST_AUTO_TEST_CASE( recently_loaded_values_are_cached )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::string loaded_data;
+    auto on_load = [ &loaded_data ]( std::error_code const& failure
+                                   , std::string const& actual_data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        loaded_data = actual_data;
+    };
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "data", loaded_data );
+    BOOST_REQUIRE_EQUAL( 0, e2->get_value_cache_statistics().hits_count_ );
+    BOOST_REQUIRE_EQUAL( 1, e2->get_value_cache_statistics().misses_count_ );
+
+    // Second load is served without any network traffic.
+    t::clear_packets();
+    loaded_data.clear();
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "data", loaded_data );
+    BOOST_REQUIRE_EQUAL( 0, t::count_packets() );
+    BOOST_REQUIRE_EQUAL( 1, e2->get_value_cache_statistics().hits_count_ );
+
+    // A local save invalidates the cached value.
+    e2->async_save( "key", "new data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( 1, e2->get_value_cache_statistics().invalidations_count_ );
+
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "new data", loaded_data );
+    BOOST_REQUIRE_EQUAL( 2, e2->get_value_cache_statistics().misses_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( value_cache_can_be_disabled )
+{
+    boost::asio::io_service io_service;
+
+    k::configuration config;
+    config.value_cache_capacity( 0 );
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_configured_test_engine( io_service, config, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::string loaded_data;
+    auto on_load = [ &loaded_data ]( std::error_code const& failure
+                                   , std::string const& actual_data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        loaded_data = actual_data;
+    };
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "data", loaded_data );
+
+    // Second load is looked up again.
+    t::clear_packets();
+    loaded_data.clear();
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "data", loaded_data );
+    BOOST_REQUIRE_GT( t::count_packets(), 0 );
+    BOOST_REQUIRE_EQUAL( 0, e2->get_value_cache_statistics().hits_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( path_caching_can_be_disabled )
+{
+    boost::asio::io_service io_service;
+
+    k::configuration config;
+    config.path_caching_ttl( std::chrono::milliseconds{ 0 } );
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_configured_test_engine( io_service, config, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    boost::asio::ip::udp::endpoint const e1_endpoint
+            { boost::asio::ip::address::from_string( e1->ipv4().address() )
+            , k::session_base::DEFAULT_PORT };
+    auto on_send = []( boost::system::error_code const& failure, std::size_t )
+    { if ( failure ) throw boost::system::system_error{ failure }; };
+
+    std::string const key{ "key" }, data{ "data" };
+    // The peer leaves once its store is sent,
+    // lookups then skip it right away.
+    auto send_store = [ & ]( std::chrono::seconds const& ttl )
+    {
+        t::fake_socket peer{ io_service, boost::asio::ip::udp::v4() };
+        BOOST_REQUIRE( ! peer.bind( { boost::asio::ip::address_v4{}
+                                    , t::fake_socket::FIXED_PORT } ) );
+
+        d::store_value_request_body const request
+                { d::id{ std::vector< std::uint8_t >{ key.begin(), key.end() } }
+                , std::vector< std::uint8_t >{ data.begin(), data.end() }
+                , ttl, 1, false, false };
+        d::id const token{ "1234" };
+        auto const message = d::message_serializer{ token }.serialize( request, token );
+        peer.async_send_to( boost::asio::buffer( message ), e1_endpoint, on_send );
+
+        BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+        boost::system::error_code failure;
+        peer.close( failure );
+    };
+
+    auto const deadline = std::chrono::steady_clock::now()
+                        + std::chrono::seconds{ 5 };
+    auto load = [ & ]( void )
+    {
+        std::error_code load_failure;
+        bool is_loaded = false;
+        auto on_load = [ &load_failure, &is_loaded ]
+            ( std::error_code const& failure, std::string const& )
+        {
+            load_failure = failure;
+            is_loaded = true;
+        };
+        e2->async_load( key, on_load );
+
+        while ( ! is_loaded )
+        {
+            BOOST_REQUIRE( std::chrono::steady_clock::now() < deadline );
+            io_service.run_one();
+        }
+
+        return load_failure;
+    };
+
+    // e1 refuses the copy cached by a lookup.
+    send_store( std::chrono::seconds{ 42 } );
+    BOOST_REQUIRE( load() == k::VALUE_NOT_FOUND );
+
+    // While it keeps a replica.
+    send_store( std::chrono::seconds::zero() );
+    BOOST_REQUIRE( ! load() );
+}
+
+BOOST_AUTO_TEST_CASE( quorum_loads_repair_stale_replicas )
+{
+    boost::asio::io_service io_service;
+
+    k::configuration config;
+    config.redundant_save_count( 2 );
+    config.read_quorum( 2 );
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_configured_test_engine( io_service, config, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_configured_test_engine( io_service, config, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", "old data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // e3 is the closest peer to the key, hence the
+    // farthest of e1 & e2 misses the new version.
+    std::string const key{ "key" };
+    d::id const id3{ d::id::value_to_hash_type( key.begin(), key.end() ) };
+    auto e3 = create_configured_test_engine( io_service, config, id3, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    e3->async_save( key, "new data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::string loaded_data;
+    auto on_load = [ &loaded_data ]( std::error_code const& failure
+                                   , std::string const& actual_data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        loaded_data = actual_data;
+    };
+
+    auto count_repairs = [ &e3 ]( void )
+    {
+        std::size_t repairs_count = 0;
+        while ( t::count_packets() > 0 )
+        {
+            auto const p = t::pop_packet();
+            if ( p.type() != d::header::STORE_REQUEST )
+                continue;
+
+            BOOST_REQUIRE( p.to() != e3->ipv4() );
+            ++ repairs_count;
+        }
+
+        return repairs_count;
+    };
+
+    t::clear_packets();
+    e1->async_load( key, on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "new data", loaded_data );
+    BOOST_REQUIRE_EQUAL( 1, count_repairs() );
+
+    // Once repaired, the replicas agree.
+    loaded_data.clear();
+    e2->async_load( key, on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "new data", loaded_data );
+    BOOST_REQUIRE_EQUAL( 0, count_repairs() );
+
+    // Loads aren't served by the cache, as the replicas must agree.
+    loaded_data.clear();
+    e1->async_load( key, on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( "new data", loaded_data );
+    BOOST_REQUIRE_EQUAL( 0, e1->get_value_cache_statistics().hits_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( stored_values_are_republished )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto const now = std::chrono::steady_clock::now();
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // Nothing is due yet.
+    e1->republish_values( now );
+    e2->republish_values( now );
+    BOOST_REQUIRE_EQUAL( 0, e1->get_republish_statistics().published_values_count_ );
+    BOOST_REQUIRE_EQUAL( 0, e2->get_republish_statistics().replicated_values_count_ );
+
+    // e2 holds a replica of the value.
+    e2->republish_values( now + d::REPLICA_REPUBLISH_INTERVAL
+                              + std::chrono::seconds{ 1 } );
+    BOOST_REQUIRE_EQUAL( 0, e2->get_republish_statistics().published_values_count_ );
+    BOOST_REQUIRE_EQUAL( 1, e2->get_republish_statistics().replicated_values_count_ );
+    BOOST_REQUIRE_EQUAL( 4, e2->get_republish_statistics().bytes_count_ );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // e1 published the value, and now holds a replica from e2.
+    e1->republish_values( now + d::PUBLISHER_REPUBLISH_INTERVAL
+                              + std::chrono::seconds{ 1 } );
+    BOOST_REQUIRE_EQUAL( 1, e1->get_republish_statistics().published_values_count_ );
+    BOOST_REQUIRE_EQUAL( 1, e1->get_republish_statistics().replicated_values_count_ );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // e2 received the value again, hence postponed its own republish.
+    e2->republish_values( now );
+    BOOST_REQUIRE_EQUAL( 0, e2->get_republish_statistics().replicated_values_count_ );
+    BOOST_REQUIRE_GE( e2->get_republish_statistics().postponed_values_count_, 2 );
+}
+
+BOOST_AUTO_TEST_CASE( published_values_expire )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto const now = std::chrono::steady_clock::now();
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // Past its ttl, e1 forgets the value it published
+    // instead of republishing it.
+    e1->republish_values( now + d::PUBLISHED_VALUE_TTL
+                              + std::chrono::seconds{ 1 } );
+    BOOST_REQUIRE_EQUAL( 1, e1->get_republish_statistics().expired_values_count_ );
+    BOOST_REQUIRE_EQUAL( 0, e1->get_republish_statistics().published_values_count_ );
+
+    e1->republish_values( now + d::PUBLISHED_VALUE_TTL
+                              + d::PUBLISHER_REPUBLISH_INTERVAL );
+    BOOST_REQUIRE_EQUAL( 0, e1->get_republish_statistics().expired_values_count_ );
+    BOOST_REQUIRE_EQUAL( 0, e1->get_republish_statistics().published_values_count_ );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( values_are_republished_by_the_republish_timer )
+{
+    boost::asio::io_service io_service;
+
+    k::configuration config;
+    config.republish_batch_interval( std::chrono::milliseconds{ 10 } );
+    config.publisher_republish_interval( std::chrono::milliseconds{ 20 } );
+    config.published_value_ttl( std::chrono::milliseconds{ 200 } );
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_configured_test_engine( io_service, config, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", "data", on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // Run the event loop until a batch satisfies check.
+    auto const deadline = std::chrono::steady_clock::now()
+                        + std::chrono::seconds{ 5 };
+    auto run_until = [ &io_service, &deadline ]
+        ( std::function< bool ( void ) > const& check )
+    {
+        while ( ! check() )
+        {
+            BOOST_REQUIRE( std::chrono::steady_clock::now() < deadline );
+            io_service.run_one();
+        }
+    };
+
+    auto const& statistics = e1->get_republish_statistics();
+    run_until( [ &statistics ]( void )
+               { return statistics.published_values_count_ > 0; } );
+    run_until( [ &statistics ]( void )
+               { return statistics.expired_values_count_ > 0; } );
+
+    // Once expired, the value is no longer republished.
+    t::clear_packets();
+    auto const later = std::chrono::steady_clock::now()
+                     + std::chrono::milliseconds{ 100 };
+    run_until( [ &statistics, &later ]( void )
+    {
+        BOOST_REQUIRE_EQUAL( 0, statistics.published_values_count_ );
+        return std::chrono::steady_clock::now() >= later;
+    } );
+    io_service.poll();
+
+    while ( t::count_packets() > 0 )
+        BOOST_REQUIRE( t::pop_packet().type() != d::header::STORE_REQUEST );
+}
+
+BOOST_AUTO_TEST_CASE( large_values_are_transferred_by_chunks )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // Larger than the largest datagram.
+    std::string expected_data( 100000, 0 );
+    for ( std::size_t i = 0; i < expected_data.size(); ++ i )
+        expected_data[ i ] = char( i * 7 );
+
+    t::clear_packets();
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", expected_data, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::string loaded_data;
+    auto on_load = [ &loaded_data ]( std::error_code const& failure
+                                   , std::string const& actual_data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        loaded_data = actual_data;
+    };
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE( expected_data == loaded_data );
+
+    // Every message fits the IPv6 minimum MTU.
+    std::size_t chunks_count = 0;
+    for ( ; t::count_packets() > 0; t::pop_packet() )
+    {
+        auto const& p = t::fake_socket::get_logged_packets().front();
+        BOOST_REQUIRE_LE( p.data_.size(), 1280 - 48 );
+        if ( t::extract_kademlia_header( p ).type_
+                == d::header::FIND_CHUNK_RESPONSE )
+            ++ chunks_count;
+    }
+    BOOST_REQUIRE_EQUAL( ( expected_data.size() + d::CHUNK_SIZE - 1 )
+                         / d::CHUNK_SIZE
+                       , chunks_count );
+}
+
+BOOST_AUTO_TEST_CASE( large_values_are_sent_whole_to_v1_peers )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::string const expected_data( 4 * d::CHUNK_SIZE, 'a' );
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e2->async_save( "key", expected_data, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // A V1 peer doesn't advertise its version.
+    t::fake_socket v1_peer{ io_service, boost::asio::ip::udp::v4() };
+    BOOST_REQUIRE( ! v1_peer.bind( { boost::asio::ip::address_v4{}
+                                   , t::fake_socket::FIXED_PORT } ) );
+
+    std::string const key{ "key" };
+    d::find_value_request_body const request
+            { d::id{ std::vector< std::uint8_t >{ key.begin(), key.end() } } };
+    d::id const token{ "1234" };
+    auto message = d::message_serializer{ token }.serialize( request, token );
+    message.pop_back();
+
+    t::clear_packets();
+
+    boost::asio::ip::udp::endpoint const e1_endpoint
+            { boost::asio::ip::address::from_string( e1->ipv4().address() )
+            , k::session_base::DEFAULT_PORT };
+    auto on_send = []( boost::system::error_code const& failure, std::size_t )
+    { if ( failure ) throw boost::system::system_error{ failure }; };
+    v1_peer.async_send_to( boost::asio::buffer( message ), e1_endpoint, on_send );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::size_t responses_count = 0;
+    for ( ; t::count_packets() > 0; t::pop_packet() )
+    {
+        auto const& p = t::fake_socket::get_logged_packets().front();
+        auto i = p.data_.begin(), e = p.data_.end();
+        d::header h;
+        BOOST_REQUIRE( ! d::deserialize( i, e, h ) );
+        if ( p.to_ != v1_peer.local_endpoint()
+           || h.type_ != d::header::FIND_VALUE_RESPONSE )
+            continue;
+
+        BOOST_REQUIRE_EQUAL( d::header::V1, h.version_ );
+        d::find_value_response_body response;
+        BOOST_REQUIRE( ! d::deserialize( i, e, response ) );
+        BOOST_REQUIRE_EQUAL( 0, response.chunked_value_size_ );
+        BOOST_REQUIRE( std::string( response.data_.begin(), response.data_.end() )
+                       == expected_data );
+        ++ responses_count;
+    }
+    BOOST_REQUIRE_EQUAL( 1, responses_count );
+}
+
+BOOST_AUTO_TEST_CASE( values_larger_than_a_datagram_are_unknown_to_v1_peers )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // Larger than the largest datagram.
+    std::string const expected_data( 100000, 'a' );
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e2->async_save( "key", expected_data, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // A V1 peer doesn't advertise its version.
+    t::fake_socket v1_peer{ io_service, boost::asio::ip::udp::v4() };
+    BOOST_REQUIRE( ! v1_peer.bind( { boost::asio::ip::address_v4{}
+                                   , t::fake_socket::FIXED_PORT } ) );
+
+    std::string const key{ "key" };
+    d::find_value_request_body const request
+            { d::id{ std::vector< std::uint8_t >{ key.begin(), key.end() } } };
+    d::id const token{ "1234" };
+    auto message = d::message_serializer{ token }.serialize( request, token );
+    message.pop_back();
+
+    t::clear_packets();
+
+    boost::asio::ip::udp::endpoint const e1_endpoint
+            { boost::asio::ip::address::from_string( e1->ipv4().address() )
+            , k::session_base::DEFAULT_PORT };
+    auto on_send = []( boost::system::error_code const& failure, std::size_t )
+    { if ( failure ) throw boost::system::system_error{ failure }; };
+    v1_peer.async_send_to( boost::asio::buffer( message ), e1_endpoint, on_send );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // It can't read the manifest, hence gets closer peers instead.
+    std::size_t responses_count = 0;
+    for ( ; t::count_packets() > 0; t::pop_packet() )
+    {
+        auto const& p = t::fake_socket::get_logged_packets().front();
+        if ( p.to_ != v1_peer.local_endpoint() )
+            continue;
+
+        auto const h = t::extract_kademlia_header( p );
+        BOOST_REQUIRE_EQUAL( d::header::V1, h.version_ );
+        BOOST_REQUIRE_EQUAL( d::header::FIND_PEER_RESPONSE, h.type_ );
+        ++ responses_count;
+    }
+    BOOST_REQUIRE_EQUAL( 1, responses_count );
+}
+
+BOOST_AUTO_TEST_CASE( large_values_are_compressed_by_chunks )
+{
+    if ( ! d::is_compression_enabled() )
+        return;
+
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    // Compressible and larger than a chunk.
+    std::string expected_data;
+    while ( expected_data.size() < 16 * d::CHUNK_SIZE )
+        expected_data += "{\"id\":" + std::to_string( expected_data.size() % 97 )
+                       + ",\"name\":\"peer\",\"online\":true},";
+    expected_data.resize( 16 * d::CHUNK_SIZE );
+
+    t::clear_packets();
+
+    auto on_save = []( std::error_code const& failure )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save( "key", expected_data, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::string loaded_data;
+    auto on_load = [ &loaded_data ]( std::error_code const& failure
+                                   , std::string const& actual_data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        loaded_data = actual_data;
+    };
+    e2->async_load( "key", on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE( expected_data == loaded_data );
+
+    auto const chunks_count = ( expected_data.size() + d::CHUNK_SIZE - 1 )
+                            / d::CHUNK_SIZE;
+    std::size_t stored_chunks_count = 0, fetched_chunks_count = 0;
+    for ( ; t::count_packets() > 0; t::pop_packet() )
+    {
+        auto const& p = t::fake_socket::get_logged_packets().front();
+        auto const h = t::extract_kademlia_header( p );
+        // e1 doesn't learn its own version.
+        if ( p.from_ == p.to_ )
+            continue;
+
+        if ( h.type_ == d::header::STORE_CHUNK_REQUEST )
+            ++ stored_chunks_count;
+        else if ( h.type_ == d::header::FIND_CHUNK_RESPONSE )
+            ++ fetched_chunks_count;
+        else
+            continue;
+
+        // Each chunk is sent compressed.
+        BOOST_REQUIRE( h.is_compressed_ );
+        BOOST_REQUIRE_LT( p.data_.size(), d::CHUNK_SIZE / 4 );
+    }
+    BOOST_REQUIRE_EQUAL( chunks_count, stored_chunks_count );
+    BOOST_REQUIRE_EQUAL( chunks_count, fetched_chunks_count );
+}
+
+BOOST_AUTO_TEST_CASE( chunks_are_served_as_stored )
+{
+    if ( ! d::is_compression_enabled() )
+        return;
+
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    auto create_peer = [ &io_service ]( void )
+    {
+        std::unique_ptr< t::fake_socket > peer
+                { new t::fake_socket{ io_service, boost::asio::ip::udp::v4() } };
+        BOOST_REQUIRE( ! peer->bind( { boost::asio::ip::address_v4{}
+                                     , t::fake_socket::FIXED_PORT } ) );
+        return peer;
+    };
+    auto v3_peer = create_peer(), v2_peer = create_peer();
+
+    boost::asio::ip::udp::endpoint const e1_endpoint
+            { boost::asio::ip::address::from_string( e1->ipv4().address() )
+            , k::session_base::DEFAULT_PORT };
+    auto on_send = []( boost::system::error_code const& failure, std::size_t )
+    { if ( failure ) throw boost::system::system_error{ failure }; };
+    d::id const token{ "1234" };
+
+    std::string const key{ "key" };
+    d::id const key_id{ std::vector< std::uint8_t >{ key.begin(), key.end() } };
+    std::vector< std::uint8_t > const chunk( d::CHUNK_SIZE, 'a' );
+    auto const compressed_chunk = create_stored_zlib_stream( chunk );
+
+    // The V3 peer stores a value of two compressed chunks.
+    for ( std::uint64_t c = 0; c != 2; ++ c )
+    {
+        d::store_chunk_request_body const request
+                { key_id, 1, 2 * d::CHUNK_SIZE, c, compressed_chunk, true };
+        auto const message = d::message_serializer{ token }
+                .serialize( request, token, d::header::V3 );
+        v3_peer->async_send_to( boost::asio::buffer( message ), e1_endpoint, on_send );
+
+        BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    }
+
+    auto find_chunk = [ & ]( t::fake_socket & peer
+                           , d::header::version const& version )
+    {
+        d::find_chunk_request_body const request{ key_id, 1, 1 };
+        auto const message = d::message_serializer{ token }
+                .serialize( request, token, version );
+
+        t::clear_packets();
+        peer.async_send_to( boost::asio::buffer( message ), e1_endpoint, on_send );
+        BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+        for ( ; t::count_packets() > 0; t::pop_packet() )
+        {
+            auto const& p = t::fake_socket::get_logged_packets().front();
+            auto i = p.data_.begin(), e = p.data_.end();
+            d::header h;
+            BOOST_REQUIRE( ! d::deserialize( i, e, h ) );
+            if ( p.to_ != peer.local_endpoint()
+               || h.type_ != d::header::FIND_CHUNK_RESPONSE )
+                continue;
+
+            d::find_chunk_response_body response;
+            BOOST_REQUIRE( ! d::deserialize( i, e, response ) );
+            response.is_compressed_ = h.is_compressed_;
+            return response;
+        }
+
+        throw std::runtime_error{ "no chunk received" };
+    };
+
+    // It gets the chunk as it sent it.
+    auto const v3_response = find_chunk( *v3_peer, d::header::V3 );
+    BOOST_REQUIRE( v3_response.is_compressed_ );
+    BOOST_REQUIRE( compressed_chunk == v3_response.chunk_ );
+
+    // A peer not supporting compression gets it uncompressed.
+    auto const v2_response = find_chunk( *v2_peer, d::header::V2 );
+    BOOST_REQUIRE( ! v2_response.is_compressed_ );
+    BOOST_REQUIRE( chunk == v2_response.chunk_ );
+}
+
+BOOST_AUTO_TEST_CASE( many_values_can_be_saved_and_loaded_at_once )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::vector< std::pair< std::string, std::string > > values;
+    for ( int i = 0; i != 40; ++ i )
+        values.emplace_back( "key" + std::to_string( i )
+                           , "data" + std::to_string( i ) );
+
+    std::set< std::string > saved_keys;
+    auto on_save = [ &saved_keys ]( std::error_code const& failure
+                                  , std::string const& key )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        saved_keys.insert( key );
+    };
+    e1->async_save_many( values, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( values.size(), saved_keys.size() );
+
+    std::vector< std::string > keys;
+    for ( auto const& v : values )
+        keys.push_back( v.first );
+    keys.push_back( "missing key" );
+
+    std::map< std::string, std::string > loaded_values;
+    std::size_t failures_count = 0;
+    auto on_load = [ &loaded_values, &failures_count ]
+        ( std::error_code const& failure
+        , std::string const& key
+        , std::string const& data )
+    {
+        if ( failure )
+            ++ failures_count;
+        else
+            loaded_values[ key ] = data;
+    };
+    e2->async_load_many( keys, on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( 1, failures_count );
+    BOOST_REQUIRE_EQUAL( values.size(), loaded_values.size() );
+    for ( auto const& v : values )
+        BOOST_REQUIRE_EQUAL( v.second, loaded_values[ v.first ] );
+}
+
+BOOST_AUTO_TEST_CASE( nearby_keys_are_loaded_with_multi_key_requests )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto const values = create_nearby_values( 10 );
+
+    auto on_save = []( std::error_code const& failure, std::string const& )
+    { if ( failure ) throw std::system_error{ failure }; };
+    e1->async_save_many( values, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    std::vector< std::string > keys;
+    for ( auto const& v : values )
+        keys.push_back( v.first );
+
+    t::clear_packets();
+
+    std::map< std::string, std::string > loaded_values;
+    auto on_load = [ &loaded_values ]( std::error_code const& failure
+                                     , std::string const& key
+                                     , std::string const& data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        loaded_values[ key ] = data;
+    };
+    e2->async_load_many( keys, on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    for ( auto const& v : values )
+        BOOST_REQUIRE_EQUAL( v.second, loaded_values[ v.first ] );
+
+    // Only the leader is looked up, from both engines,
+    // the other keys are requested at once.
+    std::size_t find_value_count = 0, find_values_count = 0;
+    for ( ; t::count_packets() > 0; t::pop_packet() )
+    {
+        auto const h = t::extract_kademlia_header(
+                t::fake_socket::get_logged_packets().front() );
+        if ( h.type_ == d::header::FIND_VALUE_REQUEST )
+            ++ find_value_count;
+        else if ( h.type_ == d::header::FIND_VALUES_REQUEST )
+        {
+            BOOST_REQUIRE_EQUAL( d::get_latest_version(), h.version_ );
+            ++ find_values_count;
+        }
+    }
+    BOOST_REQUIRE_EQUAL( 2, find_value_count );
+    BOOST_REQUIRE_EQUAL( 1, find_values_count );
+}
+
+BOOST_AUTO_TEST_CASE( nearby_keys_are_saved_with_multi_key_requests )
+{
+    boost::asio::io_service io_service;
+
+    d::id const id1{ "8000000000000000000000000000000000000000" };
+    auto e1 = create_test_engine( io_service, id1 );
+
+    d::id const id2{ "4000000000000000000000000000000000000000" };
+    auto e2 = create_test_engine( io_service, id2, e1->ipv4() );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+
+    auto const values = create_nearby_values( 10 );
+
+    t::clear_packets();
+
+    std::set< std::string > saved_keys;
+    auto on_save = [ &saved_keys ]( std::error_code const& failure
+                                  , std::string const& key )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        saved_keys.insert( key );
+    };
+    e1->async_save_many( values, on_save );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    BOOST_REQUIRE_EQUAL( values.size(), saved_keys.size() );
+
+    // Only the leader is stored alone on e2,
+    // the other values are stored at once.
+    std::size_t store_count = 0, store_values_count = 0;
+    for ( ; t::count_packets() > 0; t::pop_packet() )
+    {
+        auto const& p = t::fake_socket::get_logged_packets().front();
+        if ( p.from_ == p.to_ )
+            continue;
+
+        auto const h = t::extract_kademlia_header( p );
+        if ( h.type_ == d::header::STORE_REQUEST )
+            ++ store_count;
+        else if ( h.type_ == d::header::STORE_VALUES_REQUEST )
+            ++ store_values_count;
+    }
+    BOOST_REQUIRE_EQUAL( 1, store_count );
+    BOOST_REQUIRE_EQUAL( 1, store_values_count );
+
+    std::map< std::string, std::string > loaded_values;
+    auto on_load = [ &loaded_values ]( std::error_code const& failure
+                                     , std::string const& key
+                                     , std::string const& data )
+    {
+        if ( failure ) throw std::system_error{ failure };
+        loaded_values[ key ] = data;
+    };
+
+    std::vector< std::string > keys;
+    for ( auto const& v : values )
+        keys.push_back( v.first );
+    e2->async_load_many( keys, on_load );
+
+    BOOST_REQUIRE_GT( io_service.poll(), 0 );
+    for ( auto const& v : values )
+        BOOST_REQUIRE_EQUAL( v.second, loaded_values[ v.first ] );
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -75,6 +75,9 @@ BOOST_AUTO_TEST_CASE( error_message_follows_the_error_name )
     KADEMLIA_TEST_ERROR( VALUE_NOT_FOUND );
     KADEMLIA_TEST_ERROR( TIMER_MALFUNCTION );
     KADEMLIA_TEST_ERROR( ALREADY_RUNNING );
+    KADEMLIA_TEST_ERROR( QUORUM_NOT_REACHED );
+    KADEMLIA_TEST_ERROR( UNKNOWN_TENANT );
+    KADEMLIA_TEST_ERROR( INVALID_CONFIGURATION );
 }
 
 BOOST_AUTO_TEST_CASE( error_category_is_kademlia )
@@ -25,6 +25,7 @@
 
 #include "common.hpp"
 #include "task_fixture.hpp"
+#include "allocations.hpp"
 
 #include <vector>
 #include <utility>
@@ -304,6 +305,324 @@ BOOST_AUTO_TEST_CASE( can_return_value_when_discovered_peer_has_the_value )
                                    , data_.begin(), data_.end() );
 }
 
+BOOST_AUTO_TEST_CASE( can_cache_value_on_closest_peer_that_missed_it )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    // p1 is the only known peer atm.
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "1a" } );
+
+    // p2 is unknown atm and closer to the key.
+    auto p2 = create_peer( "192.168.1.2", kd::id{ "e" } );
+
+    // p1 knows p2.
+    kd::find_peer_response_body const fp1{ { p2 } };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, fp1 );
+
+    // And p2 knows the value.
+    kd::find_value_response_body const fv2{ { 1, 2, 3, 4 } };
+    tracker_.add_message_to_receive( p2.endpoint_, p2.id_, fv2 );
+    tracker_.set_peer_version( kd::header::V2 );
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this )
+                                          , std::chrono::seconds{ 64 } );
+    io_service_.poll();
+
+    kd::find_value_request_body const fv{ searched_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, fv ) );
+
+    // Task notified the success.
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+
+    // p1 is 2 bits farther than p2 from the key,
+    // hence it caches the value for a quarter of the ttl.
+    kd::store_value_request_body const sv{ searched_key
+                                         , fv2.data_
+                                         , std::chrono::seconds{ 64 / 4 } };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+}
+
+BOOST_AUTO_TEST_CASE( doesnt_cache_value_on_v1_peers )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "1a" } );
+    auto p2 = create_peer( "192.168.1.2", kd::id{ "e" } );
+
+    kd::find_peer_response_body const fp1{ { p2 } };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, fp1 );
+    kd::find_value_response_body const fv2{ { 1, 2, 3, 4 } };
+    tracker_.add_message_to_receive( p2.endpoint_, p2.id_, fv2 );
+
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this )
+                                          , std::chrono::seconds{ 64 } );
+    io_service_.poll();
+
+    kd::find_value_request_body const fv{ searched_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, fv ) );
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+
+    // p1 would keep the cached copy forever.
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+}
+
+BOOST_AUTO_TEST_CASE( can_return_value_once_read_quorum_is_reached )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    auto p2 = create_and_add_peer( "192.168.1.2", kd::id{ "8" } );
+    auto p3 = create_and_add_peer( "192.168.1.3", kd::id{ "9" } );
+
+    // p1 & p2 agree, p3 doesn't respond in time.
+    kd::find_value_response_body const fv1{ { 1, 2, 3, 4 }, 7 };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, fv1 );
+    tracker_.add_message_to_receive( p2.endpoint_, p2.id_, fv1 );
+
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this )
+                                          , std::chrono::seconds::zero()
+                                          , 2 );
+    io_service_.poll();
+
+    kd::find_value_request_body const fv{ searched_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p3.endpoint_, fv ) );
+
+    // Task didn't repair up to date replicas.
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+    BOOST_REQUIRE( fv1.data_ == data_ );
+}
+
+BOOST_AUTO_TEST_CASE( can_skip_value_failing_to_decompress )
+{
+    k::configuration config;
+    config.concurrent_requests_count( 1 );
+    k::test::tracker_mock tracker{ io_service_, config };
+
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    auto p2 = create_and_add_peer( "192.168.1.2", kd::id{ "8" } );
+
+    // p1 sends a corrupted compressed value.
+    kd::find_value_response_body const fv1{ { 1, 2, 3, 4 }, 0, 0, true };
+    tracker.add_message_to_receive( p1.endpoint_, p1.id_, fv1 );
+    kd::find_value_response_body const fv2{ { 5, 6, 7, 8 } };
+    tracker.add_message_to_receive( p2.endpoint_, p2.id_, fv2 );
+
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker
+                                          , routing_table_
+                                          , std::ref( *this ) );
+    io_service_.poll();
+
+    // Task asked p2 once p1's value proved unusable.
+    kd::find_value_request_body const fv{ searched_key };
+    BOOST_REQUIRE( tracker.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker.has_sent_message( p2.endpoint_, fv ) );
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+    BOOST_REQUIRE( fv2.data_ == data_ );
+}
+
+BOOST_AUTO_TEST_CASE( can_repair_stale_and_missing_replicas )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    auto p2 = create_and_add_peer( "192.168.1.2", kd::id{ "8" } );
+    auto p3 = create_and_add_peer( "192.168.1.3", kd::id{ "9" } );
+
+    // p1 has the latest version, p2 an older one
+    // and p3 doesn't have the value.
+    kd::find_value_response_body const fv1{ { 1, 2, 3, 4 }, 7 };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, fv1 );
+    kd::find_value_response_body const fv2{ { 5, 6 }, 3 };
+    tracker_.add_message_to_receive( p2.endpoint_, p2.id_, fv2 );
+    tracker_.add_message_to_receive( p3.endpoint_, p3.id_
+                                   , kd::find_peer_response_body{} );
+
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this )
+                                          , std::chrono::seconds::zero()
+                                          , 2 );
+    io_service_.poll();
+
+    kd::find_value_request_body const fv{ searched_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p3.endpoint_, fv ) );
+
+    // No quorum was reached, the latest version is returned.
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+    BOOST_REQUIRE( fv1.data_ == data_ );
+
+    // And written to p2 & p3.
+    kd::store_value_request_body const sv{ searched_key
+                                         , fv1.data_
+                                         , std::chrono::seconds::zero()
+                                         , 7 };
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, sv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p3.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+}
+
+BOOST_AUTO_TEST_CASE( can_repair_replica_responding_after_quorum )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    auto p2 = create_and_add_peer( "192.168.1.2", kd::id{ "8" } );
+    auto p3 = create_and_add_peer( "192.168.1.3", kd::id{ "9" } );
+
+    // p1 & p2 agree, then p3 responds with an older version.
+    kd::find_value_response_body const fv1{ { 1, 2, 3, 4 }, 7 };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, fv1 );
+    tracker_.add_message_to_receive( p2.endpoint_, p2.id_, fv1 );
+    kd::find_value_response_body const fv3{ { 5, 6 }, 3 };
+    tracker_.add_message_to_receive( p3.endpoint_, p3.id_, fv3 );
+
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this )
+                                          , std::chrono::seconds::zero()
+                                          , 2 );
+    io_service_.poll();
+
+    kd::find_value_request_body const fv{ searched_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p3.endpoint_, fv ) );
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+    BOOST_REQUIRE( fv1.data_ == data_ );
+
+    // p3 is sent the latest version.
+    kd::store_value_request_body const sv{ searched_key
+                                         , fv1.data_
+                                         , std::chrono::seconds::zero()
+                                         , 7 };
+    BOOST_REQUIRE( tracker_.has_sent_message( p3.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+}
+
+BOOST_AUTO_TEST_CASE( can_fetch_chunked_value )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+
+    // The value is made of 3 chunks.
+    data_type expected_data( 2 * kd::CHUNK_SIZE + 10 );
+    for ( std::size_t i = 0; i < expected_data.size(); ++ i )
+        expected_data[ i ] = std::uint8_t( i );
+
+    kd::find_value_response_body const manifest{ {}, 7, expected_data.size() };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, manifest );
+    for ( std::uint64_t c = 0; c < 3; ++ c )
+    {
+        auto const begin = std::next( expected_data.begin(), c * kd::CHUNK_SIZE );
+        auto const end = c == 2 ? expected_data.end()
+                                : std::next( begin, kd::CHUNK_SIZE );
+        kd::find_chunk_response_body const chunk{ c, { begin, end } };
+        tracker_.add_message_to_receive( p1.endpoint_, p1.id_, chunk );
+    }
+
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this ) );
+    io_service_.poll();
+
+    kd::find_value_request_body const fv{ searched_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    for ( std::uint64_t c = 0; c < 3; ++ c )
+    {
+        kd::find_chunk_request_body const fc{ searched_key, 7, c };
+        BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fc ) );
+    }
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+    BOOST_REQUIRE( expected_data == data_ );
+}
+
+BOOST_AUTO_TEST_CASE( can_notify_error_when_chunk_holders_fail )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+
+    kd::find_value_response_body const manifest{ {}, 7, 2 * kd::CHUNK_SIZE };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, manifest );
+
+    // p1 doesn't answer chunk requests.
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this ) );
+    io_service_.poll();
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( failure_ == k::VALUE_NOT_FOUND );
+}
+
+BOOST_AUTO_TEST_CASE( doesnt_allocate_chunked_value_before_its_chunks )
+{
+    kd::id const searched_key{ "a" };
+    routing_table_.expected_ids_.emplace_back( searched_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+
+    // p1 announces the largest value, but doesn't answer chunk requests.
+    kd::find_value_response_body const manifest{ {}, 7, kd::CHUNKED_VALUE_MAX_SIZE };
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, manifest );
+
+    auto const allocated_bytes_before = k::test::get_allocated_bytes_count();
+    kd::start_find_value_task< data_type >( searched_key
+                                          , tracker_
+                                          , routing_table_
+                                          , std::ref( *this ) );
+    io_service_.poll();
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( failure_ == k::VALUE_NOT_FOUND );
+    BOOST_REQUIRE_LT( k::test::get_allocated_bytes_count() - allocated_bytes_before
+                    , kd::CHUNKED_VALUE_MAX_SIZE / 16 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -24,6 +24,7 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstdint>
+#include <chrono>
 #include <future>
 
 #include <boost/asio/ip/udp.hpp>
@@ -108,6 +109,59 @@ BOOST_AUTO_TEST_CASE( first_session_run_can_be_aborted )
     BOOST_REQUIRE( result.get() == k::RUN_ABORTED );
 }
 
+BOOST_AUTO_TEST_CASE( first_session_run_with_threads_can_be_aborted )
+{
+    k::first_session s;
+
+    auto result = std::async( std::launch::async
+                            , &k::first_session::run_with_threads, &s, 4 );
+    s.abort();
+
+    BOOST_REQUIRE( result.get() == k::RUN_ABORTED );
+}
+
+BOOST_AUTO_TEST_CASE( first_session_run_for_returns_once_duration_elapsed )
+{
+    k::first_session s;
+
+    auto const duration = std::chrono::milliseconds( 10 );
+    auto const start = std::chrono::steady_clock::now();
+    BOOST_REQUIRE( ! s.run_for( duration ) );
+    BOOST_REQUIRE( std::chrono::steady_clock::now() - start >= duration );
+
+    // The session can be run again afterward.
+    BOOST_REQUIRE( ! s.run_for( duration ) );
+}
+
+BOOST_AUTO_TEST_CASE( first_session_run_for_can_be_aborted )
+{
+    k::first_session s;
+
+    auto result = std::async( std::launch::async
+                            , &k::first_session::run_for, &s
+                            , std::chrono::hours( 1 ) );
+    s.abort();
+
+    BOOST_REQUIRE( result.get() == k::RUN_ABORTED );
+}
+
+BOOST_AUTO_TEST_CASE( first_session_abort_is_consumed_by_the_next_run )
+{
+    k::first_session s;
+
+    s.abort();
+    BOOST_REQUIRE( s.run() == k::RUN_ABORTED );
+    BOOST_REQUIRE( ! s.run_for( std::chrono::milliseconds( 1 ) ) );
+}
+
+BOOST_AUTO_TEST_CASE( first_session_can_be_polled )
+{
+    k::first_session s;
+
+    BOOST_REQUIRE( ! s.poll() );
+    BOOST_REQUIRE( ! s.poll() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
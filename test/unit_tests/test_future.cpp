@@ -0,0 +1,108 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdint>
+#include <chrono>
+#include <future>
+#include <system_error>
+#include <thread>
+
+#include <kademlia/first_session.hpp>
+#include <kademlia/future.hpp>
+#include <kademlia/session.hpp>
+
+#include "common.hpp"
+#include "network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+
+/**
+ *  @brief A session bootstrapped from a first_session,
+ *         both running on their own thread.
+ */
+struct fixture
+{
+    fixture()
+        : port1_{ k::test::get_temporary_listening_port() }
+        , port2_{ k::test::get_temporary_listening_port( port1_ ) }
+        , first_{ k::endpoint{ "127.0.0.1", port1_ }
+                , k::endpoint{ "::1", port1_ } }
+        , session_{ k::endpoint{ "127.0.0.1", port1_ }
+                  , k::endpoint{ "127.0.0.1", port2_ }
+                  , k::endpoint{ "::1", port2_ } }
+        , first_result_{ std::async( std::launch::async
+                                   , &k::first_session::run, &first_ ) }
+        , session_result_{ std::async( std::launch::async
+                                     , &k::session::run, &session_ ) }
+    {
+        // Let the bootstrap refreshes complete, as they
+        // delay the following lookups beyond their timeout.
+        std::this_thread::sleep_for( std::chrono::milliseconds( 500 ) );
+    }
+
+    ~fixture()
+    {
+        session_.abort();
+        first_.abort();
+        session_result_.get();
+        first_result_.get();
+    }
+
+    std::uint16_t port1_;
+    std::uint16_t port2_;
+    k::first_session first_;
+    k::session session_;
+    std::future< std::error_code > first_result_;
+    std::future< std::error_code > session_result_;
+};
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_FIXTURE_TEST_CASE( future_holds_the_loaded_data, fixture )
+{
+    k::session::key_type const key{ 1, 2, 3 };
+    k::session::data_type const data{ 4, 5, 6 };
+
+    BOOST_REQUIRE_NO_THROW( k::save_future( session_, key, data ).get() );
+    BOOST_REQUIRE( k::load_future( session_, key ).get() == data );
+}
+
+BOOST_FIXTURE_TEST_CASE( future_throws_on_failure, fixture )
+{
+    k::session::key_type const key{ 7, 8, 9 };
+
+    BOOST_REQUIRE_THROW( k::load_future( session_, key ).get()
+                       , std::system_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
@@ -0,0 +1,186 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdint>
+#include <chrono>
+#include <future>
+#include <system_error>
+
+#include <kademlia/error.hpp>
+#include <kademlia/host.hpp>
+
+#include "common.hpp"
+#include "network.hpp"
+
+namespace {
+
+namespace k = kademlia;
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_construction )
+
+BOOST_AUTO_TEST_CASE( host_tenants_listen_on_their_endpoints )
+{
+    std::uint16_t const port1 = k::test::get_temporary_listening_port();
+    std::uint16_t const port2 = k::test::get_temporary_listening_port( port1 );
+
+    k::host h;
+    BOOST_REQUIRE_EQUAL( 0, h.tenants_count() );
+
+    BOOST_REQUIRE_EQUAL( 0, h.add_tenant( k::endpoint{ "127.0.0.1", port1 }
+                                        , k::endpoint{ "::1", port1 } ) );
+    BOOST_REQUIRE_EQUAL( 1, h.add_tenant( k::endpoint{ "127.0.0.1", port1 }
+                                        , k::endpoint{ "127.0.0.1", port2 }
+                                        , k::endpoint{ "::1", port2 } ) );
+    BOOST_REQUIRE_EQUAL( 2, h.tenants_count() );
+
+    k::test::check_listening( "127.0.0.1", port1 );
+    k::test::check_listening( "::1", port1 );
+    k::test::check_listening( "127.0.0.1", port2 );
+    k::test::check_listening( "::1", port2 );
+}
+
+BOOST_AUTO_TEST_CASE( host_throws_on_unknown_tenant )
+{
+    k::host h;
+
+    auto on_save = []( std::error_code const& ) {};
+    BOOST_REQUIRE_THROW( h.async_save( 0, { 1 }, { 2 }, on_save )
+                       , std::system_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( host_run_can_be_aborted )
+{
+    k::host h;
+
+    auto result = std::async( std::launch::async
+                            , &k::host::run, &h );
+    h.abort();
+
+    BOOST_REQUIRE( result.get() == k::RUN_ABORTED );
+}
+
+BOOST_AUTO_TEST_CASE( host_tenants_can_save_and_load_from_each_other )
+{
+    std::uint16_t const port1 = k::test::get_temporary_listening_port();
+    std::uint16_t const port2 = k::test::get_temporary_listening_port( port1 );
+    k::endpoint const first_ipv4{ "127.0.0.1", port1 };
+
+    k::host h;
+    h.add_tenant( first_ipv4, k::endpoint{ "::1", port1 } );
+    auto const tenant = h.add_tenant( first_ipv4
+                                    , k::endpoint{ "127.0.0.1", port2 }
+                                    , k::endpoint{ "::1", port2 } );
+
+    k::host::key_type const key{ 1, 2, 3 };
+    k::host::data_type const data{ 4, 5, 6 };
+    std::error_code load_failure;
+    k::host::data_type loaded_data;
+    bool is_loaded = false;
+
+    auto on_load = [ & ]( std::error_code const& failure
+                        , k::host::data_type const& d )
+    {
+        is_loaded = true;
+        load_failure = failure;
+        loaded_data = d;
+        h.abort();
+    };
+
+    auto on_save = [ & ]( std::error_code const& failure )
+    {
+        BOOST_REQUIRE_MESSAGE( ! failure, failure.message() );
+        h.async_load( tenant, key, on_load );
+    };
+
+    // Let the bootstrap refreshes complete, as they
+    // delay the save lookup beyond its timeout.
+    BOOST_REQUIRE( ! h.run_for( std::chrono::milliseconds( 500 ) ) );
+
+    h.async_save( tenant, key, data, on_save );
+
+    BOOST_REQUIRE( h.run_for( std::chrono::seconds( 10 ) ) == k::RUN_ABORTED );
+    BOOST_REQUIRE( is_loaded );
+    BOOST_REQUIRE( ! load_failure );
+    BOOST_REQUIRE( loaded_data == data );
+}
+
+BOOST_AUTO_TEST_CASE( host_tenants_can_run_on_several_threads )
+{
+    std::uint16_t const port1 = k::test::get_temporary_listening_port();
+    std::uint16_t const port2 = k::test::get_temporary_listening_port( port1 );
+    k::endpoint const first_ipv4{ "127.0.0.1", port1 };
+
+    k::host h;
+    h.add_tenant( first_ipv4, k::endpoint{ "::1", port1 } );
+    auto const tenant = h.add_tenant( first_ipv4
+                                    , k::endpoint{ "127.0.0.1", port2 }
+                                    , k::endpoint{ "::1", port2 } );
+
+    k::host::key_type const key{ 1, 2, 3 };
+    k::host::data_type const data{ 4, 5, 6 };
+    std::error_code save_failure, load_failure;
+    k::host::data_type loaded_data;
+
+    // Each tenant handlers are called on its own strand.
+    auto on_load = [ & ]( std::error_code const& failure
+                        , k::host::data_type const& d )
+    {
+        load_failure = failure;
+        loaded_data = d;
+        h.abort();
+    };
+
+    auto on_save = [ & ]( std::error_code const& failure )
+    {
+        save_failure = failure;
+        h.async_load( tenant, key, on_load );
+    };
+
+    BOOST_REQUIRE( ! h.run_for( std::chrono::milliseconds( 500 ) ) );
+
+    h.async_save( tenant, key, data, on_save );
+
+    auto result = std::async( std::launch::async
+                            , &k::host::run_with_threads, &h, 4 );
+    if ( result.wait_for( std::chrono::seconds( 10 ) ) != std::future_status::ready )
+        h.abort();
+
+    BOOST_REQUIRE( result.get() == k::RUN_ABORTED );
+    BOOST_REQUIRE_MESSAGE( ! save_failure, save_failure.message() );
+    BOOST_REQUIRE_MESSAGE( ! load_failure, load_failure.message() );
+    BOOST_REQUIRE( loaded_data == data );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
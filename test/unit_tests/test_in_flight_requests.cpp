@@ -0,0 +1,95 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "kademlia/in_flight_requests.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+using handler_type = std::function< void ( int ) >;
+using requests_type = kd::in_flight_requests< std::string, handler_type >;
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( first_request_must_be_started )
+{
+    requests_type requests;
+
+    BOOST_REQUIRE( ! requests.is_in_flight( "a" ) );
+    BOOST_REQUIRE( requests.attach( "a", []( int ) {} ) );
+    BOOST_REQUIRE( requests.is_in_flight( "a" ) );
+    BOOST_REQUIRE( requests.attach( "b", []( int ) {} ) );
+    BOOST_REQUIRE_EQUAL( 0, requests.coalesced_requests_count() );
+}
+
+BOOST_AUTO_TEST_CASE( identical_requests_are_coalesced )
+{
+    requests_type requests;
+
+    std::vector< int > results;
+    auto h = [ &results ]( int r ) { results.push_back( r ); };
+
+    BOOST_REQUIRE( requests.attach( "a", h ) );
+    BOOST_REQUIRE( ! requests.attach( "a", h ) );
+    BOOST_REQUIRE( ! requests.attach( "a", h ) );
+    BOOST_REQUIRE_EQUAL( 2, requests.coalesced_requests_count() );
+
+    requests.notify( "a", 42 );
+
+    BOOST_REQUIRE_EQUAL( 3, results.size() );
+    BOOST_REQUIRE_EQUAL( 42, results.front() );
+    BOOST_REQUIRE( ! requests.is_in_flight( "a" ) );
+
+    // Nothing left to notify.
+    requests.notify( "a", 43 );
+    BOOST_REQUIRE_EQUAL( 3, results.size() );
+}
+
+BOOST_AUTO_TEST_CASE( handler_can_issue_an_identical_request )
+{
+    requests_type requests;
+
+    bool is_restarted = false;
+    auto h = [ &requests, &is_restarted ]( int )
+    { is_restarted = requests.attach( "a", []( int ) {} ); };
+
+    requests.attach( "a", h );
+    requests.notify( "a", 0 );
+
+    BOOST_REQUIRE( is_restarted );
+    BOOST_REQUIRE( requests.is_in_flight( "a" ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -37,7 +37,7 @@ namespace ba = boost::asio;
 
 BOOST_AUTO_TEST_SUITE( test_construction )
 
-BOOST_AUTO_TEST_CASE( can_be_default_constructed )
+BOOST_AUTO_TEST_CASE( ip_endpoint_can_be_default_constructed )
 {
     BOOST_REQUIRE_NO_THROW(
         kd::ip_endpoint const e{};
@@ -0,0 +1,256 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+#include "peer_factory.hpp"
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "kademlia/lookup_task.hpp"
+#include "kademlia/constants.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+using routing_table_type = std::vector< std::pair< kd::id, kd::ip_endpoint > >;
+
+kd::id
+create_id
+    ( std::size_t value )
+{
+    char hex[ 41 ];
+    std::snprintf( hex, sizeof( hex ), "%040zx", value );
+    return kd::id{ hex };
+}
+
+std::size_t const K = kd::ROUTING_TABLE_BUCKET_SIZE;
+
+struct task final
+    : kd::lookup_task
+{
+    explicit
+    task
+        ( routing_table_type const& peers
+        , std::size_t k = K )
+        : lookup_task( create_id( 0 ), peers.begin(), peers.end(), k )
+    { }
+};
+
+routing_table_type
+create_peers
+    ( std::size_t first, std::size_t count )
+{
+    routing_table_type peers;
+    for ( std::size_t i = first; i < first + count; ++ i )
+        peers.emplace_back( create_id( i ), create_endpoint() );
+
+    return peers;
+}
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( only_the_closest_candidates_are_kept )
+{
+    // Farthest first.
+    auto peers = create_peers( 1, 2 * K );
+    task t{ routing_table_type( peers.rbegin(), peers.rend() ) };
+
+    auto const selected = t.select_new_closest_candidates( 4 * K );
+    BOOST_REQUIRE_EQUAL( K, selected.size() );
+    for ( std::size_t i = 0; i < K; ++ i )
+        BOOST_REQUIRE_EQUAL( create_id( i + 1 ), selected[ i ].id_ );
+}
+
+BOOST_AUTO_TEST_CASE( shortlist_size_is_the_configured_k )
+{
+    std::size_t const k = 4;
+    task t{ create_peers( 1, 2 * k ), k };
+
+    auto const selected = t.select_new_closest_candidates( 4 * k );
+    BOOST_REQUIRE_EQUAL( k, selected.size() );
+    BOOST_REQUIRE_EQUAL( create_id( k ), selected.back().id_ );
+}
+
+BOOST_AUTO_TEST_CASE( contacted_candidates_are_not_selected_again )
+{
+    task t{ create_peers( 1, 3 ) };
+
+    auto selected = t.select_new_closest_candidates( 2 );
+    BOOST_REQUIRE_EQUAL( 2, selected.size() );
+    BOOST_REQUIRE( t.select_new_closest_candidates( 2 ).empty() );
+
+    t.flag_candidate_as_valid( create_id( 1 ) );
+    selected = t.select_new_closest_candidates( 2 );
+    BOOST_REQUIRE_EQUAL( 1, selected.size() );
+    BOOST_REQUIRE_EQUAL( create_id( 3 ), selected[ 0 ].id_ );
+
+    // A closer candidate is selected next.
+    t.flag_candidate_as_valid( create_id( 2 ) );
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( 4 ) )
+                                             , create_peer( create_id( 1 ) ) } );
+    t.flag_candidate_as_valid( create_id( 3 ) );
+    selected = t.select_new_closest_candidates( 2 );
+    BOOST_REQUIRE_EQUAL( 1, selected.size() );
+    BOOST_REQUIRE_EQUAL( create_id( 4 ), selected[ 0 ].id_ );
+
+    t.flag_candidate_as_valid( create_id( 4 ) );
+    BOOST_REQUIRE( t.have_all_requests_completed() );
+    BOOST_REQUIRE_EQUAL( 4, t.select_closest_valid_candidates( K ).size() );
+}
+
+BOOST_AUTO_TEST_CASE( farther_candidates_are_dropped_once_full )
+{
+    task t{ create_peers( 2, K ) };
+
+    auto selected = t.select_new_closest_candidates( K );
+    BOOST_REQUIRE_EQUAL( K, selected.size() );
+    for ( auto const& p : selected )
+        t.flag_candidate_as_valid( p.id_ );
+
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( K + 2 ) ) } );
+    BOOST_REQUIRE( t.select_new_closest_candidates( K ).empty() );
+
+    // A closer one replaces the farthest responder once it responded.
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( 1 ) ) } );
+    selected = t.select_new_closest_candidates( K );
+    BOOST_REQUIRE_EQUAL( 1, selected.size() );
+    BOOST_REQUIRE_EQUAL( create_id( 1 ), selected[ 0 ].id_ );
+
+    t.flag_candidate_as_valid( create_id( 1 ) );
+    auto const valid = t.select_closest_valid_candidates( 2 * K );
+    BOOST_REQUIRE_EQUAL( K, valid.size() );
+    BOOST_REQUIRE_EQUAL( create_id( K ), valid.back().id_ );
+}
+
+BOOST_AUTO_TEST_CASE( responders_are_kept_over_closer_candidates )
+{
+    std::size_t const k = 2;
+    task t{ create_peers( 3, k ), k };
+
+    auto selected = t.select_new_closest_candidates( k );
+    BOOST_REQUIRE_EQUAL( k, selected.size() );
+    for ( auto const& p : selected )
+        t.flag_candidate_as_valid( p.id_ );
+
+    // Closer candidates which end up not responding.
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( 1 ) )
+                                             , create_peer( create_id( 2 ) ) } );
+    selected = t.select_new_closest_candidates( k );
+    BOOST_REQUIRE_EQUAL( k, selected.size() );
+    BOOST_REQUIRE( ! t.is_lookup_complete() );
+    for ( auto const& p : selected )
+        t.flag_candidate_as_invalid( p.id_ );
+
+    auto const valid = t.select_closest_valid_candidates( k );
+    BOOST_REQUIRE_EQUAL( k, valid.size() );
+    BOOST_REQUIRE_EQUAL( create_id( 3 ), valid.front().id_ );
+    BOOST_REQUIRE_EQUAL( create_id( 4 ), valid.back().id_ );
+}
+
+BOOST_AUTO_TEST_CASE( unresponsive_candidates_are_removed )
+{
+    task t{ create_peers( 1, K ) };
+
+    auto selected = t.select_new_closest_candidates( 1 );
+    BOOST_REQUIRE_EQUAL( 1, selected.size() );
+    t.flag_candidate_as_invalid( selected[ 0 ].id_ );
+    BOOST_REQUIRE( t.have_all_requests_completed() );
+
+    // Its place is free for a farther candidate.
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( K + 1 ) ) } );
+    selected = t.select_new_closest_candidates( 2 * K );
+    BOOST_REQUIRE_EQUAL( K, selected.size() );
+    BOOST_REQUIRE_EQUAL( create_id( K + 1 ), selected.back().id_ );
+}
+
+BOOST_AUTO_TEST_CASE( timed_out_candidates_are_not_queried_again )
+{
+    task t{ create_peers( 1, 2 ) };
+
+    auto selected = t.select_new_closest_candidates( 1 );
+    BOOST_REQUIRE_EQUAL( 1, selected.size() );
+    BOOST_REQUIRE_EQUAL( create_id( 1 ), selected[ 0 ].id_ );
+    t.flag_candidate_as_invalid( create_id( 1 ) );
+
+    // Another peer advertises it again.
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( 1 ) ) } );
+    selected = t.select_new_closest_candidates( 2 );
+    BOOST_REQUIRE_EQUAL( 1, selected.size() );
+    BOOST_REQUIRE_EQUAL( create_id( 2 ), selected[ 0 ].id_ );
+
+    t.flag_candidate_as_valid( create_id( 2 ) );
+    BOOST_REQUIRE( t.have_all_requests_completed() );
+    BOOST_REQUIRE( t.select_new_closest_candidates( 2 ).empty() );
+}
+
+BOOST_AUTO_TEST_CASE( dropped_candidates_are_not_queried_again )
+{
+    std::size_t const k = 2;
+    task t{ create_peers( 2, k ), k };
+    BOOST_REQUIRE_EQUAL( k, t.select_new_closest_candidates( k ).size() );
+
+    // The farthest one is dropped while its request is in flight.
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( 1 ) ) } );
+    BOOST_REQUIRE_EQUAL( 1, t.select_new_closest_candidates( k + 1 ).size() );
+    t.flag_candidate_as_valid( create_id( 1 ) );
+    t.flag_candidate_as_invalid( create_id( 2 ) );
+
+    // Its place is free again, but it was queried already.
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( 3 ) ) } );
+    BOOST_REQUIRE( t.select_new_closest_candidates( k ).empty() );
+    t.flag_candidate_as_valid( create_id( 3 ) );
+    BOOST_REQUIRE( t.have_all_requests_completed() );
+}
+
+BOOST_AUTO_TEST_CASE( lookup_completes_once_the_closest_candidates_responded )
+{
+    task t{ create_peers( 2, K ) };
+    BOOST_REQUIRE_EQUAL( K, t.select_new_closest_candidates( K ).size() );
+    BOOST_REQUIRE( ! t.is_lookup_complete() );
+
+    for ( std::size_t i = 2; i < K + 1; ++ i )
+        t.flag_candidate_as_valid( create_id( i ) );
+    BOOST_REQUIRE( ! t.is_lookup_complete() );
+
+    // The farthest candidate is dropped while its request is in flight.
+    t.add_candidates( std::vector< kd::peer >{ create_peer( create_id( 1 ) ) } );
+    BOOST_REQUIRE_EQUAL( 1, t.select_new_closest_candidates( K ).size() );
+    t.flag_candidate_as_valid( create_id( 1 ) );
+
+    BOOST_REQUIRE( ! t.have_all_requests_completed() );
+    BOOST_REQUIRE( t.is_lookup_complete() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
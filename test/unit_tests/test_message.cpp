@@ -24,6 +24,7 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "kademlia/message.hpp"
+#include "kademlia/error_impl.hpp"
 
 #include "common.hpp"
 
@@ -221,6 +222,123 @@ BOOST_AUTO_TEST_CASE( can_detect_corrupted_find_peer_response_body )
     }
 }
 
+BOOST_AUTO_TEST_CASE( can_detect_unknown_address_protocol )
+{
+    kd::find_peer_response_body const body_out
+            { { { kd::id{}
+                , { boost::asio::ip::address::from_string( "127.0.0.1" )
+                  , 1234 } } } };
+
+    kd::buffer buffer;
+    kd::serialize( body_out, buffer );
+
+    // Replace the IPv4 protocol byte following the count, id and port.
+    buffer[ 8 + kd::id::BLOCKS_COUNT + 2 ] = 3;
+
+    kd::find_peer_response_body body_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE_EQUAL( kd::make_error_code( k::CORRUPTED_BODY )
+                       , kd::deserialize( i, e, body_in ) );
+}
+
+BOOST_AUTO_TEST_CASE( can_detect_oversized_find_peer_response_body )
+{
+    // 2^64 - 1 peers announced, followed by a single peer.
+    kd::buffer buffer( 8, 0xff );
+    kd::find_peer_response_body const body_out
+            { { { kd::id{}
+                , { boost::asio::ip::address::from_string( "::1" )
+                  , 1234 } } } };
+    kd::serialize( body_out, buffer );
+    buffer.erase( buffer.begin() + 8, buffer.begin() + 16 );
+
+    kd::find_peer_response_body body_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE_EQUAL( kd::make_error_code( k::TRUNCATED_SIZE )
+                       , kd::deserialize( i, e, body_in ) );
+    BOOST_REQUIRE_EQUAL( 0, body_in.peers_.capacity() );
+
+    // The same goes for V2 lists.
+    kd::buffer const keys{ 0xff, 0xff, 0xff, 0xff, 0x0f, 0, 0, 0 };
+    kd::find_values_request_body keys_in;
+    i = keys.cbegin(), e = keys.cend();
+    BOOST_REQUIRE_EQUAL( kd::make_error_code( k::TRUNCATED_SIZE )
+                       , kd::deserialize( i, e, keys_in ) );
+    BOOST_REQUIRE_EQUAL( 0, keys_in.values_to_find_.capacity() );
+}
+
+BOOST_AUTO_TEST_CASE( can_serialize_compact_find_peer_response_body )
+{
+    std::default_random_engine random_engine;
+
+    kd::id const target{ random_engine };
+    kd::find_peer_compact_response_body body_out{ target, {} };
+
+    for ( std::size_t i = 0; i < 10; ++ i)
+    {
+        static std::string const IPS[2] =
+            { "127.0.0.1"
+            , "::1" };
+
+        // Share the first i bytes with the target.
+        kd::id id{ random_engine };
+        std::copy_n( target.begin(), i, id.begin() );
+
+        kd::peer new_peer =
+            { id
+            , { boost::asio::ip::address::from_string( IPS[ i / 5 ] )
+              , std::uint16_t( i % 2 ? 27980 - i : 27980 + i ) } };
+
+        body_out.peers_.push_back( std::move( new_peer ) );
+    }
+
+    kd::buffer buffer;
+    kd::serialize( body_out, buffer );
+
+    kd::find_peer_response_body v1_body{ body_out.peers_ };
+    BOOST_REQUIRE_LT( buffer.size(), kd::get_serialized_size( v1_body ) );
+
+    kd::find_peer_response_body body_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, kd::header::V2, target, body_in ) );
+    BOOST_REQUIRE( i == e );
+
+    BOOST_REQUIRE_EQUAL_COLLECTIONS( body_out.peers_.begin()
+                                   , body_out.peers_.end()
+                                   , body_in.peers_.begin()
+                                   , body_in.peers_.end() );
+
+    // Any truncation is detected.
+    for ( auto t = buffer.cend(); t != buffer.cbegin(); )
+    {
+        body_in.peers_.clear();
+        i = buffer.cbegin();
+        BOOST_REQUIRE( kd::deserialize( i, --t, kd::header::V2, target, body_in ) );
+    }
+
+    // A V1 header still selects the V1 format.
+    buffer.clear();
+    kd::serialize( v1_body, buffer );
+    body_in.peers_.clear();
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, kd::header::V1, target, body_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE_EQUAL( v1_body.peers_.size(), body_in.peers_.size() );
+}
+
+BOOST_AUTO_TEST_CASE( can_detect_oversized_compact_find_peer_response_body )
+{
+    // 200 IPv4 peers announced within a 10 bytes body.
+    kd::buffer const buffer{ 0xc8, 0x01, 0x00, 0, 0, 0, 0, 0, 0, 0 };
+
+    kd::find_peer_response_body body_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE_EQUAL( kd::make_error_code( k::TRUNCATED_SIZE )
+                       , kd::deserialize( i, e, kd::header::V2
+                                        , kd::id{}, body_in ) );
+    BOOST_REQUIRE( body_in.peers_.empty() );
+}
+
 BOOST_AUTO_TEST_CASE( can_serialize_find_value_request_body )
 {
     std::default_random_engine random_engine;
@@ -356,6 +474,313 @@ BOOST_AUTO_TEST_CASE( can_detect_corrupted_store_value_request_body )
     }
 }
 
+BOOST_AUTO_TEST_CASE( can_serialize_cached_store_value_request_body )
+{
+    std::default_random_engine random_engine;
+
+    kd::store_value_request_body body_out
+            { kd::id{ random_engine }
+            , std::vector< std::uint8_t >( 16 )
+            , std::chrono::seconds{ 42 } };
+
+    kd::buffer buffer;
+    kd::serialize( body_out, buffer );
+
+    kd::store_value_request_body body_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, body_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE_EQUAL( 42, body_in.ttl_.count() );
+
+    // A truncated ttl is detected.
+    i = buffer.cbegin();
+    BOOST_REQUIRE( kd::deserialize( i, std::prev( e ), body_in ) );
+
+    // V1 peers don't send the ttl.
+    body_out.ttl_ = std::chrono::seconds::zero();
+    buffer.clear();
+    kd::serialize( body_out, buffer );
+
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, body_in ) );
+    BOOST_REQUIRE_EQUAL( 0, body_in.ttl_.count() );
+}
+
+BOOST_AUTO_TEST_CASE( can_serialize_acknowledged_store_value_request_body )
+{
+    std::default_random_engine random_engine;
+
+    kd::store_value_request_body body_out
+            { kd::id{ random_engine }
+            , std::vector< std::uint8_t >( 16 )
+            , std::chrono::seconds::zero()
+            , 0
+            , false
+            , true };
+
+    kd::buffer buffer;
+    kd::serialize( body_out, buffer );
+
+    kd::store_value_request_body body_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, body_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE( body_in.is_acknowledgement_requested_ );
+
+    // Path caching and read-repair stores don't ask for an ack.
+    body_out.is_acknowledgement_requested_ = false;
+    body_out.ttl_ = std::chrono::seconds{ 42 };
+    buffer.clear();
+    kd::serialize( body_out, buffer );
+
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, body_in ) );
+    BOOST_REQUIRE( ! body_in.is_acknowledgement_requested_ );
+}
+
+BOOST_AUTO_TEST_CASE( can_serialize_versioned_values )
+{
+    std::default_random_engine random_engine;
+
+    kd::store_value_request_body store_out
+            { kd::id{ random_engine }
+            , std::vector< std::uint8_t >( 16 )
+            , std::chrono::seconds::zero()
+            , 1234 };
+
+    kd::buffer buffer;
+    kd::serialize( store_out, buffer );
+
+    kd::store_value_request_body store_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, store_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE_EQUAL( 0, store_in.ttl_.count() );
+    BOOST_REQUIRE_EQUAL( 1234, store_in.version_ );
+
+    kd::find_value_response_body const value_out{ { 1, 2, 3 }, 5678 };
+    buffer.clear();
+    kd::serialize( value_out, buffer );
+
+    kd::find_value_response_body value_in;
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, value_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE_EQUAL( 5678, value_in.version_ );
+
+    // A truncated version is detected.
+    i = buffer.cbegin();
+    BOOST_REQUIRE( kd::deserialize( i, std::prev( e ), value_in ) );
+
+    // V1 peers don't send the version.
+    buffer.clear();
+    kd::serialize( kd::find_value_response_body{ { 1, 2, 3 }, 0 }, buffer );
+    value_in.version_ = 42;
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, value_in ) );
+    BOOST_REQUIRE_EQUAL( 0, value_in.version_ );
+}
+
+BOOST_AUTO_TEST_CASE( can_serialize_chunked_value_manifest )
+{
+    kd::find_value_response_body const manifest_out{ {}, 0, 1 << 20 };
+
+    kd::buffer buffer;
+    kd::serialize( manifest_out, buffer );
+
+    kd::find_value_response_body manifest_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, manifest_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE( manifest_in.data_.empty() );
+    BOOST_REQUIRE_EQUAL( 1 << 20, manifest_in.chunked_value_size_ );
+}
+
+BOOST_AUTO_TEST_CASE( can_serialize_chunk_bodies )
+{
+    std::default_random_engine random_engine;
+
+    kd::store_chunk_request_body const store_out
+            { kd::id{ random_engine }, 7, 2500, 2, { 1, 2, 3 } };
+
+    kd::buffer buffer;
+    kd::serialize( store_out, buffer );
+
+    kd::store_chunk_request_body store_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, store_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE( store_out.data_key_hash_ == store_in.data_key_hash_ );
+    BOOST_REQUIRE_EQUAL( 7, store_in.version_ );
+    BOOST_REQUIRE_EQUAL( 2500, store_in.value_size_ );
+    BOOST_REQUIRE_EQUAL( 2, store_in.chunk_index_ );
+    BOOST_REQUIRE( store_out.chunk_ == store_in.chunk_ );
+
+    kd::find_chunk_request_body const find_out
+            { kd::id{ random_engine }, 7, 2 };
+    buffer.clear();
+    kd::serialize( find_out, buffer );
+
+    kd::find_chunk_request_body find_in;
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, find_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE( find_out.data_key_hash_ == find_in.data_key_hash_ );
+    BOOST_REQUIRE_EQUAL( 2, find_in.chunk_index_ );
+}
+
+BOOST_AUTO_TEST_CASE( multi_key_messages_require_v2_header )
+{
+    BOOST_REQUIRE_EQUAL( kd::header::V1
+                       , kd::get_version( kd::header::FIND_VALUE_REQUEST ) );
+    BOOST_REQUIRE_EQUAL( kd::header::V2
+                       , kd::get_version( kd::header::FIND_VALUES_REQUEST ) );
+
+    std::default_random_engine random_engine;
+
+    for ( auto const version : { kd::header::V1, kd::header::V2 } )
+    {
+        kd::header const header_out =
+            { version
+            , kd::header::STORE_VALUES_REQUEST
+            , kd::id{ random_engine }
+            , kd::id{ random_engine } };
+
+        kd::buffer buffer;
+        kd::serialize( header_out, buffer );
+
+        kd::header header_in;
+        auto i = buffer.cbegin(), e = buffer.cend();
+        auto const failure = kd::deserialize( i, e, header_in );
+        if ( version == kd::header::V1 )
+            BOOST_REQUIRE_EQUAL( k::UNKNOWN_PROTOCOL_VERSION, failure );
+        else
+            BOOST_REQUIRE( ! failure );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( compressed_values_require_v3_header )
+{
+    std::default_random_engine random_engine;
+
+    for ( auto const version : { kd::header::V2, kd::header::V3 } )
+    {
+        kd::header const header_out =
+            { version
+            , kd::header::FIND_VALUE_RESPONSE
+            , kd::id{ random_engine }
+            , kd::id{ random_engine }
+            , true };
+
+        kd::buffer buffer;
+        kd::serialize( header_out, buffer );
+
+        kd::header header_in;
+        auto i = buffer.cbegin(), e = buffer.cend();
+        auto const failure = kd::deserialize( i, e, header_in );
+        if ( version < kd::header::V3 || version > kd::get_latest_version() )
+            BOOST_REQUIRE_EQUAL( k::UNKNOWN_PROTOCOL_VERSION, failure );
+        else
+        {
+            BOOST_REQUIRE( ! failure );
+            BOOST_REQUIRE_EQUAL( kd::header::V3, header_in.version_ );
+            BOOST_REQUIRE( header_in.is_compressed_ );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( can_serialize_multi_key_bodies )
+{
+    std::default_random_engine random_engine;
+
+    kd::find_values_request_body const find_out
+            { { kd::id{ random_engine }, kd::id{ random_engine } } };
+
+    kd::buffer buffer;
+    kd::serialize( find_out, buffer );
+
+    kd::find_values_request_body find_in;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, find_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE( find_out.values_to_find_ == find_in.values_to_find_ );
+
+    kd::peer const p{ kd::id{ random_engine }
+                    , kd::ip_endpoint{ boost::asio::ip::address::from_string( "::1" )
+                                     , 1234 } };
+    kd::find_values_response_body const found_out
+            { { { kd::id{ random_engine }, true, { 1, 2, 3 }, 7, {} }
+              , { kd::id{ random_engine }, false, {}, 0, { p } } } };
+    buffer.clear();
+    kd::serialize( found_out, buffer );
+
+    kd::find_values_response_body found_in;
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, found_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE_EQUAL( 2, found_in.results_.size() );
+    BOOST_REQUIRE( found_in.results_[ 0 ].is_found_ );
+    BOOST_REQUIRE( found_out.results_[ 0 ].data_ == found_in.results_[ 0 ].data_ );
+    BOOST_REQUIRE_EQUAL( 7, found_in.results_[ 0 ].version_ );
+    BOOST_REQUIRE( ! found_in.results_[ 1 ].is_found_ );
+    BOOST_REQUIRE_EQUAL( 1, found_in.results_[ 1 ].peers_.size() );
+    BOOST_REQUIRE_EQUAL( p, found_in.results_[ 1 ].peers_.front() );
+
+    kd::store_values_request_body const store_out
+            { { { kd::id{ random_engine }, { 4, 5 }, 3 } } };
+    buffer.clear();
+    kd::serialize( store_out, buffer );
+
+    kd::store_values_request_body store_in;
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize( i, e, store_in ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE_EQUAL( 1, store_in.values_.size() );
+    BOOST_REQUIRE( store_out.values_[ 0 ].data_key_hash_
+                   == store_in.values_[ 0 ].data_key_hash_ );
+    BOOST_REQUIRE( store_out.values_[ 0 ].data_value_
+                   == store_in.values_[ 0 ].data_value_ );
+    BOOST_REQUIRE_EQUAL( 3, store_in.values_[ 0 ].version_ );
+
+    // A truncated result is detected.
+    buffer.clear();
+    kd::serialize( found_out, buffer );
+    buffer.pop_back();
+    found_in.results_.clear();
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( kd::deserialize( i, e, found_in ) );
+}
+
+BOOST_AUTO_TEST_CASE( can_deserialize_chunk_into_its_value )
+{
+    // The value is made of 2 chunks of 4 bytes and a chunk of 2 bytes.
+    std::vector< std::uint8_t > value( 10 );
+
+    kd::buffer buffer;
+    kd::serialize( kd::find_chunk_response_body{ 1, { 5, 6, 7, 8 } }, buffer );
+
+    std::uint64_t chunk_index;
+    auto i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( ! kd::deserialize_chunk( i, e, 4, value, chunk_index ) );
+    BOOST_REQUIRE( i == e );
+    BOOST_REQUIRE_EQUAL( 1, chunk_index );
+
+    std::vector< std::uint8_t > const expected{ 0, 0, 0, 0, 5, 6, 7, 8, 0, 0 };
+    BOOST_REQUIRE( expected == value );
+
+    // The last chunk is shorter.
+    buffer.clear();
+    kd::serialize( kd::find_chunk_response_body{ 2, { 5, 6, 7, 8 } }, buffer );
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( kd::deserialize_chunk( i, e, 4, value, chunk_index ) );
+
+    // And there is no fourth chunk.
+    buffer.clear();
+    kd::serialize( kd::find_chunk_response_body{ 3, { 5, 6 } }, buffer );
+    i = buffer.cbegin(), e = buffer.cend();
+    BOOST_REQUIRE( kd::deserialize_chunk( i, e, 4, value, chunk_index ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE( test_print )
@@ -400,6 +825,38 @@ BOOST_AUTO_TEST_CASE( header_is_printable )
                      , kd::header::FIND_VALUE_RESPONSE }
         << std::endl;
 
+    out << kd::header{ kd::header::V1
+                     , kd::header::STORE_RESPONSE }
+        << std::endl;
+
+    out << kd::header{ kd::header::V1
+                     , kd::header::STORE_CHUNK_REQUEST }
+        << std::endl;
+
+    out << kd::header{ kd::header::V1
+                     , kd::header::FIND_CHUNK_REQUEST }
+        << std::endl;
+
+    out << kd::header{ kd::header::V1
+                     , kd::header::FIND_CHUNK_RESPONSE }
+        << std::endl;
+
+    out << kd::header{ kd::header::V2
+                     , kd::header::FIND_VALUES_REQUEST }
+        << std::endl;
+
+    out << kd::header{ kd::header::V2
+                     , kd::header::FIND_VALUES_RESPONSE }
+        << std::endl;
+
+    out << kd::header{ kd::header::V2
+                     , kd::header::STORE_VALUES_REQUEST }
+        << std::endl;
+
+    out << kd::header{ kd::header::V2
+                     , kd::header::STORE_VALUES_RESPONSE }
+        << std::endl;
+
     BOOST_REQUIRE( out.match_pattern() );
 
     BOOST_REQUIRE_THROW( out << generate_incorrect_header()
@@ -0,0 +1,246 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include "kademlia/message_filter.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+using clock = kd::message_filter::clock;
+
+kd::buffer
+create_message
+    ( kd::header::type const& type
+    , kd::id const& token )
+{
+    kd::header const h{ kd::header::V1, type, kd::id{}, token };
+
+    kd::buffer b;
+    kd::serialize( h, b );
+
+    return b;
+}
+
+bool
+accept
+    ( kd::message_filter & f
+    , kd::ip_endpoint const& sender
+    , kd::buffer const& b
+    , clock::time_point const& now
+    , kd::id const& awaited_token = kd::id{} )
+{
+    auto is_awaited_response = [ &awaited_token ]( kd::id const& token )
+    { return token == awaited_token; };
+
+    kd::header h;
+    auto i = b.begin();
+    return f.accept( sender, i, b.end(), h, now, is_awaited_response );
+}
+
+kd::token_bucket_sketch
+create_sketch
+    ( std::size_t rate
+    , std::size_t burst )
+{ return kd::token_bucket_sketch{ 4, 64, rate, burst }; }
+
+kd::admission_controller
+create_admission_controller
+    ( void )
+{
+    return kd::admission_controller{ std::chrono::milliseconds{ 50 }
+                                   , std::chrono::milliseconds{ 200 } };
+}
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( sketch_limits_keys_independently )
+{
+    kd::token_bucket_sketch s{ 4, 1024, 1, 1 };
+    auto const now = clock::now();
+
+    for ( std::size_t key = 0; key < 100; ++ key )
+        BOOST_REQUIRE( s.consume( key, now ) );
+
+    for ( std::size_t key = 0; key < 100; ++ key )
+        BOOST_REQUIRE( ! s.consume( key, now ) );
+
+    BOOST_REQUIRE( s.consume( 0, now + std::chrono::seconds{ 1 } ) );
+}
+
+BOOST_AUTO_TEST_CASE( filter_drops_invalid_headers )
+{
+    kd::message_filter f{ create_sketch( 10, 10 ), create_sketch( 10, 10 )
+                        , create_sketch( 100, 100 ), create_admission_controller() };
+    auto const sender = kd::to_ip_endpoint( "10.0.0.1", 5555 );
+    auto const now = clock::now();
+
+    BOOST_REQUIRE( ! accept( f, sender, kd::buffer{}, now ) );
+
+    kd::buffer b = create_message( kd::header::PING_REQUEST, kd::id{} );
+    // Unknown version.
+    b[ 0 ] = 0x7;
+    BOOST_REQUIRE( ! accept( f, sender, b, now ) );
+    // Unknown type.
+    b[ 0 ] = 0xf1;
+    BOOST_REQUIRE( ! accept( f, sender, b, now ) );
+
+    BOOST_REQUIRE_EQUAL( 3, f.get_statistics().invalid_headers_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( filter_drops_unsolicited_responses )
+{
+    kd::message_filter f{ create_sketch( 10, 10 ), create_sketch( 10, 10 )
+                        , create_sketch( 100, 100 ), create_admission_controller() };
+    auto const sender = kd::to_ip_endpoint( "10.0.0.1", 5555 );
+    auto const now = clock::now();
+    kd::id const token{ "1" };
+
+    BOOST_REQUIRE( accept( f, sender
+                         , create_message( kd::header::PING_REQUEST, token )
+                         , now ) );
+    BOOST_REQUIRE( ! accept( f, sender
+                           , create_message( kd::header::PING_RESPONSE, token )
+                           , now ) );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().unassociated_responses_count_ );
+
+    BOOST_REQUIRE( accept( f, sender
+                         , create_message( kd::header::PING_RESPONSE, token )
+                         , now, token ) );
+}
+
+BOOST_AUTO_TEST_CASE( filter_rate_limits_senders )
+{
+    kd::message_filter f{ create_sketch( 10, 2 ), create_sketch( 100, 100 )
+                        , create_sketch( 100, 100 ), create_admission_controller() };
+    auto const sender = kd::to_ip_endpoint( "10.0.0.1", 5555 );
+    auto const m = create_message( kd::header::PING_REQUEST, kd::id{} );
+    auto const now = clock::now();
+
+    // The burst is consumed.
+    BOOST_REQUIRE( accept( f, sender, m, now ) );
+    BOOST_REQUIRE( accept( f, sender, m, now ) );
+    BOOST_REQUIRE( ! accept( f, sender, m, now ) );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().rate_limited_addresses_count_ );
+
+    // Other senders have their own budget.
+    auto const other_sender = kd::to_ip_endpoint( "10.0.0.2", 5555 );
+    BOOST_REQUIRE( accept( f, other_sender, m, now ) );
+
+    // A token is regained every 100ms.
+    auto const later = now + std::chrono::milliseconds{ 100 };
+    BOOST_REQUIRE( accept( f, sender, m, later ) );
+    BOOST_REQUIRE( ! accept( f, sender, m, later ) );
+    BOOST_REQUIRE_EQUAL( 2, f.get_statistics().rate_limited_addresses_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( filter_doesnt_rate_limit_awaited_responses )
+{
+    kd::message_filter f{ create_sketch( 10, 1 ), create_sketch( 10, 1 )
+                        , create_sketch( 100, 100 ), create_admission_controller() };
+    auto const sender = kd::to_ip_endpoint( "10.0.0.1", 5555 );
+    kd::id const token{ "1" };
+    auto const response = create_message( kd::header::FIND_PEER_RESPONSE, token );
+    auto const now = clock::now();
+
+    for ( int i = 0; i != 10; ++ i )
+        BOOST_REQUIRE( accept( f, sender, response, now, token ) );
+
+    // The requests budget is left untouched.
+    auto const request = create_message( kd::header::PING_REQUEST, kd::id{} );
+    BOOST_REQUIRE( accept( f, sender, request, now ) );
+    BOOST_REQUIRE( ! accept( f, sender, request, now ) );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().rate_limited_addresses_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( filter_rate_limits_network_prefixes )
+{
+    kd::message_filter f{ create_sketch( 10, 10 ), create_sketch( 10, 3 )
+                        , create_sketch( 100, 100 ), create_admission_controller() };
+    auto const m = create_message( kd::header::PING_REQUEST, kd::id{} );
+    auto const now = clock::now();
+
+    BOOST_REQUIRE( accept( f, kd::to_ip_endpoint( "10.0.0.1", 5555 ), m, now ) );
+    BOOST_REQUIRE( accept( f, kd::to_ip_endpoint( "10.0.0.2", 5555 ), m, now ) );
+    BOOST_REQUIRE( accept( f, kd::to_ip_endpoint( "10.0.0.3", 5555 ), m, now ) );
+    BOOST_REQUIRE( ! accept( f, kd::to_ip_endpoint( "10.0.0.4", 5555 ), m, now ) );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().rate_limited_prefixes_count_ );
+
+    BOOST_REQUIRE( accept( f, kd::to_ip_endpoint( "10.0.1.1", 5555 ), m, now ) );
+}
+
+BOOST_AUTO_TEST_CASE( filter_rate_limits_chunks_within_their_own_budget )
+{
+    kd::message_filter f{ create_sketch( 10, 1 ), create_sketch( 10, 1 )
+                        , create_sketch( 10, 2 ), create_admission_controller() };
+    auto const sender = kd::to_ip_endpoint( "10.0.0.1", 5555 );
+    auto const chunk = create_message( kd::header::FIND_CHUNK_REQUEST, kd::id{} );
+    auto const ping = create_message( kd::header::PING_REQUEST, kd::id{} );
+    auto const now = clock::now();
+
+    BOOST_REQUIRE( accept( f, sender, chunk, now ) );
+    BOOST_REQUIRE( accept( f, sender, chunk, now ) );
+    BOOST_REQUIRE( ! accept( f, sender, chunk, now ) );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().rate_limited_chunks_count_ );
+
+    // The requests budget is left untouched.
+    BOOST_REQUIRE( accept( f, sender, ping, now ) );
+    BOOST_REQUIRE( ! accept( f, sender, ping, now ) );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().rate_limited_addresses_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( filter_sheds_stores_then_value_lookups )
+{
+    kd::message_filter f{ create_sketch( 100, 100 ), create_sketch( 100, 100 )
+                        , create_sketch( 100, 100 ), create_admission_controller() };
+    auto const sender = kd::to_ip_endpoint( "10.0.0.1", 5555 );
+    auto const store = create_message( kd::header::STORE_REQUEST, kd::id{} );
+    auto const find_value = create_message( kd::header::FIND_VALUE_REQUEST, kd::id{} );
+    auto const find_peer = create_message( kd::header::FIND_PEER_REQUEST, kd::id{} );
+    auto const now = clock::now();
+
+    f.update_event_loop_lag( std::chrono::milliseconds{ 100 } );
+    BOOST_REQUIRE( ! accept( f, sender, store, now ) );
+    BOOST_REQUIRE( accept( f, sender, find_value, now ) );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().shed_stores_count_ );
+
+    f.update_event_loop_lag( std::chrono::milliseconds{ 300 } );
+    BOOST_REQUIRE( ! accept( f, sender, store, now ) );
+    BOOST_REQUIRE( ! accept( f, sender, find_value, now ) );
+    BOOST_REQUIRE( accept( f, sender, find_peer, now ) );
+    BOOST_REQUIRE_EQUAL( 2, f.get_statistics().shed_stores_count_ );
+    BOOST_REQUIRE_EQUAL( 1, f.get_statistics().shed_find_values_count_ );
+
+    // The event loop caught up.
+    f.update_event_loop_lag( std::chrono::milliseconds{ 0 } );
+    BOOST_REQUIRE( accept( f, sender, store, now ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -72,7 +72,49 @@ BOOST_AUTO_TEST_CASE( can_serialize_a_message_with_a_body )
     BOOST_REQUIRE( ! kd::deserialize( i, e, actual ) );
     BOOST_REQUIRE( expected.peer_to_find_id_ == actual.peer_to_find_id_ );
 
-    BOOST_REQUIRE( i == e );
+    // V1 peers ignore the version following the body.
+    BOOST_REQUIRE_EQUAL( 1, std::distance( i, e ) );
+    BOOST_REQUIRE_EQUAL( kd::get_latest_version(), *i );
+}
+
+BOOST_AUTO_TEST_CASE( lookup_requests_advertise_the_latest_version )
+{
+    kd::message_serializer s{ id_ };
+    kd::id const token{ "ABCD" };
+
+    auto check_sender_version = [ & ]
+        ( kd::buffer const& b
+        , kd::header::version const& expected )
+    {
+        auto i = std::begin( b ), e = std::end( b );
+        kd::header h;
+        BOOST_REQUIRE( ! kd::deserialize( i, e, h ) );
+        BOOST_REQUIRE_EQUAL( expected, kd::get_sender_version( h, i, e ) );
+    };
+
+    kd::find_value_request_body const request{ kd::id{ "1234" } };
+    check_sender_version( s.serialize( request, token )
+                        , kd::get_latest_version() );
+
+    // The header already tells it.
+    auto b = s.serialize( request, token, kd::header::V2 );
+    BOOST_REQUIRE_EQUAL( b.size(), s.serialize( request, token ).size() - 1 );
+    check_sender_version( b, kd::header::V2 );
+
+    // Other V1 messages don't tell it.
+    b = s.serialize( kd::header::PING_REQUEST, token );
+    check_sender_version( b, kd::header::V1 );
+    b.push_back( kd::header::V2 );
+    check_sender_version( b, kd::header::V1 );
+
+    // As V1 peers don't.
+    b = s.serialize( request, token );
+    b.pop_back();
+    check_sender_version( b, kd::header::V1 );
+
+    // Unknown versions are capped.
+    b.push_back( 0xff );
+    check_sender_version( b, kd::get_latest_version() );
 }
 
 BOOST_AUTO_TEST_CASE( can_serialize_a_message_without_body )
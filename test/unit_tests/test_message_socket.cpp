@@ -23,12 +23,15 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <functional>
+#include <vector>
 #include <boost/asio/ip/udp.hpp>
 
 #include <kademlia/endpoint.hpp>
 
 #include "kademlia/ip_endpoint.hpp"
 #include "kademlia/message_socket.hpp"
+#include "kademlia/reception_buffer_pool.hpp"
 
 #include "common.hpp"
 #include "network.hpp"
@@ -103,7 +106,8 @@ BOOST_AUTO_TEST_CASE( ipv4_socket_can_be_created )
                               , k::test::get_temporary_listening_port() );
 
     BOOST_REQUIRE_NO_THROW(
-        message_socket_type::ipv4( io_service, endpoint );
+        message_socket_type::ipv4( kd::get_default_strand( io_service )
+                                 , endpoint );
     );
 }
 
@@ -115,11 +119,62 @@ BOOST_AUTO_TEST_CASE( ipv6_socket_can_be_created )
                               , k::test::get_temporary_listening_port() );
 
     BOOST_REQUIRE_NO_THROW(
-        message_socket_type::ipv6( io_service, endpoint );
+        message_socket_type::ipv6( kd::get_default_strand( io_service )
+                                 , endpoint );
     );
 }
 
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( sockets_can_share_a_reception_buffer_pool )
+{
+    boost::asio::io_service io_service;
+    auto & s = kd::get_default_strand( io_service );
+    kd::reception_buffer_pool buffers{ message_socket_type::INPUT_BUFFER_SIZE };
+
+    auto const port1 = k::test::get_temporary_listening_port();
+    auto const port2 = k::test::get_temporary_listening_port( port1 );
+    auto sender = message_socket_type::ipv4( s, k::endpoint{ "127.0.0.1", port1 }
+                                           , &buffers );
+    auto receiver = message_socket_type::ipv4( s, k::endpoint{ "127.0.0.1", port2 }
+                                             , &buffers );
+
+    std::vector< kd::buffer > received_messages;
+    std::function< void ( std::error_code const&
+                        , kd::ip_endpoint const&
+                        , kd::buffer::const_iterator
+                        , kd::buffer::const_iterator ) > on_receive;
+    on_receive = [ & ]( std::error_code const& failure
+                      , kd::ip_endpoint const& sender_endpoint
+                      , kd::buffer::const_iterator i
+                      , kd::buffer::const_iterator e )
+    {
+        BOOST_REQUIRE_MESSAGE( ! failure, failure.message() );
+        BOOST_REQUIRE_EQUAL( port1, sender_endpoint.port_ );
+        received_messages.emplace_back( i, e );
+        if ( received_messages.size() < 2 )
+            receiver.async_receive( on_receive );
+    };
+    receiver.async_receive( on_receive );
+
+    auto const to = receiver.local_endpoint();
+    auto on_send = []( std::error_code const& failure )
+    { BOOST_REQUIRE_MESSAGE( ! failure, failure.message() ); };
+    sender.async_send( kd::buffer{ 1, 2, 3 }, to, on_send );
+    sender.async_send( kd::buffer{ 4, 5 }, to, on_send );
+
+    while ( received_messages.size() < 2 )
+        io_service.run_one();
+
+    BOOST_REQUIRE( received_messages[ 0 ] == ( kd::buffer{ 1, 2, 3 } ) );
+    BOOST_REQUIRE( received_messages[ 1 ] == ( kd::buffer{ 4, 5 } ) );
+    // The buffer is given back once each message is handled.
+    BOOST_REQUIRE_EQUAL( 1, buffers.buffers_count() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 }
 
@@ -69,8 +69,8 @@ BOOST_AUTO_TEST_CASE( schedule_receive_on_construction )
 {
     using namespace std::placeholders;
     network_type m{ io_service_
-                  , socket_type::ipv4( io_service_, ipv4_ )
-                  , socket_type::ipv6( io_service_, ipv6_ )
+                  , socket_type::ipv4( kd::get_default_strand( io_service_ ), ipv4_ )
+                  , socket_type::ipv6( kd::get_default_strand( io_service_ ), ipv6_ )
                   , std::bind( &fixture::on_message_received
                              , this
                              , _1, _2, _3 ) };
@@ -0,0 +1,151 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include "kademlia/request_decoder.hpp"
+#include "kademlia/message.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+struct handler
+{
+    handler
+        ( void )
+            : pings_count_{}
+            , find_peer_requests_count_{}
+            , other_requests_count_{}
+            , invalid_requests_count_{}
+            , responses_count_{}
+            , peer_to_find_id_{}
+    { }
+
+    void
+    handle_request
+        ( kd::header const& )
+    { ++ pings_count_; }
+
+    void
+    handle_request
+        ( kd::header const&
+        , kd::find_peer_request_body && request )
+    {
+        ++ find_peer_requests_count_;
+        peer_to_find_id_ = request.peer_to_find_id_;
+    }
+
+    template< typename BodyType >
+    void
+    handle_request
+        ( kd::header const&
+        , BodyType && )
+    { ++ other_requests_count_; }
+
+    void
+    handle_invalid_request
+        ( kd::header const&
+        , std::error_code const& )
+    { ++ invalid_requests_count_; }
+
+    void
+    handle_response
+        ( kd::header const&
+        , kd::buffer::const_iterator
+        , kd::buffer::const_iterator )
+    { ++ responses_count_; }
+
+    std::size_t pings_count_;
+    std::size_t find_peer_requests_count_;
+    std::size_t other_requests_count_;
+    std::size_t invalid_requests_count_;
+    std::size_t responses_count_;
+    kd::id peer_to_find_id_;
+};
+
+kd::header
+create_header
+    ( kd::header::type type )
+{ return kd::header{ kd::header::V1, type, kd::id{}, kd::id{}, false }; }
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( requests_are_forwarded_deserialized )
+{
+    handler h;
+
+    kd::buffer b;
+    kd::decode_request( create_header( kd::header::PING_REQUEST )
+                      , b.begin(), b.end(), h );
+    BOOST_REQUIRE_EQUAL( 1, h.pings_count_ );
+
+    kd::id const searched_id{ "1234" };
+    kd::serialize( kd::find_peer_request_body{ searched_id }, b );
+    kd::decode_request( create_header( kd::header::FIND_PEER_REQUEST )
+                      , b.begin(), b.end(), h );
+    BOOST_REQUIRE_EQUAL( 1, h.find_peer_requests_count_ );
+    BOOST_REQUIRE_EQUAL( searched_id, h.peer_to_find_id_ );
+
+    b.clear();
+    kd::serialize( kd::find_chunk_request_body{ searched_id, 1, 2 }, b );
+    kd::decode_request( create_header( kd::header::FIND_CHUNK_REQUEST )
+                      , b.begin(), b.end(), h );
+    BOOST_REQUIRE_EQUAL( 1, h.other_requests_count_ );
+    BOOST_REQUIRE_EQUAL( 0, h.invalid_requests_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( truncated_requests_are_reported )
+{
+    handler h;
+
+    kd::buffer b;
+    kd::serialize( kd::find_peer_request_body{ kd::id{ "1234" } }, b );
+    b.pop_back();
+    kd::decode_request( create_header( kd::header::FIND_PEER_REQUEST )
+                      , b.begin(), b.end(), h );
+
+    BOOST_REQUIRE_EQUAL( 1, h.invalid_requests_count_ );
+    BOOST_REQUIRE_EQUAL( 0, h.find_peer_requests_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( responses_are_forwarded_undecoded )
+{
+    handler h;
+
+    // Its task knows what to expect.
+    kd::buffer const b{ 1, 2, 3 };
+    kd::decode_request( create_header( kd::header::FIND_VALUE_RESPONSE )
+                      , b.begin(), b.end(), h );
+
+    BOOST_REQUIRE_EQUAL( 1, h.responses_count_ );
+    BOOST_REQUIRE_EQUAL( 0, h.invalid_requests_count_ );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
@@ -38,7 +38,7 @@ namespace kd = k::detail;
  */
 BOOST_AUTO_TEST_SUITE( test_construction )
 
-BOOST_AUTO_TEST_CASE( can_be_constructed_using_a_reactor )
+BOOST_AUTO_TEST_CASE( router_can_be_constructed_using_a_reactor )
 {
     boost::asio::io_service io_service;
     BOOST_REQUIRE_NO_THROW( kd::response_router{ io_service } );
@@ -66,7 +66,7 @@ struct fixture
  */
 BOOST_AUTO_TEST_SUITE( test_usage )
 
-BOOST_FIXTURE_TEST_CASE( known_messages_are_forwarded, fixture )
+BOOST_FIXTURE_TEST_CASE( router_known_messages_are_forwarded, fixture )
 {
     // Create the callbacks.
     auto on_message_received = [ this ]
@@ -103,11 +103,99 @@ BOOST_AUTO_TEST_CASE( session_throw_on_invalid_ipv4_address )
                        , std::exception );
 }
 
+BOOST_AUTO_TEST_CASE( session_throw_on_invalid_configuration )
+{
+    std::uint16_t const port1 = k::test::get_temporary_listening_port();
+    std::uint16_t const port2 = k::test::get_temporary_listening_port( port1 );
+    k::endpoint ipv4_endpoint{ "127.0.0.1", port1 };
+    k::endpoint ipv6_endpoint{ "::1", port2 };
+
+    k::configuration k_config;
+    k_config.k_bucket_size( 0 );
+
+    k::configuration window_config;
+    window_config.chunk_window_size( 0 );
+
+    k::configuration republish_config;
+    republish_config.republish_batch_interval( std::chrono::milliseconds::zero() );
+
+    k::endpoint const initial_peer{ "127.0.0.1", 12345 };
+    for ( auto const& config : { k_config, window_config, republish_config } )
+    {
+        try
+        {
+            k::session s( initial_peer, ipv4_endpoint, ipv6_endpoint, config );
+            BOOST_FAIL( "the session has been constructed" );
+        }
+        catch ( std::system_error const& e )
+        {
+            BOOST_REQUIRE( e.code() == k::INVALID_CONFIGURATION );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( session_throw_on_unreachable_quorums )
+{
+    std::uint16_t const port1 = k::test::get_temporary_listening_port();
+    std::uint16_t const port2 = k::test::get_temporary_listening_port( port1 );
+    k::endpoint ipv4_endpoint{ "127.0.0.1", port1 };
+    k::endpoint ipv6_endpoint{ "::1", port2 };
+
+    // More acks or agreeing replicas than replicas are required.
+    k::configuration write_config;
+    write_config.redundant_save_count( 2 );
+    write_config.write_quorum( 3 );
+
+    k::configuration read_config;
+    read_config.redundant_save_count( 2 );
+    read_config.read_quorum( 3 );
+
+    k::endpoint const initial_peer{ "127.0.0.1", 12345 };
+    for ( auto const& config : { write_config, read_config } )
+    {
+        try
+        {
+            k::session s( initial_peer, ipv4_endpoint, ipv6_endpoint, config );
+            BOOST_FAIL( "the session has been constructed" );
+        }
+        catch ( std::system_error const& e )
+        {
+            BOOST_REQUIRE( e.code() == k::INVALID_CONFIGURATION );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( session_accepts_custom_configuration )
+{
+    std::uint16_t const port1 = k::test::get_temporary_listening_port();
+    std::uint16_t const port2 = k::test::get_temporary_listening_port( port1 );
+    k::endpoint ipv4_endpoint{ "127.0.0.1", port1 };
+    k::endpoint ipv6_endpoint{ "::1", port2 };
+
+    k::configuration config;
+    config.k_bucket_size( 8 );
+    config.concurrent_requests_count( 5 );
+    config.redundant_save_count( 2 );
+    config.write_quorum( 2 );
+    config.read_quorum( 2 );
+    config.initial_contact_timeout( std::chrono::milliseconds{ 500 } );
+    config.peer_lookup_timeout( std::chrono::milliseconds{ 100 } );
+    config.chunk_window_size( 2 );
+    config.value_cache_capacity( 0 );
+    config.republish_batch_interval( std::chrono::milliseconds{ 50 } );
+
+    k::endpoint const initial_peer{ "127.0.0.1", 12345 };
+    k::session s{ initial_peer, ipv4_endpoint, ipv6_endpoint, config };
+
+    k::test::check_listening( "127.0.0.1", port1 );
+    k::test::check_listening( "::1", port2 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE( test_usage )
 
-BOOST_AUTO_TEST_CASE( first_session_run_can_be_aborted )
+BOOST_AUTO_TEST_CASE( session_run_can_be_aborted )
 {
     k::endpoint const initial_peer{ "127.0.0.1", 12345 };
     k::session s{ initial_peer };
@@ -119,6 +207,18 @@ BOOST_AUTO_TEST_CASE( first_session_run_can_be_aborted )
     BOOST_REQUIRE( result.get() == k::RUN_ABORTED );
 }
 
+BOOST_AUTO_TEST_CASE( session_run_with_threads_can_be_aborted )
+{
+    k::endpoint const initial_peer{ "127.0.0.1", 12345 };
+    k::session s{ initial_peer };
+
+    auto result = std::async( std::launch::async
+                            , &k::session::run_with_threads, &s, 4 );
+    s.abort();
+
+    BOOST_REQUIRE( result.get() == k::RUN_ABORTED );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -0,0 +1,140 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <array>
+#include <memory>
+
+#include "kademlia/small_function.hpp"
+
+#include "allocations.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+
+using function_type = kd::small_function< int ( int ) >;
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_construction )
+
+BOOST_AUTO_TEST_CASE( default_constructed_functions_are_empty )
+{
+    function_type const f;
+    BOOST_REQUIRE( ! f );
+}
+
+BOOST_AUTO_TEST_CASE( small_callables_are_stored_inline )
+{
+    int const offset = 1;
+
+    auto const allocations_before = t::get_allocations_count();
+    function_type const f{ [ offset ]( int i ) { return i + offset; } };
+    BOOST_REQUIRE_EQUAL( allocations_before, t::get_allocations_count() );
+
+    BOOST_REQUIRE( f );
+    BOOST_REQUIRE_EQUAL( 3, f( 2 ) );
+}
+
+BOOST_AUTO_TEST_CASE( large_callables_are_stored_on_the_heap )
+{
+    std::array< int, 64 > offsets{};
+    offsets.back() = 1;
+
+    auto const allocations_before = t::get_allocations_count();
+    function_type const f{ [ offsets ]( int i ) { return i + offsets.back(); } };
+    BOOST_REQUIRE_EQUAL( allocations_before + 1, t::get_allocations_count() );
+
+    BOOST_REQUIRE_EQUAL( 3, f( 2 ) );
+}
+
+BOOST_AUTO_TEST_CASE( move_only_callables_can_be_stored )
+{
+    struct move_only_callable
+    {
+        int operator()( int i ) const { return i + *offset_; }
+        std::unique_ptr< int > offset_;
+    };
+
+    std::unique_ptr< int > offset{ new int{ 1 } };
+    function_type f{ move_only_callable{ std::move( offset ) } };
+    BOOST_REQUIRE_EQUAL( 3, f( 2 ) );
+
+    function_type const g{ std::move( f ) };
+    BOOST_REQUIRE_EQUAL( 3, g( 2 ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( moved_from_functions_are_empty )
+{
+    std::array< int, 64 > offsets{};
+    offsets.back() = 1;
+
+    function_type f{ []( int i ) { return i; } };
+    function_type g{ [ offsets ]( int i ) { return i + offsets.back(); } };
+
+    function_type h{ std::move( f ) };
+    BOOST_REQUIRE( ! f );
+    BOOST_REQUIRE_EQUAL( 2, h( 2 ) );
+
+    h = std::move( g );
+    BOOST_REQUIRE( ! g );
+    BOOST_REQUIRE_EQUAL( 3, h( 2 ) );
+}
+
+BOOST_AUTO_TEST_CASE( callables_are_destroyed_with_the_function )
+{
+    auto const counter = std::make_shared< int >();
+    std::array< int, 64 > padding{};
+
+    {
+        function_type const f{ [ counter ]( int i ) { return i; } };
+        function_type const g{ [ counter, padding ]( int i )
+                               { return i + padding.back(); } };
+        BOOST_REQUIRE_EQUAL( 3, counter.use_count() );
+    }
+
+    BOOST_REQUIRE_EQUAL( 1, counter.use_count() );
+
+    function_type f{ [ counter ]( int i ) { return i; } };
+    f = function_type{};
+    BOOST_REQUIRE_EQUAL( 1, counter.use_count() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
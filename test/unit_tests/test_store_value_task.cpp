@@ -63,7 +63,7 @@ struct fixture : k::test::task_fixture
 
 BOOST_FIXTURE_TEST_SUITE( test_usage, fixture )
 
-BOOST_AUTO_TEST_CASE( can_notify_error_when_routing_table_is_empty )
+BOOST_AUTO_TEST_CASE( store_can_notify_error_when_routing_table_is_empty )
 {
     kd::id const chosen_key{ "a" };
     kd::buffer const data{ 1, 2, 3, 4 };
@@ -90,7 +90,7 @@ BOOST_AUTO_TEST_CASE( can_notify_error_when_routing_table_is_empty )
     BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
 }
 
-BOOST_AUTO_TEST_CASE( can_notify_error_when_unique_peer_fails_to_respond )
+BOOST_AUTO_TEST_CASE( store_can_notify_error_when_unique_peer_fails_to_respond )
 {
     kd::id const chosen_key{ "a" };
     kd::buffer const data{ 1, 2, 3, 4 };
@@ -120,7 +120,7 @@ BOOST_AUTO_TEST_CASE( can_notify_error_when_unique_peer_fails_to_respond )
     BOOST_REQUIRE( failure_ == k::INITIAL_PEER_FAILED_TO_RESPOND );
 }
 
-BOOST_AUTO_TEST_CASE( can_notify_error_when_all_peers_fail_to_respond )
+BOOST_AUTO_TEST_CASE( store_can_notify_error_when_all_peers_fail_to_respond )
 {
     kd::id const chosen_key{ "a" };
     kd::buffer const data{ 1, 2, 3, 4 };
@@ -154,6 +154,8 @@ BOOST_AUTO_TEST_CASE( can_notify_error_when_all_peers_fail_to_respond )
 
 BOOST_AUTO_TEST_CASE( can_store_value_when_already_known_peer_is_the_target )
 {
+    tracker_.set_peer_version( kd::header::V2 );
+
     kd::id const chosen_key{ "a" };
     kd::buffer const data{ 1, 2, 3, 4 };
     routing_table_.expected_ids_.emplace_back( chosen_key );
@@ -161,6 +163,8 @@ BOOST_AUTO_TEST_CASE( can_store_value_when_already_known_peer_is_the_target )
     auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
     kd::find_peer_response_body const b1{};
     tracker_.add_message_to_receive( p1.endpoint_, p1.id_, b1 );
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_
+                                   , kd::store_value_response_body{} );
     kd::start_store_value_task< data_type >( chosen_key
                                            , data
                                            , tracker_
@@ -177,7 +181,9 @@ BOOST_AUTO_TEST_CASE( can_store_value_when_already_known_peer_is_the_target )
 
     // Task decided that p1 was the closest
     // hence it asked to store data on it.
-    kd::store_value_request_body const sv{ chosen_key, data };
+    kd::store_value_request_body const sv{ chosen_key, data
+                                         , std::chrono::seconds::zero()
+                                         , 0, false, true };
     BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, sv ) );
 
     // Task didn't send any more message.
@@ -190,6 +196,8 @@ BOOST_AUTO_TEST_CASE( can_store_value_when_already_known_peer_is_the_target )
 
 BOOST_AUTO_TEST_CASE( can_store_value_when_discovered_peer_is_the_target )
 {
+    tracker_.set_peer_version( kd::header::V2 );
+
     kd::id const chosen_key{ "a" };
     kd::buffer const data{ 1, 2, 3, 4 };
     routing_table_.expected_ids_.emplace_back( chosen_key );
@@ -210,6 +218,11 @@ BOOST_AUTO_TEST_CASE( can_store_value_when_discovered_peer_is_the_target )
     kd::find_peer_response_body const fp2{};
     tracker_.add_message_to_receive( e2, i2, fp2 );
 
+    // Both acknowledge the store.
+    kd::store_value_response_body const sr{};
+    tracker_.add_message_to_receive( e2, i2, sr );
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, sr );
+
     kd::start_store_value_task< data_type >( chosen_key
                                            , data
                                            , tracker_
@@ -229,7 +242,9 @@ BOOST_AUTO_TEST_CASE( can_store_value_when_discovered_peer_is_the_target )
 
     // Task decided that p2 was the closest
     // hence it asked to store data on it.
-    kd::store_value_request_body const sv{ chosen_key, data };
+    kd::store_value_request_body const sv{ chosen_key, data
+                                         , std::chrono::seconds::zero()
+                                         , 0, false, true };
     BOOST_REQUIRE( tracker_.has_sent_message( e2, sv ) );
 
     // Task is also required to store data 
@@ -244,7 +259,201 @@ BOOST_AUTO_TEST_CASE( can_store_value_when_discovered_peer_is_the_target )
     BOOST_REQUIRE( ! failure_ );
 }
 
-BOOST_AUTO_TEST_CASE( can_skip_wrong_response )
+BOOST_AUTO_TEST_CASE( store_can_notify_error_when_quorum_is_not_reached )
+{
+    tracker_.set_peer_version( kd::header::V2 );
+
+    kd::id const chosen_key{ "a" };
+    kd::buffer const data{ 1, 2, 3, 4 };
+    routing_table_.expected_ids_.emplace_back( chosen_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_
+                                   , kd::find_peer_response_body{} );
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_
+                                   , kd::store_value_response_body{} );
+
+    kd::start_store_value_task< data_type >( chosen_key
+                                           , data
+                                           , tracker_
+                                           , routing_table_
+                                           , std::ref( *this )
+                                           , 2 );
+    io_service_.poll();
+
+    kd::find_peer_request_body const fv{ chosen_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    kd::store_value_request_body const sv{ chosen_key, data
+                                         , std::chrono::seconds::zero()
+                                         , 0, false, true };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+
+    // Only p1 acknowledged the store, and no other peer is known.
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( failure_ == k::QUORUM_NOT_REACHED );
+}
+
+BOOST_AUTO_TEST_CASE( store_can_replace_replica_that_fails_to_acknowledge )
+{
+    tracker_.set_peer_version( kd::header::V2 );
+
+    kd::id const chosen_key{ "a" };
+    kd::buffer const data{ 1, 2, 3, 4 };
+    routing_table_.expected_ids_.emplace_back( chosen_key );
+
+    // From the closest to the farthest from the key.
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    auto p2 = create_and_add_peer( "192.168.1.2", kd::id{ "8" } );
+    auto p3 = create_and_add_peer( "192.168.1.3", kd::id{ "9" } );
+    auto p4 = create_and_add_peer( "192.168.1.4", kd::id{ "e" } );
+
+    kd::find_peer_response_body const fp{};
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, fp );
+    tracker_.add_message_to_receive( p2.endpoint_, p2.id_, fp );
+    tracker_.add_message_to_receive( p3.endpoint_, p3.id_, fp );
+    tracker_.add_message_to_receive( p4.endpoint_, p4.id_, fp );
+
+    // p2 never acknowledges the store.
+    kd::store_value_response_body const sr{};
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_, sr );
+    tracker_.add_message_to_receive( p3.endpoint_, p3.id_, sr );
+    tracker_.add_message_to_receive( p4.endpoint_, p4.id_, sr );
+
+    kd::start_store_value_task< data_type >( chosen_key
+                                           , data
+                                           , tracker_
+                                           , routing_table_
+                                           , std::ref( *this )
+                                           , 3 );
+    io_service_.poll();
+
+    kd::find_peer_request_body const fv{ chosen_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p3.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p4.endpoint_, fv ) );
+
+    // The three closest peers are asked to store the value.
+    kd::store_value_request_body const sv{ chosen_key, data
+                                         , std::chrono::seconds::zero()
+                                         , 0, false, true };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, sv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p2.endpoint_, sv ) );
+    BOOST_REQUIRE( tracker_.has_sent_message( p3.endpoint_, sv ) );
+
+    // Then p4 replaces p2.
+    BOOST_REQUIRE( tracker_.has_sent_message( p4.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+}
+
+BOOST_AUTO_TEST_CASE( store_uses_the_configured_redundant_save_count )
+{
+    k::configuration config;
+    config.redundant_save_count( 1 );
+    k::test::tracker_mock tracker{ io_service_, config };
+    tracker.set_peer_version( kd::header::V2 );
+
+    kd::id const chosen_key{ "a" };
+    kd::buffer const data{ 1, 2, 3, 4 };
+    routing_table_.expected_ids_.emplace_back( chosen_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    auto p2 = create_and_add_peer( "192.168.1.2", kd::id{ "8" } );
+
+    kd::find_peer_response_body const fp{};
+    tracker.add_message_to_receive( p1.endpoint_, p1.id_, fp );
+    tracker.add_message_to_receive( p2.endpoint_, p2.id_, fp );
+    tracker.add_message_to_receive( p1.endpoint_, p1.id_
+                                  , kd::store_value_response_body{} );
+
+    kd::start_store_value_task< data_type >( chosen_key
+                                           , data
+                                           , tracker
+                                           , routing_table_
+                                           , std::ref( *this )
+                                           , 3 );
+    io_service_.poll();
+
+    kd::find_peer_request_body const fv{ chosen_key };
+    BOOST_REQUIRE( tracker.has_sent_message( p1.endpoint_, fv ) );
+    BOOST_REQUIRE( tracker.has_sent_message( p2.endpoint_, fv ) );
+
+    // Only the closest peer is asked to store the value,
+    // and the quorum is bounded by the replicas count.
+    kd::store_value_request_body const sv{ chosen_key, data
+                                         , std::chrono::seconds::zero()
+                                         , 0, false, true };
+    BOOST_REQUIRE( tracker.has_sent_message( p1.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker.has_sent_message() );
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+}
+
+BOOST_AUTO_TEST_CASE( store_to_v1_peers_is_not_acknowledged )
+{
+    kd::id const chosen_key{ "a" };
+    kd::buffer const data{ 1, 2, 3, 4 };
+    routing_table_.expected_ids_.emplace_back( chosen_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_
+                                   , kd::find_peer_response_body{} );
+
+    kd::start_store_value_task< data_type >( chosen_key
+                                           , data
+                                           , tracker_
+                                           , routing_table_
+                                           , std::ref( *this ) );
+    io_service_.poll();
+
+    kd::find_peer_request_body const fv{ chosen_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+
+    // p1 is sent the value without being asked for an ack.
+    kd::store_value_request_body const sv{ chosen_key, data };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+
+    // Hence it counts as stored once sent.
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+}
+
+BOOST_AUTO_TEST_CASE( large_values_are_stored_whole_to_v1_peers )
+{
+    kd::id const chosen_key{ "a" };
+    data_type const data( 4 * kd::CHUNK_SIZE, 'a' );
+    routing_table_.expected_ids_.emplace_back( chosen_key );
+
+    auto p1 = create_and_add_peer( "192.168.1.1", kd::id{ "b" } );
+    tracker_.add_message_to_receive( p1.endpoint_, p1.id_
+                                   , kd::find_peer_response_body{} );
+
+    kd::start_store_value_task< data_type >( chosen_key
+                                           , data
+                                           , tracker_
+                                           , routing_table_
+                                           , std::ref( *this ) );
+    io_service_.poll();
+
+    kd::find_peer_request_body const fv{ chosen_key };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, fv ) );
+
+    // p1 may not know chunks.
+    kd::store_value_request_body const sv{ chosen_key, data };
+    BOOST_REQUIRE( tracker_.has_sent_message( p1.endpoint_, sv ) );
+    BOOST_REQUIRE( ! tracker_.has_sent_message() );
+
+    BOOST_REQUIRE_EQUAL( 1, callback_call_count_ );
+    BOOST_REQUIRE( ! failure_ );
+}
+
+BOOST_AUTO_TEST_CASE( store_can_skip_wrong_response )
 {
     kd::id const chosen_key{ "a" };
     kd::buffer const data{ 1, 2, 3, 4 };
@@ -269,7 +478,7 @@ BOOST_AUTO_TEST_CASE( can_skip_wrong_response )
     BOOST_REQUIRE( failure_ == k::INITIAL_PEER_FAILED_TO_RESPOND );
 }
 
-BOOST_AUTO_TEST_CASE( can_skip_corrupted_response )
+BOOST_AUTO_TEST_CASE( store_can_skip_corrupted_response )
 {
     kd::id const chosen_key{ "a" };
     kd::buffer const data{ 1, 2, 3, 4 };
@@ -0,0 +1,137 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <memory>
+
+#include <boost/asio/io_service.hpp>
+
+#include "kademlia/strand.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+/// Counts its copies.
+struct copy_counter
+{
+    explicit
+    copy_counter
+        ( std::size_t & copies_count )
+            : copies_count_( &copies_count )
+    { }
+
+    copy_counter
+        ( copy_counter const& other )
+            : copies_count_( other.copies_count_ )
+    { ++ *copies_count_; }
+
+    copy_counter
+        ( copy_counter && other )
+            : copies_count_( other.copies_count_ )
+    { }
+
+    std::size_t * copies_count_;
+};
+
+struct handler
+{
+    void
+    operator()
+        ( copy_counter const& )
+        const
+    { ++ *calls_count_; }
+
+    std::size_t * calls_count_;
+    copy_counter counter_;
+};
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( single_threaded_calls_copy_nothing )
+{
+    boost::asio::io_service io_service;
+    kd::strand strand{ io_service };
+
+    std::size_t calls_count = 0, handler_copies_count = 0, arg_copies_count = 0;
+    auto const wrapped = strand.wrap( handler{ &calls_count
+                                             , copy_counter{ handler_copies_count } } );
+    auto const copies_count_once_wrapped = handler_copies_count;
+
+    copy_counter const arg{ arg_copies_count };
+    wrapped( arg );
+    wrapped( copy_counter{ arg_copies_count } );
+
+    BOOST_REQUIRE_EQUAL( 2, calls_count );
+    BOOST_REQUIRE_EQUAL( copies_count_once_wrapped, handler_copies_count );
+    BOOST_REQUIRE_EQUAL( 0, arg_copies_count );
+}
+
+BOOST_AUTO_TEST_CASE( concurrent_calls_are_deferred_to_the_strand )
+{
+    boost::asio::io_service io_service;
+    kd::get_strand_service( io_service ).set_concurrent( true );
+    kd::strand strand{ io_service };
+
+    std::size_t calls_count = 0, handler_copies_count = 0, arg_copies_count = 0;
+    auto const wrapped = strand.wrap( handler{ &calls_count
+                                             , copy_counter{ handler_copies_count } } );
+
+    // Rvalue arguments are moved.
+    wrapped( copy_counter{ arg_copies_count } );
+    BOOST_REQUIRE_EQUAL( 0, calls_count );
+    BOOST_REQUIRE_EQUAL( 0, arg_copies_count );
+
+    io_service.run();
+    BOOST_REQUIRE_EQUAL( 1, calls_count );
+}
+
+BOOST_AUTO_TEST_CASE( handlers_outliving_their_strand_are_dropped )
+{
+    for ( auto const is_concurrent : { false, true } )
+    {
+        boost::asio::io_service io_service;
+        kd::get_strand_service( io_service ).set_concurrent( is_concurrent );
+
+        std::size_t calls_count = 0;
+        auto on_call = [ &calls_count ]( void ) { ++ calls_count; };
+
+        std::unique_ptr< kd::strand > strand{ new kd::strand{ io_service } };
+        auto const wrapped = strand->wrap( on_call );
+        strand->post( on_call );
+        strand.reset();
+
+        wrapped();
+        io_service.run();
+        BOOST_REQUIRE_EQUAL( 0, calls_count );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
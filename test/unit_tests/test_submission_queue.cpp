@@ -0,0 +1,147 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "kademlia/submission_queue.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+struct fixture
+{
+    fixture()
+        : io_service_{}
+        , queue_{ kd::get_default_strand( io_service_ ), 4 }
+        , executed_tasks_{}
+    { }
+
+    boost::asio::io_service io_service_;
+    kd::submission_queue queue_;
+    std::vector< std::size_t > executed_tasks_;
+};
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_FIXTURE_TEST_CASE( tasks_are_executed_by_the_io_service, fixture )
+{
+    queue_.push( [ this ]( void ) { executed_tasks_.push_back( 0 ); } );
+    BOOST_REQUIRE( executed_tasks_.empty() );
+
+    BOOST_REQUIRE_EQUAL( 1, io_service_.poll() );
+    BOOST_REQUIRE_EQUAL( 1, executed_tasks_.size() );
+    BOOST_REQUIRE_EQUAL( 1, queue_.drains_count() );
+    BOOST_REQUIRE_EQUAL( 1, queue_.executed_tasks_count() );
+}
+
+BOOST_FIXTURE_TEST_CASE( tasks_are_executed_by_batches_in_order, fixture )
+{
+    for ( std::size_t i = 0; i < 10; ++ i )
+        queue_.push( [ this, i ]( void ) { executed_tasks_.push_back( i ); } );
+
+    // One drain per batch of 4 tasks.
+    BOOST_REQUIRE_EQUAL( 1, io_service_.run_one() );
+    BOOST_REQUIRE_EQUAL( 4, executed_tasks_.size() );
+
+    BOOST_REQUIRE_EQUAL( 2, io_service_.poll() );
+    BOOST_REQUIRE_EQUAL( 3, queue_.drains_count() );
+    BOOST_REQUIRE_EQUAL( 10, queue_.executed_tasks_count() );
+
+    for ( std::size_t i = 0; i < executed_tasks_.size(); ++ i )
+        BOOST_REQUIRE_EQUAL( i, executed_tasks_[ i ] );
+}
+
+BOOST_FIXTURE_TEST_CASE( tasks_can_push_tasks, fixture )
+{
+    auto push_next = [ this ]( void )
+    {
+        executed_tasks_.push_back( 0 );
+        queue_.push( [ this ]( void ) { executed_tasks_.push_back( 1 ); } );
+    };
+    queue_.push( push_next );
+
+    BOOST_REQUIRE_EQUAL( 2, io_service_.poll() );
+    BOOST_REQUIRE_EQUAL( 2, executed_tasks_.size() );
+    BOOST_REQUIRE_EQUAL( 1, executed_tasks_[ 1 ] );
+}
+
+BOOST_FIXTURE_TEST_CASE( pending_tasks_are_released_on_destruction, fixture )
+{
+    auto const counter = std::make_shared< int >();
+    {
+        kd::submission_queue queue{ kd::get_default_strand( io_service_ ), 4 };
+        queue.push( [ counter ]( void ) {} );
+        BOOST_REQUIRE_EQUAL( 2, counter.use_count() );
+    }
+
+    BOOST_REQUIRE_EQUAL( 1, counter.use_count() );
+}
+
+BOOST_FIXTURE_TEST_CASE( tasks_can_be_pushed_from_multiple_threads, fixture )
+{
+    std::size_t const producers_count = 4;
+    std::size_t const tasks_count = 1000;
+
+    std::vector< std::thread > producers;
+    for ( std::size_t i = 0; i < producers_count; ++ i )
+        producers.emplace_back( [ this, i, tasks_count ]( void )
+        {
+            for ( std::size_t j = 0; j < tasks_count; ++ j )
+                queue_.push( [ this, i ]( void )
+                             { executed_tasks_.push_back( i ); } );
+        } );
+
+    // Consume while the producers are pushing.
+    boost::asio::io_service::work work{ io_service_ };
+    std::thread consumer{ [ this ]( void ) { io_service_.run(); } };
+
+    for ( auto & producer : producers )
+        producer.join();
+
+    while ( queue_.executed_tasks_count() < producers_count * tasks_count )
+        std::this_thread::yield();
+
+    io_service_.stop();
+    consumer.join();
+
+    BOOST_REQUIRE_EQUAL( producers_count * tasks_count
+                       , executed_tasks_.size() );
+    BOOST_REQUIRE_GE( producers_count * tasks_count
+                    , queue_.drains_count() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
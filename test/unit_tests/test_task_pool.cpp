@@ -0,0 +1,87 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <vector>
+
+#include "kademlia/task_pool.hpp"
+
+#include "allocations.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+namespace t = k::test;
+
+struct task final
+    : kd::pooled_task< task >
+{
+    char payload_[ 128 ];
+};
+
+/**
+ *
+ */
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( destroyed_tasks_storage_is_reused )
+{
+    auto const first = new task;
+    delete first;
+
+    auto const allocations_before = t::get_allocations_count();
+    auto const second = new task;
+    BOOST_REQUIRE_EQUAL( allocations_before, t::get_allocations_count() );
+    BOOST_REQUIRE_EQUAL( first, second );
+
+    delete second;
+}
+
+BOOST_AUTO_TEST_CASE( pooled_storage_is_bounded )
+{
+    std::vector< task * > tasks;
+    for ( std::size_t i = 0; i < kd::TASK_POOL_CAPACITY + 1; ++ i )
+        tasks.push_back( new task );
+
+    for ( auto i : tasks )
+        delete i;
+
+    // Only the first TASK_POOL_CAPACITY tasks are recycled.
+    auto const allocations_before = t::get_allocations_count();
+    tasks.clear();
+    for ( std::size_t i = 0; i < kd::TASK_POOL_CAPACITY + 1; ++ i )
+        tasks.push_back( new task );
+    BOOST_REQUIRE_EQUAL( allocations_before + 1, t::get_allocations_count() );
+
+    for ( auto i : tasks )
+        delete i;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
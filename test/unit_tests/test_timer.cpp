@@ -28,6 +28,7 @@
 #include <vector>
 #include "kademlia/error_impl.hpp"
 
+#include "kademlia/strand.hpp"
 #include "kademlia/timer.hpp"
 #include "kademlia/log.hpp"
 
@@ -40,7 +41,7 @@ namespace kd = k::detail;
  */
 BOOST_AUTO_TEST_SUITE( test_construction )
 
-BOOST_AUTO_TEST_CASE( can_be_constructed_using_a_reactor )
+BOOST_AUTO_TEST_CASE( timer_can_be_constructed_using_a_reactor )
 {
     boost::asio::io_service io_service;
     BOOST_REQUIRE_NO_THROW( kd::timer{ io_service } );
@@ -100,6 +101,52 @@ BOOST_FIXTURE_TEST_CASE( multiple_associations_can_be_added, fixture )
     // A timeout (infinite) is still in flight atm.
 }
 
+BOOST_FIXTURE_TEST_CASE( callbacks_can_schedule_new_timeouts, fixture )
+{
+    // This callback reschedules itself as long as
+    // fewer than 3 timeouts have been received.
+    std::function< void ( void ) > on_expiration = [ this, &on_expiration ] ( void )
+    {
+        ++ timeouts_received_;
+        if ( timeouts_received_ < 3 )
+            manager_.expires_from_now( kd::timer::duration::zero()
+                                     , on_expiration );
+    };
+
+    manager_.expires_from_now( kd::timer::duration::zero(), on_expiration );
+
+    // The rescheduled callback waits for the next tick.
+    BOOST_REQUIRE_EQUAL( 1, io_service_.run_one() );
+    BOOST_REQUIRE_EQUAL( 1, timeouts_received_ );
+
+    io_service_.poll();
+    while ( timeouts_received_ < 3 )
+        io_service_.run_one();
+
+    BOOST_REQUIRE_EQUAL( 0, io_service_.poll() );
+    BOOST_REQUIRE_EQUAL( 3, timeouts_received_ );
+}
+
+BOOST_AUTO_TEST_CASE( timers_of_several_strands_can_share_a_queue )
+{
+    boost::asio::io_service io_service;
+    kd::timer_queue queue{ kd::get_default_strand( io_service ) };
+    kd::strand s1{ io_service }, s2{ io_service };
+    kd::timer t1{ s1, &queue }, t2{ s2, &queue };
+
+    std::vector< int > expired_timers;
+    t2.expires_from_now( std::chrono::milliseconds( 2 )
+                       , [ & ]( void ) { expired_timers.push_back( 2 ); } );
+    t1.expires_from_now( std::chrono::milliseconds( 1 )
+                       , [ & ]( void ) { expired_timers.push_back( 1 ); } );
+
+    io_service.run();
+
+    BOOST_REQUIRE_EQUAL( 2, expired_timers.size() );
+    BOOST_REQUIRE_EQUAL( 1, expired_timers[ 0 ] );
+    BOOST_REQUIRE_EQUAL( 2, expired_timers[ 1 ] );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
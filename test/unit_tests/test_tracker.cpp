@@ -0,0 +1,135 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+#include "peer_factory.hpp"
+
+#include <random>
+
+#include <boost/asio/io_service.hpp>
+
+#include "kademlia/tracker.hpp"
+#include "kademlia/constants.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+// The peer versions bookkeeping doesn't send anything.
+struct network_stub final
+{
+    using endpoint_type = kd::ip_endpoint;
+};
+
+using tracker_type = kd::tracker< std::default_random_engine, network_stub >;
+
+struct fixture
+{
+    fixture()
+        : io_service_{}
+        , network_{}
+        , random_engine_{}
+        , configuration_{}
+        , tracker_{ kd::get_default_strand( io_service_ ), kd::id{}, network_, random_engine_
+                  , configuration_ }
+    { }
+
+    static kd::ip_endpoint
+    create_peer_endpoint
+        ( std::size_t i )
+    { return create_endpoint( "10.0.0.1", static_cast< std::uint16_t >( i ) ); }
+
+    boost::asio::io_service io_service_;
+    network_stub network_;
+    std::default_random_engine random_engine_;
+    k::configuration configuration_;
+    tracker_type tracker_;
+};
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_FIXTURE_TEST_CASE( unknown_peers_speak_v1, fixture )
+{
+    auto const e = create_peer_endpoint( 1 );
+    BOOST_REQUIRE( tracker_.get_peer_version( e ) == kd::header::V1 );
+
+    tracker_.record_peer_version( e, kd::header::V2 );
+    BOOST_REQUIRE( tracker_.get_peer_version( e ) == kd::header::V2 );
+}
+
+BOOST_FIXTURE_TEST_CASE( least_recently_heard_peer_version_is_evicted, fixture )
+{
+    auto const capacity = kd::PEER_VERSIONS_CAPACITY;
+    for ( std::size_t i = 1; i <= capacity; ++ i )
+        tracker_.record_peer_version( create_peer_endpoint( i )
+                                    , kd::header::V2 );
+
+    // The first peer is heard from again.
+    tracker_.record_peer_version( create_peer_endpoint( 1 ), kd::header::V2 );
+    tracker_.record_peer_version( create_peer_endpoint( capacity + 1 )
+                                , kd::header::V2 );
+
+    kd::header::version version;
+    BOOST_REQUIRE( tracker_.find_peer_version( create_peer_endpoint( 1 )
+                                             , version ) );
+    BOOST_REQUIRE( ! tracker_.find_peer_version( create_peer_endpoint( 2 )
+                                               , version ) );
+    BOOST_REQUIRE( tracker_.find_peer_version( create_peer_endpoint( 3 )
+                                             , version ) );
+    BOOST_REQUIRE( tracker_.find_peer_version( create_peer_endpoint( capacity + 1 )
+                                             , version ) );
+}
+
+BOOST_FIXTURE_TEST_CASE( peer_version_heard_repeatedly_is_kept, fixture )
+{
+    auto const capacity = kd::PEER_VERSIONS_CAPACITY;
+    auto const talking_peer = create_peer_endpoint( 0 );
+    tracker_.record_peer_version( talking_peer, kd::header::V3 );
+
+    // The talking peer keeps sending messages
+    // while newer peers are heard from.
+    for ( std::size_t i = 1; i <= 2 * capacity; ++ i )
+    {
+        tracker_.record_peer_version( create_peer_endpoint( i )
+                                    , kd::header::V2 );
+        tracker_.touch_peer_version( talking_peer );
+    }
+
+    BOOST_REQUIRE( tracker_.get_peer_version( talking_peer ) == kd::header::V3 );
+    BOOST_REQUIRE( tracker_.get_peer_version( create_peer_endpoint( 1 ) )
+                   == kd::header::V1 );
+
+    // Touching an unknown peer doesn't record it.
+    auto const unknown_peer = create_peer_endpoint( 2 * capacity + 1 );
+    tracker_.touch_peer_version( unknown_peer );
+    kd::header::version version;
+    BOOST_REQUIRE( ! tracker_.find_peer_version( unknown_peer, version ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+
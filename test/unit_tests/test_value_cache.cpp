@@ -0,0 +1,147 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <string>
+
+#include "kademlia/value_cache.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+using cache_type = kd::value_cache< std::string, std::string >;
+
+std::size_t const OVERHEAD = cache_type::get_entry_overhead();
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( cache_can_find_inserted_value )
+{
+    cache_type c{ 4 * OVERHEAD, std::chrono::hours{ 1 } };
+
+    BOOST_REQUIRE( ! c.find( "a" ) );
+    BOOST_REQUIRE_EQUAL( 1, c.get_statistics().misses_count_ );
+
+    c.insert( "a", "123" );
+    BOOST_REQUIRE_EQUAL( OVERHEAD + 3, c.size() );
+
+    auto const v = c.find( "a" );
+    BOOST_REQUIRE( v );
+    BOOST_REQUIRE_EQUAL( "123", *v );
+    BOOST_REQUIRE_EQUAL( 1, c.get_statistics().hits_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( cache_evicts_least_recently_used_values )
+{
+    cache_type c{ 2 * ( OVERHEAD + 4 ), std::chrono::hours{ 1 } };
+
+    c.insert( "a", "123" );
+    c.insert( "b", "456" );
+    // Refresh "a".
+    BOOST_REQUIRE( c.find( "a" ) );
+
+    // There is no room for both "b" and "c".
+    c.insert( "c", "789" );
+
+    BOOST_REQUIRE_EQUAL( 2 * ( OVERHEAD + 3 ), c.size() );
+    BOOST_REQUIRE_EQUAL( 1, c.get_statistics().evictions_count_ );
+    BOOST_REQUIRE( c.find( "a" ) );
+    BOOST_REQUIRE( ! c.find( "b" ) );
+    BOOST_REQUIRE( c.find( "c" ) );
+}
+
+BOOST_AUTO_TEST_CASE( cache_rejects_too_large_values )
+{
+    cache_type c{ 2 * ( OVERHEAD + 4 ), std::chrono::hours{ 1 } };
+
+    c.insert( "a", "123" );
+    c.insert( "b", "123456789" );
+
+    BOOST_REQUIRE( c.find( "a" ) );
+    BOOST_REQUIRE( ! c.find( "b" ) );
+
+    cache_type disabled{ 0, std::chrono::hours{ 1 } };
+    disabled.insert( "a", "" );
+    BOOST_REQUIRE( ! disabled.find( "a" ) );
+}
+
+BOOST_AUTO_TEST_CASE( cache_bounds_empty_values )
+{
+    cache_type c{ 4 * OVERHEAD, std::chrono::hours{ 1 } };
+
+    for ( char k = 'a'; k <= 'z'; ++ k )
+        c.insert( std::string( 1, k ), "" );
+
+    BOOST_REQUIRE_EQUAL( 4 * OVERHEAD, c.size() );
+    BOOST_REQUIRE_EQUAL( 26 - 4, c.get_statistics().evictions_count_ );
+    BOOST_REQUIRE( ! c.find( "a" ) );
+    BOOST_REQUIRE( c.find( "z" ) );
+}
+
+BOOST_AUTO_TEST_CASE( cache_forgets_expired_values )
+{
+    cache_type c{ 4 * OVERHEAD, std::chrono::seconds{ 0 } };
+
+    c.insert( "a", "123" );
+
+    BOOST_REQUIRE( ! c.find( "a" ) );
+    BOOST_REQUIRE_EQUAL( 0, c.size() );
+}
+
+BOOST_AUTO_TEST_CASE( cache_drops_expired_values_on_insert )
+{
+    cache_type c{ 4 * OVERHEAD, std::chrono::seconds{ 0 } };
+
+    // Neither "a" nor "b" is looked up again.
+    c.insert( "a", "123" );
+    c.insert( "b", "456" );
+
+    BOOST_REQUIRE_EQUAL( OVERHEAD + 3, c.size() );
+    BOOST_REQUIRE_EQUAL( 1, c.get_statistics().expirations_count_ );
+    BOOST_REQUIRE_EQUAL( 0, c.get_statistics().evictions_count_ );
+}
+
+BOOST_AUTO_TEST_CASE( cache_can_invalidate_value )
+{
+    cache_type c{ 4 * OVERHEAD, std::chrono::hours{ 1 } };
+
+    c.insert( "a", "123" );
+    c.insert( "a", "45" );
+    BOOST_REQUIRE_EQUAL( OVERHEAD + 2, c.size() );
+
+    c.invalidate( "a" );
+    c.invalidate( "b" );
+
+    BOOST_REQUIRE( ! c.find( "a" ) );
+    BOOST_REQUIRE_EQUAL( 0, c.size() );
+    BOOST_REQUIRE_EQUAL( 1, c.get_statistics().invalidations_count_ );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
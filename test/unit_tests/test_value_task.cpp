@@ -32,6 +32,7 @@
 #include "kademlia/id.hpp"
 #include "kademlia/message_socket.hpp"
 #include "kademlia/lookup_task.hpp"
+#include "kademlia/constants.hpp"
 
 namespace {
 
@@ -43,7 +44,7 @@ struct test_task : kd::lookup_task {
     test_task
         ( kd::id const& key
         , Iterator i, Iterator e )
-        : lookup_task{ key, i, e }
+        : lookup_task{ key, i, e, kd::ROUTING_TABLE_BUCKET_SIZE }
     { }
 };
 
@@ -0,0 +1,102 @@
+// Copyright (c) 2013-2014, David Keller
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the University of California, Berkeley nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY DAVID KELLER AND CONTRIBUTORS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "kademlia/varint.hpp"
+
+namespace {
+
+namespace k = kademlia;
+namespace kd = k::detail;
+
+BOOST_AUTO_TEST_SUITE( test_usage )
+
+BOOST_AUTO_TEST_CASE( can_serialize_varints )
+{
+    std::vector< std::uint64_t > const values
+            { 0, 1, 127, 128, 300, 16383, 16384
+            , std::uint64_t( 1 ) << 35
+            , std::numeric_limits< std::uint64_t >::max() };
+
+    kd::buffer buffer;
+    for ( auto const v : values )
+    {
+        auto const previous_size = buffer.size();
+        kd::serialize_varint( v, buffer );
+        BOOST_REQUIRE_EQUAL( kd::get_varint_size( v )
+                           , buffer.size() - previous_size );
+    }
+
+    auto i = buffer.cbegin(), e = buffer.cend();
+    for ( auto const v : values )
+    {
+        std::uint64_t actual;
+        BOOST_REQUIRE( ! kd::deserialize_varint( i, e, actual ) );
+        BOOST_REQUIRE_EQUAL( v, actual );
+    }
+    BOOST_REQUIRE( i == e );
+
+    BOOST_REQUIRE_EQUAL( 1, kd::get_varint_size( 127 ) );
+    BOOST_REQUIRE_EQUAL( 2, kd::get_varint_size( 128 ) );
+    BOOST_REQUIRE_EQUAL( kd::VARINT_MAX_SIZE
+                       , kd::get_varint_size( values.back() ) );
+}
+
+BOOST_AUTO_TEST_CASE( can_detect_invalid_varints )
+{
+    auto const check = []( kd::buffer const& buffer
+                         , std::error_code const& expected )
+    {
+        std::uint64_t value;
+        auto i = buffer.cbegin(), e = buffer.cend();
+        BOOST_REQUIRE_EQUAL( expected, kd::deserialize_varint( i, e, value ) );
+        // The iterator is left untouched.
+        BOOST_REQUIRE( i == buffer.cbegin() );
+    };
+
+    auto const truncated = kd::make_error_code( k::TRUNCATED_SIZE );
+    auto const corrupted = kd::make_error_code( k::CORRUPTED_BODY );
+
+    check( kd::buffer{}, truncated );
+    check( kd::buffer{ 0x80 }, truncated );
+    check( kd::buffer( 9, 0xff ), truncated );
+    // Longer than the longest encoding.
+    check( kd::buffer( 11, 0xff ), corrupted );
+    // Doesn't fit 64 bits.
+    kd::buffer overflow( 9, 0xff );
+    overflow.push_back( 0x02 );
+    check( overflow, corrupted );
+    // Not encoded with the fewest bytes.
+    check( kd::buffer{ 0x81, 0x00 }, corrupted );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
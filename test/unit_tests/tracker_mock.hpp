@@ -30,6 +30,8 @@
 
 #include <boost/asio/io_service.hpp>
 
+#include <kademlia/configuration.hpp>
+
 #include "kademlia/error_impl.hpp"
 
 #include "kademlia/message.hpp"
@@ -49,12 +51,15 @@ public:
      *
      */
     tracker_mock
-        ( boost::asio::io_service & io_service )
+        ( boost::asio::io_service & io_service
+        , configuration const& config = configuration{} )
             : io_service_( io_service )
+            , configuration_( config )
             , id_()
             , message_serializer_( id_ )
             , responses_to_receive_()
             , sent_messages_()
+            , peer_version_( detail::header::V1 )
     { }
 
     /**
@@ -69,7 +74,9 @@ public:
     {
         message_to_receive m{ endpoint
                             , detail::message_traits< MessageType >::TYPE_ID
-                            , source_id };
+                            , source_id
+                            , {}
+                            , detail::is_compressed( message ) };
         serialize( message, m.body );
 
         responses_to_receive_.push( std::move( m ) );
@@ -131,7 +138,9 @@ public:
             responses_to_receive_.pop();
             detail::header h{ detail::header::V1
                             , r.message_type
-                            , r.source_id };
+                            , r.source_id
+                            , detail::id{}
+                            , r.is_compressed };
 
             auto forwarder = [ on_message_received, h, r ]
             {
@@ -168,6 +177,32 @@ public:
         , EndpointType const& e )
     { save_sent_message( r, e ); }
 
+    /**
+     *  @brief Peers of the mock speak V1 unless told otherwise.
+     */
+    detail::header::version
+    get_peer_version
+        ( endpoint_type const& )
+        const
+    { return peer_version_; }
+
+    /**
+     *
+     */
+    void
+    set_peer_version
+        ( detail::header::version version )
+    { peer_version_ = version; }
+
+    /**
+     *
+     */
+    configuration const&
+    get_configuration
+        ( void )
+        const
+    { return configuration_; }
+
 private:
     struct sent_message final
     {
@@ -181,6 +216,7 @@ private:
         detail::header::type message_type;
         detail::id source_id;
         detail::buffer body;
+        bool is_compressed;
     };
 
 private:
@@ -204,6 +240,8 @@ private:
     ///
     boost::asio::io_service & io_service_;
     ///
+    configuration configuration_;
+    ///
     detail::id id_;
     ///
     detail::message_serializer message_serializer_;
@@ -211,6 +249,8 @@ private:
     std::queue< message_to_receive > responses_to_receive_;
     ///
     std::queue< sent_message > sent_messages_;
+    ///
+    detail::header::version peer_version_;
 };
 
 } // namespace test